@@ -14,6 +14,7 @@ SPVTOOLS_SRC_FILES := \
 		source/enum_string_mapping.cpp \
 		source/extensions.cpp \
 		source/libspirv.cpp \
+		source/module_index.cpp \
 		source/name_mapper.cpp \
 		source/opcode.cpp \
 		source/operand.cpp \
@@ -120,6 +121,7 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/feature_manager.cpp \
 		source/opt/fix_func_call_arguments.cpp \
 		source/opt/fix_storage_class.cpp \
+		source/opt/fixed_point_pass_group.cpp \
 		source/opt/flatten_decoration_pass.cpp \
 		source/opt/fold.cpp \
 		source/opt/folding_rules.cpp \
@@ -129,6 +131,7 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/graphics_robust_access_pass.cpp \
 		source/opt/if_conversion.cpp \
 		source/opt/inline_pass.cpp \
+		source/opt/inline_cost_model_pass.cpp \
 		source/opt/inline_exhaustive_pass.cpp \
 		source/opt/inline_opaque_pass.cpp \
 		source/opt/instruction.cpp \
@@ -160,8 +163,10 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/module.cpp \
 		source/opt/opextinst_forward_ref_fixup_pass.cpp \
 		source/opt/optimizer.cpp \
+		source/opt/optimizer_cache.cpp \
 		source/opt/pass.cpp \
 		source/opt/pass_manager.cpp \
+		source/opt/pass_profiler.cpp \
 		source/opt/private_to_local_pass.cpp \
 		source/opt/propagator.cpp \
 		source/opt/reduce_load_size.cpp \
@@ -402,6 +402,9 @@ typedef enum spv_binary_to_text_options_t {
   // Reorder blocks to match the structured control flow of SPIR-V to increase
   // readability.
   SPV_BINARY_TO_TEXT_OPTION_REORDER_BLOCKS = SPV_BIT(9),
+  // Disassemble function bodies on multiple threads.  The text is the same as
+  // without this option.
+  SPV_BINARY_TO_TEXT_OPTION_PARALLEL = SPV_BIT(10),
   SPV_FORCE_32_BIT_ENUM(spv_binary_to_text_options_t)
 } spv_binary_to_text_options_t;
 
@@ -866,6 +869,31 @@ SPIRV_TOOLS_EXPORT spv_result_t spvTextToBinaryWithOptions(
     const spv_const_context context, const char* text, const size_t length,
     const uint32_t options, spv_binary* binary, spv_diagnostic* diagnostic);
 
+// Supplies the assembly text read by spvTextToBinaryStream. Writes up to |size|
+// bytes of text to |buffer| and returns the number of bytes written. Returning
+// 0 marks the end of the text.
+typedef size_t (*spv_text_reader_fn)(void* user_data, char* buffer,
+                                     size_t size);
+
+// Receives |count| words of the binary produced by spvTextToBinaryStream,
+// which go at word |offset| of the module. The |words| are only valid during
+// the call.
+typedef void (*spv_binary_sink_fn)(void* user_data, size_t offset,
+                                   const uint32_t* words, size_t count);
+
+// Same as spvTextToBinaryWithOptions, but reads the text from |reader| and
+// passes the binary to |sink| as it is produced, so that neither is held in
+// memory as a whole. The instruction words are passed in order, starting at
+// offset 5. The header, whose id bound is only known at the end, is passed
+// last at offset 0. With SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS, the
+// binary is held until the end of the text, and numeric ids of 2^31 or more
+// are rejected. On error, the sink may already have received part of the
+// binary.
+SPIRV_TOOLS_EXPORT spv_result_t spvTextToBinaryStream(
+    const spv_const_context context, spv_text_reader_fn reader,
+    void* reader_data, const uint32_t options, spv_binary_sink_fn sink,
+    void* sink_data, spv_diagnostic* diagnostic);
+
 // Frees an allocated text stream. This is a no-op if the text parameter
 // is a null pointer.
 SPIRV_TOOLS_EXPORT void spvTextDestroy(spv_text text);
@@ -883,6 +911,20 @@ SPIRV_TOOLS_EXPORT spv_result_t spvBinaryToText(const spv_const_context context,
                                                 spv_text* text,
                                                 spv_diagnostic* diagnostic);
 
+// Receives a piece of the text produced by spvBinaryToTextWithSink. The
+// |text| is not null-terminated and is only valid during the call.
+typedef void (*spv_text_sink_fn)(void* user_data, const char* text,
+                                 size_t length);
+
+// Same as spvBinaryToText, but passes the text to |sink| in pieces as it is
+// produced instead of collecting it in memory. The |user_data| is passed to
+// every call of |sink|. The SPV_BINARY_TO_TEXT_OPTION_PRINT option is
+// ignored. On error, the sink may already have received part of the text.
+SPIRV_TOOLS_EXPORT spv_result_t spvBinaryToTextWithSink(
+    const spv_const_context context, const uint32_t* binary,
+    const size_t word_count, const uint32_t options, spv_text_sink_fn sink,
+    void* user_data, spv_diagnostic* diagnostic);
+
 // Frees a binary stream from memory. This is a no-op if binary is a null
 // pointer.
 SPIRV_TOOLS_EXPORT void spvBinaryDestroy(spv_binary binary);
@@ -35,6 +35,16 @@ using HeaderParser = std::function<spv_result_t(
     const spv_endianness_t endianess, const spv_parsed_header_t& instruction)>;
 using InstructionParser =
     std::function<spv_result_t(const spv_parsed_instruction_t& instruction)>;
+// Receives a piece of disassembly text. The |text| is not null-terminated and
+// is only valid during the call.
+using TextSink = std::function<void(const char* text, size_t length)>;
+// Supplies assembly text. Writes up to |size| bytes to |buffer| and returns the
+// number of bytes written, or 0 at the end of the text.
+using TextReader = std::function<size_t(char* buffer, size_t size)>;
+// Receives |count| words of a binary, which go at word |offset| of the module.
+// The |words| are only valid during the call.
+using BinarySink =
+    std::function<void(size_t offset, const uint32_t* words, size_t count)>;
 
 // C++ RAII wrapper around the C context object spv_context.
 class SPIRV_TOOLS_EXPORT Context {
@@ -341,6 +351,11 @@ class SPIRV_TOOLS_EXPORT SpirvTools {
   bool Assemble(const char* text, size_t text_size,
                 std::vector<uint32_t>* binary,
                 uint32_t options = kDefaultAssembleOption) const;
+  // Assembles the text supplied by |reader| a piece at a time, and passes the
+  // binary to |sink| as it is produced. See spvTextToBinaryStream for the
+  // order in which the words are passed.
+  bool AssembleStream(const TextReader& reader, const BinarySink& sink,
+                      uint32_t options = kDefaultAssembleOption) const;
 
   // Disassembles the given SPIR-V |binary| with the given |options| and writes
   // the assembly to |text|. Returns true on successful disassembling. |text|
@@ -351,6 +366,14 @@ class SPIRV_TOOLS_EXPORT SpirvTools {
   bool Disassemble(const uint32_t* binary, size_t binary_size,
                    std::string* text,
                    uint32_t options = kDefaultDisassembleOption) const;
+  // Disassembles the given SPIR-V |binary| with the given |options| and passes
+  // the assembly to |sink| in pieces as it is produced, without holding all of
+  // it in memory. The SPV_BINARY_TO_TEXT_OPTION_PRINT option is ignored.
+  // Returns true on successful disassembling. On failure, |sink| may already
+  // have received part of the assembly.
+  bool DisassembleToSink(const uint32_t* binary, size_t binary_size,
+                         const TextSink& sink,
+                         uint32_t options = kDefaultDisassembleOption) const;
 
   // Parses a SPIR-V binary, specified as counted sequence of 32-bit words.
   // Parsing feedback is provided via two callbacks provided as std::function.
@@ -404,6 +427,104 @@ class SPIRV_TOOLS_EXPORT SpirvTools {
   std::unique_ptr<Impl> impl_;  // Unique pointer to implementation data.
 };
 
+// An index of where things are in a SPIR-V binary, for answering questions
+// such as "where is function %N" or "which instructions decorate %X" without
+// parsing the module. It is built by one pass over the instruction words,
+// which only looks at the operands holding result ids and decoration targets.
+// It can be saved next to the binary and loaded again instead of rebuilt.
+//
+// Locations are word offsets into the binary. The index does not keep the
+// binary; callers read the instructions at the returned offsets themselves.
+// The binary does not need to be valid: instructions are indexed wherever
+// they appear.
+class SPIRV_TOOLS_EXPORT ModuleIndex {
+ public:
+  // The sections of the logical layout of a module.
+  enum class Section {
+    kCapability,
+    kExtension,
+    kExtInstImport,
+    kMemoryModel,
+    kEntryPoint,
+    kExecutionMode,
+    kDebug,
+    kAnnotation,
+    kGlobal,  // Types, constants, global variables and undefs.
+    kFunction,
+  };
+
+  // The words [begin, end) of the binary.
+  struct Range {
+    size_t begin = 0;
+    size_t end = 0;
+
+    bool empty() const { return begin == end; }
+  };
+
+  // Returned for the offset of something which is not in the module.
+  static constexpr size_t kNotFound = ~size_t(0);
+
+  ModuleIndex();
+  ~ModuleIndex();
+  ModuleIndex(ModuleIndex&& other);
+  ModuleIndex& operator=(ModuleIndex&& other);
+  ModuleIndex(const ModuleIndex&) = delete;
+  ModuleIndex& operator=(const ModuleIndex&) = delete;
+
+  // Indexes the |word_count| words of |binary|, in either endianness. Returns
+  // false, and leaves the index empty, if the header is invalid or an
+  // instruction extends past the end of the binary.
+  bool Build(const uint32_t* binary, size_t word_count);
+
+  // Appends the index to |data|, in a form which Load() reads back.
+  void Save(std::vector<uint32_t>* data) const;
+  // Replaces the index by the one saved in the |word_count| words of |data|.
+  // Returns false, and leaves the index empty, if the data is not a saved
+  // index.
+  bool Load(const uint32_t* data, size_t word_count);
+  // Returns true if the index was built from the |word_count| words of
+  // |binary|, according to their checksum. This reads the whole binary, but
+  // is much cheaper than indexing it again.
+  bool Matches(const uint32_t* binary, size_t word_count) const;
+
+  // Returns the id bound of the module, or 0 if the index is empty.
+  uint32_t id_bound() const;
+
+  // Returns the instructions of |section|. They are expected to be
+  // contiguous; otherwise, the range goes from the first to the last
+  // instruction of the section.
+  Range GetSection(Section section) const;
+
+  // Returns the offset of the instruction whose result is |id|, or kNotFound.
+  size_t GetDefinition(uint32_t id) const;
+
+  // Returns the offsets of the OpEntryPoint instructions.
+  std::vector<size_t> GetEntryPoints() const;
+
+  // Returns the offsets of the annotations applying to |id|: the decorations
+  // targeting it, and the group decorations listing it.
+  std::vector<size_t> GetDecorations(uint32_t id) const;
+
+  // Returns the number of functions, in module order.
+  size_t function_count() const;
+  // Returns the words of function number |index|, from OpFunction to
+  // OpFunctionEnd included.
+  Range GetFunction(size_t index) const;
+  // Returns the words of the function whose result is |id|, or an empty range.
+  Range GetFunctionById(uint32_t id) const;
+
+  // Returns the offsets of the OpLabel instructions of function number
+  // |index|.
+  std::vector<size_t> GetBlocks(size_t index) const;
+  // Returns the words of the block whose label is |id|, from the OpLabel up to
+  // the next OpLabel or OpFunctionEnd, or an empty range.
+  Range GetBlockById(uint32_t id) const;
+
+ private:
+  struct SPIRV_TOOLS_LOCAL Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
 }  // namespace spvtools
 
 #endif  // INCLUDE_SPIRV_TOOLS_LIBSPIRV_HPP_
@@ -15,6 +15,7 @@
 #ifndef INCLUDE_SPIRV_TOOLS_OPTIMIZER_HPP_
 #define INCLUDE_SPIRV_TOOLS_OPTIMIZER_HPP_
 
+#include <functional>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -32,6 +33,40 @@ class Pass;
 struct DescriptorSetAndBinding;
 }  // namespace opt
 
+// An interface for storing the results of Optimizer::Run so that optimizing
+// the same module with the same configuration again can skip the work.
+//
+// Keys are strings of hexadecimal digits computed by the optimizer from the
+// input binary, the registered passes and their options, the optimizer and
+// validator options, the target environment and the library version.  Values
+// are the optimized binaries.  Implementations must be safe to call from
+// several threads at once if the cache is shared between optimizers that run
+// concurrently.
+class SPIRV_TOOLS_EXPORT OptimizerCache {
+ public:
+  virtual ~OptimizerCache();
+
+  // Returns true and writes the binary stored for |key| into |binary| if
+  // there is one.  Returns false otherwise, leaving |binary| untouched.
+  virtual bool Lookup(const std::string& key,
+                      std::vector<uint32_t>* binary) = 0;
+
+  // Stores |binary| as the result for |key|, replacing any previous entry.
+  virtual void Store(const std::string& key,
+                     const std::vector<uint32_t>& binary) = 0;
+};
+
+// Creates a cache that keeps the |max_entries| most recently used results in
+// memory.  The returned cache can be shared between threads.
+SPIRV_TOOLS_EXPORT std::unique_ptr<OptimizerCache> CreateMemoryOptimizerCache(
+    size_t max_entries);
+
+// Creates a cache that stores each result as a file in |directory|, which
+// must already exist.  Several processes can share the same directory.
+// Entries are never evicted; clearing the directory is left to the client.
+SPIRV_TOOLS_EXPORT std::unique_ptr<OptimizerCache>
+CreateDirectoryOptimizerCache(const std::string& directory);
+
 // C++ interface for SPIR-V optimization functionalities. It wraps the context
 // (including target environment and the corresponding SPIR-V grammar) and
 // provides methods for registering optimization passes and optimizing.
@@ -94,6 +129,19 @@ class SPIRV_TOOLS_EXPORT Optimizer {
   // method.
   Optimizer& RegisterPass(PassToken&& pass);
 
+  // Registers a group of passes that is run repeatedly, in order, until every
+  // pass in the group has run once in a row without changing the module, or
+  // until |max_rounds| rounds have started.  A pass that made no change is not
+  // run again until another pass in the group changes the module.
+  //
+  // Passes can only run once, so each element of |pass_factories| is called
+  // to create a new pass every time the group runs that pass.  When a time
+  // report is requested, it includes the number of pass invocations the group
+  // needed.
+  Optimizer& RegisterFixedPointGroup(
+      std::vector<std::function<PassToken()>> pass_factories,
+      uint32_t max_rounds);
+
   // Registers passes that attempt to improve performance of generated code.
   // This sequence of passes is subject to constant review and will change
   // from time to time.
@@ -235,9 +283,46 @@ class SPIRV_TOOLS_EXPORT Optimizer {
   // |out| output stream.
   Optimizer& SetTimeReport(std::ostream* out);
 
+  // Sets the option to write a profile of the passes to |out| at the end of
+  // each call to Run().  If |out| is null, then no profile is generated.
+  //
+  // The profile is a JSON document in the Chrome trace event format, with one
+  // event per pass.  The arguments of each event give its CPU time, the number
+  // of instructions in the module before and after the pass, the number of
+  // functions it touched, and how many times each analysis was built and
+  // invalidated while it ran.  It is available whether or not the library was
+  // built with SPIRV_TIMER_ENABLED.
+  Optimizer& SetProfileReport(std::ostream* out);
+
+  // Sets the option to describe the decisions of the heuristic passes, one
+  // line each, such as the unroll factor CreateLoopUnrollHeuristicPass()
+  // chooses for each loop.  If |out| is null, then no output is generated.
+  Optimizer& SetDecisionReport(std::ostream* out);
+
   // Sets the option to validate the module after each pass.
   Optimizer& SetValidateAfterAll(bool validate);
 
+  // Sets the cache consulted by Run().  The optimizer does not take ownership
+  // of |cache|, which must outlive every call to Run().  If |cache| is null,
+  // results are not cached.
+  //
+  // On a hit, Run() returns the cached binary without validating the input or
+  // running any pass, and the registered passes are consumed as if they had
+  // run.  The cache is bypassed when SetPrintAll(), SetProfileReport() or
+  // SetDecisionReport() is in effect, since that output can only be produced
+  // by running the passes.
+  //
+  // Passes registered with RegisterPassFromFlag() or one of the Register*Passes
+  // recipes are identified in the key by their flag or recipe.  Passes
+  // registered directly with RegisterPass() are identified by their name and
+  // the parameters they were created with.  The cache is bypassed when such a
+  // pass writes its results outside of the module, as the pass created by
+  // CreateAnalyzeLiveInputPass() does.
+  //
+  // Each hit or miss is reported to the message consumer as a debug message,
+  // and to the time report stream if one is set.
+  Optimizer& SetCache(OptimizerCache* cache);
+
  private:
   struct SPIRV_TOOLS_LOCAL Impl;  // Opaque struct for holding internal data.
   std::unique_ptr<Impl> impl_;    // Unique pointer to internal data.
@@ -385,6 +470,17 @@ Optimizer::PassToken CreateBlockMergePass();
 // that are not in the call tree of an entry point are not changed.
 Optimizer::PassToken CreateInlineExhaustivePass();
 
+// Creates a cost-model inline pass.
+// Like the exhaustive inline pass, this pass inlines calls in the call trees
+// of the entry points and exported functions, but it decides for each call
+// whether inlining it pays off. Functions are processed bottom-up. Small
+// callees, callees marked Inline and the last call to a function are always
+// inlined. Other calls are inlined when the size of the callee, reduced by
+// the benefit of the call site, is under a threshold and the growth of the
+// module stays within a budget proportional to its original size. Calls in
+// loops and calls with constant or pointer arguments have a larger benefit.
+Optimizer::PassToken CreateInlineCostModelPass();
+
 // Creates an opaque inline pass.
 // An opaque inline pass inlines all function calls in all functions in all
 // entry point call trees where the called function contains an opaque type
@@ -620,6 +716,16 @@ Optimizer::PassToken CreateLocalRedundancyEliminationPass();
 // the loops preheader.
 Optimizer::PassToken CreateLoopInvariantCodeMotionPass();
 
+// Creates an aggressive LICM pass.
+// In addition to what the LICM pass does, this pass hoists loads from
+// variables that the loop does not write, when the load is not guarded by a
+// condition in the loop body.  It also moves stores of an invariant value to
+// an invariant pointer to the merge block of the loop, when nothing else in
+// the loop accesses the stored variable.  Hoisting stops in a loop when the
+// estimated register pressure of the loop would exceed |max_registers|.
+Optimizer::PassToken CreateAggressiveLoopInvariantCodeMotionPass(
+    uint32_t max_registers = 64);
+
 // Creates a loop fission pass.
 // This pass will split all top level loops whose register pressure exceedes the
 // given |threshold|.
@@ -699,6 +805,19 @@ Optimizer::PassToken CreateSimplificationPass();
 // won't be unrolled. See CanPerformUnroll LoopUtils.h for more information.
 Optimizer::PassToken CreateLoopUnrollPass(bool fully_unroll, int factor = 0);
 
+// Creates a loop unroller pass that chooses how to unroll each loop.
+// Every loop that is not marked DontUnroll and meets the criteria of
+// LoopUtils::CanPerformUnroll is fully unrolled if the estimated register
+// pressure of the unrolled loop is at most |max_registers| and the unrolled
+// copies have at most |max_instructions| instructions.  Otherwise it is
+// partially unrolled by the largest power of two factor that fits these
+// limits, if any.  The register pressure is estimated with the register
+// liveness analysis.  Each decision is written to the decision report, see
+// Optimizer::SetDecisionReport(), and sent to the message consumer as a debug
+// message.
+Optimizer::PassToken CreateLoopUnrollHeuristicPass(
+    uint32_t max_registers = 64, uint32_t max_instructions = 1024);
+
 // Create the SSA rewrite pass.
 // This pass converts load/store operations on function local variables into
 // operations on SSA IDs.  This allows SSA optimizers to act on these variables.
@@ -20,16 +20,20 @@
 #include "source/disassemble.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <iomanip>
 #include <ios>
+#include <iostream>
 #include <memory>
 #include <set>
 #include <sstream>
 #include <stack>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "source/assembly_grammar.h"
 #include "source/binary.h"
@@ -43,6 +47,7 @@
 #include "source/util/hex_float.h"
 #include "source/util/make_unique.h"
 #include "spirv-tools/libspirv.h"
+#include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
 namespace {
@@ -70,8 +75,13 @@ class ParsedInstruction {
  public:
   ParsedInstruction(const spv_parsed_instruction_t* instruction) {
     // Make a copy of the parsed instruction, including stable memory for its
-    // operands.
+    // words and operands.  The parser reuses the memory of the words for
+    // modules that are not in the host's endianness.
     instruction_ = *instruction;
+    words_ = std::make_unique<uint32_t[]>(instruction->num_words);
+    memcpy(words_.get(), instruction->words,
+           instruction->num_words * sizeof(*instruction->words));
+    instruction_.words = words_.get();
     operands_ =
         std::make_unique<spv_parsed_operand_t[]>(instruction->num_operands);
     memcpy(operands_.get(), instruction->operands,
@@ -83,6 +93,7 @@ class ParsedInstruction {
 
  private:
   spv_parsed_instruction_t instruction_;
+  std::unique_ptr<uint32_t[]> words_;
   std::unique_ptr<spv_parsed_operand_t[]> operands_;
 };
 
@@ -111,23 +122,126 @@ struct ControlFlowGraph {
   std::vector<SingleBlock> blocks;
 };
 
+// The state carried from one instruction to the next that the text of the
+// following instructions depends on.
+struct TextState {
+  uint32_t comment_alignment = 0;
+  bool inserted_decoration_space = false;
+  bool inserted_debug_space = false;
+  bool inserted_type_space = false;
+};
+
+// A function whose text is produced apart from the rest of the module.
+struct DeferredFunction {
+  // The byte offset in the SPIR-V where the function starts.
+  size_t byte_offset;
+
+  // The instructions from OpFunction to OpFunctionEnd.
+  std::vector<ParsedInstruction> instructions;
+  bool complete = false;
+
+  // The text of the function, and the state it was produced from and ended
+  // with.
+  std::string text;
+  TextState start_state;
+  TextState end_state;
+  // How the text depends on the comment alignment of |start_state|, see
+  // InstructionDisassembler::leading_comment_alignment and
+  // all_lines_commented.
+  uint32_t leading_comment_alignment = 0;
+  bool all_lines_commented = true;
+};
+
+// A stream buffer that collects text in fixed-size chunks, so that long
+// text is never copied to grow a contiguous buffer. With a sink, each chunk
+// is passed to the sink when it fills up and is then reused, so the text is
+// never held in memory as a whole.
+class ChunkedTextBuffer : public std::streambuf {
+ public:
+  explicit ChunkedTextBuffer(TextSink sink) : sink_(std::move(sink)) {}
+
+  // Returns the length of the text held in the buffer.
+  size_t size() const {
+    if (chunks_.empty()) return 0;
+    return (chunks_.size() - 1) * kChunkSize + size_t(pptr() - pbase());
+  }
+
+  // Copies the text collected so far to |str|.
+  void CopyTo(char* str) const {
+    for (size_t i = 0; i + 1 < chunks_.size(); ++i) {
+      memcpy(str + i * kChunkSize, chunks_[i].get(), kChunkSize);
+    }
+    if (!chunks_.empty()) {
+      memcpy(str + (chunks_.size() - 1) * kChunkSize, pbase(),
+             size_t(pptr() - pbase()));
+    }
+  }
+
+  // Passes the text not yet seen by the sink to it.
+  void Flush() {
+    if (!sink_ || chunks_.empty()) return;
+    if (pptr() != pbase()) sink_(pbase(), size_t(pptr() - pbase()));
+    setp(chunks_.back().get(), chunks_.back().get() + kChunkSize);
+  }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+    }
+    if (sink_ && !chunks_.empty()) {
+      Flush();
+    } else {
+      chunks_.emplace_back(new char[kChunkSize]);
+      setp(chunks_.back().get(), chunks_.back().get() + kChunkSize);
+    }
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+  }
+
+ private:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  TextSink sink_;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+};
+
 // A Disassembler instance converts a SPIR-V binary to its assembly
 // representation.
 class Disassembler {
  public:
+  // Writes the text to |sink| if it is set, and otherwise collects it for
+  // SaveTextResult.
   Disassembler(const AssemblyGrammar& grammar, uint32_t options,
-               NameMapper name_mapper)
+               NameMapper name_mapper, TextSink sink = nullptr)
       : print_(spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PRINT, options)),
         nested_indent_(
             spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_NESTED_INDENT, options)),
         reorder_blocks_(
             spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_REORDER_BLOCKS, options)),
-        text_(),
-        out_(print_ ? out_stream() : out_stream(text_)),
-        instruction_disassembler_(grammar, out_.get(), options, name_mapper),
+        parallel_(spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PARALLEL, options)),
+        text_(std::move(sink)),
+        text_stream_(&text_),
+        out_(print_ ? std::cout : text_stream_),
+        instruction_disassembler_(grammar, out_, options, name_mapper),
         header_(!spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER, options)),
         byte_offset_(0) {}
 
+  // Creates a disassembler for the functions of the module |parent| is
+  // disassembling, which writes their text to |stream|.
+  Disassembler(const Disassembler& parent, std::ostream& stream)
+      : print_(false),
+        nested_indent_(parent.nested_indent_),
+        reorder_blocks_(parent.reorder_blocks_),
+        parallel_(false),
+        text_(nullptr),
+        text_stream_(&text_),
+        out_(stream),
+        instruction_disassembler_(parent.instruction_disassembler_, stream),
+        header_(false),
+        byte_offset_(0) {}
+
   // Emits the assembly header for the module, and sets up internal state
   // so subsequent callbacks can handle the cases where the entire module
   // is either big-endian or little-endian.
@@ -141,17 +255,32 @@ class Disassembler {
   // Returns SPV_SUCCESS on success.
   spv_result_t SaveTextResult(spv_text* text_result) const;
 
+  // Passes the text not yet written to the sink to it.
+  void FlushText() { text_.Flush(); }
+
+  // Emits the text of the functions that were deferred to be disassembled in
+  // parallel.
+  void EmitDeferredFunctions();
+
+  // Produces the text of |function| starting from |state|.
+  void DisassembleFunction(const TextState& state, DeferredFunction* function);
+
  private:
   void EmitCFG();
 
+  TextState GetTextState() const;
+  void SetTextState(const TextState& state);
+
   const bool print_;  // Should we also print to the standard output stream?
   const bool nested_indent_;  // Should the blocks be indented according to the
                               // control flow structure?
   const bool
       reorder_blocks_;       // Should the blocks be reordered for readability?
+  const bool parallel_;      // Should functions be disassembled in parallel?
   spv_endianness_t endian_;  // The detected endianness of the binary.
-  std::stringstream text_;   // Captures the text, if not printing.
-  out_stream out_;  // The Output stream.  Either to text_ or standard output.
+  ChunkedTextBuffer text_;   // Captures the text, if not printing.
+  std::ostream text_stream_;  // Writes to text_.
+  std::ostream& out_;         // Where the text goes.
   disassemble::InstructionDisassembler instruction_disassembler_;
   const bool header_;   // Should we output header as the leading comment?
   size_t byte_offset_;  // The number of bytes processed so far.
@@ -161,6 +290,12 @@ class Disassembler {
 
   // The CFG for the current function
   ControlFlowGraph current_function_cfg_;
+
+  // The functions to disassemble in parallel, in module order.
+  std::vector<DeferredFunction> deferred_functions_;
+  // Whether a deferred function has an OpDecorate, which may add comments to
+  // the functions after it.
+  bool deferred_decoration_ = false;
 };
 
 spv_result_t Disassembler::HandleHeader(spv_endianness_t endian,
@@ -183,6 +318,28 @@ spv_result_t Disassembler::HandleHeader(spv_endianness_t endian,
 
 spv_result_t Disassembler::HandleInstruction(
     const spv_parsed_instruction_t& inst) {
+  // With parallel disassembly, stash everything from the first function on.
+  // The instructions that follow OpFunctionEnd start a new function, which
+  // mirrors how the text of a function only depends on the instructions
+  // before it through TextState.
+  if (parallel_ &&
+      (!deferred_functions_.empty() ||
+       (static_cast<spv::Op>(inst.opcode) == spv::Op::OpFunction &&
+        current_function_cfg_.blocks.empty()))) {
+    if (deferred_functions_.empty() || deferred_functions_.back().complete) {
+      deferred_functions_.emplace_back();
+      deferred_functions_.back().byte_offset = byte_offset_;
+    }
+    DeferredFunction& function = deferred_functions_.back();
+    function.instructions.emplace_back(&inst);
+    function.complete =
+        static_cast<spv::Op>(inst.opcode) == spv::Op::OpFunctionEnd;
+    deferred_decoration_ |=
+        static_cast<spv::Op>(inst.opcode) == spv::Op::OpDecorate;
+    byte_offset_ += inst.num_words * sizeof(uint32_t);
+    return SPV_SUCCESS;
+  }
+
   instruction_disassembler_.EmitSectionComment(inst, inserted_decoration_space_,
                                                inserted_debug_space_,
                                                inserted_type_space_);
@@ -517,12 +674,185 @@ void Disassembler::EmitCFG() {
   current_function_cfg_.blocks.clear();
 }
 
+TextState Disassembler::GetTextState() const {
+  TextState state;
+  state.comment_alignment = instruction_disassembler_.comment_alignment();
+  state.inserted_decoration_space = inserted_decoration_space_;
+  state.inserted_debug_space = inserted_debug_space_;
+  state.inserted_type_space = inserted_type_space_;
+  return state;
+}
+
+void Disassembler::SetTextState(const TextState& state) {
+  instruction_disassembler_.ResetCommentAlignment(state.comment_alignment);
+  inserted_decoration_space_ = state.inserted_decoration_space;
+  inserted_debug_space_ = state.inserted_debug_space;
+  inserted_type_space_ = state.inserted_type_space;
+}
+
+void Disassembler::DisassembleFunction(const TextState& state,
+                                       DeferredFunction* function) {
+  SetTextState(state);
+  byte_offset_ = function->byte_offset;
+  current_function_cfg_.blocks.clear();
+  for (const ParsedInstruction& inst : function->instructions) {
+    HandleInstruction(*inst.get());
+  }
+  function->start_state = state;
+  function->end_state = GetTextState();
+  function->leading_comment_alignment =
+      instruction_disassembler_.leading_comment_alignment();
+  function->all_lines_commented =
+      instruction_disassembler_.all_lines_commented();
+}
+
+// Returns true if the text of |function| would change if it started from
+// |state| instead of the state it was produced from.
+bool DependsOnTextState(const DeferredFunction& function,
+                        const TextState& state) {
+  const TextState& start = function.start_state;
+  const TextState& end = function.end_state;
+  // Only the comment on the first line of the function is aligned to the
+  // comment before it, and only if that is further to the right.  The
+  // comments after it are aligned to it in turn.
+  if (state.comment_alignment != start.comment_alignment) {
+    assert(start.comment_alignment == 0);
+    if (function.leading_comment_alignment != 0 &&
+        state.comment_alignment > function.leading_comment_alignment) {
+      return true;
+    }
+  }
+  // A section comment is emitted only if no function before emitted it.
+  return (end.inserted_decoration_space && !start.inserted_decoration_space &&
+          state.inserted_decoration_space) ||
+         (end.inserted_debug_space && !start.inserted_debug_space &&
+          state.inserted_debug_space) ||
+         (end.inserted_type_space && !start.inserted_type_space &&
+          state.inserted_type_space);
+}
+
+// Returns the state after the text of |function|, if it started from |state|
+// and does not depend on it.
+TextState FollowTextState(const DeferredFunction& function,
+                          const TextState& state) {
+  TextState next = function.end_state;
+  if (function.all_lines_commented) {
+    next.comment_alignment =
+        std::max(next.comment_alignment, state.comment_alignment);
+  }
+  next.inserted_decoration_space |= state.inserted_decoration_space;
+  next.inserted_debug_space |= state.inserted_debug_space;
+  next.inserted_type_space |= state.inserted_type_space;
+  return next;
+}
+
+// A thread producing the text of deferred functions.
+class FunctionWorker {
+ public:
+  explicit FunctionWorker(const Disassembler& parent)
+      : stream_(&text_), disassembler_(parent, stream_) {}
+
+  void Disassemble(const TextState& state, DeferredFunction* function) {
+    text_.clear();
+    disassembler_.DisassembleFunction(state, function);
+    function->text = text_.str();
+  }
+
+ private:
+  disassemble::StringBuffer text_;
+  std::ostream stream_;
+  Disassembler disassembler_;
+};
+
+void Disassembler::EmitDeferredFunctions() {
+  if (deferred_functions_.empty()) return;
+
+  const size_t num_threads =
+      deferred_decoration_
+          ? 1
+          : std::max<size_t>(
+                1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                    deferred_functions_.size()));
+  if (num_threads == 1) {
+    FunctionWorker worker(*this);
+    TextState state = GetTextState();
+    for (DeferredFunction& function : deferred_functions_) {
+      worker.Disassemble(state, &function);
+      state = function.end_state;
+      out_.write(function.text.data(), std::streamsize(function.text.size()));
+    }
+    deferred_functions_.clear();
+    SetTextState(state);
+    return;
+  }
+
+  // The first function starts from the current state.  The others start from
+  // the state after the module-level instructions with no comment alignment,
+  // which is the common case after OpFunctionEnd.  The functions whose text
+  // turns out to depend on the state left by the functions before them are
+  // disassembled again below.
+  const TextState first_state = GetTextState();
+  TextState other_state = first_state;
+  other_state.comment_alignment = 0;
+
+  std::vector<std::unique_ptr<FunctionWorker>> workers;
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers.push_back(MakeUnique<FunctionWorker>(*this));
+  }
+
+  // Disassembles the functions whose index is in |indices| on all workers.
+  auto disassemble = [this, &workers](const std::vector<size_t>& indices,
+                                      const std::vector<TextState>& states) {
+    std::atomic<size_t> next(0);
+    auto work = [this, &indices, &states, &next](FunctionWorker* worker) {
+      for (size_t i = next++; i < indices.size(); i = next++) {
+        worker->Disassemble(states[i], &deferred_functions_[indices[i]]);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(workers.size(), indices.size()); ++i) {
+      threads.emplace_back(work, workers[i].get());
+    }
+    work(workers[0].get());
+    for (std::thread& thread : threads) thread.join();
+  };
+
+  std::vector<size_t> indices(deferred_functions_.size());
+  std::vector<TextState> states(deferred_functions_.size(), other_state);
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = i;
+  states[0] = first_state;
+  disassemble(indices, states);
+
+  // Work out the state each function actually starts from.  Since the state
+  // after a function follows from the state before it without its text, the
+  // functions to redo are independent of each other.
+  indices.clear();
+  states.clear();
+  TextState state = first_state;
+  for (size_t i = 0; i < deferred_functions_.size(); ++i) {
+    const DeferredFunction& function = deferred_functions_[i];
+    if (DependsOnTextState(function, state)) {
+      indices.push_back(i);
+      states.push_back(state);
+    }
+    state = FollowTextState(function, state);
+  }
+  if (!indices.empty()) disassemble(indices, states);
+
+  for (DeferredFunction& function : deferred_functions_) {
+    out_.write(function.text.data(), std::streamsize(function.text.size()));
+  }
+  deferred_functions_.clear();
+  SetTextState(state);
+}
+
 spv_result_t Disassembler::SaveTextResult(spv_text* text_result) const {
   if (!print_) {
-    size_t length = text_.str().size();
+    size_t length = text_.size();
     char* str = new char[length + 1];
     if (!str) return SPV_ERROR_OUT_OF_MEMORY;
-    strncpy(str, text_.str().c_str(), length + 1);
+    text_.CopyTo(str);
+    str[length] = '\0';
     spv_text text = new spv_text_t();
     if (!text) {
       delete[] str;
@@ -598,7 +928,7 @@ spv_result_t DisassembleTargetInstruction(
   return SPV_SUCCESS;
 }
 
-uint32_t GetLineLengthWithoutColor(const std::string line) {
+uint32_t GetLineLengthWithoutColor(const std::string& line) {
   // Currently, every added color is in the form \x1b...m, so instead of doing a
   // lot of string comparisons with spvtools::clr::* strings, we just ignore
   // those ranges.
@@ -641,7 +971,32 @@ InstructionDisassembler::InstructionDisassembler(const AssemblyGrammar& grammar,
       show_byte_offset_(
           spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET, options)),
       name_mapper_(std::move(name_mapper)),
-      last_instruction_comment_alignment_(0) {}
+      last_instruction_comment_alignment_(0),
+      line_(&line_buffer_),
+      comments_(&comments_buffer_) {}
+
+InstructionDisassembler::InstructionDisassembler(
+    const InstructionDisassembler& other, std::ostream& stream)
+    : grammar_(other.grammar_),
+      stream_(stream),
+      print_(other.print_),
+      color_(other.color_),
+      indent_(other.indent_),
+      nested_indent_(other.nested_indent_),
+      comment_(other.comment_),
+      show_byte_offset_(other.show_byte_offset_),
+      name_mapper_(other.name_mapper_),
+      id_comments_(other.id_comments_),
+      last_instruction_comment_alignment_(0),
+      line_(&line_buffer_),
+      comments_(&comments_buffer_) {}
+
+void InstructionDisassembler::ResetCommentAlignment(uint32_t alignment) {
+  last_instruction_comment_alignment_ = alignment;
+  emitted_line_ = false;
+  leading_comment_alignment_ = 0;
+  all_lines_commented_ = true;
+}
 
 void InstructionDisassembler::EmitHeaderSpirv() { stream_ << "; SPIR-V\n"; }
 
@@ -689,7 +1044,8 @@ void InstructionDisassembler::EmitInstructionImpl(
 
   // To better align the comments (if any), write the instruction to a line
   // first so its length can be readily available.
-  std::ostringstream line;
+  std::ostream& line = line_;
+  line_buffer_.clear();
 
   if (nested_indent_ && opcode == spv::Op::OpLabel) {
     // Separate the blocks by an empty line to make them easier to separate
@@ -735,7 +1091,8 @@ void InstructionDisassembler::EmitInstructionImpl(
     GenerateCommentForDecoratedId(inst);
   }
 
-  std::ostringstream comments;
+  std::ostream& comments = comments_;
+  comments_buffer_.clear();
   const char* comment_separator = "";
 
   if (show_byte_offset_) {
@@ -758,25 +1115,31 @@ void InstructionDisassembler::EmitInstructionImpl(
   }
 
   if (comment_ && inst.result_id && id_comments_.count(inst.result_id) > 0) {
-    comments << comment_separator << id_comments_[inst.result_id].str();
+    comments << comment_separator << id_comments_[inst.result_id];
     comment_separator = ", ";
   }
 
-  stream_ << line.str();
+  const std::string& line_text = line_buffer_.str();
+  stream_.write(line_text.data(), std::streamsize(line_text.size()));
 
-  if (!comments.str().empty()) {
+  const std::string& comments_text = comments_buffer_.str();
+  if (!comments_text.empty()) {
     // Align the comments
-    const uint32_t line_length = GetLineLengthWithoutColor(line.str());
+    const uint32_t line_length = GetLineLengthWithoutColor(line_text);
     uint32_t align = std::max(
         {line_length + 2, last_instruction_comment_alignment_, kCommentColumn});
     // Round up the alignment to a multiple of 4 for more niceness.
     align = (align + 3) & ~0x3u;
     last_instruction_comment_alignment_ = align;
 
-    stream_ << std::string(align - line_length, ' ') << "; " << comments.str();
+    stream_ << std::string(align - line_length, ' ') << "; ";
+    stream_.write(comments_text.data(), std::streamsize(comments_text.size()));
+    if (!emitted_line_) leading_comment_alignment_ = align;
   } else {
     last_instruction_comment_alignment_ = 0;
+    all_lines_commented_ = false;
   }
+  emitted_line_ = true;
 
   stream_ << "\n";
 }
@@ -809,11 +1172,11 @@ void InstructionDisassembler::GenerateCommentForDecoratedId(
   }
 
   // Add the new comment to the comments of this id
-  std::ostringstream& id_comment = id_comments_[id];
-  if (!id_comment.str().empty()) {
-    id_comment << ", ";
+  std::string& id_comment = id_comments_[id];
+  if (!id_comment.empty()) {
+    id_comment += ", ";
   }
-  id_comment << partial.str();
+  id_comment += partial.str();
 }
 
 void InstructionDisassembler::EmitSectionComment(
@@ -1057,7 +1420,9 @@ std::string spvInstructionBinaryToText(const spv_target_env env,
   }
 
   // Now disassemble!
-  Disassembler disassembler(grammar, options, name_mapper);
+  Disassembler disassembler(grammar,
+                            options & ~SPV_BINARY_TO_TEXT_OPTION_PARALLEL,
+                            name_mapper);
   WrappedDisassembler wrapped(&disassembler, instCode, instWordCount);
   spvBinaryParse(context, &wrapped, code, wordCount, DisassembleTargetHeader,
                  DisassembleTargetInstruction, nullptr);
@@ -1074,38 +1439,72 @@ std::string spvInstructionBinaryToText(const spv_target_env env,
 
   return output;
 }
-}  // namespace spvtools
 
-spv_result_t spvBinaryToText(const spv_const_context context,
-                             const uint32_t* code, const size_t wordCount,
-                             const uint32_t options, spv_text* pText,
-                             spv_diagnostic* pDiagnostic) {
+namespace {
+
+// Disassembles the binary in |code|. Passes the text to |sink| if it is set,
+// and otherwise returns it in |pText| unless the options say to print it.
+spv_result_t BinaryToText(const spv_const_context context,
+                          const uint32_t* code, const size_t wordCount,
+                          const uint32_t options, TextSink sink,
+                          spv_text* pText, spv_diagnostic* pDiagnostic) {
   spv_context_t hijack_context = *context;
   if (pDiagnostic) {
     *pDiagnostic = nullptr;
-    spvtools::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+    UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
   }
 
-  const spvtools::AssemblyGrammar grammar(&hijack_context);
+  const AssemblyGrammar grammar(&hijack_context);
   if (!grammar.isValid()) return SPV_ERROR_INVALID_TABLE;
 
   // Generate friendly names for Ids if requested.
-  std::unique_ptr<spvtools::FriendlyNameMapper> friendly_mapper;
-  spvtools::NameMapper name_mapper = spvtools::GetTrivialNameMapper();
+  std::unique_ptr<FriendlyNameMapper> friendly_mapper;
+  NameMapper name_mapper = GetTrivialNameMapper();
   if (options & SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES) {
-    friendly_mapper = spvtools::MakeUnique<spvtools::FriendlyNameMapper>(
-        &hijack_context, code, wordCount);
+    friendly_mapper =
+        MakeUnique<FriendlyNameMapper>(&hijack_context, code, wordCount);
     name_mapper = friendly_mapper->GetNameMapper();
   }
 
   // Now disassemble!
-  spvtools::Disassembler disassembler(grammar, options, name_mapper);
-  if (auto error =
-          spvBinaryParse(&hijack_context, &disassembler, code, wordCount,
-                         spvtools::DisassembleHeader,
-                         spvtools::DisassembleInstruction, pDiagnostic)) {
-    return error;
+  const bool to_sink = bool(sink);
+  Disassembler disassembler(grammar, options, name_mapper, std::move(sink));
+  const spv_result_t result =
+      spvBinaryParse(&hijack_context, &disassembler, code, wordCount,
+                     DisassembleHeader, DisassembleInstruction, pDiagnostic);
+  // Emit the functions parsed so far even on error, like serial disassembly.
+  disassembler.EmitDeferredFunctions();
+  if (result != SPV_SUCCESS) return result;
+
+  if (to_sink) {
+    disassembler.FlushText();
+    return SPV_SUCCESS;
   }
-
   return disassembler.SaveTextResult(pText);
 }
+
+}  // namespace
+}  // namespace spvtools
+
+spv_result_t spvBinaryToText(const spv_const_context context,
+                             const uint32_t* code, const size_t wordCount,
+                             const uint32_t options, spv_text* pText,
+                             spv_diagnostic* pDiagnostic) {
+  return spvtools::BinaryToText(context, code, wordCount, options, nullptr,
+                                pText, pDiagnostic);
+}
+
+spv_result_t spvBinaryToTextWithSink(const spv_const_context context,
+                                     const uint32_t* code,
+                                     const size_t wordCount,
+                                     const uint32_t options,
+                                     spv_text_sink_fn sink, void* user_data,
+                                     spv_diagnostic* pDiagnostic) {
+  if (!sink) return SPV_ERROR_INVALID_POINTER;
+  return spvtools::BinaryToText(
+      context, code, wordCount, options & ~SPV_BINARY_TO_TEXT_OPTION_PRINT,
+      [sink, user_data](const char* text, size_t length) {
+        sink(user_data, text, length);
+      },
+      nullptr, pDiagnostic);
+}
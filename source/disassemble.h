@@ -16,7 +16,9 @@
 #define SOURCE_DISASSEMBLE_H_
 
 #include <ios>
+#include <ostream>
 #include <sstream>
+#include <streambuf>
 #include <string>
 
 #include "source/name_mapper.h"
@@ -40,6 +42,30 @@ std::string spvInstructionBinaryToText(const spv_target_env env,
 class AssemblyGrammar;
 namespace disassemble {
 
+// A stream buffer appending to a string, which can be read and cleared
+// without copying it.
+class StringBuffer : public std::streambuf {
+ public:
+  const std::string& str() const { return str_; }
+  void clear() { str_.clear(); }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+    }
+    str_.push_back(traits_type::to_char_type(ch));
+    return ch;
+  }
+  std::streamsize xsputn(const char* s, std::streamsize count) override {
+    str_.append(s, static_cast<size_t>(count));
+    return count;
+  }
+
+ private:
+  std::string str_;
+};
+
 // Shared code with other tools (than the disassembler) that might need to
 // output disassembly. An InstructionDisassembler instance converts SPIR-V
 // binary for an instruction to its assembly representation.
@@ -47,6 +73,10 @@ class InstructionDisassembler {
  public:
   InstructionDisassembler(const AssemblyGrammar& grammar, std::ostream& stream,
                           uint32_t options, NameMapper name_mapper);
+  // Creates a disassembler with the options and the comments on ids collected
+  // by |other|, which writes to |stream|.
+  InstructionDisassembler(const InstructionDisassembler& other,
+                          std::ostream& stream);
 
   // Emits the assembly header for the module.
   void EmitHeaderSpirv();
@@ -70,6 +100,24 @@ class InstructionDisassembler {
                           bool& inserted_debug_space,
                           bool& inserted_type_space);
 
+  // Returns the column the comment of the last instruction was aligned to, or
+  // 0 if it had no comment.
+  uint32_t comment_alignment() const {
+    return last_instruction_comment_alignment_;
+  }
+  // Continues as if the comment of the last instruction was aligned to
+  // |alignment|, and starts tracking how the lines emitted from now on depend
+  // on it.
+  void ResetCommentAlignment(uint32_t alignment);
+  // Returns the column the comment on the first line emitted since
+  // ResetCommentAlignment was aligned to, or 0 if that line had no comment.
+  uint32_t leading_comment_alignment() const {
+    return leading_comment_alignment_;
+  }
+  // Returns true if every line emitted since ResetCommentAlignment had a
+  // comment.
+  bool all_lines_commented() const { return all_lines_commented_; }
+
   // Resets the output color, if color is turned on.
   void ResetColor();
   // Set the output color, if color is turned on.
@@ -117,9 +165,21 @@ class InstructionDisassembler {
   // Some comments are generated as instructions (such as OpDecorate) are
   // visited so that when the instruction with that result id is visited, the
   // comment can be output.
-  std::unordered_map<uint32_t, std::ostringstream> id_comments_;
+  std::unordered_map<uint32_t, std::string> id_comments_;
   // Align the comments in consecutive lines for more readability.
   uint32_t last_instruction_comment_alignment_;
+  // Whether the comment alignment carried into the lines emitted since
+  // ResetCommentAlignment affects them.
+  bool emitted_line_ = false;
+  uint32_t leading_comment_alignment_ = 0;
+  bool all_lines_commented_ = true;
+
+  // The text and the comments of the instruction being emitted. They are
+  // kept across instructions so that their storage is reused.
+  StringBuffer line_buffer_;
+  std::ostream line_;
+  StringBuffer comments_buffer_;
+  std::ostream comments_;
 };
 
 }  // namespace disassemble
@@ -89,6 +89,26 @@ bool SpirvTools::Assemble(const char* text, const size_t text_size,
   return status == SPV_SUCCESS;
 }
 
+namespace {
+size_t CallTextReader(void* user_data, char* buffer, size_t size) {
+  return (*static_cast<const TextReader*>(user_data))(buffer, size);
+}
+
+void CallBinarySink(void* user_data, size_t offset, const uint32_t* words,
+                    size_t count) {
+  (*static_cast<const BinarySink*>(user_data))(offset, words, count);
+}
+}  // namespace
+
+bool SpirvTools::AssembleStream(const TextReader& reader,
+                                const BinarySink& sink,
+                                uint32_t options) const {
+  spv_result_t status = spvTextToBinaryStream(
+      impl_->context, CallTextReader, const_cast<TextReader*>(&reader),
+      options, CallBinarySink, const_cast<BinarySink*>(&sink), nullptr);
+  return status == SPV_SUCCESS;
+}
+
 bool SpirvTools::Disassemble(const std::vector<uint32_t>& binary,
                              std::string* text, uint32_t options) const {
   return Disassemble(binary.data(), binary.size(), text, options);
@@ -96,6 +116,21 @@ bool SpirvTools::Disassemble(const std::vector<uint32_t>& binary,
 
 bool SpirvTools::Disassemble(const uint32_t* binary, const size_t binary_size,
                              std::string* text, uint32_t options) const {
+  if ((options & SPV_BINARY_TO_TEXT_OPTION_PRINT) == 0) {
+    // Append the text as it is produced instead of copying it out of an
+    // spv_text at the end.
+    std::string result;
+    if (!DisassembleToSink(binary, binary_size,
+                           [&result](const char* data, size_t length) {
+                             result.append(data, length);
+                           },
+                           options)) {
+      return false;
+    }
+    text->swap(result);
+    return true;
+  }
+
   spv_text spvtext = nullptr;
   spv_result_t status = spvBinaryToText(impl_->context, binary, binary_size,
                                         options, &spvtext, nullptr);
@@ -108,6 +143,22 @@ bool SpirvTools::Disassemble(const uint32_t* binary, const size_t binary_size,
   return status == SPV_SUCCESS;
 }
 
+namespace {
+void CallTextSink(void* user_data, const char* text, size_t length) {
+  (*static_cast<const TextSink*>(user_data))(text, length);
+}
+}  // namespace
+
+bool SpirvTools::DisassembleToSink(const uint32_t* binary,
+                                   const size_t binary_size,
+                                   const TextSink& sink,
+                                   uint32_t options) const {
+  spv_result_t status = spvBinaryToTextWithSink(
+      impl_->context, binary, binary_size, options, CallTextSink,
+      const_cast<TextSink*>(&sink), nullptr);
+  return status == SPV_SUCCESS;
+}
+
 struct CxxParserContext {
   const HeaderParser& header_parser;
   const InstructionParser& instruction_parser;
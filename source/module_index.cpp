@@ -0,0 +1,477 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "source/latest_version_spirv_header.h"
+#include "source/spirv_constant.h"
+#include "source/spirv_endian.h"
+#include "source/table.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace {
+
+// Identifies saved indices, and their format.
+constexpr uint32_t kIndexMagic = 0x58495053;  // "SPIX"
+constexpr uint32_t kIndexVersion = 1;
+
+constexpr size_t kSectionCount =
+    static_cast<size_t>(ModuleIndex::Section::kFunction) + 1;
+
+// Returns the section an instruction with |opcode| belongs to, outside of
+// functions.
+ModuleIndex::Section SectionOf(spv::Op opcode) {
+  using Section = ModuleIndex::Section;
+  switch (opcode) {
+    case spv::Op::OpCapability:
+      return Section::kCapability;
+    case spv::Op::OpExtension:
+      return Section::kExtension;
+    case spv::Op::OpExtInstImport:
+      return Section::kExtInstImport;
+    case spv::Op::OpMemoryModel:
+      return Section::kMemoryModel;
+    case spv::Op::OpEntryPoint:
+      return Section::kEntryPoint;
+    case spv::Op::OpExecutionMode:
+    case spv::Op::OpExecutionModeId:
+      return Section::kExecutionMode;
+    case spv::Op::OpString:
+    case spv::Op::OpSourceExtension:
+    case spv::Op::OpSource:
+    case spv::Op::OpSourceContinued:
+    case spv::Op::OpName:
+    case spv::Op::OpMemberName:
+    case spv::Op::OpModuleProcessed:
+      return Section::kDebug;
+    case spv::Op::OpDecorate:
+    case spv::Op::OpMemberDecorate:
+    case spv::Op::OpDecorationGroup:
+    case spv::Op::OpGroupDecorate:
+    case spv::Op::OpGroupMemberDecorate:
+    case spv::Op::OpDecorateId:
+    case spv::Op::OpDecorateString:
+    case spv::Op::OpMemberDecorateString:
+      return Section::kAnnotation;
+    case spv::Op::OpFunction:
+      return Section::kFunction;
+    default:
+      return Section::kGlobal;
+  }
+}
+
+// Returns the FNV-1a hash of the |word_count| words of |words|.
+uint64_t Checksum(const uint32_t* words, size_t word_count) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < word_count; ++i) {
+    hash = (hash ^ words[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Reads the words of a saved index, failing past its end.
+class IndexReader {
+ public:
+  IndexReader(const uint32_t* data, size_t word_count)
+      : data_(data), end_(data + word_count) {}
+
+  bool Read(uint32_t* word) {
+    if (data_ == end_) return false;
+    *word = *data_++;
+    return true;
+  }
+
+  // Reads a count followed by that many elements of |words_per_element|
+  // words, into |elements|.
+  template <typename T, typename F>
+  bool ReadVector(size_t words_per_element, std::vector<T>* elements,
+                  F element_from_words) {
+    uint32_t count = 0;
+    if (!Read(&count) ||
+        count > static_cast<size_t>(end_ - data_) / words_per_element) {
+      return false;
+    }
+    elements->clear();
+    elements->reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      elements->push_back(element_from_words(data_));
+      data_ += words_per_element;
+    }
+    return true;
+  }
+
+  bool AtEnd() const { return data_ == end_; }
+
+ private:
+  const uint32_t* data_;
+  const uint32_t* const end_;
+};
+
+}  // namespace
+
+struct ModuleIndex::Impl {
+  // A function, in word offsets.
+  struct Function {
+    uint32_t begin;
+    // The OpFunctionEnd, or |end| if there is none.
+    uint32_t body_end;
+    uint32_t end;
+    // The index in |blocks| of the first label of the function.
+    uint32_t first_block;
+  };
+
+  uint32_t word_count = 0;
+  uint64_t checksum = 0;
+  uint32_t id_bound = 0;
+  // The begin and end offsets of each section, both 0 if it is empty.
+  std::array<std::pair<uint32_t, uint32_t>, kSectionCount> sections = {};
+  // The offset of the definition of each id below the word count, or 0 if it
+  // is not defined. Ids can only be that high in a sparsely numbered module,
+  // whose definitions are kept in |sparse_definitions| instead, so that a
+  // corrupt id bound cannot make the table huge.
+  std::vector<uint32_t> definitions;
+  // The (id, offset) definitions of higher ids, sorted.
+  std::vector<std::pair<uint32_t, uint32_t>> sparse_definitions;
+  std::vector<uint32_t> entry_points;
+  // The (target id, offset) of each annotation applying to an id, sorted.
+  std::vector<std::pair<uint32_t, uint32_t>> decorations;
+  std::vector<Function> functions;
+  // The offsets of the OpLabel instructions within functions.
+  std::vector<uint32_t> blocks;
+
+  // Returns the end of the blocks of function number |index| in |blocks|.
+  size_t BlocksEnd(size_t index) const {
+    return index + 1 < functions.size() ? functions[index + 1].first_block
+                                        : blocks.size();
+  }
+};
+
+ModuleIndex::ModuleIndex() : impl_(new Impl) {}
+
+ModuleIndex::~ModuleIndex() = default;
+
+// The moved-from index is left empty, rather than without an Impl.
+ModuleIndex::ModuleIndex(ModuleIndex&& other) : impl_(new Impl) {
+  impl_.swap(other.impl_);
+}
+
+ModuleIndex& ModuleIndex::operator=(ModuleIndex&& other) {
+  impl_.swap(other.impl_);
+  *other.impl_ = Impl();
+  return *this;
+}
+
+bool ModuleIndex::Build(const uint32_t* binary, size_t word_count) {
+  *impl_ = Impl();
+  if (!binary || word_count < SPV_INDEX_INSTRUCTION ||
+      word_count > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  spv_const_binary_t module = {binary, word_count};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&module, &endian) != SPV_SUCCESS) return false;
+  // Any environment has the result ids of all the opcodes.
+  spv_opcode_table opcode_table = nullptr;
+  if (spvOpcodeTableGet(&opcode_table, SPV_ENV_UNIVERSAL_1_0) != SPV_SUCCESS) {
+    return false;
+  }
+  const auto table_begin = opcode_table->entries;
+  const auto table_end = opcode_table->entries + opcode_table->count;
+
+  Impl index;
+  index.word_count = static_cast<uint32_t>(word_count);
+  index.checksum = Checksum(binary, word_count);
+  index.id_bound = spvFixWord(binary[SPV_INDEX_BOUND], endian);
+  index.definitions.assign(std::min<size_t>(index.id_bound, word_count), 0);
+
+  auto word = [binary, endian](size_t offset) {
+    return spvFixWord(binary[offset], endian);
+  };
+  auto add_decoration = [&index](uint32_t id, size_t offset) {
+    index.decorations.emplace_back(id, static_cast<uint32_t>(offset));
+  };
+
+  bool in_function = false;
+  for (size_t offset = SPV_INDEX_INSTRUCTION; offset < word_count;) {
+    const uint32_t first_word = word(offset);
+    const size_t inst_words = first_word >> 16;
+    const auto opcode = static_cast<spv::Op>(first_word & 0xffff);
+    if (inst_words == 0 || inst_words > word_count - offset) return false;
+    const auto inst_end = static_cast<uint32_t>(offset + inst_words);
+
+    auto& section = index.sections[static_cast<size_t>(
+        index.functions.empty() ? SectionOf(opcode) : Section::kFunction)];
+    if (section.first == 0) section.first = static_cast<uint32_t>(offset);
+    section.second = inst_end;
+
+    // The result id follows the result type id, if there is one.
+    const auto entry = std::lower_bound(
+        table_begin, table_end, opcode,
+        [](const spv_opcode_desc_t& lhs, spv::Op rhs) {
+          return lhs.opcode < rhs;
+        });
+    if (entry != table_end && entry->opcode == opcode && entry->hasResult) {
+      const size_t result_offset = entry->hasType ? 2 : 1;
+      if (result_offset < inst_words) {
+        const uint32_t id = word(offset + result_offset);
+        if (id < index.definitions.size()) {
+          index.definitions[id] = static_cast<uint32_t>(offset);
+        } else {
+          index.sparse_definitions.emplace_back(
+              id, static_cast<uint32_t>(offset));
+        }
+      }
+    }
+
+    switch (opcode) {
+      case spv::Op::OpEntryPoint:
+        index.entry_points.push_back(static_cast<uint32_t>(offset));
+        break;
+      case spv::Op::OpDecorate:
+      case spv::Op::OpMemberDecorate:
+      case spv::Op::OpDecorateId:
+      case spv::Op::OpDecorateString:
+      case spv::Op::OpMemberDecorateString:
+        if (inst_words > 1) add_decoration(word(offset + 1), offset);
+        break;
+      case spv::Op::OpGroupDecorate:
+        for (size_t i = 2; i < inst_words; ++i) {
+          add_decoration(word(offset + i), offset);
+        }
+        break;
+      case spv::Op::OpGroupMemberDecorate:
+        // The targets are followed by member numbers.
+        for (size_t i = 2; i < inst_words; i += 2) {
+          add_decoration(word(offset + i), offset);
+        }
+        break;
+      case spv::Op::OpFunction:
+        if (in_function) {
+          // The previous function has no OpFunctionEnd.
+          index.functions.back().body_end = static_cast<uint32_t>(offset);
+          index.functions.back().end = static_cast<uint32_t>(offset);
+        }
+        index.functions.push_back(
+            {static_cast<uint32_t>(offset), inst_end, inst_end,
+             static_cast<uint32_t>(index.blocks.size())});
+        in_function = true;
+        break;
+      case spv::Op::OpLabel:
+        if (in_function) index.blocks.push_back(static_cast<uint32_t>(offset));
+        break;
+      case spv::Op::OpFunctionEnd:
+        if (in_function) {
+          index.functions.back().body_end = static_cast<uint32_t>(offset);
+          index.functions.back().end = inst_end;
+          in_function = false;
+        }
+        break;
+      default:
+        break;
+    }
+    if (in_function) index.functions.back().end = inst_end;
+    offset = inst_end;
+  }
+  if (in_function) {
+    index.functions.back().body_end = index.functions.back().end;
+  }
+
+  std::sort(index.sparse_definitions.begin(), index.sparse_definitions.end());
+  std::sort(index.decorations.begin(), index.decorations.end());
+  *impl_ = std::move(index);
+  return true;
+}
+
+void ModuleIndex::Save(std::vector<uint32_t>* data) const {
+  const Impl& index = *impl_;
+  const auto count = [](size_t size) { return static_cast<uint32_t>(size); };
+  data->insert(data->end(),
+               {kIndexMagic, kIndexVersion, index.word_count,
+                static_cast<uint32_t>(index.checksum),
+                static_cast<uint32_t>(index.checksum >> 32), index.id_bound});
+  for (const auto& section : index.sections) {
+    data->insert(data->end(), {section.first, section.second});
+  }
+
+  data->push_back(count(index.definitions.size()));
+  data->insert(data->end(), index.definitions.begin(), index.definitions.end());
+  data->push_back(count(index.sparse_definitions.size()));
+  for (const auto& definition : index.sparse_definitions) {
+    data->insert(data->end(), {definition.first, definition.second});
+  }
+  data->push_back(count(index.entry_points.size()));
+  data->insert(data->end(), index.entry_points.begin(),
+               index.entry_points.end());
+  data->push_back(count(index.decorations.size()));
+  for (const auto& decoration : index.decorations) {
+    data->insert(data->end(), {decoration.first, decoration.second});
+  }
+  data->push_back(count(index.functions.size()));
+  for (const auto& function : index.functions) {
+    data->insert(data->end(), {function.begin, function.body_end, function.end,
+                               function.first_block});
+  }
+  data->push_back(count(index.blocks.size()));
+  data->insert(data->end(), index.blocks.begin(), index.blocks.end());
+}
+
+bool ModuleIndex::Load(const uint32_t* data, size_t word_count) {
+  *impl_ = Impl();
+  if (!data) return false;
+
+  Impl index;
+  IndexReader reader(data, word_count);
+  uint32_t magic = 0, version = 0, checksum_low = 0, checksum_high = 0;
+  if (!reader.Read(&magic) || magic != kIndexMagic ||
+      !reader.Read(&version) || version != kIndexVersion ||
+      !reader.Read(&index.word_count) || !reader.Read(&checksum_low) ||
+      !reader.Read(&checksum_high) || !reader.Read(&index.id_bound)) {
+    return false;
+  }
+  index.checksum = (uint64_t(checksum_high) << 32) | checksum_low;
+  for (auto& section : index.sections) {
+    if (!reader.Read(&section.first) || !reader.Read(&section.second)) {
+      return false;
+    }
+  }
+
+  const auto word = [](const uint32_t* words) { return words[0]; };
+  const auto pair = [](const uint32_t* words) {
+    return std::make_pair(words[0], words[1]);
+  };
+  const auto function = [](const uint32_t* words) {
+    return Impl::Function{words[0], words[1], words[2], words[3]};
+  };
+  if (!reader.ReadVector(1, &index.definitions, word) ||
+      !reader.ReadVector(2, &index.sparse_definitions, pair) ||
+      !reader.ReadVector(1, &index.entry_points, word) ||
+      !reader.ReadVector(2, &index.decorations, pair) ||
+      !reader.ReadVector(4, &index.functions, function) ||
+      !reader.ReadVector(1, &index.blocks, word) || !reader.AtEnd()) {
+    return false;
+  }
+  // The queries rely on the functions indexing the blocks in order.
+  uint32_t first_block = 0;
+  for (const auto& f : index.functions) {
+    if (f.first_block < first_block || f.first_block > index.blocks.size()) {
+      return false;
+    }
+    first_block = f.first_block;
+  }
+
+  *impl_ = std::move(index);
+  return true;
+}
+
+bool ModuleIndex::Matches(const uint32_t* binary, size_t word_count) const {
+  return binary && word_count == impl_->word_count && word_count != 0 &&
+         Checksum(binary, word_count) == impl_->checksum;
+}
+
+uint32_t ModuleIndex::id_bound() const { return impl_->id_bound; }
+
+ModuleIndex::Range ModuleIndex::GetSection(Section section) const {
+  const auto& words = impl_->sections[static_cast<size_t>(section)];
+  return {words.first, words.second};
+}
+
+size_t ModuleIndex::GetDefinition(uint32_t id) const {
+  const Impl& index = *impl_;
+  if (id < index.definitions.size()) {
+    return index.definitions[id] ? index.definitions[id] : kNotFound;
+  }
+  const auto it = std::lower_bound(
+      index.sparse_definitions.begin(), index.sparse_definitions.end(),
+      std::make_pair(id, uint32_t(0)));
+  if (it == index.sparse_definitions.end() || it->first != id) {
+    return kNotFound;
+  }
+  return it->second;
+}
+
+std::vector<size_t> ModuleIndex::GetEntryPoints() const {
+  return std::vector<size_t>(impl_->entry_points.begin(),
+                             impl_->entry_points.end());
+}
+
+std::vector<size_t> ModuleIndex::GetDecorations(uint32_t id) const {
+  const auto& decorations = impl_->decorations;
+  std::vector<size_t> offsets;
+  for (auto it = std::lower_bound(decorations.begin(), decorations.end(),
+                                  std::make_pair(id, uint32_t(0)));
+       it != decorations.end() && it->first == id; ++it) {
+    // A group decoration can list the same target more than once.
+    if (offsets.empty() || offsets.back() != it->second) {
+      offsets.push_back(it->second);
+    }
+  }
+  return offsets;
+}
+
+size_t ModuleIndex::function_count() const { return impl_->functions.size(); }
+
+ModuleIndex::Range ModuleIndex::GetFunction(size_t index) const {
+  if (index >= impl_->functions.size()) return {};
+  const auto& function = impl_->functions[index];
+  return {function.begin, function.end};
+}
+
+ModuleIndex::Range ModuleIndex::GetFunctionById(uint32_t id) const {
+  const size_t offset = GetDefinition(id);
+  if (offset == kNotFound) return {};
+  const auto& functions = impl_->functions;
+  const auto it = std::lower_bound(
+      functions.begin(), functions.end(), offset,
+      [](const Impl::Function& f, size_t o) { return f.begin < o; });
+  if (it == functions.end() || it->begin != offset) return {};
+  return {it->begin, it->end};
+}
+
+std::vector<size_t> ModuleIndex::GetBlocks(size_t index) const {
+  if (index >= impl_->functions.size()) return {};
+  const auto& blocks = impl_->blocks;
+  return std::vector<size_t>(
+      blocks.begin() + impl_->functions[index].first_block,
+      blocks.begin() + impl_->BlocksEnd(index));
+}
+
+ModuleIndex::Range ModuleIndex::GetBlockById(uint32_t id) const {
+  const size_t offset = GetDefinition(id);
+  if (offset == kNotFound) return {};
+  const Impl& index = *impl_;
+
+  // Finds the function containing the label, then the label among its blocks.
+  const auto function = std::upper_bound(
+      index.functions.begin(), index.functions.end(), offset,
+      [](size_t o, const Impl::Function& f) { return o < f.begin; });
+  if (function == index.functions.begin()) return {};
+  const size_t function_index = function - index.functions.begin() - 1;
+  const auto blocks_begin =
+      index.blocks.begin() + index.functions[function_index].first_block;
+  const auto blocks_end =
+      index.blocks.begin() + index.BlocksEnd(function_index);
+  const auto block = std::lower_bound(blocks_begin, blocks_end, offset);
+  if (block == blocks_end || *block != offset) return {};
+  const size_t end = block + 1 != blocks_end
+                         ? *(block + 1)
+                         : index.functions[function_index].body_end;
+  return {offset, end};
+}
+
+}  // namespace spvtools
@@ -18,7 +18,7 @@
 
 #include <algorithm>
 #include <cassert>
-#include <iterator>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -36,58 +36,142 @@ NameMapper GetTrivialNameMapper() {
   return [](uint32_t i) { return spvtools::to_string(i); };
 }
 
+namespace {
+
+// The size of the blocks holding the names.
+constexpr size_t kArenaBlockSize = 16 * 1024;
+
+bool IsValidNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+bool IsNumber(const std::string& name) {
+  return std::all_of(name.begin(), name.end(),
+                     [](char c) { return c >= '0' && c <= '9'; });
+}
+
+}  // namespace
+
 FriendlyNameMapper::FriendlyNameMapper(const spv_const_context context,
                                        const uint32_t* code,
                                        const size_t wordCount)
-    : grammar_(AssemblyGrammar(context)) {
+    : context_{context->target_env, context->opcode_table,
+               context->operand_table, context->ext_inst_table,
+               [](spv_message_level_t, const char*, const spv_position_t&,
+                  const char*) {}},
+      code_(code),
+      word_count_(wordCount),
+      grammar_(AssemblyGrammar(context)) {}
+
+std::string FriendlyNameMapper::NameForId(uint32_t id) {
+  std::call_once(parsed_, [this] { ParseModule(); });
+  return LookUpName(id);
+}
+
+void FriendlyNameMapper::ParseModule() {
+  // Header word 3 is the id bound.  It is only a size hint, and is capped in
+  // case the header is corrupt or in the other endianness.
+  number_named_.resize(word_count_ > 3 ? std::min(code_[3], 1u << 22) : 0);
+
   spv_diagnostic diag = nullptr;
   // We don't care if the parse fails.
-  spvBinaryParse(context, this, code, wordCount, nullptr,
+  spvBinaryParse(&context_, this, code_, word_count_, nullptr,
                  ParseInstructionForwarder, &diag);
   spvDiagnosticDestroy(diag);
+
+  if (saw_number_name_) {
+    // Some Id claims a name that could be taken by an Id named by its number,
+    // so start over, recording every name.
+    name_all_ids_ = true;
+    name_for_id_.clear();
+    used_names_.clear();
+    number_named_.assign(number_named_.size(), false);
+    number_named_out_of_bound_.clear();
+    spvBinaryParse(&context_, this, code_, word_count_, nullptr,
+                   ParseInstructionForwarder, &diag);
+    spvDiagnosticDestroy(diag);
+  }
 }
 
-std::string FriendlyNameMapper::NameForId(uint32_t id) {
+std::string FriendlyNameMapper::LookUpName(uint32_t id) const {
   auto iter = name_for_id_.find(id);
   if (iter == name_for_id_.end()) {
-    // It must have been an invalid module, so just return a trivial mapping.
-    // We don't care about uniqueness.
+    // Either the Id is named by its number, or it must have been an invalid
+    // module, so just return a trivial mapping.  We don't care about
+    // uniqueness in the latter case.
     return to_string(id);
   } else {
-    return iter->second;
+    return std::string(iter->second);
   }
 }
 
-std::string FriendlyNameMapper::Sanitize(const std::string& suggested_name) {
-  if (suggested_name.empty()) return "_";
+void FriendlyNameMapper::Sanitize(const std::string& suggested_name,
+                                  std::string* result) {
+  result->clear();
+  if (suggested_name.empty()) {
+    *result = "_";
+    return;
+  }
   // Otherwise, replace invalid characters by '_'.
-  std::string result;
-  std::string valid =
-      "abcdefghijklmnopqrstuvwxyz"
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      "_0123456789";
-  std::transform(suggested_name.begin(), suggested_name.end(),
-                 std::back_inserter(result), [&valid](const char c) {
-                   return (std::string::npos == valid.find(c)) ? '_' : c;
-                 });
-  return result;
+  result->reserve(suggested_name.size());
+  for (const char c : suggested_name) {
+    result->push_back(IsValidNameChar(c) ? c : '_');
+  }
+}
+
+bool FriendlyNameMapper::HasName(uint32_t id) const {
+  if (id < number_named_.size()) {
+    if (number_named_[id]) return true;
+  } else if (number_named_out_of_bound_.count(id)) {
+    return true;
+  }
+  return name_for_id_.find(id) != name_for_id_.end();
+}
+
+void FriendlyNameMapper::SaveNumberName(uint32_t id) {
+  if (HasName(id)) return;
+  if (name_all_ids_) {
+    SaveName(id, to_string(id));
+  } else if (id < number_named_.size()) {
+    number_named_[id] = true;
+  } else {
+    number_named_out_of_bound_.insert(id);
+  }
+}
+
+std::string_view FriendlyNameMapper::Intern(const std::string& name) {
+  if (arena_left_ < name.size()) {
+    const size_t size = std::max(kArenaBlockSize, name.size());
+    arena_.emplace_back(new char[size]);
+    arena_next_ = arena_.back().get();
+    arena_left_ = size;
+  }
+  memcpy(arena_next_, name.data(), name.size());
+  const std::string_view interned(arena_next_, name.size());
+  arena_next_ += name.size();
+  arena_left_ -= name.size();
+  return interned;
 }
 
 void FriendlyNameMapper::SaveName(uint32_t id,
                                   const std::string& suggested_name) {
-  if (name_for_id_.find(id) != name_for_id_.end()) return;
+  if (HasName(id)) return;
 
-  const std::string sanitized_suggested_name = Sanitize(suggested_name);
-  std::string name = sanitized_suggested_name;
-  auto inserted = used_names_.insert(name);
-  if (!inserted.second) {
-    const std::string base_name = sanitized_suggested_name + "_";
-    for (uint32_t index = 0; !inserted.second; ++index) {
-      name = base_name + to_string(index);
-      inserted = used_names_.insert(name);
+  std::string& name = name_buffer_;
+  Sanitize(suggested_name, &name);
+  if (!name_all_ids_ && IsNumber(name)) saw_number_name_ = true;
+  if (used_names_.count(name)) {
+    name += '_';
+    const size_t base_size = name.size();
+    for (uint32_t index = 0; used_names_.count(name); ++index) {
+      name.resize(base_size);
+      name += to_string(index);
     }
   }
-  name_for_id_[id] = name;
+  const std::string_view interned = Intern(name);
+  used_names_.insert(interned);
+  name_for_id_.emplace(id, interned);
 }
 
 void FriendlyNameMapper::SaveBuiltInName(uint32_t target_id,
@@ -234,29 +318,29 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
     } break;
     case spv::Op::OpTypeVector:
       SaveName(result_id, std::string("v") + to_string(inst.words[3]) +
-                              NameForId(inst.words[2]));
+                              LookUpName(inst.words[2]));
       break;
     case spv::Op::OpTypeMatrix:
       SaveName(result_id, std::string("mat") + to_string(inst.words[3]) +
-                              NameForId(inst.words[2]));
+                              LookUpName(inst.words[2]));
       break;
     case spv::Op::OpTypeArray:
-      SaveName(result_id, std::string("_arr_") + NameForId(inst.words[2]) +
-                              "_" + NameForId(inst.words[3]));
+      SaveName(result_id, std::string("_arr_") + LookUpName(inst.words[2]) +
+                              "_" + LookUpName(inst.words[3]));
       break;
     case spv::Op::OpTypeRuntimeArray:
       SaveName(result_id,
-               std::string("_runtimearr_") + NameForId(inst.words[2]));
+               std::string("_runtimearr_") + LookUpName(inst.words[2]));
       break;
     case spv::Op::OpTypeNodePayloadArrayAMDX:
       SaveName(result_id,
-               std::string("_payloadarr_") + NameForId(inst.words[2]));
+               std::string("_payloadarr_") + LookUpName(inst.words[2]));
       break;
     case spv::Op::OpTypePointer:
       SaveName(result_id, std::string("_ptr_") +
                               NameForEnumOperand(SPV_OPERAND_TYPE_STORAGE_CLASS,
                                                  inst.words[2]) +
-                              "_" + NameForId(inst.words[3]));
+                              "_" + LookUpName(inst.words[3]));
       break;
     case spv::Op::OpTypeUntypedPointerKHR:
       SaveName(result_id, std::string("_ptr_") +
@@ -281,10 +365,11 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
     case spv::Op::OpTypeQueue:
       SaveName(result_id, "Queue");
       break;
-    case spv::Op::OpTypeOpaque:
-      SaveName(result_id, std::string("Opaque_") +
-                              Sanitize(spvDecodeLiteralStringOperand(inst, 1)));
-      break;
+    case spv::Op::OpTypeOpaque: {
+      std::string sanitized;
+      Sanitize(spvDecodeLiteralStringOperand(inst, 1), &sanitized);
+      SaveName(result_id, std::string("Opaque_") + sanitized);
+    } break;
     case spv::Op::OpTypePipeStorage:
       SaveName(result_id, "PipeStorage");
       break;
@@ -310,7 +395,7 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       // to underscore.
       for (auto& c : value_str)
         if (c == '-') c = 'n';
-      SaveName(result_id, NameForId(inst.type_id) + "_" + value_str);
+      SaveName(result_id, LookUpName(inst.type_id) + "_" + value_str);
     } break;
     default:
       // If this instruction otherwise defines an Id, then save a mapping for
@@ -318,8 +403,7 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       // string something like "1" that might collide with this result_id.
       // We should only do this if a name hasn't already been registered by some
       // previous forward reference.
-      if (result_id && name_for_id_.find(result_id) == name_for_id_.end())
-        SaveName(result_id, to_string(result_id));
+      if (result_id) SaveNumberName(result_id);
       break;
   }
   return SPV_SUCCESS;
@@ -16,11 +16,16 @@
 #define SOURCE_NAME_MAPPER_H_
 
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "source/assembly_grammar.h"
+#include "source/table.h"
 #include "spirv-tools/libspirv.h"
 
 namespace spvtools {
@@ -33,9 +38,10 @@ using NameMapper = std::function<std::string(uint32_t)>;
 // Returns a NameMapper which always maps an Id to its decimal representation.
 NameMapper GetTrivialNameMapper();
 
-// A FriendlyNameMapper parses a module upon construction.  If the parse is
-// successful, then the NameForId method maps an Id to a friendly name
-// while also satisfying the constraints on a NameMapper.
+// A FriendlyNameMapper parses a module upon the first call to NameForId, so
+// that users which might never ask for a name, like the validator, pay nothing
+// for it.  If the parse is successful, then the NameForId method maps an Id to
+// a friendly name while also satisfying the constraints on a NameMapper.
 //
 // The mapping is friendly in the following sense:
 //  - If an Id has a debug name (via OpName), then that will be used when
@@ -61,9 +67,10 @@ NameMapper GetTrivialNameMapper();
 //  - Numeric literals in OpConstant map to a human-friendly name.
 class FriendlyNameMapper {
  public:
-  // Construct a friendly name mapper, and determine friendly names for each
-  // defined Id in the specified module.  The module is specified by the code
-  // wordCount, and should be parseable in the specified context.
+  // Construct a friendly name mapper for the specified module.  The module is
+  // specified by the code wordCount, and should be parseable in the specified
+  // context.  The context is copied, but the module is not, and must outlive
+  // the mapper.
   FriendlyNameMapper(const spv_const_context context, const uint32_t* code,
                      const size_t wordCount);
 
@@ -73,15 +80,32 @@ class FriendlyNameMapper {
     return [this](uint32_t id) { return this->NameForId(id); };
   }
 
-  // Returns the friendly name for the given id.  If the module parsed during
-  // construction is valid, then the mapping satisfies the rules for a
-  // NameMapper.
+  // Returns the friendly name for the given id.  If the module is valid, then
+  // the mapping satisfies the rules for a NameMapper.  The first call
+  // determines the names; it can be made from several threads at once.
   std::string NameForId(uint32_t id);
 
  private:
+  // Parses the module to determine the friendly names.
+  void ParseModule();
+
+  // Returns the name determined so far for the given id.
+  std::string LookUpName(uint32_t id) const;
+
   // Transforms the given string so that it is acceptable as an Id name in
-  // assembly language.  Two distinct inputs can map to the same output.
-  std::string Sanitize(const std::string& suggested_name);
+  // assembly language, and stores it in |result|.  Two distinct inputs can
+  // map to the same output.
+  static void Sanitize(const std::string& suggested_name, std::string* result);
+
+  // Returns true if the given id already has a name.
+  bool HasName(uint32_t id) const;
+
+  // Records that the given id is named by its number.  Unless name_all_ids_,
+  // the name itself is not stored.
+  void SaveNumberName(uint32_t id);
+
+  // Copies |name| into the arena and returns a view of the copy.
+  std::string_view Intern(const std::string& name);
 
   // Records a name for the given id.  If this id already has a name, then
   // this is a no-op.  If the id doesn't have a name, use the given
@@ -94,7 +118,7 @@ class FriendlyNameMapper {
   void SaveBuiltInName(uint32_t target_id, uint32_t built_in);
 
   // Collects information from the given parsed instruction to populate
-  // name_for_id_.  Returns SPV_SUCCESS;
+  // name_for_id_.  Returns SPV_SUCCESS.
   spv_result_t ParseInstruction(const spv_parsed_instruction_t& inst);
 
   // Forwards a parsed-instruction callback from the binary parser into the
@@ -108,11 +132,40 @@ class FriendlyNameMapper {
   // Returns the friendly name for an enumerant.
   std::string NameForEnumOperand(spv_operand_type_t type, uint32_t word);
 
-  // Maps an id to its friendly name.  This will have an entry for each Id
-  // defined in the module.
-  std::unordered_map<uint32_t, std::string> name_for_id_;
-  // The set of names that have a mapping in name_for_id_;
-  std::unordered_set<std::string> used_names_;
+  // The module to name, parsed once by the first call to NameForId.  The
+  // copy of the context has no message consumer, since the parse ignores
+  // errors.
+  const spv_context_t context_;
+  const uint32_t* const code_;
+  const size_t word_count_;
+  std::once_flag parsed_;
+
+  // Whether every defined Id gets an entry in name_for_id_.  Most Ids in an
+  // optimized module are simply named by their number, so by default those
+  // are only marked in number_named_.  This is only exact when no other Id
+  // claims a name made of digits, otherwise the module is parsed again with
+  // this set.
+  bool name_all_ids_ = false;
+  // Set if a name made of digits was suggested while !name_all_ids_.
+  bool saw_number_name_ = false;
+
+  // Maps an id to its friendly name.  Unless name_all_ids_, Ids named by their
+  // number are missing.
+  std::unordered_map<uint32_t, std::string_view> name_for_id_;
+  // The set of names that have a mapping in name_for_id_.
+  std::unordered_set<std::string_view> used_names_;
+  // The Ids below the bound named by their number, and the others, which only
+  // occur in invalid modules.
+  std::vector<bool> number_named_;
+  std::unordered_set<uint32_t> number_named_out_of_bound_;
+
+  // The storage of the names, in blocks which are never reallocated.
+  std::vector<std::unique_ptr<char[]>> arena_;
+  char* arena_next_ = nullptr;
+  size_t arena_left_ = 0;
+  // Scratch space to build a name.
+  std::string name_buffer_;
+
   // The assembly grammar for the current context.
   const AssemblyGrammar grammar_;
 };
@@ -280,6 +280,22 @@ bool AggressiveDCEPass::AggressiveDCE(Function* func) {
   return KillDeadInstructions(func, structured_order);
 }
 
+void AggressiveDCEPass::MarkFunctionAsLive(Function* func) {
+  live_local_vars_.clear();
+  func->ForEachInst(
+      [this](Instruction* inst) { live_insts_.Set(inst->unique_id()); });
+  // The labels, branches and stores that |MarkBlockAsLive| and |ProcessLoad|
+  // would add are in |func|, and so already live.  Only the instructions
+  // outside of the function can be added to the work list here.
+  func->ForEachInst([this, func](Instruction* inst) {
+    AddOperandsToWorkList(inst);
+    MarkLoadedVariablesAsLive(func, inst);
+    AddDecorationsToWorkList(inst);
+    AddDebugInstructionsToWorkList(inst);
+  });
+  ProcessWorkList(func);
+}
+
 bool AggressiveDCEPass::KillDeadInstructions(
     const Function* func, std::list<BasicBlock*>& structured_order) {
   bool modified = false;
@@ -338,8 +354,8 @@ bool AggressiveDCEPass::KillDeadInstructions(
 
 void AggressiveDCEPass::ProcessWorkList(Function* func) {
   while (!worklist_.empty()) {
-    Instruction* live_inst = worklist_.front();
-    worklist_.pop();
+    Instruction* live_inst = worklist_.back();
+    worklist_.pop_back();
     AddOperandsToWorkList(live_inst);
     MarkBlockAsLive(live_inst);
     MarkLoadedVariablesAsLive(func, live_inst);
@@ -715,8 +731,27 @@ Pass::Status AggressiveDCEPass::ProcessImpl() {
   // will become dead if all function call to them are removed.  These dead
   // function will still be in the module after this pass.  We expect this to be
   // rare.
+  //
+  // The live instructions of a function only depend on the function itself.
+  // If this pass already found every instruction of a function live, and the
+  // function has not changed since, they are all still live.  Such functions
+  // only need the module-level instructions they use to be marked as live.
+  // The result is shared by every instance of the pass in the pipeline that
+  // has the same parameters.  Any change to the function, including one made
+  // directly through the def-use manager, makes it be processed again.
+  const std::string pass_key = CacheKey();
+  std::unordered_set<const Function*> skipped_functions;
+  std::unordered_set<const Function*> unchanged_functions;
   for (Function& fp : *context()->module()) {
-    modified |= AggressiveDCE(&fp);
+    if (!fp.IsDeclaration() &&
+        context()->IsFunctionUnchangedSinceLastRun(pass_key, fp)) {
+      MarkFunctionAsLive(&fp);
+      skipped_functions.insert(&fp);
+    } else if (AggressiveDCE(&fp)) {
+      modified = true;
+    } else {
+      unchanged_functions.insert(&fp);
+    }
   }
 
   // If the decoration manager is kept live then the context will try to keep it
@@ -742,9 +777,15 @@ Pass::Status AggressiveDCEPass::ProcessImpl() {
     context()->KillInst(inst);
   }
 
-  // Cleanup all CFG including all unreachable blocks.
+  // Cleanup all CFG including all unreachable blocks.  The skipped functions
+  // were already clean.
   for (Function& fp : *context()->module()) {
-    modified |= CFGCleanup(&fp);
+    if (skipped_functions.count(&fp)) continue;
+    if (CFGCleanup(&fp)) {
+      modified = true;
+    } else if (unchanged_functions.count(&fp)) {
+      context()->RecordFunctionUnchangedByRun(pass_key, &fp);
+    }
   }
 
   return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
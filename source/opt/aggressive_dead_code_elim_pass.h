@@ -20,7 +20,6 @@
 #include <algorithm>
 #include <list>
 #include <map>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -50,6 +49,10 @@ class AggressiveDCEPass : public MemPass {
         remove_outputs_(remove_outputs) {}
 
   const char* name() const override { return "eliminate-dead-code-aggressive"; }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " + std::to_string(preserve_interface_) +
+           " " + std::to_string(remove_outputs_);
+  }
   Status Process() override;
 
   IRContext::Analysis GetPreservedAnalyses() override {
@@ -91,7 +94,7 @@ class AggressiveDCEPass : public MemPass {
   // Add |inst| to worklist_ and live_insts_.
   void AddToWorklist(Instruction* inst) {
     if (!live_insts_.Set(inst->unique_id())) {
-      worklist_.push(inst);
+      worklist_.push_back(inst);
     }
   }
 
@@ -138,6 +141,12 @@ class AggressiveDCEPass : public MemPass {
   // TODO(): Remove useless control constructs.
   bool AggressiveDCE(Function* func);
 
+  // Marks every instruction in |func| as live, and the module-level
+  // instructions they depend on.  This gives the same result as
+  // |AggressiveDCE| on a function in which every instruction is live, without
+  // looking at its control flow.
+  void MarkFunctionAsLive(Function* func);
+
   Pass::Status ProcessImpl();
 
   // Adds instructions which must be kept because of they have side-effects
@@ -242,8 +251,9 @@ class AggressiveDCEPass : public MemPass {
   // if it might have a side effect, either directly or indirectly.
   // If we don't know, then add it to this list.  Instructions are
   // removed from this list as the algorithm traces side effects,
-  // building up the live instructions set |live_insts_|.
-  std::queue<Instruction*> worklist_;
+  // building up the live instructions set |live_insts_|.  The order in which
+  // they are removed does not change the result, so it is used as a stack.
+  std::vector<Instruction*> worklist_;
 
   // Live Instructions
   utils::BitVector live_insts_;
@@ -31,6 +31,8 @@ class AnalyzeLiveInputPass : public Pass {
       : live_locs_(live_locs), live_builtins_(live_builtins) {}
 
   const char* name() const override { return "analyze-live-input"; }
+  // The result is written to the sets passed to the constructor.
+  std::string CacheKey() const override { return ""; }
   Status Process() override;
 
   // Return the mask of preserved Analyses.
@@ -37,10 +37,20 @@ constexpr uint32_t kVaryingSSAId = std::numeric_limits<uint32_t>::max();
 
 bool CCPPass::IsVaryingValue(uint32_t id) const { return id == kVaryingSSAId; }
 
+void CCPPass::SetValue(uint32_t id, uint32_t value) {
+  if (id >= values_.size()) {
+    values_.resize(std::max<size_t>(id + 1, values_.size() * 2), 0);
+  }
+  if (values_[id] == 0 && !IsVaryingValue(value) && id != value) {
+    ids_to_replace_.push_back(id);
+  }
+  values_[id] = value;
+}
+
 SSAPropagator::PropStatus CCPPass::MarkInstructionVarying(Instruction* instr) {
   assert(instr->result_id() != 0 &&
          "Instructions with no result cannot be marked varying.");
-  values_[instr->result_id()] = kVaryingSSAId;
+  SetValue(instr->result_id(), kVaryingSSAId);
   return SSAPropagator::kVarying;
 }
 
@@ -55,20 +65,19 @@ SSAPropagator::PropStatus CCPPass::VisitPhi(Instruction* phi) {
       // Ignore arguments coming through non-executable edges.
       continue;
     }
-    uint32_t phi_arg_id = phi->GetSingleWordOperand(i);
-    auto it = values_.find(phi_arg_id);
-    if (it != values_.end()) {
+    uint32_t phi_arg_val = GetValue(phi->GetSingleWordOperand(i));
+    if (phi_arg_val != 0) {
       // We found an argument with a constant value.  Apply the meet operation
       // with the previous arguments.
-      if (it->second == kVaryingSSAId) {
+      if (phi_arg_val == kVaryingSSAId) {
         // The "constant" value is actually a placeholder for varying. Return
         // varying for this phi.
         return MarkInstructionVarying(phi);
       } else if (meet_val_id == 0) {
         // This is the first argument we find.  Initialize the result to its
         // constant value id.
-        meet_val_id = it->second;
-      } else if (it->second == meet_val_id) {
+        meet_val_id = phi_arg_val;
+      } else if (phi_arg_val == meet_val_id) {
         // The argument is the same constant value already computed. Continue
         // looking.
         continue;
@@ -94,7 +103,7 @@ SSAPropagator::PropStatus CCPPass::VisitPhi(Instruction* phi) {
 
   // All the operands have the same constant value represented by |meet_val_id|.
   // Set the Phi's result to that value and declare it interesting.
-  values_[phi->result_id()] = meet_val_id;
+  SetValue(phi->result_id(), meet_val_id);
   return SSAPropagator::kInteresting;
 }
 
@@ -110,12 +119,11 @@ uint32_t CCPPass::ComputeLatticeMeet(Instruction* instr, uint32_t val2) {
   // When two different values meet, the result is always varying because CCP
   // does not allow lateral transitions in the lattice.  This prevents
   // infinite cycles during propagation.
-  auto val1_it = values_.find(instr->result_id());
-  if (val1_it == values_.end()) {
+  uint32_t val1 = GetValue(instr->result_id());
+  if (val1 == 0) {
     return val2;
   }
 
-  uint32_t val1 = val1_it->second;
   if (IsVaryingValue(val1)) {
     return val1;
   } else if (IsVaryingValue(val2)) {
@@ -133,14 +141,13 @@ SSAPropagator::PropStatus CCPPass::VisitAssignment(Instruction* instr) {
   // If this is a copy operation, and the RHS is a known constant, assign its
   // value to the LHS.
   if (instr->opcode() == spv::Op::OpCopyObject) {
-    uint32_t rhs_id = instr->GetSingleWordInOperand(0);
-    auto it = values_.find(rhs_id);
-    if (it != values_.end()) {
-      if (IsVaryingValue(it->second)) {
+    uint32_t rhs_val = GetValue(instr->GetSingleWordInOperand(0));
+    if (rhs_val != 0) {
+      if (IsVaryingValue(rhs_val)) {
         return MarkInstructionVarying(instr);
       } else {
-        uint32_t new_val = ComputeLatticeMeet(instr, it->second);
-        values_[instr->result_id()] = new_val;
+        uint32_t new_val = ComputeLatticeMeet(instr, rhs_val);
+        SetValue(instr->result_id(), new_val);
         return IsVaryingValue(new_val) ? SSAPropagator::kVarying
                                        : SSAPropagator::kInteresting;
       }
@@ -155,11 +162,11 @@ SSAPropagator::PropStatus CCPPass::VisitAssignment(Instruction* instr) {
 
   // See if the RHS of the assignment folds into a constant value.
   auto map_func = [this](uint32_t id) {
-    auto it = values_.find(id);
-    if (it == values_.end() || IsVaryingValue(it->second)) {
+    uint32_t val = GetValue(id);
+    if (val == 0 || IsVaryingValue(val)) {
       return id;
     }
-    return it->second;
+    return val;
   };
   Instruction* folded_inst =
       context()->get_instruction_folder().FoldInstructionToConstant(instr,
@@ -172,27 +179,22 @@ SSAPropagator::PropStatus CCPPass::VisitAssignment(Instruction* instr) {
             IsSpecConstantInst(folded_inst->opcode())) &&
            "CCP is only interested in constant values.");
     uint32_t new_val = ComputeLatticeMeet(instr, folded_inst->result_id());
-    values_[instr->result_id()] = new_val;
+    SetValue(instr->result_id(), new_val);
     return IsVaryingValue(new_val) ? SSAPropagator::kVarying
                                    : SSAPropagator::kInteresting;
   }
 
   // Conservatively mark this instruction as varying if any input id is varying.
   if (!instr->WhileEachInId([this](uint32_t* op_id) {
-        auto iter = values_.find(*op_id);
-        if (iter != values_.end() && IsVaryingValue(iter->second)) return false;
-        return true;
+        return !IsVaryingValue(GetValue(*op_id));
       })) {
     return MarkInstructionVarying(instr);
   }
 
   // If not, see if there is a least one unknown operand to the instruction.  If
   // so, we might be able to fold it later.
-  if (!instr->WhileEachInId([this](uint32_t* op_id) {
-        auto it = values_.find(*op_id);
-        if (it == values_.end()) return false;
-        return true;
-      })) {
+  if (!instr->WhileEachInId(
+          [this](uint32_t* op_id) { return GetValue(*op_id) != 0; })) {
     return SSAPropagator::kNotInteresting;
   }
 
@@ -214,16 +216,14 @@ SSAPropagator::PropStatus CCPPass::VisitBranch(Instruction* instr,
     // For a conditional branch, determine whether the predicate selector has a
     // known value in |values_|.  If it does, set the destination block
     // according to the selector's boolean value.
-    uint32_t pred_id = instr->GetSingleWordOperand(0);
-    auto it = values_.find(pred_id);
-    if (it == values_.end() || IsVaryingValue(it->second)) {
+    uint32_t pred_val_id = GetValue(instr->GetSingleWordOperand(0));
+    if (pred_val_id == 0 || IsVaryingValue(pred_val_id)) {
       // The predicate has an unknown value, either branch could be taken.
       return SSAPropagator::kVarying;
     }
 
     // Get the constant value for the predicate selector from the value table.
     // Use it to decide which branch will be taken.
-    uint32_t pred_val_id = it->second;
     const analysis::Constant* c = const_mgr_->FindDeclaredConstant(pred_val_id);
     assert(c && "Expected to find a constant declaration for a known value.");
     // Undef values should have returned as varying above.
@@ -245,16 +245,14 @@ SSAPropagator::PropStatus CCPPass::VisitBranch(Instruction* instr,
       // Add support for wider constants.
       return SSAPropagator::kVarying;
     }
-    uint32_t select_id = instr->GetSingleWordOperand(0);
-    auto it = values_.find(select_id);
-    if (it == values_.end() || IsVaryingValue(it->second)) {
+    uint32_t select_val_id = GetValue(instr->GetSingleWordOperand(0));
+    if (select_val_id == 0 || IsVaryingValue(select_val_id)) {
       // The selector has an unknown value, any of the branches could be taken.
       return SSAPropagator::kVarying;
     }
 
     // Get the constant value for the selector from the value table. Use it to
     // decide which branch will be taken.
-    uint32_t select_val_id = it->second;
     const analysis::Constant* c =
         const_mgr_->FindDeclaredConstant(select_val_id);
     assert(c && "Expected to find a constant declaration for a known value.");
@@ -308,14 +306,16 @@ bool CCPPass::ReplaceValues() {
   // https://github.com/KhronosGroup/SPIRV-Tools/issues/3991 for details.
   bool changed_ir = (context()->module()->IdBound() > original_id_bound_);
 
-  for (const auto& it : values_) {
-    uint32_t id = it.first;
-    uint32_t cst_id = it.second;
-    if (!IsVaryingValue(cst_id) && id != cst_id) {
+  // Only the ids that received a constant value since the last replacement
+  // need to be looked at.  Their value may have become varying since.
+  for (uint32_t id : ids_to_replace_) {
+    uint32_t cst_id = values_[id];
+    if (!IsVaryingValue(cst_id)) {
       context()->KillNamesAndDecorates(id);
       changed_ir |= context()->ReplaceAllUsesWith(id, cst_id);
     }
   }
+  ids_to_replace_.clear();
 
   return changed_ir;
 }
@@ -327,16 +327,9 @@ bool CCPPass::PropagateConstants(Function* fp) {
 
   // Mark function parameters as varying.
   fp->ForEachParam([this](const Instruction* inst) {
-    values_[inst->result_id()] = kVaryingSSAId;
+    SetValue(inst->result_id(), kVaryingSSAId);
   });
 
-  const auto visit_fn = [this](Instruction* instr, BasicBlock** dest_bb) {
-    return VisitInstruction(instr, dest_bb);
-  };
-
-  propagator_ =
-      std::unique_ptr<SSAPropagator>(new SSAPropagator(context(), visit_fn));
-
   if (propagator_->Run(fp)) {
     return ReplaceValues();
   }
@@ -346,6 +339,8 @@ bool CCPPass::PropagateConstants(Function* fp) {
 
 void CCPPass::Initialize() {
   const_mgr_ = context()->get_constant_mgr();
+  values_.assign(context()->module()->IdBound(), 0);
+  ids_to_replace_.clear();
 
   // Populate the constant table with values from constant declarations in the
   // module.  The values of each OpConstant declaration is the identity
@@ -354,13 +349,21 @@ void CCPPass::Initialize() {
     // Record compile time constant ids. Treat all other global values as
     // varying.
     if (inst.IsConstant()) {
-      values_[inst.result_id()] = inst.result_id();
+      SetValue(inst.result_id(), inst.result_id());
     } else {
-      values_[inst.result_id()] = kVaryingSSAId;
+      SetValue(inst.result_id(), kVaryingSSAId);
     }
   }
 
   original_id_bound_ = context()->module()->IdBound();
+
+  // The same propagator is used for every function, so that its tables are
+  // only allocated once.
+  const auto visit_fn = [this](Instruction* instr, BasicBlock** dest_bb) {
+    return VisitInstruction(instr, dest_bb);
+  };
+  propagator_ =
+      std::unique_ptr<SSAPropagator>(new SSAPropagator(context(), visit_fn));
 }
 
 Pass::Status CCPPass::Process() {
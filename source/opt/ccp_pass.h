@@ -16,7 +16,7 @@
 #define SOURCE_OPT_CCP_PASS_H_
 
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
 #include "source/opt/constants.h"
 #include "source/opt/function.h"
@@ -88,6 +88,14 @@ class CCPPass : public MemPass {
   // value.
   bool IsVaryingValue(uint32_t id) const;
 
+  // Returns the value of |id| in |values_|, or 0 if |id| has no value yet.
+  uint32_t GetValue(uint32_t id) const {
+    return id < values_.size() ? values_[id] : 0;
+  }
+
+  // Records |value| as the value of |id| in |values_|.
+  void SetValue(uint32_t id, uint32_t value);
+
   // Constant manager for the parent IR context.  Used to record new constants
   // generated during propagation.
   analysis::ConstantManager* const_mgr_;
@@ -108,16 +116,21 @@ class CCPPass : public MemPass {
   // infinite cycles during propagation.
   uint32_t ComputeLatticeMeet(Instruction* instr, uint32_t val2);
 
-  // Constant value table.  Each entry <id, const_decl_id> in this map
-  // represents the compile-time constant value for |id| as declared by
-  // |const_decl_id|. Each |const_decl_id| in this table is an OpConstant
-  // declaration for the current module.
+  // Constant value table, indexed by id.  A non-zero entry |const_decl_id|
+  // at index |id| represents the compile-time constant value for |id| as
+  // declared by |const_decl_id|. Each |const_decl_id| in this table is an
+  // OpConstant declaration for the current module.  Ids without a value yet
+  // have the entry 0.
   //
   // Additionally, this table keeps track of SSA IDs with varying values. If an
-  // SSA ID is found to have a varying value, it will have an entry in this
-  // table that maps to the special SSA id kVaryingSSAId.  These values are
-  // never replaced in the IR, they are used by CCP during propagation.
-  std::unordered_map<uint32_t, uint32_t> values_;
+  // SSA ID is found to have a varying value, its entry is the special SSA id
+  // kVaryingSSAId.  These values are never replaced in the IR, they are used
+  // by CCP during propagation.
+  std::vector<uint32_t> values_;
+
+  // Ids that received a constant value other than themselves since values
+  // were last replaced in the IR.
+  std::vector<uint32_t> ids_to_replace_;
 
   // Propagator engine used.
   std::unique_ptr<SSAPropagator> propagator_;
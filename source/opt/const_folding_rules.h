@@ -15,10 +15,11 @@
 #ifndef SOURCE_OPT_CONST_FOLDING_RULES_H_
 #define SOURCE_OPT_CONST_FOLDING_RULES_H_
 
-#include <unordered_map>
+#include <map>
 #include <vector>
 
 #include "source/opt/constants.h"
+#include "source/opt/opcode_rule_table.h"
 
 namespace spvtools {
 namespace opt {
@@ -74,6 +75,7 @@ class ConstantFoldingRules {
   struct Value {
     std::vector<ConstantFoldingRule> value;
     void push_back(ConstantFoldingRule rule) { value.push_back(rule); }
+    bool empty() const { return value.empty(); }
   };
 
  public:
@@ -82,16 +84,18 @@ class ConstantFoldingRules {
 
   // Returns true if there is at least 1 folding rule for |opcode|.
   bool HasFoldingRule(const Instruction* inst) const {
-    return !GetRulesForInstruction(inst).empty();
+    if (inst->opcode() != spv::Op::OpExtInst) {
+      return rules_.HasRules(inst->opcode());
+    }
+    return !ext_rules_.empty() && !GetRulesForInstruction(inst).empty();
   }
 
   // Returns true if there is at least 1 folding rule for |inst|.
   const std::vector<ConstantFoldingRule>& GetRulesForInstruction(
       const Instruction* inst) const {
     if (inst->opcode() != spv::Op::OpExtInst) {
-      auto it = rules_.find(inst->opcode());
-      if (it != rules_.end()) {
-        return it->second.value;
+      if (const Value* rules = rules_.Find(inst->opcode())) {
+        return rules->value;
       }
     } else {
       uint32_t ext_inst_id = inst->GetSingleWordInOperand(0);
@@ -108,15 +112,9 @@ class ConstantFoldingRules {
   virtual void AddFoldingRules();
 
  protected:
-  struct hasher {
-    size_t operator()(const spv::Op& op) const noexcept {
-      return std::hash<uint32_t>()(uint32_t(op));
-    }
-  };
-
   // |rules[opcode]| is the set of rules that can be applied to instructions
   // with |opcode| as the opcode.
-  std::unordered_map<spv::Op, Value, hasher> rules_;
+  OpcodeRuleTable<Value> rules_;
 
   // The folding rules for extended instructions.
   std::map<Key, Value> ext_rules_;
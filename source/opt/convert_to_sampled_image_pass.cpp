@@ -14,8 +14,11 @@
 
 #include "source/opt/convert_to_sampled_image_pass.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "source/opt/ir_builder.h"
 #include "source/util/make_unique.h"
@@ -166,6 +169,20 @@ bool ConvertToSampledImagePass::CollectResourcesToConvert(
   return true;
 }
 
+std::string ConvertToSampledImagePass::CacheKey() const {
+  // Sorted, so that the key does not depend on the order of the hash set.
+  std::vector<std::pair<uint32_t, uint32_t>> pairs;
+  for (const auto& pair : descriptor_set_binding_pairs_) {
+    pairs.emplace_back(pair.descriptor_set, pair.binding);
+  }
+  std::sort(pairs.begin(), pairs.end());
+  std::string key = name();
+  for (const auto& pair : pairs) {
+    key += " " + std::to_string(pair.first) + ":" + std::to_string(pair.second);
+  }
+  return key;
+}
+
 Pass::Status ConvertToSampledImagePass::Process() {
   Status status = Status::SuccessWithoutChange;
 
@@ -60,6 +60,7 @@ class ConvertToSampledImagePass : public Pass {
                                       descriptor_set_binding_pairs.end()) {}
 
   const char* name() const override { return "convert-to-sampled-image"; }
+  std::string CacheKey() const override;
   Status Process() override;
 
   // Parses the given null-terminated C string to get a vector of descriptor set
@@ -476,8 +476,16 @@ Pass::Status DeadBranchElimPass::Process() {
     if (ai.opcode() == spv::Op::OpGroupDecorate)
       return Status::SuccessWithoutChange;
   // Process all entry point functions
+  // Functions left unchanged by an earlier run of this pass are skipped.
   ProcessFunction pfn = [this](Function* fp) {
-    return EliminateDeadBranches(fp);
+    if (context()->IsFunctionUnchangedSinceLastRun(name(), *fp)) {
+      return false;
+    }
+    bool modified = EliminateDeadBranches(fp);
+    if (!modified) {
+      context()->RecordFunctionUnchangedByRun(name(), fp);
+    }
+    return modified;
   };
   bool modified = context()->ProcessReachableCallTree(pfn);
   if (modified) FixBlockOrder();
@@ -19,6 +19,7 @@ namespace opt {
 namespace analysis {
 
 void DefUseManager::AnalyzeInstDef(Instruction* inst) {
+  ScopedChange change(this, inst, Change::kAdded);
   const uint32_t def_id = inst->result_id();
   if (def_id != 0) {
     auto iter = id_to_def_.find(def_id);
@@ -34,6 +35,7 @@ void DefUseManager::AnalyzeInstDef(Instruction* inst) {
 }
 
 void DefUseManager::AnalyzeInstUse(Instruction* inst) {
+  ScopedChange change(this, inst, Change::kUsesChanged);
   // Create entry for the given instruction. Note that the instruction may
   // not have any in-operands. In such cases, we still need a entry for those
   // instructions so this manager knows it has seen the instruction later.
@@ -64,6 +66,7 @@ void DefUseManager::AnalyzeInstUse(Instruction* inst) {
 }
 
 void DefUseManager::AnalyzeInstDefUse(Instruction* inst) {
+  ScopedChange change(this, inst, Change::kAdded);
   AnalyzeInstDef(inst);
   AnalyzeInstUse(inst);
   // Analyze lines last otherwise they will be cleared when inst is
@@ -72,6 +75,7 @@ void DefUseManager::AnalyzeInstDefUse(Instruction* inst) {
 }
 
 void DefUseManager::UpdateDefUse(Instruction* inst) {
+  ScopedChange change(this, inst, Change::kAdded);
   const uint32_t def_id = inst->result_id();
   if (def_id != 0) {
     auto iter = id_to_def_.find(def_id);
@@ -230,6 +234,7 @@ void DefUseManager::AnalyzeDefUse(Module* module) {
 }
 
 void DefUseManager::ClearInst(Instruction* inst) {
+  ScopedChange change(this, inst, Change::kKilled);
   auto iter = inst_to_used_ids_.find(inst);
   if (iter != inst_to_used_ids_.end()) {
     EraseUseRecordsOfOperandIds(inst);
@@ -247,6 +252,7 @@ void DefUseManager::ClearInst(Instruction* inst) {
 }
 
 void DefUseManager::EraseUseRecordsOfOperandIds(const Instruction* inst) {
+  ScopedChange change(this, inst, Change::kUsesChanged);
   // Go through all ids used by this instruction, remove this instruction's
   // uses of them.
   auto iter = inst_to_used_ids_.find(inst);
@@ -15,8 +15,10 @@
 #ifndef SOURCE_OPT_DEF_USE_MANAGER_H_
 #define SOURCE_OPT_DEF_USE_MANAGER_H_
 
+#include <functional>
 #include <set>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "source/opt/instruction.h"
@@ -76,6 +78,17 @@ class DefUseManager {
  public:
   using IdToDefMap = std::unordered_map<uint32_t, Instruction*>;
 
+  // How an instruction reported to the change observer was changed.
+  enum class Change {
+    // The instruction was added, or may have been added, to the module.
+    kAdded,
+    // The operands of the instruction changed.
+    kUsesChanged,
+    // The instruction is about to be removed from the module.
+    kKilled,
+  };
+  using ChangeObserver = std::function<void(Instruction*, Change)>;
+
   // Constructs a def-use manager from the given |module|. All internal messages
   // will be communicated to the outside via the given message |consumer|. This
   // instance only keeps a reference to the |consumer|, so the |consumer| should
@@ -87,6 +100,14 @@ class DefUseManager {
   DefUseManager& operator=(const DefUseManager&) = delete;
   DefUseManager& operator=(DefUseManager&&) = delete;
 
+  // Makes the manager call |observer| before it records the changes to an
+  // instruction that is analyzed, updated or cleared.  The records changed as
+  // a consequence, such as those of an instruction redefining the same result
+  // id, are part of the same change and are not reported separately.
+  void SetChangeObserver(ChangeObserver observer) {
+    observer_ = std::move(observer);
+  }
+
   // Analyzes the defs in the given |inst|.
   void AnalyzeInstDef(Instruction* inst);
 
@@ -193,6 +214,28 @@ class DefUseManager {
   void UpdateDefUse(Instruction* inst);
 
  private:
+  // Reports a change to |observer_| when created, unless another change is
+  // being reported already.  Until it is destroyed, the changes it makes
+  // through other methods are not reported on their own.
+  class ScopedChange {
+   public:
+    ScopedChange(DefUseManager* manager, const Instruction* inst,
+                 Change change)
+        : manager_(manager->reporting_change_ ? nullptr : manager) {
+      if (manager_ == nullptr) return;
+      manager_->reporting_change_ = true;
+      if (manager_->observer_) {
+        manager_->observer_(const_cast<Instruction*>(inst), change);
+      }
+    }
+    ~ScopedChange() {
+      if (manager_ != nullptr) manager_->reporting_change_ = false;
+    }
+
+   private:
+    DefUseManager* manager_;
+  };
+
   using IdToUsersMap = std::set<UserEntry, UserEntryLess>;
   using InstToUsedIdsMap =
       std::unordered_map<const Instruction*, std::vector<uint32_t>>;
@@ -221,6 +264,11 @@ class DefUseManager {
   IdToUsersMap id_to_users_;  // Mapping from ids to their users
   // Mapping from instructions to the ids used in the instruction.
   InstToUsedIdsMap inst_to_used_ids_;
+
+  // See SetChangeObserver.
+  ChangeObserver observer_;
+  // True while a change is reported.  See ScopedChange.
+  bool reporting_change_ = false;
 };
 
 }  // namespace analysis
@@ -35,6 +35,11 @@ class EliminateDeadIOComponentsPass : public Pass {
   const char* name() const override {
     return "eliminate-dead-input-components";
   }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " +
+           std::to_string(static_cast<uint32_t>(elim_sclass_)) + " " +
+           std::to_string(safe_mode_);
+  }
   Status Process() override;
 
   // Return the mask of preserved Analyses.
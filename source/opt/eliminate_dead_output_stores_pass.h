@@ -34,6 +34,9 @@ class EliminateDeadOutputStoresPass : public Pass {
       : live_locs_(live_locs), live_builtins_(live_builtins) {}
 
   const char* name() const override { return "eliminate-dead-output-stores"; }
+  // The result depends on the sets passed to the constructor, which can still
+  // be filled in when the pass runs.
+  std::string CacheKey() const override { return ""; }
   Status Process() override;
 
   // Return the mask of preserved Analyses.
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/fixed_point_pass_group.h"
+
+#include <chrono>
+
+namespace spvtools {
+namespace opt {
+
+Pass::Status FixedPointPassGroup::RunToFixedPoint(const PassRunner& run_pass) {
+  Status status = Status::SuccessWithoutChange;
+  num_invocations_ = 0;
+  num_rounds_ = 0;
+  reached_fixed_point_ = false;
+  pass_invocations_.assign(factories_.size(), 0);
+  pass_seconds_.assign(factories_.size(), 0.0);
+
+  // The number of passes that have run without a change since the last pass
+  // that changed the module.  Once every pass has done so, running any of
+  // them again would not change anything either.
+  size_t unchanged_in_a_row = 0;
+  while (num_rounds_ < max_rounds_) {
+    ++num_rounds_;
+    for (size_t i = 0; i < factories_.size(); ++i) {
+      if (unchanged_in_a_row == factories_.size()) {
+        break;
+      }
+      std::unique_ptr<Pass> pass = factories_[i]();
+      pass->SetMessageConsumer(consumer());
+      ++num_invocations_;
+      ++pass_invocations_[i];
+      const auto start = std::chrono::steady_clock::now();
+      const Status one_status = run_pass(pass.get());
+      pass_seconds_[i] += std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+      if (one_status == Status::Failure) {
+        return Status::Failure;
+      }
+      if (one_status == Status::SuccessWithChange) {
+        status = Status::SuccessWithChange;
+        unchanged_in_a_row = 0;
+      } else {
+        ++unchanged_in_a_row;
+      }
+    }
+    if (unchanged_in_a_row == factories_.size()) {
+      reached_fixed_point_ = true;
+      break;
+    }
+  }
+
+  return status;
+}
+
+double FixedPointPassGroup::EstimatedSecondsSaved() const {
+  double saved = 0.0;
+  for (size_t i = 0; i < pass_invocations_.size(); ++i) {
+    if (pass_invocations_[i] == 0) continue;
+    saved += (num_rounds_ - pass_invocations_[i]) *
+             (pass_seconds_[i] / pass_invocations_[i]);
+  }
+  return saved;
+}
+
+Pass::Status FixedPointPassGroup::Process() {
+  return RunToFixedPoint([this](Pass* pass) {
+    return pass->Run(context());
+  });
+}
+
+}  // namespace opt
+}  // namespace spvtools
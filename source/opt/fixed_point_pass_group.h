@@ -0,0 +1,104 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_FIXED_POINT_PASS_GROUP_H_
+#define SOURCE_OPT_FIXED_POINT_PASS_GROUP_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// A group of passes that is run repeatedly until it reaches a fixed point.
+//
+// The passes are run in order, starting over at the first pass after the
+// last one, until every pass in the group has run once in a row without
+// changing the module, or until |max_rounds| rounds have started.  A pass that
+// reports no change is not run again until another pass changes the module,
+// so the last round stops as soon as it gets back to the pass that made the
+// last change.
+//
+// Passes can only run once, so the group holds a factory for each pass and
+// creates a fresh instance every time it runs one.  Passes that use
+// IRContext::IsFunctionUnchangedSinceLastRun also skip the functions that did
+// not change since their previous instance ran.
+class FixedPointPassGroup : public Pass {
+ public:
+  using PassFactory = std::function<std::unique_ptr<Pass>()>;
+  // Runs |pass| on the module and returns its status.
+  using PassRunner = std::function<Status(Pass* pass)>;
+
+  FixedPointPassGroup(std::vector<PassFactory> factories, uint32_t max_rounds)
+      : factories_(std::move(factories)), max_rounds_(max_rounds) {}
+
+  const char* name() const override { return "fixed-point-group"; }
+
+  // The passes in the group invalidate the analyses they do not preserve
+  // themselves.
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::Analysis(IRContext::kAnalysisEnd - 1);
+  }
+
+  FixedPointPassGroup* AsFixedPointPassGroup() override { return this; }
+
+  // Runs the group, using |run_pass| to run each pass on the module.  The pass
+  // manager uses this to apply its per-pass instrumentation to the passes in
+  // the group.
+  Status RunToFixedPoint(const PassRunner& run_pass);
+
+  // Returns the number of passes in the group.
+  size_t size() const { return factories_.size(); }
+
+  // Returns the number of pass instances run by the last call to
+  // |RunToFixedPoint|.
+  uint32_t num_invocations() const { return num_invocations_; }
+
+  // Returns the number of rounds started by the last call to
+  // |RunToFixedPoint|.
+  uint32_t num_rounds() const { return num_rounds_; }
+
+  // Returns true if the last call to |RunToFixedPoint| stopped because no
+  // pass could make any further change.
+  bool reached_fixed_point() const { return reached_fixed_point_; }
+
+  // Returns an estimate of the time, in seconds, that the last call to
+  // |RunToFixedPoint| saved compared with running every pass in every round.
+  // Each invocation that was not needed is counted at the average time of the
+  // invocations of the same pass.
+  double EstimatedSecondsSaved() const;
+
+ private:
+  Status Process() override;
+
+  std::vector<PassFactory> factories_;
+  const uint32_t max_rounds_;
+
+  uint32_t num_invocations_ = 0;
+  uint32_t num_rounds_ = 0;
+  bool reached_fixed_point_ = false;
+  // The number of invocations of each pass, and the time they took in
+  // seconds, indexed like |factories_|.
+  std::vector<uint32_t> pass_invocations_;
+  std::vector<double> pass_seconds_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_FIXED_POINT_PASS_GROUP_H_
@@ -186,12 +186,19 @@ bool InstructionFolder::FoldInstructionInternal(Instruction* inst) const {
     return true;
   }
 
+  // Most instructions have no folding rules.  Avoid collecting the operand
+  // constants for them.
+  const FoldingRules::FoldingRuleSet& rules =
+      GetFoldingRules().GetRulesForInstruction(inst);
+  if (rules.empty()) {
+    return false;
+  }
+
   analysis::ConstantManager* const_manager = context_->get_constant_mgr();
   std::vector<const analysis::Constant*> constants =
       const_manager->GetOperandConstants(inst);
 
-  for (const FoldingRule& rule :
-       GetFoldingRules().GetRulesForInstruction(inst)) {
+  for (const FoldingRule& rule : rules) {
     if (rule(context_, inst, constants)) {
       return true;
     }
@@ -595,7 +602,8 @@ Instruction* InstructionFolder::FoldInstructionToConstant(
   });
 
   const analysis::Constant* folded_const = nullptr;
-  for (auto rule : GetConstantFoldingRules().GetRulesForInstruction(inst)) {
+  for (const ConstantFoldingRule& rule :
+       GetConstantFoldingRules().GetRulesForInstruction(inst)) {
     folded_const = rule(context_, inst, constants);
     if (folded_const != nullptr) {
       Instruction* const_inst =
@@ -16,10 +16,11 @@
 #define SOURCE_OPT_FOLDING_RULES_H_
 
 #include <cstdint>
-#include <unordered_map>
+#include <map>
 #include <vector>
 
 #include "source/opt/constants.h"
+#include "source/opt/opcode_rule_table.h"
 
 namespace spvtools {
 namespace opt {
@@ -63,11 +64,10 @@ class FoldingRules {
   explicit FoldingRules(IRContext* ctx) : context_(ctx) {}
   virtual ~FoldingRules() = default;
 
-  const FoldingRuleSet& GetRulesForInstruction(Instruction* inst) const {
+  const FoldingRuleSet& GetRulesForInstruction(const Instruction* inst) const {
     if (inst->opcode() != spv::Op::OpExtInst) {
-      auto it = rules_.find(inst->opcode());
-      if (it != rules_.end()) {
-        return it->second;
+      if (const FoldingRuleSet* rules = rules_.Find(inst->opcode())) {
+        return *rules;
       }
     } else {
       uint32_t ext_inst_id = inst->GetSingleWordInOperand(0);
@@ -80,20 +80,23 @@ class FoldingRules {
     return empty_vector_;
   }
 
+  // Returns true if there is at least one folding rule for |inst|.  This is
+  // cheap enough to be used to skip instructions before doing any other work.
+  bool HasFoldingRule(const Instruction* inst) const {
+    if (inst->opcode() != spv::Op::OpExtInst) {
+      return rules_.HasRules(inst->opcode());
+    }
+    return !ext_rules_.empty() && !GetRulesForInstruction(inst).empty();
+  }
+
   IRContext* context() { return context_; }
 
   // Adds the folding rules for the object.
   virtual void AddFoldingRules();
 
  protected:
-  struct hasher {
-    size_t operator()(const spv::Op& op) const noexcept {
-      return std::hash<uint32_t>()(uint32_t(op));
-    }
-  };
-
-  // The folding rules for core instructions.
-  std::unordered_map<spv::Op, FoldingRuleSet, hasher> rules_;
+  // The folding rules for core instructions, indexed by opcode.
+  OpcodeRuleTable<FoldingRuleSet> rules_;
 
   // The folding rules for extended instructions.
   struct Key {
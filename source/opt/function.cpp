@@ -199,6 +199,7 @@ void Function::ForEachDebugInstructionsInHeader(
 
 BasicBlock* Function::InsertBasicBlockAfter(
     std::unique_ptr<BasicBlock>&& new_block, BasicBlock* position) {
+  MarkStructureModified();
   for (auto bb_iter = begin(); bb_iter != end(); ++bb_iter) {
     if (&*bb_iter == position) {
       new_block->SetParent(this);
@@ -213,6 +214,7 @@ BasicBlock* Function::InsertBasicBlockAfter(
 
 BasicBlock* Function::InsertBasicBlockBefore(
     std::unique_ptr<BasicBlock>&& new_block, BasicBlock* position) {
+  MarkStructureModified();
   for (auto bb_iter = begin(); bb_iter != end(); ++bb_iter) {
     if (&*bb_iter == position) {
       new_block->SetParent(this);
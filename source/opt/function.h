@@ -16,6 +16,7 @@
 #define SOURCE_OPT_FUNCTION_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -88,6 +89,7 @@ class Function {
   using RewriteParamFn = std::function<void(
       std::unique_ptr<Instruction>&&, std::back_insert_iterator<ParamList>&)>;
   void RewriteParams(RewriteParamFn& replacer) {
+    MarkStructureModified();
     ParamList new_params;
     auto appender = std::back_inserter(new_params);
     for (auto& param : params_) {
@@ -161,6 +163,11 @@ class Function {
   bool WhileEachInst(const std::function<bool(const Instruction*)>& f,
                      bool run_on_debug_line_insts = false,
                      bool run_on_non_semantic_insts = false) const;
+  // Runs |f| on the same instructions as ForEachInst with debug line and
+  // non-semantic instructions, but calls |f| directly instead of through a
+  // std::function.  For loops over every instruction of a module.
+  template <typename F>
+  void ForEachInstInlined(F&& f) const;
 
   // Runs the given function |f| on each parameter instruction in this function,
   // in order, and optionally on debug line instructions that might precede
@@ -203,6 +210,19 @@ class Function {
   // Reorders the basic blocks in the function to match the structured order.
   void ReorderBasicBlocksInStructuredOrder();
 
+  // The value of |modification_epoch()| for a function that has changed in a
+  // way the IRContext could not observe, or that was never stamped.
+  static constexpr uint64_t kUnstampedEpoch = ~uint64_t(0);
+
+  // Returns the IRContext modification epoch at which this function was last
+  // seen to change.  See IRContext::IsFunctionUnchangedSinceLastRun.
+  uint64_t modification_epoch() const { return modification_epoch_; }
+  void set_modification_epoch(uint64_t epoch) { modification_epoch_ = epoch; }
+
+  // Records that the list of blocks or parameters of this function changed.
+  // These changes are not seen by the def-use manager.
+  void MarkStructureModified() { modification_epoch_ = kUnstampedEpoch; }
+
  private:
   // Reorders the basic blocks in the function to match the order given by the
   // range |{begin,end}|.  The range must contain every basic block in the
@@ -225,6 +245,8 @@ class Function {
   std::unique_ptr<Instruction> end_inst_;
   // Non-semantic instructions succeeded by this function.
   std::vector<std::unique_ptr<Instruction>> non_semantic_;
+  // The epoch at which this function was last modified.
+  uint64_t modification_epoch_ = kUnstampedEpoch;
 };
 
 // Pretty-prints |func| to |str|. Returns |str|.
@@ -234,6 +256,7 @@ inline Function::Function(std::unique_ptr<Instruction> def_inst)
     : def_inst_(std::move(def_inst)), end_inst_() {}
 
 inline void Function::AddParameter(std::unique_ptr<Instruction> p) {
+  MarkStructureModified();
   params_.emplace_back(std::move(p));
 }
 
@@ -248,17 +271,20 @@ inline void Function::AddBasicBlock(std::unique_ptr<BasicBlock> b) {
 
 inline void Function::AddBasicBlock(std::unique_ptr<BasicBlock> b,
                                     iterator ip) {
+  MarkStructureModified();
   b->SetParent(this);
   ip.InsertBefore(std::move(b));
 }
 
 template <typename T>
 inline void Function::AddBasicBlocks(T src_begin, T src_end, iterator ip) {
+  MarkStructureModified();
   blocks_.insert(ip.Get(), std::make_move_iterator(src_begin),
                  std::make_move_iterator(src_end));
 }
 
 inline void Function::MoveBasicBlockToAfter(uint32_t id, BasicBlock* ip) {
+  MarkStructureModified();
   std::unique_ptr<BasicBlock> block_to_move = std::move(*FindBlock(id).Get());
   blocks_.erase(std::find(std::begin(blocks_), std::end(blocks_), nullptr));
 
@@ -269,6 +295,7 @@ inline void Function::MoveBasicBlockToAfter(uint32_t id, BasicBlock* ip) {
 }
 
 inline void Function::RemoveEmptyBlocks() {
+  MarkStructureModified();
   auto first_empty =
       std::remove_if(std::begin(blocks_), std::end(blocks_),
                      [](const std::unique_ptr<BasicBlock>& bb) -> bool {
@@ -278,6 +305,7 @@ inline void Function::RemoveEmptyBlocks() {
 }
 
 inline void Function::RemoveParameter(uint32_t id) {
+  MarkStructureModified();
   params_.erase(std::remove_if(params_.begin(), params_.end(),
                                [id](const std::unique_ptr<Instruction>& param) {
                                  return param->result_id() == id;
@@ -294,10 +322,28 @@ inline void Function::AddNonSemanticInstruction(
   non_semantic_.emplace_back(std::move(non_semantic));
 }
 
+template <typename F>
+void Function::ForEachInstInlined(F&& f) const {
+  auto run = [&f](const Instruction& inst) {
+    for (const auto& dbg_line : inst.dbg_line_insts()) f(&dbg_line);
+    f(&inst);
+  };
+  if (def_inst_) run(*def_inst_);
+  for (const auto& param : params_) run(*param);
+  for (const auto& di : debug_insts_in_header_) run(di);
+  for (const auto& bb : blocks_) {
+    if (bb->GetLabelInst()) run(*bb->GetLabelInst());
+    for (const auto& inst : *bb) run(inst);
+  }
+  if (end_inst_) run(*end_inst_);
+  for (const auto& non_semantic : non_semantic_) run(*non_semantic);
+}
+
 template <class It>
 void Function::ReorderBasicBlocks(It begin, It end) {
   // Asserts to make sure every node in the function is in new_order.
   assert(ContainsAllBlocksInTheFunction(begin, end));
+  MarkStructureModified();
 
   // We have a pointer to all the elements in order, so we can release all
   // pointers in |block_|, and then create the new unique pointers from |{begin,
@@ -0,0 +1,224 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/inline_cost_model_pass.h"
+
+#include <functional>
+#include <utility>
+
+#include "source/opcode.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+constexpr uint32_t kEntryPointFunctionIdInIdx = 1;
+constexpr uint32_t kFunctionCallFunctionIdInIdx = 0;
+constexpr uint32_t kFunctionCallArgumentInIdx = 1;
+
+// Benefit of inlining a call for each loop the call is nested in.
+constexpr uint32_t kLoopDepthBenefit = 16;
+// Benefit of inlining a call for each constant argument, which later passes
+// can fold into the inlined body.
+constexpr uint32_t kConstantArgumentBenefit = 8;
+// Benefit of inlining a call for each pointer argument. Once the call is
+// gone the pointed-to variable can usually be scalarized and promoted.
+constexpr uint32_t kPointerArgumentBenefit = 32;
+
+uint32_t CalleeId(const Instruction& call) {
+  return call.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+}
+}  // namespace
+
+std::vector<Function*> InlineCostModelPass::BottomUpOrder() {
+  std::vector<uint32_t> root_ids;
+  for (auto& e : get_module()->entry_points()) {
+    root_ids.push_back(e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+  }
+  for (auto& a : get_module()->annotations()) {
+    if (a.opcode() != spv::Op::OpDecorate ||
+        spv::Decoration(a.GetSingleWordInOperand(1)) !=
+            spv::Decoration::LinkageAttributes) {
+      continue;
+    }
+    const uint32_t last_operand = a.NumOperands() - 1;
+    if (spv::LinkageType(a.GetSingleWordOperand(last_operand)) ==
+            spv::LinkageType::Export &&
+        id2function_.count(a.GetSingleWordInOperand(0))) {
+      root_ids.push_back(a.GetSingleWordInOperand(0));
+    }
+  }
+
+  std::vector<Function*> order;
+  std::unordered_set<uint32_t> visited;
+  std::function<void(Function*)> visit = [&](Function* func) {
+    if (!visited.insert(func->result_id()).second) return;
+    func->ForEachInst([&](Instruction* inst) {
+      if (inst->opcode() != spv::Op::OpFunctionCall) return;
+      auto callee = id2function_.find(CalleeId(*inst));
+      if (callee != id2function_.end()) visit(callee->second);
+    });
+    order.push_back(func);
+  };
+  for (uint32_t id : root_ids) {
+    roots_.insert(id);
+    visit(id2function_[id]);
+  }
+  return order;
+}
+
+void InlineCostModelPass::CollectCallSites(
+    const std::vector<Function*>& functions) {
+  uint64_t module_size = 0;
+  for (Function* func : functions) {
+    LoopDescriptor& loops = *context()->GetLoopDescriptor(func);
+    std::unordered_set<uint32_t>& sites = call_sites_[func->result_id()];
+    for (auto& bb : *func) {
+      const Loop* loop = loops[&bb];
+      const uint32_t depth = loop ? uint32_t(loop->GetDepth()) : 0;
+      for (auto& inst : bb) {
+        if (inst.opcode() != spv::Op::OpFunctionCall) continue;
+        sites.insert(inst.result_id());
+        call_benefit_[inst.result_id()] = CallSiteBenefit(inst, depth);
+        ++remaining_calls_[CalleeId(inst)];
+      }
+    }
+    module_size += FunctionSize(*func);
+  }
+  growth_budget_ = int64_t(module_size * growth_budget_percent_ / 100);
+}
+
+uint32_t InlineCostModelPass::FunctionSize(const Function& func) {
+  uint32_t size = 0;
+  for (const auto& bb : func) {
+    for (auto ii = bb.cbegin(); ii != bb.cend(); ++ii) ++size;
+  }
+  return size;
+}
+
+uint32_t InlineCostModelPass::CallSiteBenefit(const Instruction& call,
+                                              uint32_t loop_depth) const {
+  uint32_t benefit = kLoopDepthBenefit * loop_depth;
+
+  analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  for (uint32_t i = kFunctionCallArgumentInIdx; i < call.NumInOperands();
+       ++i) {
+    const Instruction* arg =
+        def_use_mgr->GetDef(call.GetSingleWordInOperand(i));
+    if (spvOpcodeIsConstant(arg->opcode())) {
+      benefit += kConstantArgumentBenefit;
+    } else if (arg->type_id() != 0) {
+      // Untyped pointers are pointers for the type manager too.
+      const analysis::Type* type = type_mgr->GetType(arg->type_id());
+      if (type != nullptr && type->AsPointer() != nullptr) {
+        benefit += kPointerArgumentBenefit;
+      }
+    }
+  }
+  return benefit;
+}
+
+bool InlineCostModelPass::ShouldInline(const Instruction& call) {
+  const uint32_t callee_id = CalleeId(call);
+  const Function* callee = id2function_[callee_id];
+  const uint32_t size = function_size_[callee_id];
+  uint32_t& remaining = remaining_calls_[callee_id];
+
+  // Inlining the last call to a function that is not reachable from outside
+  // the module lets the callee be removed, so the module does not grow.
+  const bool callee_dies = remaining == 1 && roots_.count(callee_id) == 0;
+  const bool always_inline =
+      size <= kDefaultAlwaysInlineSize ||
+      (callee->control_mask() & uint32_t(spv::FunctionControlMask::Inline));
+
+  if (!always_inline && !callee_dies) {
+    const uint32_t benefit = call_benefit_[call.result_id()];
+    const uint32_t cost = size > benefit ? size - benefit : 0;
+    if (cost > inline_threshold_ || int64_t(size) > growth_budget_) {
+      return false;
+    }
+  }
+
+  growth_budget_ -= size;
+  if (--remaining == 0 && roots_.count(callee_id) == 0) {
+    growth_budget_ += size;
+  }
+  // The calls the callee kept are copied into the caller.
+  for (uint32_t kept : kept_callees_[callee_id]) {
+    ++remaining_calls_[kept];
+  }
+  return true;
+}
+
+Pass::Status InlineCostModelPass::InlineCalls(Function* func) {
+  std::unordered_set<uint32_t>& sites = call_sites_[func->result_id()];
+  bool modified = false;
+  // Using block iterators here because of block erasures and insertions.
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    for (auto ii = bi->begin(); ii != bi->end();) {
+      if (ii->opcode() == spv::Op::OpFunctionCall &&
+          sites.erase(ii->result_id()) && IsInlinableFunctionCall(&*ii) &&
+          ShouldInline(*ii)) {
+        // Continue at the beginning of the calling block. The calls copied
+        // from the callee are not call sites of |func| and are skipped.
+        if (!InlineCallAt(func, &bi, &ii)) {
+          return Status::Failure;
+        }
+        modified = true;
+      } else {
+        ++ii;
+      }
+    }
+  }
+
+  if (modified) {
+    FixDebugDeclares(func);
+  }
+
+  // Record what callers of |func| will copy when they inline it.
+  function_size_[func->result_id()] = FunctionSize(*func);
+  std::vector<uint32_t>& kept = kept_callees_[func->result_id()];
+  func->ForEachInst([&kept](Instruction* inst) {
+    if (inst->opcode() == spv::Op::OpFunctionCall) {
+      kept.push_back(CalleeId(*inst));
+    }
+  });
+
+  return (modified ? Status::SuccessWithChange : Status::SuccessWithoutChange);
+}
+
+Pass::Status InlineCostModelPass::Process() {
+  InitializeInline();
+  call_sites_.clear();
+  call_benefit_.clear();
+  remaining_calls_.clear();
+  function_size_.clear();
+  kept_callees_.clear();
+  roots_.clear();
+
+  const std::vector<Function*> functions = BottomUpOrder();
+  CollectCallSites(functions);
+
+  Status status = Status::SuccessWithoutChange;
+  for (Function* func : functions) {
+    status = CombineStatus(status, InlineCalls(func));
+    if (status == Status::Failure) break;
+  }
+  return status;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,111 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INLINE_COST_MODEL_PASS_H_
+#define SOURCE_OPT_INLINE_COST_MODEL_PASS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/inline_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class InlineCostModelPass : public InlinePass {
+ public:
+  // Callees with at most this many instructions are always inlined: the call
+  // itself costs about as much as their body.
+  static constexpr uint32_t kDefaultAlwaysInlineSize = 16;
+  // A call is inlined when the size of the callee minus the benefit of
+  // inlining it at that call site is at most this value.
+  static constexpr uint32_t kDefaultInlineThreshold = 64;
+  // The module may grow by at most this percentage of its original size
+  // through inlining of callees that stay alive.
+  static constexpr uint32_t kDefaultGrowthBudgetPercent = 100;
+
+  InlineCostModelPass(
+      uint32_t inline_threshold = kDefaultInlineThreshold,
+      uint32_t growth_budget_percent = kDefaultGrowthBudgetPercent)
+      : inline_threshold_(inline_threshold),
+        growth_budget_percent_(growth_budget_percent) {}
+
+  Status Process() override;
+
+  const char* name() const override { return "inline-cost-model"; }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " + std::to_string(inline_threshold_) + " " +
+           std::to_string(growth_budget_percent_);
+  }
+
+ private:
+  // Returns the functions reachable from the entry points and exported
+  // functions, ordered so that every callee comes before its callers.
+  std::vector<Function*> BottomUpOrder();
+
+  // Records the call sites of every function in |functions|, the number of
+  // calls to each callee and the benefit of inlining each call.  The benefits
+  // are computed here, before inlining starts, because each inlined call
+  // invalidates the def-use analysis they need.
+  void CollectCallSites(const std::vector<Function*>& functions);
+
+  // Returns the number of instructions in the body of |func|.
+  static uint32_t FunctionSize(const Function& func);
+
+  // Returns the benefit of inlining |call|, which is nested in |loop_depth|
+  // loops: calls in loops, calls with constant arguments and calls passing
+  // pointers are more profitable to inline.
+  uint32_t CallSiteBenefit(const Instruction& call, uint32_t loop_depth) const;
+
+  // Returns true if the cost model accepts inlining |call|. Updates the
+  // growth budget and the call counts when it does.
+  bool ShouldInline(const Instruction& call);
+
+  // Inlines the calls in |func| that were there before inlining started and
+  // that the cost model accepts. Calls brought in from inlined callees were
+  // already decided on when the callee was processed. Returns the status.
+  Status InlineCalls(Function* func);
+
+  // See kDefaultInlineThreshold.
+  const uint32_t inline_threshold_;
+  // See kDefaultGrowthBudgetPercent.
+  const uint32_t growth_budget_percent_;
+
+  // Result ids of the calls each function contained before inlining,
+  // indexed by the id of the calling function.
+  std::unordered_map<uint32_t, std::unordered_set<uint32_t>> call_sites_;
+  // Benefit of inlining each call site, indexed by the result id of the call.
+  std::unordered_map<uint32_t, uint32_t> call_benefit_;
+  // Number of calls to each function that have not been inlined.
+  std::unordered_map<uint32_t, uint32_t> remaining_calls_;
+  // Size of each function once its own calls have been processed.
+  std::unordered_map<uint32_t, uint32_t> function_size_;
+  // Callees of the calls each function kept once its own calls have been
+  // processed. Inlining the function copies these calls into the caller.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> kept_callees_;
+  // Functions that are reachable from outside the module and so stay alive
+  // even when every call to them is inlined.
+  std::unordered_set<uint32_t> roots_;
+
+  // The growth still available to inlining decisions, in instructions.
+  int64_t growth_budget_ = 0;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INLINE_COST_MODEL_PASS_H_
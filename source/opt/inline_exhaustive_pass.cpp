@@ -27,28 +27,10 @@ Pass::Status InlineExhaustivePass::InlineExhaustive(Function* func) {
   for (auto bi = func->begin(); bi != func->end(); ++bi) {
     for (auto ii = bi->begin(); ii != bi->end();) {
       if (IsInlinableFunctionCall(&*ii)) {
-        // Inline call.
-        std::vector<std::unique_ptr<BasicBlock>> newBlocks;
-        std::vector<std::unique_ptr<Instruction>> newVars;
-        if (!GenInlineCode(&newBlocks, &newVars, ii, bi)) {
+        // Inline call, then restart inlining at beginning of calling block.
+        if (!InlineCallAt(func, &bi, &ii)) {
           return Status::Failure;
         }
-        // If call block is replaced with more than one block, point
-        // succeeding phis at new last block.
-        if (newBlocks.size() > 1) UpdateSucceedingPhis(newBlocks);
-        // Replace old calling block with new block(s).
-
-        bi = bi.Erase();
-
-        for (auto& bb : newBlocks) {
-          bb->SetParent(func);
-        }
-        bi = bi.InsertBefore(&newBlocks);
-        // Insert new function variables.
-        if (newVars.size() > 0)
-          func->begin()->begin().InsertBefore(std::move(newVars));
-        // Restart inlining at beginning of calling block.
-        ii = bi->begin();
         modified = true;
       } else {
         ++ii;
@@ -754,6 +754,30 @@ void InlinePass::UpdateSucceedingPhis(
       });
 }
 
+bool InlinePass::InlineCallAt(Function* func,
+                              UptrVectorIterator<BasicBlock>* call_block_itr,
+                              BasicBlock::iterator* call_inst_itr) {
+  std::vector<std::unique_ptr<BasicBlock>> newBlocks;
+  std::vector<std::unique_ptr<Instruction>> newVars;
+  if (!GenInlineCode(&newBlocks, &newVars, *call_inst_itr, *call_block_itr)) {
+    return false;
+  }
+  // If call block is replaced with more than one block, point
+  // succeeding phis at new last block.
+  if (newBlocks.size() > 1) UpdateSucceedingPhis(newBlocks);
+  // Replace old calling block with new block(s).
+  *call_block_itr = call_block_itr->Erase();
+  for (auto& bb : newBlocks) {
+    bb->SetParent(func);
+  }
+  *call_block_itr = call_block_itr->InsertBefore(&newBlocks);
+  // Insert new function variables.
+  if (newVars.size() > 0)
+    func->begin()->begin().InsertBefore(std::move(newVars));
+  *call_inst_itr = (*call_block_itr)->begin();
+  return true;
+}
+
 bool InlinePass::HasNoReturnInLoop(Function* func) {
   // If control not structured, do not do loop/return analysis
   // TODO: Analyze returns in non-structured control flow
@@ -125,6 +125,17 @@ class InlinePass : public Pass {
                      BasicBlock::iterator call_inst_itr,
                      UptrVectorIterator<BasicBlock> call_block_itr);
 
+  // Inlines the call at |*call_inst_itr| in the block at |*call_block_itr| of
+  // |func|, replacing the calling block with the inlined code and adding the
+  // new function variables to |func|.  On success, |*call_block_itr| points
+  // to the block that replaced the calling block, and |*call_inst_itr| to its
+  // first instruction.
+  //
+  // Returns true if successful.
+  bool InlineCallAt(Function* func,
+                    UptrVectorIterator<BasicBlock>* call_block_itr,
+                    BasicBlock::iterator* call_inst_itr);
+
   // Return true if |inst| is a function call that can be inlined.
   bool IsInlinableFunctionCall(const Instruction* inst);
 
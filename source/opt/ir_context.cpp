@@ -117,6 +117,17 @@ void IRContext::InvalidateAnalyses(IRContext::Analysis analyses_to_invalidate) {
     analyses_to_invalidate |= kAnalysisDominatorAnalysis;
   }
 
+  if (analyses_to_invalidate & valid_analyses_ &
+      (kAnalysisDefUse | kAnalysisInstrToBlockMapping)) {
+    ++tracking_interruptions_;
+  }
+
+  for (uint32_t i = 0; i < kNumAnalyses; ++i) {
+    if (analyses_to_invalidate & valid_analyses_ & (1u << i)) {
+      ++analysis_invalidations_[i];
+    }
+  }
+
   if (analyses_to_invalidate & kAnalysisDefUse) {
     def_use_mgr_.reset(nullptr);
   }
@@ -462,6 +473,160 @@ void IRContext::AnalyzeUses(Instruction* inst) {
   }
 }
 
+const char* IRContext::GetAnalysisName(Analysis analysis) {
+  switch (analysis) {
+    case kAnalysisDefUse:
+      return "def-use";
+    case kAnalysisInstrToBlockMapping:
+      return "instr-to-block";
+    case kAnalysisDecorations:
+      return "decorations";
+    case kAnalysisCombinators:
+      return "combinators";
+    case kAnalysisCFG:
+      return "cfg";
+    case kAnalysisDominatorAnalysis:
+      return "dominators";
+    case kAnalysisLoopAnalysis:
+      return "loops";
+    case kAnalysisNameMap:
+      return "name-map";
+    case kAnalysisScalarEvolution:
+      return "scalar-evolution";
+    case kAnalysisRegisterPressure:
+      return "register-pressure";
+    case kAnalysisValueNumberTable:
+      return "value-numbers";
+    case kAnalysisStructuredCFG:
+      return "structured-cfg";
+    case kAnalysisBuiltinVarId:
+      return "builtin-var-ids";
+    case kAnalysisIdToFuncMapping:
+      return "id-to-function";
+    case kAnalysisConstants:
+      return "constants";
+    case kAnalysisTypes:
+      return "types";
+    case kAnalysisDebugInfo:
+      return "debug-info";
+    case kAnalysisLiveness:
+      return "liveness";
+    default:
+      return "unknown";
+  }
+}
+
+bool IRContext::IsFunctionUnchangedSinceLastRun(const std::string& pass_key,
+                                                const Function& func) const {
+  if (func.modification_epoch() == Function::kUnstampedEpoch) {
+    return false;
+  }
+  auto pass_entry = unchanged_by_pass_.find(pass_key);
+  if (pass_entry == unchanged_by_pass_.end()) {
+    return false;
+  }
+  auto func_entry = pass_entry->second.find(func.result_id());
+  if (func_entry == pass_entry->second.end()) {
+    return false;
+  }
+  if (func_entry->second < func.modification_epoch() ||
+      func_entry->second < all_functions_modified_epoch_) {
+    return false;
+  }
+  ++num_unchanged_function_hits_;
+  return true;
+}
+
+void IRContext::RecordFunctionUnchangedByRun(const std::string& pass_key,
+                                             Function* func) {
+  // The function is as the pass left it, so it can be stamped with the
+  // earliest epoch.  Any later change gives it a newer epoch than the record.
+  if (func->modification_epoch() == Function::kUnstampedEpoch) {
+    func->set_modification_epoch(0);
+  }
+  unchanged_by_pass_[pass_key][func->result_id()] = modification_epoch_;
+}
+
+void IRContext::NoteInstructionChange(Instruction* inst,
+                                      InstructionChange change) {
+  if (AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
+    auto entry = instr_to_block_.find(inst);
+    if (entry != instr_to_block_.end()) {
+      if (entry->second != nullptr) {
+        MarkFunctionModified(entry->second->GetParent());
+      }
+      return;
+    }
+  }
+
+  const spv::Op opcode = inst->opcode();
+  // Names, source information and debug info do not change what a function
+  // computes.
+  if (IsDebug1Inst(opcode) || IsDebug2Inst(opcode) || IsDebug3Inst(opcode) ||
+      IsOpLineInst(opcode) || inst->IsCommonDebugInstr()) {
+    return;
+  }
+
+  // A decoration is charged to the function defining its target.
+  if (opcode == spv::Op::OpDecorate || opcode == spv::Op::OpDecorateId ||
+      opcode == spv::Op::OpDecorateString) {
+    if (AreAnalysesValid(kAnalysisDefUse | kAnalysisInstrToBlockMapping)) {
+      Instruction* target = get_def_use_mgr()->GetDef(
+          inst->GetSingleWordInOperand(kSpvDecorateTargetIdInIdx));
+      if (target != nullptr) {
+        auto entry = instr_to_block_.find(target);
+        if (entry != instr_to_block_.end()) {
+          if (entry->second != nullptr) {
+            MarkFunctionModified(entry->second->GetParent());
+          }
+          return;
+        }
+        // Decorations on global ids, such as descriptor bindings, can still
+        // change how a function is optimized.
+      }
+    }
+    MarkAllFunctionsModified();
+    return;
+  }
+
+  if (change == InstructionChange::kUsesChanged) {
+    MarkAllFunctionsModified();
+    return;
+  }
+
+  // Types, constants and global variables can come and go without changing
+  // the functions that do not use them, and a function cannot use an
+  // instruction that is being killed or was just created.
+  if (IsTypeInst(opcode) || IsConstantInst(opcode) ||
+      opcode == spv::Op::OpExtInstImport) {
+    return;
+  }
+  if (opcode == spv::Op::OpVariable &&
+      spv::StorageClass(inst->GetSingleWordInOperand(0)) !=
+          spv::StorageClass::Function) {
+    return;
+  }
+  // With a valid mapping, any other instruction that is not in a block is a
+  // new instruction not yet placed in a function, which |set_instr_block|
+  // will charge to its function.  Module-level instructions that change how
+  // every function is optimized are the exception.
+  if (AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
+    switch (opcode) {
+      case spv::Op::OpCapability:
+      case spv::Op::OpExtension:
+      case spv::Op::OpMemoryModel:
+      case spv::Op::OpEntryPoint:
+      case spv::Op::OpExecutionMode:
+      case spv::Op::OpExecutionModeId:
+      case spv::Op::OpFunctionParameter:
+        break;
+      default:
+        return;
+    }
+  }
+  MarkAllFunctionsModified();
+}
+
 void IRContext::KillNamesAndDecorates(uint32_t id) {
   analysis::DecorationManager* dec_mgr = get_decoration_mgr();
   dec_mgr->RemoveDecorationsFrom(id);
@@ -785,7 +950,7 @@ void IRContext::InitializeCombinators() {
     AddCombinatorsForExtension(&extension);
   }
 
-  valid_analyses_ |= kAnalysisCombinators;
+  MarkAnalysisBuilt(kAnalysisCombinators);
 }
 
 void IRContext::RemoveFromIdToName(const Instruction* inst) {
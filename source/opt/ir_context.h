@@ -16,6 +16,7 @@
 #define SOURCE_OPT_IR_CONTEXT_H_
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -63,6 +64,8 @@ class IRContext {
   //    or remove IR elements (e.g., KillDef, KillInst, ReplaceAllUsesWith).
   //
   // 3. Add handling code in BuildInvalidAnalyses and InvalidateAnalyses
+  //
+  // 4. Add its name to GetAnalysisName and update kNumAnalyses.
   enum Analysis {
     kAnalysisNone = 0 << 0,
     kAnalysisBegin = 1 << 0,
@@ -87,6 +90,11 @@ class IRContext {
     kAnalysisEnd = 1 << 18
   };
 
+  // The number of analyses between kAnalysisBegin and kAnalysisEnd.
+  static constexpr uint32_t kNumAnalyses = 18;
+  static_assert(kAnalysisEnd == 1 << kNumAnalyses,
+                "kNumAnalyses must match the Analysis enum");
+
   using ProcessFunction = std::function<bool(Function*)>;
 
   friend inline Analysis operator|(Analysis lhs, Analysis rhs);
@@ -329,6 +337,11 @@ class IRContext {
   void set_instr_block(Instruction* inst, BasicBlock* block) {
     if (AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
       instr_to_block_[inst] = block;
+      if (block != nullptr) {
+        MarkFunctionModified(block->GetParent());
+      }
+    } else {
+      MarkAllFunctionsModified();
     }
   }
 
@@ -684,17 +697,120 @@ class IRContext {
   // Return the target environment for the current context.
   spv_target_env GetTargetEnv() const { return syntax_context_->target_env; }
 
+  // Returns a short name for the single analysis |analysis|, such as
+  // "def-use".
+  static const char* GetAnalysisName(Analysis analysis);
+
+  // Returns the number of times the single analysis |analysis| has been built
+  // since this context was created.
+  uint32_t GetAnalysisBuildCount(Analysis analysis) const {
+    return analysis_builds_[AnalysisIndex(analysis)];
+  }
+
+  // Returns the number of times the single analysis |analysis| has been
+  // invalidated while it was valid since this context was created.
+  uint32_t GetAnalysisInvalidationCount(Analysis analysis) const {
+    return analysis_invalidations_[AnalysisIndex(analysis)];
+  }
+
+  // Returns the modification epoch of the last change that was charged to
+  // every function.  See the function modification tracking below.
+  uint64_t all_functions_modified_epoch() const {
+    return all_functions_modified_epoch_;
+  }
+
+  // Function modification tracking.
+  //
+  // The context keeps a modification epoch that is bumped for every change it
+  // is told about: instructions added, killed or having their uses updated
+  // in the def-use manager, whether through the context or directly, and
+  // instructions placed in a block with |set_instr_block|.  A change is
+  // charged to the function containing the instruction when the instruction
+  // to block mapping can tell, and to every function otherwise.  Adding or
+  // removing types, constants and global variables does not change any
+  // function.
+  //
+  // Changes made while the def-use manager or the instruction to block
+  // mapping is invalid cannot be attributed, so Pass::Run marks every
+  // function as modified after a pass that changed the module in that state.
+  //
+  // A function-local pass can use this to skip functions that it has already
+  // processed without making a change, as long as its result for a function
+  // only depends on the function itself.
+
+  // Returns true if |func| has not been modified since the pass identified by
+  // |pass_key| called |RecordFunctionUnchangedByRun| on it.
+  bool IsFunctionUnchangedSinceLastRun(const std::string& pass_key,
+                                       const Function& func) const;
+
+  // Returns the number of times |IsFunctionUnchangedSinceLastRun| has returned
+  // true, i.e. the number of function runs that passes could skip.
+  uint64_t num_unchanged_function_hits() const {
+    return num_unchanged_function_hits_;
+  }
+
+  // Records that running the pass identified by |pass_key| over |func| did not
+  // change it.
+  void RecordFunctionUnchangedByRun(const std::string& pass_key,
+                                    Function* func);
+
+  // Records that |func| has been modified.
+  void MarkFunctionModified(Function* func) {
+    if (func != nullptr) {
+      func->set_modification_epoch(++modification_epoch_);
+    }
+  }
+
+  // Records that any function may have been modified.
+  void MarkAllFunctionsModified() {
+    all_functions_modified_epoch_ = ++modification_epoch_;
+  }
+
+  // Returns the number of times the def-use manager or the instruction to
+  // block mapping has been invalidated.  While this count is unchanged, every
+  // change made through the context has been charged to the right function.
+  uint64_t tracking_interruptions() const { return tracking_interruptions_; }
+
  private:
+  // Returns the position of the single analysis |analysis| in the Analysis
+  // enum, starting at 0 for kAnalysisBegin.
+  static uint32_t AnalysisIndex(Analysis analysis) {
+    uint32_t index = 0;
+    while ((1u << index) < static_cast<uint32_t>(analysis)) {
+      ++index;
+    }
+    return index;
+  }
+
+  // Marks |analysis| as valid, and counts it as built.
+  void MarkAnalysisBuilt(Analysis analysis) {
+    valid_analyses_ = valid_analyses_ | analysis;
+    ++analysis_builds_[AnalysisIndex(analysis)];
+  }
+
+  // How an instruction reported to |NoteInstructionChange| was changed.
+  using InstructionChange = analysis::DefUseManager::Change;
+
+  // Bumps the modification epoch of the function containing |inst|, or of
+  // all functions if it cannot be determined whether |change| affects a
+  // single function.  Called by the def-use manager for every change it is
+  // told about.
+  void NoteInstructionChange(Instruction* inst, InstructionChange change);
+
   // Builds the def-use manager from scratch, even if it was already valid.
   void BuildDefUseManager() {
     def_use_mgr_ = MakeUnique<analysis::DefUseManager>(module());
-    valid_analyses_ = valid_analyses_ | kAnalysisDefUse;
+    def_use_mgr_->SetChangeObserver(
+        [this](Instruction* inst, InstructionChange change) {
+          NoteInstructionChange(inst, change);
+        });
+    MarkAnalysisBuilt(kAnalysisDefUse);
   }
 
   // Builds the liveness manager from scratch, even if it was already valid.
   void BuildLivenessManager() {
     liveness_mgr_ = MakeUnique<analysis::LivenessManager>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisLiveness;
+    MarkAnalysisBuilt(kAnalysisLiveness);
   }
 
   // Builds the instruction-block map for the whole module.
@@ -707,7 +823,7 @@ class IRContext {
         });
       }
     }
-    valid_analyses_ = valid_analyses_ | kAnalysisInstrToBlockMapping;
+    MarkAnalysisBuilt(kAnalysisInstrToBlockMapping);
   }
 
   // Builds the instruction-function map for the whole module.
@@ -716,63 +832,63 @@ class IRContext {
     for (auto& fn : *module_) {
       id_to_func_[fn.result_id()] = &fn;
     }
-    valid_analyses_ = valid_analyses_ | kAnalysisIdToFuncMapping;
+    MarkAnalysisBuilt(kAnalysisIdToFuncMapping);
   }
 
   void BuildDecorationManager() {
     decoration_mgr_ = MakeUnique<analysis::DecorationManager>(module());
-    valid_analyses_ = valid_analyses_ | kAnalysisDecorations;
+    MarkAnalysisBuilt(kAnalysisDecorations);
   }
 
   void BuildCFG() {
     cfg_ = MakeUnique<CFG>(module());
-    valid_analyses_ = valid_analyses_ | kAnalysisCFG;
+    MarkAnalysisBuilt(kAnalysisCFG);
   }
 
   void BuildScalarEvolutionAnalysis() {
     scalar_evolution_analysis_ = MakeUnique<ScalarEvolutionAnalysis>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisScalarEvolution;
+    MarkAnalysisBuilt(kAnalysisScalarEvolution);
   }
 
   // Builds the liveness analysis from scratch, even if it was already valid.
   void BuildRegPressureAnalysis() {
     reg_pressure_ = MakeUnique<LivenessAnalysis>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisRegisterPressure;
+    MarkAnalysisBuilt(kAnalysisRegisterPressure);
   }
 
   // Builds the value number table analysis from scratch, even if it was already
   // valid.
   void BuildValueNumberTable() {
     vn_table_ = MakeUnique<ValueNumberTable>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisValueNumberTable;
+    MarkAnalysisBuilt(kAnalysisValueNumberTable);
   }
 
   // Builds the structured CFG analysis from scratch, even if it was already
   // valid.
   void BuildStructuredCFGAnalysis() {
     struct_cfg_analysis_ = MakeUnique<StructuredCFGAnalysis>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisStructuredCFG;
+    MarkAnalysisBuilt(kAnalysisStructuredCFG);
   }
 
   // Builds the constant manager from scratch, even if it was already
   // valid.
   void BuildConstantManager() {
     constant_mgr_ = MakeUnique<analysis::ConstantManager>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisConstants;
+    MarkAnalysisBuilt(kAnalysisConstants);
   }
 
   // Builds the type manager from scratch, even if it was already
   // valid.
   void BuildTypeManager() {
     type_mgr_ = MakeUnique<analysis::TypeManager>(consumer(), this);
-    valid_analyses_ = valid_analyses_ | kAnalysisTypes;
+    MarkAnalysisBuilt(kAnalysisTypes);
   }
 
   // Builds the debug information manager from scratch, even if it was
   // already valid.
   void BuildDebugInfoManager() {
     debug_info_mgr_ = MakeUnique<analysis::DebugInfoManager>(this);
-    valid_analyses_ = valid_analyses_ | kAnalysisDebugInfo;
+    MarkAnalysisBuilt(kAnalysisDebugInfo);
   }
 
   // Removes all computed dominator and post-dominator trees. This will force
@@ -781,21 +897,21 @@ class IRContext {
     // Clear the cache.
     dominator_trees_.clear();
     post_dominator_trees_.clear();
-    valid_analyses_ = valid_analyses_ | kAnalysisDominatorAnalysis;
+    MarkAnalysisBuilt(kAnalysisDominatorAnalysis);
   }
 
   // Removes all computed loop descriptors.
   void ResetLoopAnalysis() {
     // Clear the cache.
     loop_descriptors_.clear();
-    valid_analyses_ = valid_analyses_ | kAnalysisLoopAnalysis;
+    MarkAnalysisBuilt(kAnalysisLoopAnalysis);
   }
 
   // Removes all computed loop descriptors.
   void ResetBuiltinAnalysis() {
     // Clear the cache.
     builtin_var_id_map_.clear();
-    valid_analyses_ = valid_analyses_ | kAnalysisBuiltinVarId;
+    MarkAnalysisBuilt(kAnalysisBuiltinVarId);
   }
 
   // Analyzes the features in the owned module. Builds the manager if required.
@@ -930,6 +1046,30 @@ class IRContext {
   // Whether all specialization constants within |module_|
   // should be preserved.
   bool preserve_spec_constants_;
+
+  // The most recent modification epoch handed out.
+  uint64_t modification_epoch_ = 0;
+
+  // The epoch of the most recent change that could not be charged to a
+  // single function.
+  uint64_t all_functions_modified_epoch_ = 0;
+
+  // The number of times |IsFunctionUnchangedSinceLastRun| returned true.
+  mutable uint64_t num_unchanged_function_hits_ = 0;
+
+  // The number of times the def-use manager or the instruction to block
+  // mapping was invalidated.
+  uint64_t tracking_interruptions_ = 0;
+
+  // The number of times each analysis was built and invalidated, indexed by
+  // AnalysisIndex.
+  std::array<uint32_t, kNumAnalyses> analysis_builds_{};
+  std::array<uint32_t, kNumAnalyses> analysis_invalidations_{};
+
+  // Maps a pass key and a function id to the modification epoch at which the
+  // pass last ran over the function without changing it.
+  std::unordered_map<std::string, std::unordered_map<uint32_t, uint64_t>>
+      unchanged_by_pass_;
 };
 
 inline IRContext::Analysis operator|(IRContext::Analysis lhs,
@@ -1250,7 +1390,7 @@ void IRContext::BuildIdToNameMap() {
       id_to_name_->insert({debug_inst.GetSingleWordInOperand(0), &debug_inst});
     }
   }
-  valid_analyses_ = valid_analyses_ | kAnalysisNameMap;
+  MarkAnalysisBuilt(kAnalysisNameMap);
 }
 
 IteratorRange<std::multimap<uint32_t, Instruction*>::iterator>
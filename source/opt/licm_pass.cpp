@@ -16,11 +16,32 @@
 
 #include <queue>
 
+#include "source/opt/ir_context.h"
 #include "source/opt/module.h"
 #include "source/opt/pass.h"
+#include "source/opt/register_pressure.h"
 
 namespace spvtools {
 namespace opt {
+namespace {
+constexpr uint32_t kVariableStorageClassInIdx = 0;
+constexpr uint32_t kLoadMemoryAccessInIdx = 1;
+constexpr uint32_t kStoreMemoryAccessInIdx = 2;
+
+// Returns true if the memory access operand of |inst| at |in_idx| is present
+// and makes the access volatile, or synchronizes it with other invocations
+// under the Vulkan memory model.  Such an access may see a different value
+// each time, so it must stay where it is.
+bool IsSynchronizedAccess(const Instruction& inst, uint32_t in_idx) {
+  constexpr uint32_t kSynchronizedMask =
+      uint32_t(spv::MemoryAccessMask::Volatile) |
+      uint32_t(spv::MemoryAccessMask::MakePointerAvailableKHR) |
+      uint32_t(spv::MemoryAccessMask::MakePointerVisibleKHR) |
+      uint32_t(spv::MemoryAccessMask::NonPrivatePointerKHR);
+  return inst.NumInOperands() > in_idx &&
+         (inst.GetSingleWordInOperand(in_idx) & kSynchronizedMask) != 0;
+}
+}  // namespace
 
 Pass::Status LICMPass::Process() { return ProcessIRContext(); }
 
@@ -40,6 +61,19 @@ Pass::Status LICMPass::ProcessFunction(Function* f) {
   Status status = Status::SuccessWithoutChange;
   LoopDescriptor* loop_descriptor = context()->GetLoopDescriptor(f);
 
+  // The register pressure is estimated before any change, because the
+  // liveness analysis is not updated as instructions are moved.
+  loop_pressure_.clear();
+  if (aggressive_ && loop_descriptor->NumLoops() > 0) {
+    const RegisterLiveness* liveness =
+        context()->GetLivenessAnalysis()->Get(f);
+    for (Loop& loop : *loop_descriptor) {
+      RegisterLiveness::RegionRegisterLiveness pressure;
+      liveness->ComputeLoopRegisterPressure(loop, &pressure);
+      loop_pressure_[&loop] = pressure.used_registers_;
+    }
+  }
+
   // Process each loop in the function
   for (auto it = loop_descriptor->begin();
        it != loop_descriptor->end() && status != Status::Failure; ++it) {
@@ -63,6 +97,10 @@ Pass::Status LICMPass::ProcessLoop(Loop* loop, Function* f) {
     status = CombineStatus(status, ProcessLoop(nested_loop, f));
   }
 
+  if (aggressive_) {
+    AnalyseLoop(loop);
+  }
+
   std::vector<BasicBlock*> loop_bbs{};
   status = CombineStatus(
       status,
@@ -75,6 +113,11 @@ Pass::Status LICMPass::ProcessLoop(Loop* loop, Function* f) {
         CombineStatus(status, AnalyseAndHoistFromBB(loop, f, bb, &loop_bbs));
   }
 
+  if (aggressive_ && status != Status::Failure &&
+      SinkInvariantStores(loop, f)) {
+    status = CombineStatus(status, Status::SuccessWithChange);
+  }
+
   return status;
 }
 
@@ -83,11 +126,14 @@ Pass::Status LICMPass::AnalyseAndHoistFromBB(
     std::vector<BasicBlock*>* loop_bbs) {
   bool modified = false;
   std::function<bool(Instruction*)> hoist_inst =
-      [this, &loop, &modified](Instruction* inst) {
-        if (loop->ShouldHoistInstruction(*inst)) {
+      [this, &loop, f, bb, &modified](Instruction* inst) {
+        if (ShouldHoist(loop, f, bb, *inst)) {
           if (!HoistInstruction(loop, inst)) {
             return false;
           }
+          if (aggressive_) {
+            ChargeRegisters(loop, inst);
+          }
           modified = true;
         }
         return true;
@@ -135,5 +181,271 @@ bool LICMPass::HoistInstruction(Loop* loop, Instruction* inst) {
   return true;
 }
 
+bool LICMPass::ShouldHoist(Loop* loop, Function* f, BasicBlock* bb,
+                           const Instruction& inst) {
+  if (!aggressive_) {
+    return loop->ShouldHoistInstruction(inst);
+  }
+  if (!loop->ShouldHoistInstruction(inst) &&
+      !IsInvariantLoad(loop, f, bb, inst)) {
+    return false;
+  }
+  // The hoisted value is live across the whole loop.
+  return register_budget_ > 0;
+}
+
+bool LICMPass::IsInvariantLoad(Loop* loop, Function* f, BasicBlock* bb,
+                               const Instruction& inst) const {
+  if (inst.opcode() != spv::Op::OpLoad || memory_.writes_unknown ||
+      IsSynchronizedAccess(inst, kLoadMemoryAccessInIdx) ||
+      !loop->AreAllOperandsOutsideLoop(inst)) {
+    return false;
+  }
+
+  Instruction* var = GetAccessedVariable(inst);
+  if (var == nullptr || memory_.written.count(var->result_id())) {
+    return false;
+  }
+
+  // Only hoist loads that are executed whenever the loop is entered.  The
+  // preheader runs even if the loop exits before reaching the load, and a
+  // load guarded by a condition in the loop may rely on that condition to
+  // stay in bounds.  This holds if |bb| dominates every block that leaves the
+  // loop, which also rules out loops that can exit from the header before the
+  // body runs.  A loop that never leaves has no such block, and its guarded
+  // loads are not hoisted either.
+  DominatorAnalysis* dom_analysis = context()->GetDominatorAnalysis(f);
+  CFG* cfg = context()->cfg();
+  bool has_exit = false;
+  for (uint32_t block_id : loop->GetBlocks()) {
+    BasicBlock* block = cfg->block(block_id);
+    bool leaves_loop = !block->hasSuccessor();
+    block->ForEachSuccessorLabel([loop, &leaves_loop](uint32_t succ_id) {
+      if (!loop->IsInsideLoop(succ_id)) leaves_loop = true;
+    });
+    if (!leaves_loop) continue;
+    if (!dom_analysis->Dominates(bb, block)) return false;
+    has_exit = true;
+  }
+  return has_exit;
+}
+
+Instruction* LICMPass::GetAccessedVariable(const Instruction& inst) const {
+  Instruction* var = inst.GetBaseAddress();
+  if (var->opcode() != spv::Op::OpVariable) {
+    return nullptr;
+  }
+
+  switch (spv::StorageClass(
+      var->GetSingleWordInOperand(kVariableStorageClassInIdx))) {
+    case spv::StorageClass::Function:
+    case spv::StorageClass::Private:
+    case spv::StorageClass::Uniform:
+    case spv::StorageClass::UniformConstant:
+    case spv::StorageClass::StorageBuffer:
+    case spv::StorageClass::PushConstant:
+    case spv::StorageClass::Input:
+    case spv::StorageClass::Output:
+      break;
+    default:
+      // Other invocations may write the memory while the loop runs.
+      return nullptr;
+  }
+
+  // Memory that may alias other variables or that other invocations may
+  // write is unknown.
+  const Instruction* pointer_type =
+      context()->get_def_use_mgr()->GetDef(var->type_id());
+  if (HasSharedMemoryDecoration(var->result_id()) ||
+      HasSharedMemoryDecoration(pointer_type->GetSingleWordInOperand(1))) {
+    return nullptr;
+  }
+  return var;
+}
+
+bool LICMPass::HasSharedMemoryDecoration(uint32_t id) const {
+  analysis::DecorationManager* dec_mgr = context()->get_decoration_mgr();
+  for (spv::Decoration decoration :
+       {spv::Decoration::Aliased, spv::Decoration::Coherent,
+        spv::Decoration::Volatile}) {
+    // This also finds the decorations of the members of a struct.
+    if (dec_mgr->HasDecoration(id, decoration)) return true;
+  }
+
+  // The decorations may be on a block inside an array of descriptors, or on
+  // a nested struct.
+  const Instruction* type = context()->get_def_use_mgr()->GetDef(id);
+  switch (type->opcode()) {
+    case spv::Op::OpTypeArray:
+    case spv::Op::OpTypeRuntimeArray:
+      return HasSharedMemoryDecoration(type->GetSingleWordInOperand(0));
+    case spv::Op::OpTypeStruct:
+      for (uint32_t i = 0; i < type->NumInOperands(); ++i) {
+        if (HasSharedMemoryDecoration(type->GetSingleWordInOperand(i))) {
+          return true;
+        }
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+void LICMPass::AnalyseLoop(Loop* loop) {
+  memory_ = LoopMemory();
+  hoisted_.clear();
+  register_budget_ =
+      int64_t(max_registers_) - int64_t(loop_pressure_[loop]);
+
+  analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  auto record_access = [this](const Instruction& inst, bool writes) {
+    Instruction* var = GetAccessedVariable(inst);
+    if (var == nullptr) {
+      memory_.reads_unknown = true;
+      memory_.writes_unknown |= writes;
+      return;
+    }
+    ++memory_.accesses[var->result_id()];
+    if (writes) {
+      memory_.written.insert(var->result_id());
+    }
+  };
+
+  for (uint32_t bb_id : loop->GetBlocks()) {
+    for (Instruction& inst : *context()->cfg()->block(bb_id)) {
+      switch (inst.opcode()) {
+        case spv::Op::OpLoad:
+          record_access(inst, false);
+          break;
+        case spv::Op::OpStore:
+          record_access(inst, true);
+          break;
+        case spv::Op::OpCopyMemory:
+        case spv::Op::OpCopyMemorySized:
+          // The source is not tracked.
+          record_access(inst, true);
+          memory_.reads_unknown = true;
+          break;
+        case spv::Op::OpFunctionCall:
+        case spv::Op::OpControlBarrier:
+        case spv::Op::OpMemoryBarrier:
+          memory_.reads_unknown = true;
+          memory_.writes_unknown = true;
+          break;
+        case spv::Op::OpAccessChain:
+        case spv::Op::OpInBoundsAccessChain:
+        case spv::Op::OpPtrAccessChain:
+        case spv::Op::OpInBoundsPtrAccessChain:
+        case spv::Op::OpImageTexelPointer:
+        case spv::Op::OpCopyObject:
+        case spv::Op::OpArrayLength:
+        case spv::Op::OpPhi:
+          break;
+        default:
+          if (inst.IsAtomicOp()) {
+            record_access(inst, true);
+            break;
+          }
+          if (inst.IsCommonDebugInstr() || inst.IsNonSemanticInstruction()) {
+            break;
+          }
+          // Any other instruction taking a pointer may access its memory.
+          inst.ForEachInId([this, def_use_mgr, type_mgr](const uint32_t* id) {
+            const Instruction* def = def_use_mgr->GetDef(*id);
+            if (def->type_id() != 0 &&
+                type_mgr->GetType(def->type_id())->AsPointer()) {
+              memory_.reads_unknown = true;
+              memory_.writes_unknown = true;
+            }
+          });
+          break;
+      }
+    }
+  }
+}
+
+void LICMPass::ChargeRegisters(Loop* loop, Instruction* inst) {
+  hoisted_.insert(inst);
+  --register_budget_;
+
+  // An operand hoisted earlier is no longer live in the loop once its last
+  // user in the loop has been hoisted.
+  analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
+  std::unordered_set<Instruction*> operands;
+  inst->ForEachInId([def_use_mgr, &operands](const uint32_t* id) {
+    operands.insert(def_use_mgr->GetDef(*id));
+  });
+  for (Instruction* operand : operands) {
+    if (!hoisted_.count(operand)) {
+      continue;
+    }
+    const bool used_in_loop = !def_use_mgr->WhileEachUser(
+        operand, [this, loop](Instruction* user) {
+          BasicBlock* user_bb = context()->get_instr_block(user);
+          return user_bb == nullptr || !loop->IsInsideLoop(user_bb);
+        });
+    if (!used_in_loop) {
+      ++register_budget_;
+    }
+  }
+}
+
+bool LICMPass::SinkInvariantStores(Loop* loop, Function* f) {
+  BasicBlock* merge_bb = loop->GetMergeBlock();
+  if (merge_bb == nullptr || memory_.reads_unknown ||
+      memory_.writes_unknown) {
+    return false;
+  }
+
+  // The loop must only be left through its merge block, so that the store is
+  // executed once the loop is done on every path.
+  std::unordered_set<uint32_t> exit_blocks;
+  loop->GetExitBlocks(&exit_blocks);
+  if (exit_blocks.size() != 1 || exit_blocks.count(merge_bb->id()) == 0) {
+    return false;
+  }
+  CFG* cfg = context()->cfg();
+  for (uint32_t bb_id : loop->GetBlocks()) {
+    if (cfg->block(bb_id)->IsReturnOrAbort()) {
+      return false;
+    }
+  }
+
+  DominatorAnalysis* dom_analysis = context()->GetDominatorAnalysis(f);
+  std::vector<Instruction*> stores;
+  for (uint32_t bb_id : loop->GetBlocks()) {
+    BasicBlock* bb = cfg->block(bb_id);
+    if (!dom_analysis->Dominates(bb, merge_bb)) {
+      continue;
+    }
+    for (Instruction& inst : *bb) {
+      if (inst.opcode() != spv::Op::OpStore ||
+          IsSynchronizedAccess(inst, kStoreMemoryAccessInIdx) ||
+          !loop->AreAllOperandsOutsideLoop(inst)) {
+        continue;
+      }
+      Instruction* var = GetAccessedVariable(inst);
+      if (var != nullptr && memory_.accesses[var->result_id()] == 1) {
+        stores.push_back(&inst);
+      }
+    }
+  }
+
+  if (stores.empty()) {
+    return false;
+  }
+
+  auto insertion_point = merge_bb->begin();
+  while (insertion_point->opcode() == spv::Op::OpPhi) {
+    ++insertion_point;
+  }
+  for (Instruction* store : stores) {
+    store->InsertBefore(&*insertion_point);
+    context()->set_instr_block(store, merge_bb);
+  }
+  return true;
+}
+
 }  // namespace opt
 }  // namespace spvtools
@@ -15,7 +15,10 @@
 #ifndef SOURCE_OPT_LICM_PASS_H_
 #define SOURCE_OPT_LICM_PASS_H_
 
+#include <cstdint>
 #include <queue>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "source/opt/basic_block.h"
@@ -28,9 +31,25 @@ namespace opt {
 
 class LICMPass : public Pass {
  public:
+  static constexpr uint32_t kDefaultMaxRegisters = 64;
+
   LICMPass() {}
 
-  const char* name() const override { return "loop-invariant-code-motion"; }
+  // Creates a pass that also hoists invariant loads from memory that is not
+  // written in the loop and sinks invariant stores out of the loop.  Hoisting
+  // stops in a loop once the estimated register pressure in the loop would
+  // exceed |max_registers|.
+  explicit LICMPass(uint32_t max_registers)
+      : aggressive_(true), max_registers_(max_registers) {}
+
+  const char* name() const override {
+    return aggressive_ ? "loop-invariant-code-motion-aggressive"
+                       : "loop-invariant-code-motion";
+  }
+  std::string CacheKey() const override {
+    if (!aggressive_) return name();
+    return std::string(name()) + " " + std::to_string(max_registers_);
+  }
   Status Process() override;
 
  private:
@@ -64,6 +83,69 @@ class LICMPass : public Pass {
   // Move the instruction to the preheader of |loop|.
   // This method will update the instruction to block mapping for the context
   bool HoistInstruction(Loop* loop, Instruction* inst);
+
+  // Returns true if |inst| in |bb| should be moved to the preheader of |loop|.
+  // In the aggressive mode, this also accepts loads from memory the loop does
+  // not write, and rejects instructions that do not fit the register budget.
+  bool ShouldHoist(Loop* loop, Function* f, BasicBlock* bb,
+                   const Instruction& inst);
+
+  // Returns true if |inst| in |bb| is a load from a variable that |loop| does
+  // not write, with an invariant pointer, and that runs whenever |loop| is
+  // entered: |loop| must have an exit, and |bb| must dominate every block that
+  // leaves |loop|.
+  bool IsInvariantLoad(Loop* loop, Function* f, BasicBlock* bb,
+                       const Instruction& inst) const;
+
+  // Returns the variable |inst| accesses through its pointer operand, or
+  // nullptr if it is not known or other memory may alias it.
+  Instruction* GetAccessedVariable(const Instruction& inst) const;
+
+  // Returns true if the variable or type |id| is decorated Aliased, Coherent
+  // or Volatile, or if a type it contains, such as the element of an array or
+  // a member of a struct, is.
+  bool HasSharedMemoryDecoration(uint32_t id) const;
+
+  // Fills |memory_| with the variables accessed and written in |loop|, and
+  // resets the register budget of the aggressive mode for |loop|.
+  void AnalyseLoop(Loop* loop);
+
+  // Updates the register budget after hoisting |inst| out of |loop|.
+  void ChargeRegisters(Loop* loop, Instruction* inst);
+
+  // Moves the stores in |loop| that store an invariant value to an invariant
+  // pointer to the merge block of |loop|, when nothing else in the loop
+  // accesses the stored variable and every path out of the loop executes the
+  // store.  Returns true if a store was moved.
+  bool SinkInvariantStores(Loop* loop, Function* f);
+
+  // The memory accessed in the loop being processed.
+  struct LoopMemory {
+    // Number of loads, stores and atomic operations on each variable.
+    std::unordered_map<uint32_t, uint32_t> accesses;
+    // The variables that are written.
+    std::unordered_set<uint32_t> written;
+    // True if the loop may write memory that is not in |written|.
+    bool writes_unknown = false;
+    // True if the loop may read memory that is not in |accesses|.
+    bool reads_unknown = false;
+  };
+
+  // True if the aggressive mode is enabled.
+  bool aggressive_ = false;
+  // The maximum estimated register pressure of a loop after hoisting.
+  uint32_t max_registers_ = kDefaultMaxRegisters;
+
+  // The estimated register pressure of each loop of the function being
+  // processed, before any change.
+  std::unordered_map<const Loop*, size_t> loop_pressure_;
+  // The memory accessed in the loop being processed.
+  LoopMemory memory_;
+  // The number of registers that hoisting can still add to the loop being
+  // processed.
+  int64_t register_budget_ = 0;
+  // The instructions hoisted out of the loop being processed.
+  std::unordered_set<Instruction*> hoisted_;
 };
 
 }  // namespace opt
@@ -419,7 +419,10 @@ Loop* LoopFissionImpl::SplitLoop() {
 
 LoopFissionPass::LoopFissionPass(const size_t register_threshold_to_split,
                                  bool split_multiple_times)
-    : split_multiple_times_(split_multiple_times) {
+    : split_multiple_times_(split_multiple_times),
+      cache_key_(std::string(name()) + " " +
+                 std::to_string(register_threshold_to_split) + " " +
+                 std::to_string(split_multiple_times)) {
   // Split if the number of registers in the loop exceeds
   // |register_threshold_to_split|.
   split_criteria_ =
@@ -429,7 +432,8 @@ LoopFissionPass::LoopFissionPass(const size_t register_threshold_to_split,
       };
 }
 
-LoopFissionPass::LoopFissionPass() : split_multiple_times_(false) {
+LoopFissionPass::LoopFissionPass()
+    : split_multiple_times_(false), cache_key_(name()) {
   // Split by default.
   split_criteria_ = [](const RegisterLiveness::RegionRegisterLiveness&) {
     return true;
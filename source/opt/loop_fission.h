@@ -56,6 +56,7 @@ class LoopFissionPass : public Pass {
       : split_criteria_(functor), split_multiple_times_(split_multiple_times) {}
 
   const char* name() const override { return "loop-fission"; }
+  std::string CacheKey() const override { return cache_key_; }
 
   Pass::Status Process() override;
 
@@ -70,6 +71,9 @@ class LoopFissionPass : public Pass {
   // Flag designating whether or not we should also split the result of
   // previously split loops if they meet the register presure criteria.
   bool split_multiple_times_;
+
+  // See Pass::CacheKey.  Empty when |split_criteria_| was given by the caller.
+  std::string cache_key_;
 };
 
 }  // namespace opt
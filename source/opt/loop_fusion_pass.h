@@ -30,6 +30,9 @@ class LoopFusionPass : public Pass {
       : Pass(), max_registers_per_loop_(max_registers_per_loop) {}
 
   const char* name() const override { return "loop-fusion"; }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " + std::to_string(max_registers_per_loop_);
+  }
 
   // Processes the given |module|. Returns Status::Failure if errors occur when
   // processing. Returns the corresponding Status::Success if processing is
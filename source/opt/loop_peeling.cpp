@@ -43,8 +43,6 @@ void GetBlocksInPath(uint32_t block, uint32_t entry,
 }
 }  // namespace
 
-size_t LoopPeelingPass::code_grow_threshold_ = 1000;
-
 void LoopPeeling::DuplicateAndConnectLoop(
     LoopUtils::LoopCloningResult* clone_results) {
   CFG& cfg = *context_->cfg();
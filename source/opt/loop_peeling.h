@@ -245,17 +245,22 @@ class LoopPeelingPass : public Pass {
     std::vector<std::tuple<const Loop*, PeelDirection, uint32_t>> peeled_loops_;
   };
 
-  LoopPeelingPass(LoopPeelingStats* stats = nullptr) : stats_(stats) {}
+  // The default loop peeling code growth threshold.
+  static constexpr size_t kDefaultCodeGrowThreshold = 1000;
 
-  // Sets the loop peeling growth threshold. If the code size increase is above
-  // |code_grow_threshold|, the loop will not be peeled. The code size is
-  // measured in terms of SPIR-V instructions.
-  static void SetLoopPeelingThreshold(size_t code_grow_threshold) {
+  // If the code size increase is above |code_grow_threshold|, the loop will
+  // not be peeled. The code size is measured in terms of SPIR-V instructions.
+  LoopPeelingPass(LoopPeelingStats* stats = nullptr,
+                  size_t code_grow_threshold = kDefaultCodeGrowThreshold)
+      : code_grow_threshold_(code_grow_threshold), stats_(stats) {}
+
+  // Sets the loop peeling growth threshold of this pass.
+  void SetLoopPeelingThreshold(size_t code_grow_threshold) {
     code_grow_threshold_ = code_grow_threshold;
   }
 
-  // Returns the loop peeling code growth threshold.
-  static size_t GetLoopPeelingThreshold() { return code_grow_threshold_; }
+  // Returns the loop peeling code growth threshold of this pass.
+  size_t GetLoopPeelingThreshold() const { return code_grow_threshold_; }
 
   const char* name() const override { return "loop-peeling"; }
 
@@ -326,7 +331,7 @@ class LoopPeelingPass : public Pass {
   // Peel |loop| if profitable.
   std::pair<bool, Loop*> ProcessLoop(Loop* loop, CodeMetrics* loop_size);
 
-  static size_t code_grow_threshold_;
+  size_t code_grow_threshold_;
   LoopPeelingStats* stats_;
 };
 
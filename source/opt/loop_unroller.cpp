@@ -16,12 +16,15 @@
 
 #include <limits>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "source/opt/ir_builder.h"
+#include "source/opt/log.h"
 #include "source/opt/loop_utils.h"
+#include "source/opt/register_pressure.h"
 
 // Implements loop util unrolling functionality for fully and partially
 // unrolling loops. Given a factor it will duplicate the loop that many times,
@@ -1116,6 +1119,104 @@ void LoopUtils::Finalize() {
  *
  */
 
+bool LoopUnroller::ChooseUnrollFactor(const Loop& loop, size_t iterations,
+                                      const RegisterLiveness& liveness,
+                                      size_t* factor) {
+  size_t body_size = 0;
+  for (uint32_t bb_id : loop.GetBlocks()) {
+    const BasicBlock* bb = context()->cfg()->block(bb_id);
+    for (auto inst = bb->cbegin(); inst != bb->cend(); ++inst) ++body_size;
+  }
+
+  // Try a full unroll first, then partial unrolls by decreasing powers of two.
+  std::vector<size_t> factors = {iterations};
+  size_t power_of_two = 2;
+  while (power_of_two * 2 < iterations) power_of_two *= 2;
+  for (; power_of_two >= 2 && power_of_two < iterations; power_of_two /= 2) {
+    factors.push_back(power_of_two);
+  }
+
+  std::string message = "Loop %" + std::to_string(loop.GetHeaderBlock()->id()) +
+                        " (" + std::to_string(iterations) + " iterations, " +
+                        std::to_string(body_size) + " instructions): ";
+  for (size_t candidate : factors) {
+    RegisterLiveness::RegionRegisterLiveness simulation;
+    liveness.SimulateUnroll(loop, candidate, &simulation);
+    // A partial unroll keeps a copy of the body for the residual iterations.
+    size_t size = body_size * candidate;
+    if (candidate < iterations && iterations % candidate != 0) {
+      size += body_size;
+    }
+    if (simulation.used_registers_ <= budget_.max_registers &&
+        size <= budget_.max_instructions) {
+      message += (candidate == iterations
+                      ? std::string("fully unrolled")
+                      : "unrolled by " + std::to_string(candidate)) +
+                 ", estimated " + std::to_string(simulation.used_registers_) +
+                 " registers and " + std::to_string(size) + " instructions";
+      ReportDecision(message);
+      *factor = candidate;
+      return true;
+    }
+  }
+
+  message += "not unrolled, every unroll factor exceeds the budget of " +
+             std::to_string(budget_.max_registers) + " registers and " +
+             std::to_string(budget_.max_instructions) + " instructions";
+  ReportDecision(message);
+  return false;
+}
+
+void LoopUnroller::ReportDecision(const std::string& message) {
+  if (decision_report()) {
+    *decision_report() << name() << ": " << message << std::endl;
+  }
+  Log(consumer(), SPV_MSG_DEBUG, name(), {0, 0, 0}, message.c_str());
+}
+
+bool LoopUnroller::UnrollWithHeuristic(Function* func) {
+  LoopDescriptor* LD = context()->GetLoopDescriptor(func);
+  const RegisterLiveness* liveness =
+      context()->GetLivenessAnalysis()->Get(func);
+
+  // Decide on every loop before unrolling any of them, as unrolling makes the
+  // liveness information of the function stale.  Only innermost loops can be
+  // unrolled, so the loops are disjoint.  A loop that becomes innermost once
+  // its nested loops are unrolled is considered by the next run of the pass.
+  struct Decision {
+    Loop* loop;
+    size_t factor;
+    bool fully_unroll;
+  };
+  std::vector<Decision> decisions;
+  for (Loop& loop : *LD) {
+    LoopUtils loop_utils{context(), &loop};
+    if (loop.HasDontUnrollLoopControl() || !loop_utils.CanPerformUnroll()) {
+      continue;
+    }
+
+    const BasicBlock* condition = loop.FindConditionBlock();
+    const Instruction* induction = loop.FindConditionVariable(condition);
+    size_t iterations = 0;
+    loop.FindNumberOfIterations(induction, &*condition->ctail(), &iterations);
+
+    size_t factor = 0;
+    if (ChooseUnrollFactor(loop, iterations, *liveness, &factor)) {
+      decisions.push_back({&loop, factor, factor == iterations});
+    }
+  }
+
+  bool changed = false;
+  for (const Decision& decision : decisions) {
+    LoopUtils loop_utils{context(), decision.loop};
+    if (decision.fully_unroll ? loop_utils.FullyUnroll()
+                              : loop_utils.PartiallyUnroll(decision.factor)) {
+      changed = true;
+    }
+  }
+  return changed;
+}
+
 Pass::Status LoopUnroller::Process() {
   bool changed = false;
   for (Function& f : *context()->module()) {
@@ -1124,6 +1225,12 @@ Pass::Status LoopUnroller::Process() {
     }
 
     LoopDescriptor* LD = context()->GetLoopDescriptor(&f);
+    if (use_heuristic_) {
+      changed |= UnrollWithHeuristic(&f);
+      LD->PostModificationCleanup();
+      continue;
+    }
+
     for (Loop& loop : *LD) {
       LoopUtils loop_utils{context(), &loop};
       if (!loop.HasUnrollLoopControl() || !loop_utils.CanPerformUnroll()) {
@@ -15,6 +15,8 @@
 #ifndef SOURCE_OPT_LOOP_UNROLLER_H_
 #define SOURCE_OPT_LOOP_UNROLLER_H_
 
+#include <cstdint>
+
 #include "source/opt/pass.h"
 
 namespace spvtools {
@@ -22,11 +24,41 @@ namespace opt {
 
 class LoopUnroller : public Pass {
  public:
+  // Limits on the loops produced by the heuristic unrolling mode.
+  struct HeuristicBudget {
+    // The maximum estimated register pressure of an unrolled loop.
+    uint32_t max_registers;
+    // The maximum number of instructions in the unrolled copies of a loop.
+    uint32_t max_instructions;
+  };
+
+  static constexpr uint32_t kDefaultMaxRegisters = 64;
+  static constexpr uint32_t kDefaultMaxUnrolledInstructions = 1024;
+
   LoopUnroller() : Pass(), fully_unroll_(true), unroll_factor_(0) {}
   LoopUnroller(bool fully_unroll, int unroll_factor)
       : Pass(), fully_unroll_(fully_unroll), unroll_factor_(unroll_factor) {}
 
-  const char* name() const override { return "loop-unroll"; }
+  // Creates an unroller that picks the unroll factor of each loop that is not
+  // marked DontUnroll, so that the unrolled loop stays within |budget|.
+  explicit LoopUnroller(const HeuristicBudget& budget)
+      : Pass(),
+        fully_unroll_(false),
+        unroll_factor_(0),
+        use_heuristic_(true),
+        budget_(budget) {}
+
+  const char* name() const override {
+    return use_heuristic_ ? "loop-unroll-heuristic" : "loop-unroll";
+  }
+  std::string CacheKey() const override {
+    if (use_heuristic_) {
+      return std::string(name()) + " " + std::to_string(budget_.max_registers) +
+             " " + std::to_string(budget_.max_instructions);
+    }
+    return std::string(name()) + " " + std::to_string(fully_unroll_) + " " +
+           std::to_string(unroll_factor_);
+  }
 
   Status Process() override;
 
@@ -39,8 +71,28 @@ class LoopUnroller : public Pass {
   }
 
  private:
+  // Unrolls the loops of |func| under |budget_|. Returns true if a loop was
+  // unrolled.
+  bool UnrollWithHeuristic(Function* func);
+
+  // Finds the largest unroll factor of |loop|, which runs |iterations| times,
+  // that keeps the estimated register pressure and size of the unrolled loop
+  // within |budget_|, and stores it in |factor|. A factor equal to
+  // |iterations| is a full unroll. Returns false if there is no such factor.
+  // The decision is written to the decision report and sent to the message
+  // consumer as a debug message.
+  bool ChooseUnrollFactor(const Loop& loop, size_t iterations,
+                          const RegisterLiveness& liveness, size_t* factor);
+
+  // Writes |message|, which describes an unroll decision, to the decision
+  // report and sends it to the message consumer as a debug message.
+  void ReportDecision(const std::string& message);
+
   bool fully_unroll_;
   int unroll_factor_;
+  bool use_heuristic_ = false;
+  HeuristicBudget budget_ = {kDefaultMaxRegisters,
+                             kDefaultMaxUnrolledInstructions};
 };
 
 }  // namespace opt
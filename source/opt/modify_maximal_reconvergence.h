@@ -29,6 +29,9 @@ namespace opt {
 class ModifyMaximalReconvergence : public Pass {
  public:
   const char* name() const override { return "modify-maximal-reconvergence"; }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " + std::to_string(add_);
+  }
   Status Process() override;
 
   explicit ModifyMaximalReconvergence(bool add = true) : Pass(), add_(add) {}
@@ -15,12 +15,15 @@
 #include "source/opt/module.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <ostream>
+#include <thread>
 
 #include "source/operand.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/reflect.h"
+#include "source/spirv_constant.h"
 
 namespace spvtools {
 namespace opt {
@@ -138,110 +141,293 @@ void Module::ForEachInst(const std::function<void(const Instruction*)>& f,
 #undef DELEGATE
 }
 
-void Module::ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const {
-  binary->push_back(header_.magic_number);
-  binary->push_back(header_.version);
-  // TODO(antiagainst): should we change the generator number?
-  binary->push_back(header_.generator);
-  binary->push_back(header_.bound);
-  binary->push_back(header_.schema);
+namespace {
 
-  size_t bound_idx = binary->size() - 2;
-  DebugScope last_scope(kNoDebugScope, kNoInlinedAt);
+// The ids used by the debug instructions created while serializing a module.
+struct DebugInfoIds {
+  // The NonSemantic.Shader.DebugInfo.100 and OpenCL.DebugInfo.100 sets.
+  uint32_t shader_set = 0;
+  uint32_t opencl_set = 0;
+  uint32_t void_type = 0;
+};
+
+// The state carried from one instruction to the next while serializing a
+// module, which decides where line and scope instructions are emitted.
+struct SerializerState {
+  DebugScope last_scope{kNoDebugScope, kNoInlinedAt};
   const Instruction* last_line_inst = nullptr;
   bool between_merge_and_branch = false;
   bool between_label_and_phi_var = false;
-  auto write_inst = [binary, skip_nop, &last_scope, &last_line_inst,
-                     &between_merge_and_branch, &between_label_and_phi_var,
-                     this](const Instruction* i) {
-    // Skip emitting line instructions between merge and branch instructions.
-    auto opcode = i->opcode();
-    if (between_merge_and_branch && i->IsLineInst()) {
+};
+
+// Where the serialization of a part of the module starts.
+struct Checkpoint {
+  // The number of words before the part, after the header.
+  size_t offset = 0;
+  // The number of new ids used before the part.
+  size_t next_id = 0;
+  SerializerState state;
+};
+
+// Serializes the instructions of a module, in module order.
+//
+// A writer first counts the words without writing them, and takes the ids of
+// the debug instructions it creates.  A writer can then write the words at
+// their final place, using the same ids, from any checkpoint recorded while
+// counting.  Since both make the same decisions, the word counts match.
+class BinaryWriter {
+ public:
+  // Creates a writer which counts words, and appends the ids it takes to
+  // |new_ids|.
+  BinaryWriter(const Module& module, const DebugInfoIds& debug_ids,
+               bool skip_nop, std::vector<uint32_t>* new_ids)
+      : module_(module),
+        debug_ids_(debug_ids),
+        skip_nop_(skip_nop),
+        new_ids_(new_ids) {}
+
+  // Makes the writer write the words after |checkpoint| to |words|, which
+  // holds the words after the header.
+  void StartWriting(uint32_t* words, const Checkpoint& checkpoint) {
+    out_ = words;
+    words_ = checkpoint.offset;
+    next_id_ = checkpoint.next_id;
+    state_ = checkpoint.state;
+  }
+
+  Checkpoint checkpoint() const { return {words_, next_id_, state_}; }
+
+  // Serializes |inst|, preceded by the line and scope instructions needed.
+  void Write(const Instruction* inst);
+
+ private:
+  void Emit(uint32_t word) {
+    if (out_) out_[words_] = word;
+    ++words_;
+  }
+
+  // Emits |inst| without its attached debug line instructions.
+  void EmitInstruction(const Instruction& inst) {
+    if (!out_) {
+      words_ += 1 + inst.NumOperandWords();
       return;
     }
-    if (last_line_inst != nullptr) {
-      // If the current instruction is OpLine or DebugLine and it is the same
-      // as the last line instruction that is still effective (can be applied
-      // to the next instruction), we skip writing the current instruction.
-      if (i->IsLine()) {
-        uint32_t operand_index = 0;
-        if (last_line_inst->WhileEachInOperand(
-                [&operand_index, i](const uint32_t* word) {
-                  assert(i->NumInOperandWords() > operand_index);
-                  return *word == i->GetSingleWordInOperand(operand_index++);
-                })) {
-          return;
-        }
-      } else if (!i->IsNoLine() && i->dbg_line_insts().empty()) {
-        // If the current instruction does not have the line information,
-        // the last line information is not effective any more. Emit OpNoLine
-        // or DebugNoLine to specify it.
-        uint32_t shader_set_id = context()
-                                     ->get_feature_mgr()
-                                     ->GetExtInstImportId_Shader100DebugInfo();
-        if (shader_set_id != 0) {
-          binary->push_back((5 << 16) |
-                            static_cast<uint16_t>(spv::Op::OpExtInst));
-          binary->push_back(context()->get_type_mgr()->GetVoidTypeId());
-          binary->push_back(context()->TakeNextId());
-          binary->push_back(shader_set_id);
-          binary->push_back(NonSemanticShaderDebugInfo100DebugNoLine);
-        } else {
-          binary->push_back((1 << 16) |
-                            static_cast<uint16_t>(spv::Op::OpNoLine));
-        }
-        last_line_inst = nullptr;
-      }
+    uint32_t* const first = out_ + words_;
+    uint32_t* out = first + 1;
+    for (const auto& operand : inst) {
+      out = std::copy(operand.words.begin(), operand.words.end(), out);
     }
+    const auto num_words = static_cast<uint32_t>(out - first);
+    *first = (num_words << 16) | static_cast<uint16_t>(inst.opcode());
+    words_ += num_words;
+  }
+
+  uint32_t TakeNextId() {
+    if (!out_) new_ids_->push_back(module_.context()->TakeNextId());
+    return (*new_ids_)[next_id_++];
+  }
 
-    if (opcode == spv::Op::OpLabel) {
-      between_label_and_phi_var = true;
-    } else if (opcode != spv::Op::OpVariable && opcode != spv::Op::OpPhi &&
-               !spvtools::opt::IsOpLineInst(opcode)) {
-      between_label_and_phi_var = false;
+  const Module& module_;
+  const DebugInfoIds& debug_ids_;
+  const bool skip_nop_;
+  std::vector<uint32_t>* const new_ids_;
+  // The output, or null while counting.
+  uint32_t* out_ = nullptr;
+  size_t words_ = 0;
+  size_t next_id_ = 0;
+  SerializerState state_;
+  // Reused for DebugScope instructions.
+  std::vector<uint32_t> scope_words_;
+};
+
+void BinaryWriter::Write(const Instruction* i) {
+  // Skip emitting line instructions between merge and branch instructions.
+  auto opcode = i->opcode();
+  if (state_.between_merge_and_branch && i->IsLineInst()) {
+    return;
+  }
+  if (state_.last_line_inst != nullptr) {
+    // If the current instruction is OpLine or DebugLine and it is the same
+    // as the last line instruction that is still effective (can be applied
+    // to the next instruction), we skip writing the current instruction.
+    if (i->IsLine()) {
+      uint32_t operand_index = 0;
+      if (state_.last_line_inst->WhileEachInOperand(
+              [&operand_index, i](const uint32_t* word) {
+                assert(i->NumInOperandWords() > operand_index);
+                return *word == i->GetSingleWordInOperand(operand_index++);
+              })) {
+        return;
+      }
+    } else if (!i->IsNoLine() && i->dbg_line_insts().empty()) {
+      // If the current instruction does not have the line information,
+      // the last line information is not effective any more. Emit OpNoLine
+      // or DebugNoLine to specify it.
+      if (debug_ids_.shader_set != 0) {
+        Emit((5 << 16) | static_cast<uint16_t>(spv::Op::OpExtInst));
+        Emit(debug_ids_.void_type);
+        Emit(TakeNextId());
+        Emit(debug_ids_.shader_set);
+        Emit(NonSemanticShaderDebugInfo100DebugNoLine);
+      } else {
+        Emit((1 << 16) | static_cast<uint16_t>(spv::Op::OpNoLine));
+      }
+      state_.last_line_inst = nullptr;
     }
+  }
 
-    if (!(skip_nop && i->IsNop())) {
-      const auto& scope = i->GetDebugScope();
-      if (scope != last_scope && !between_merge_and_branch) {
-        // Can only emit nonsemantic instructions after all phi instructions
-        // in a block so don't emit scope instructions before phi instructions
-        // for NonSemantic.Shader.DebugInfo.100.
-        if (!between_label_and_phi_var ||
-            context()
-                ->get_feature_mgr()
-                ->GetExtInstImportId_OpenCL100DebugInfo()) {
-          // Emit DebugScope |scope| to |binary|.
-          auto dbg_inst = ext_inst_debuginfo_.begin();
-          // The dbg_inst may have been cleared to a Nop, in which case
-          // ignore it.
-          if (!dbg_inst->IsNop()) {
-            scope.ToBinary(dbg_inst->type_id(), context()->TakeNextId(),
-                           dbg_inst->GetSingleWordOperand(2), binary);
-          }
+  if (opcode == spv::Op::OpLabel) {
+    state_.between_label_and_phi_var = true;
+  } else if (opcode != spv::Op::OpVariable && opcode != spv::Op::OpPhi &&
+             !spvtools::opt::IsOpLineInst(opcode)) {
+    state_.between_label_and_phi_var = false;
+  }
+
+  if (!(skip_nop_ && i->IsNop())) {
+    const auto& scope = i->GetDebugScope();
+    if (scope != state_.last_scope && !state_.between_merge_and_branch) {
+      // Can only emit nonsemantic instructions after all phi instructions
+      // in a block so don't emit scope instructions before phi instructions
+      // for NonSemantic.Shader.DebugInfo.100.
+      if (!state_.between_label_and_phi_var || debug_ids_.opencl_set) {
+        // Emit DebugScope |scope| to |binary|.
+        auto dbg_inst = module_.ext_inst_debuginfo().begin();
+        // The dbg_inst may have been cleared to a Nop, in which case
+        // ignore it.
+        if (!dbg_inst->IsNop()) {
+          scope_words_.clear();
+          scope.ToBinary(dbg_inst->type_id(), TakeNextId(),
+                         dbg_inst->GetSingleWordOperand(2), &scope_words_);
+          for (uint32_t word : scope_words_) Emit(word);
         }
-        last_scope = scope;
       }
-
-      i->ToBinaryWithoutAttachedDebugInsts(binary);
+      state_.last_scope = scope;
     }
-    // Update the last line instruction.
-    between_merge_and_branch = false;
-    if (spvOpcodeIsBlockTerminator(opcode) || i->IsNoLine()) {
-      last_line_inst = nullptr;
-    } else if (opcode == spv::Op::OpLoopMerge ||
-               opcode == spv::Op::OpSelectionMerge) {
-      between_merge_and_branch = true;
-      last_line_inst = nullptr;
-    } else if (i->IsLine()) {
-      last_line_inst = i;
+
+    EmitInstruction(*i);
+  }
+  // Update the last line instruction.
+  state_.between_merge_and_branch = false;
+  if (spvOpcodeIsBlockTerminator(opcode) || i->IsNoLine()) {
+    state_.last_line_inst = nullptr;
+  } else if (opcode == spv::Op::OpLoopMerge ||
+             opcode == spv::Op::OpSelectionMerge) {
+    state_.between_merge_and_branch = true;
+    state_.last_line_inst = nullptr;
+  } else if (i->IsLine()) {
+    state_.last_line_inst = i;
+  }
+}
+
+}  // namespace
+
+void Module::ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const {
+  ToBinary(binary, skip_nop, 1);
+}
+
+void Module::ToBinary(std::vector<uint32_t>* binary, bool skip_nop,
+                      size_t num_threads) const {
+  // Looked up first, since looking up the void type may add it to the module.
+  DebugInfoIds debug_ids;
+  if (!ext_inst_imports_.empty()) {
+    auto* feature_mgr = context()->get_feature_mgr();
+    debug_ids.shader_set = feature_mgr->GetExtInstImportId_Shader100DebugInfo();
+    debug_ids.opencl_set = feature_mgr->GetExtInstImportId_OpenCL100DebugInfo();
+    if (debug_ids.shader_set != 0) {
+      debug_ids.void_type = GetGlobalValue(spv::Op::OpTypeVoid);
+      if (debug_ids.void_type == 0) {
+        debug_ids.void_type = context()->get_type_mgr()->GetVoidTypeId();
+      }
     }
+  }
+
+  // Runs |f| on the instructions before the functions, in the order of
+  // ForEachInst.
+  auto for_each_global_inst = [this](auto&& f) {
+    auto run = [&f](const Instruction& inst) {
+      for (const auto& dbg_line : inst.dbg_line_insts()) f(&dbg_line);
+      f(&inst);
+    };
+    for (const auto& i : capabilities_) run(i);
+    for (const auto& i : extensions_) run(i);
+    for (const auto& i : ext_inst_imports_) run(i);
+    if (memory_model_) run(*memory_model_);
+    if (sampled_image_address_mode_) run(*sampled_image_address_mode_);
+    for (const auto& i : entry_points_) run(i);
+    for (const auto& i : execution_modes_) run(i);
+    for (const auto& i : debugs1_) run(i);
+    for (const auto& i : debugs2_) run(i);
+    for (const auto& i : debugs3_) run(i);
+    for (const auto& i : annotations_) run(i);
+    for (const auto& i : types_values_) run(i);
+    for (const auto& i : ext_inst_debuginfo_) run(i);
+  };
+  auto for_each_trailing_inst = [this](auto&& f) {
+    for (const auto& i : trailing_dbg_line_info_) f(&i);
   };
-  ForEachInst(write_inst, true);
 
-  // We create new instructions for DebugScope and DebugNoLine. The bound must
-  // be updated.
-  binary->data()[bound_idx] = header_.bound;
+  // Counts the words, and records where each function starts.  The ids of
+  // the debug instructions are taken in module order, as they are needed.
+  std::vector<uint32_t> new_ids;
+  BinaryWriter counter(*this, debug_ids, skip_nop, &new_ids);
+  auto count = [&counter](const Instruction* inst) { counter.Write(inst); };
+  for_each_global_inst(count);
+  std::vector<Checkpoint> function_starts;
+  function_starts.reserve(functions_.size());
+  for (const auto& function : functions_) {
+    function_starts.push_back(counter.checkpoint());
+    function->ForEachInstInlined(count);
+  }
+  const Checkpoint trailing_start = counter.checkpoint();
+  for_each_trailing_inst(count);
+  const size_t num_words = counter.checkpoint().offset;
+
+  // The debug instructions took new ids, so the bound is only known now.
+  const size_t header_offset = binary->size();
+  binary->resize(header_offset + SPV_INDEX_INSTRUCTION + num_words);
+  uint32_t* const header = binary->data() + header_offset;
+  header[SPV_INDEX_MAGIC_NUMBER] = header_.magic_number;
+  header[SPV_INDEX_VERSION_NUMBER] = header_.version;
+  // TODO(antiagainst): should we change the generator number?
+  header[SPV_INDEX_GENERATOR_NUMBER] = header_.generator;
+  header[SPV_INDEX_BOUND] = header_.bound;
+  header[SPV_INDEX_SCHEMA] = header_.schema;
+  uint32_t* const words = header + SPV_INDEX_INSTRUCTION;
+
+  BinaryWriter writer(*this, debug_ids, skip_nop, &new_ids);
+  auto write = [&writer](const Instruction* inst) { writer.Write(inst); };
+  writer.StartWriting(words, Checkpoint());
+  for_each_global_inst(write);
+
+  num_threads = std::min(num_threads, functions_.size());
+  if (num_threads <= 1) {
+    for (const auto& function : functions_) {
+      function->ForEachInstInlined(write);
+    }
+  } else {
+    // Each function is written from the state it starts with, at its place.
+    std::atomic<size_t> next(0);
+    auto work = [this, &debug_ids, skip_nop, &new_ids, &function_starts,
+                 words, &next]() {
+      BinaryWriter function_writer(*this, debug_ids, skip_nop, &new_ids);
+      auto function_write = [&function_writer](const Instruction* inst) {
+        function_writer.Write(inst);
+      };
+      for (size_t i = next++; i < functions_.size(); i = next++) {
+        function_writer.StartWriting(words, function_starts[i]);
+        functions_[i]->ForEachInstInlined(function_write);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) threads.emplace_back(work);
+    work();
+    for (std::thread& thread : threads) thread.join();
+  }
+
+  writer.StartWriting(words, trailing_start);
+  for_each_trailing_inst(write);
+  assert(writer.checkpoint().offset == num_words &&
+         "Serialized size differs from the counted size");
 }
 
 uint32_t Module::ComputeIdBound() const {
@@ -262,6 +262,11 @@ class Module {
   // Pushes the binary segments for this instruction into the back of *|binary|.
   // If |skip_nop| is true and this is a OpNop, do nothing.
   void ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const;
+  // Same as above, but writes the functions on up to |num_threads| threads.
+  // The words of each function are written at an offset computed
+  // beforehand, so the binary is the same.
+  void ToBinary(std::vector<uint32_t>* binary, bool skip_nop,
+                size_t num_threads) const;
 
   // Returns 1 more than the maximum Id value mentioned in the module.
   uint32_t ComputeIdBound() const;
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_OPCODE_RULE_TABLE_H_
+#define SOURCE_OPT_OPCODE_RULE_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "source/latest_version_spirv_header.h"
+
+namespace spvtools {
+namespace opt {
+
+// A table mapping core opcodes to a set of rules, indexed directly by opcode.
+//
+// The folder looks up the rules for every instruction it visits, and most
+// opcodes have no rules at all.  Rather than hashing the opcode, the table
+// keeps a dense array of 16-bit slots indexed by opcode.  A zero slot means
+// there are no rules for the opcode, so the common negative lookup is a bounds
+// check and a single load.  Non-zero slots are 1-based indices into a compact
+// vector of rule sets, so the table only costs two bytes per opcode up to the
+// largest opcode that has a rule.
+//
+// |RuleSet| must be default constructible and provide |empty()|.
+template <class RuleSet>
+class OpcodeRuleTable {
+ public:
+  OpcodeRuleTable() = default;
+
+  // Returns the rule set for |opcode|, creating an empty one if needed.  This
+  // is meant to be used while populating the table.
+  RuleSet& operator[](spv::Op opcode) {
+    const uint32_t index = static_cast<uint32_t>(opcode);
+    if (index >= slots_.size()) {
+      slots_.resize(index + 1, 0);
+    }
+    if (slots_[index] == 0) {
+      rule_sets_.emplace_back();
+      slots_[index] = static_cast<uint16_t>(rule_sets_.size());
+    }
+    return rule_sets_[slots_[index] - 1];
+  }
+
+  // Returns the rule set for |opcode|, or nullptr if no rule set was ever
+  // created for it.
+  const RuleSet* Find(spv::Op opcode) const {
+    const uint32_t index = static_cast<uint32_t>(opcode);
+    if (index >= slots_.size() || slots_[index] == 0) {
+      return nullptr;
+    }
+    return &rule_sets_[slots_[index] - 1];
+  }
+
+  // Returns true if there is at least one rule for |opcode|.
+  bool HasRules(spv::Op opcode) const {
+    const RuleSet* rules = Find(opcode);
+    return rules != nullptr && !rules->empty();
+  }
+
+ private:
+  // |slots_[opcode]| is 0 if there are no rules for |opcode|, and otherwise
+  // is one more than the index of its rules in |rule_sets_|.  Opcodes are 16
+  // bits wide, so the number of rule sets always fits.
+  std::vector<uint16_t> slots_;
+
+  // The rule sets in the order their opcodes were first added.
+  std::vector<RuleSet> rule_sets_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_OPCODE_RULE_TABLE_H_
@@ -14,9 +14,11 @@
 
 #include "spirv-tools/optimizer.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <charconv>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <system_error>
 #include <unordered_map>
@@ -26,10 +28,12 @@
 #include "source/opt/build_module.h"
 #include "source/opt/graphics_robust_access_pass.h"
 #include "source/opt/log.h"
+#include "source/opt/optimizer_cache.h"
 #include "source/opt/pass_manager.h"
 #include "source/opt/passes.h"
 #include "source/spirv_optimizer_options.h"
 #include "source/util/make_unique.h"
+#include "source/util/parse_number.h"
 #include "source/util/string_utils.h"
 
 namespace spvtools {
@@ -69,11 +73,108 @@ Optimizer::PassToken::~PassToken() {}
 struct Optimizer::Impl {
   explicit Impl(spv_target_env env) : target_env(env), pass_manager() {}
 
+  // Records the passes registered by a flag or recipe as a single entry in
+  // |pipeline|, for as long as the object lives.  Registrations nested inside
+  // another one are described by the outermost one.
+  class ScopedRegistration {
+   public:
+    ScopedRegistration(Impl* impl, const std::string& description,
+                       bool preserve_interface)
+        : impl_(impl) {
+      if (impl_->registration_depth++ == 0) {
+        impl_->pipeline.push_back(description +
+                                  (preserve_interface ? " preserve" : ""));
+      }
+    }
+    ~ScopedRegistration() { --impl_->registration_depth; }
+
+   private:
+    Impl* impl_;
+  };
+
+  // Returns a description of everything other than the input binary that
+  // affects the result of Optimizer::Run with |opt_options|.
+  std::string CacheDescriptor(const spv_optimizer_options opt_options) const;
+
+  // Reports a cache lookup for |key| to the message consumer and the time
+  // report stream.
+  void ReportCacheLookup(const std::string& key, bool hit);
+
   spv_target_env target_env;      // Target environment.
   opt::PassManager pass_manager;  // Internal implementation pass manager.
   std::unordered_set<uint32_t> live_locs;  // Arg to debug dead output passes
+
+  // One entry for each flag, recipe or pass registered since the last run.
+  // Passes are described by their Pass::CacheKey.  An empty entry is a pass
+  // whose result cannot be cached.
+  std::vector<std::string> pipeline;
+  // The number of flag or recipe registrations in progress.
+  uint32_t registration_depth = 0;
+
+  // Settings forwarded to |pass_manager| that the cache needs to know about.
+  std::ostream* print_all_stream = nullptr;
+  std::ostream* time_report_stream = nullptr;
+  std::ostream* profile_stream = nullptr;
+  std::ostream* decision_report_stream = nullptr;
+  bool validate_after_all = false;
+
+  // The threshold set by --loop-peeling-threshold, and the passes registered
+  // by --loop-peeling since the last run.  The threshold applies to all of
+  // them, whether the flag comes before or after them.
+  size_t loop_peeling_threshold =
+      opt::LoopPeelingPass::kDefaultCodeGrowThreshold;
+  std::vector<opt::LoopPeelingPass*> loop_peeling_passes;
+
+  OptimizerCache* cache = nullptr;  // Not owned.  Null when not caching.
+  size_t cache_hits = 0;
+  size_t cache_misses = 0;
 };
 
+std::string Optimizer::Impl::CacheDescriptor(
+    const spv_optimizer_options opt_options) const {
+  const spv_validator_options_t& val = opt_options->val_options_;
+  const validator_universal_limits_t& limits = val.universal_limits_;
+  std::ostringstream str;
+  str << spvSoftwareVersionDetailsString() << "\n"
+      << "env " << static_cast<int>(target_env) << "\n"
+      << "options " << opt_options->run_validator_ << " "
+      << opt_options->max_id_bound_ << " " << opt_options->preserve_bindings_
+      << " " << opt_options->preserve_spec_constants_ << " "
+      << validate_after_all << "\n"
+      << "limits " << limits.max_struct_members << " "
+      << limits.max_struct_depth << " " << limits.max_local_variables << " "
+      << limits.max_global_variables << " " << limits.max_switch_branches
+      << " " << limits.max_function_args << " "
+      << limits.max_control_flow_nesting_depth << " "
+      << limits.max_access_chain_indexes << " " << limits.max_id_bound << "\n"
+      << "validator " << val.relax_struct_store << val.relax_logical_pointer
+      << val.relax_block_layout << val.uniform_buffer_standard_layout
+      << val.scalar_block_layout << val.workgroup_scalar_block_layout
+      << val.skip_block_layout << val.allow_localsizeid
+      << val.allow_offset_texture_operand << val.allow_vulkan_32_bit_bitwise
+      << val.before_hlsl_legalization << "\n";
+  for (const std::string& entry : pipeline) {
+    str << "pass " << entry << "\n";
+  }
+  return str.str();
+}
+
+void Optimizer::Impl::ReportCacheLookup(const std::string& key, bool hit) {
+  if (hit) {
+    ++cache_hits;
+  } else {
+    ++cache_misses;
+  }
+  std::ostringstream str;
+  str << "Optimizer cache " << (hit ? "hit" : "miss") << " for " << key << " ("
+      << cache_hits << " hits, " << cache_misses << " misses)";
+  spv_position_t null_pos{0, 0, 0};
+  Log(pass_manager.consumer(), SPV_MSG_DEBUG, "", null_pos, str.str().c_str());
+  if (time_report_stream) {
+    *time_report_stream << str.str() << std::endl;
+  }
+}
+
 Optimizer::Optimizer(spv_target_env env) : impl_(new Impl(env)) {
   assert(env != SPV_ENV_WEBGPU_0);
 }
@@ -93,12 +194,41 @@ const MessageConsumer& Optimizer::consumer() const {
 }
 
 Optimizer& Optimizer::RegisterPass(PassToken&& p) {
+  if (impl_->registration_depth == 0) {
+    impl_->pipeline.push_back(p.impl_->pass->CacheKey());
+  }
   // Change to use the pass manager's consumer.
   p.impl_->pass->SetMessageConsumer(consumer());
   impl_->pass_manager.AddPass(std::move(p.impl_->pass));
   return *this;
 }
 
+Optimizer& Optimizer::RegisterFixedPointGroup(
+    std::vector<std::function<PassToken()>> pass_factories,
+    uint32_t max_rounds) {
+  if (impl_->registration_depth == 0) {
+    std::string description = "fixed-point " + std::to_string(max_rounds);
+    for (const auto& factory : pass_factories) {
+      const std::string key = factory().impl_->pass->CacheKey();
+      if (key.empty()) {
+        description.clear();
+        break;
+      }
+      description += " (" + key + ")";
+    }
+    impl_->pipeline.push_back(description);
+  }
+
+  std::vector<std::function<std::unique_ptr<opt::Pass>()>> factories;
+  factories.reserve(pass_factories.size());
+  for (auto& factory : pass_factories) {
+    factories.push_back(
+        [factory]() { return std::move(factory().impl_->pass); });
+  }
+  impl_->pass_manager.AddFixedPointGroup(std::move(factories), max_rounds);
+  return *this;
+}
+
 // The legalization passes take a spir-v shader generated by an HLSL front-end
 // and turn it into a valid vulkan spir-v shader.  There are two ways in which
 // the code will be invalid at the start:
@@ -121,6 +251,8 @@ Optimizer& Optimizer::RegisterPass(PassToken&& p) {
 // problem.  The optimization we use are all used to either do copy propagation
 // or enable more copy propagation.
 Optimizer& Optimizer::RegisterLegalizationPasses(bool preserve_interface) {
+  Impl::ScopedRegistration recipe(impl_.get(), "--legalize-hlsl",
+                                  preserve_interface);
   return
       // Wrap OpKill instructions so all other code can be inlined.
       RegisterPass(CreateWrapOpKillPass())
@@ -179,10 +311,11 @@ Optimizer& Optimizer::RegisterLegalizationPasses() {
 }
 
 Optimizer& Optimizer::RegisterPerformancePasses(bool preserve_interface) {
+  Impl::ScopedRegistration recipe(impl_.get(), "-O", preserve_interface);
   return RegisterPass(CreateWrapOpKillPass())
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateMergeReturnPass())
-      .RegisterPass(CreateInlineExhaustivePass())
+      .RegisterPass(CreateInlineCostModelPass())
       .RegisterPass(CreateEliminateDeadFunctionsPass())
       .RegisterPass(CreateAggressiveDCEPass(preserve_interface))
       .RegisterPass(CreatePrivateToLocalPass())
@@ -200,6 +333,7 @@ Optimizer& Optimizer::RegisterPerformancePasses(bool preserve_interface) {
       .RegisterPass(CreateAggressiveDCEPass(preserve_interface))
       .RegisterPass(CreateLoopUnrollPass(true))
       .RegisterPass(CreateDeadBranchElimPass())
+      .RegisterPass(CreateAggressiveLoopInvariantCodeMotionPass())
       .RegisterPass(CreateRedundancyEliminationPass())
       .RegisterPass(CreateCombineAccessChainsPass())
       .RegisterPass(CreateSimplificationPass())
@@ -230,6 +364,7 @@ Optimizer& Optimizer::RegisterPerformancePasses() {
 }
 
 Optimizer& Optimizer::RegisterSizePasses(bool preserve_interface) {
+  Impl::ScopedRegistration recipe(impl_.get(), "-Os", preserve_interface);
   return RegisterPass(CreateWrapOpKillPass())
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateMergeReturnPass())
@@ -307,6 +442,8 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag,
     return false;
   }
 
+  Impl::ScopedRegistration registration(impl_.get(), flag, preserve_interface);
+
   // Split flags of the form --pass_name=pass_args.
   auto p = utils::SplitFlagArgs(flag);
   std::string pass_name = p.first;
@@ -353,6 +490,8 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag,
     RegisterPass(CreateFreezeSpecConstantValuePass());
   } else if (pass_name == "inline-entry-points-exhaustive") {
     RegisterPass(CreateInlineExhaustivePass());
+  } else if (pass_name == "inline-cost-model") {
+    RegisterPass(CreateInlineCostModelPass());
   } else if (pass_name == "inline-entry-points-opaque") {
     RegisterPass(CreateInlineOpaquePass());
   } else if (pass_name == "combine-access-chains") {
@@ -431,6 +570,17 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag,
     RegisterPass(CreateLocalRedundancyEliminationPass());
   } else if (pass_name == "loop-invariant-code-motion") {
     RegisterPass(CreateLoopInvariantCodeMotionPass());
+  } else if (pass_name == "loop-invariant-code-motion-aggressive") {
+    uint32_t max_registers = opt::LICMPass::kDefaultMaxRegisters;
+    if (pass_args.size() > 0 &&
+        !utils::ParseNumber(pass_args.c_str(), &max_registers)) {
+      Errorf(consumer(), nullptr, {},
+             "Invalid argument for --loop-invariant-code-motion-aggressive: "
+             "%s",
+             pass_args.c_str());
+      return false;
+    }
+    RegisterPass(CreateAggressiveLoopInvariantCodeMotionPass(max_registers));
   } else if (pass_name == "reduce-load-size") {
     if (pass_args.size() == 0) {
       RegisterPass(CreateReduceLoadSizePass());
@@ -493,6 +643,29 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag,
     }
   } else if (pass_name == "loop-unroll") {
     RegisterPass(CreateLoopUnrollPass(true));
+  } else if (pass_name == "loop-unroll-heuristic") {
+    // The optional argument is <max registers>[:<max instructions>].
+    uint32_t max_registers = opt::LoopUnroller::kDefaultMaxRegisters;
+    uint32_t max_instructions =
+        opt::LoopUnroller::kDefaultMaxUnrolledInstructions;
+    if (pass_args.size() > 0) {
+      auto separator_pos = pass_args.find(':');
+      const std::string registers = pass_args.substr(0, separator_pos);
+      const std::string instructions =
+          separator_pos == std::string::npos
+              ? std::string()
+              : pass_args.substr(separator_pos + 1);
+      if (!utils::ParseNumber(registers.c_str(), &max_registers) ||
+          (separator_pos != std::string::npos &&
+           !utils::ParseNumber(instructions.c_str(), &max_instructions))) {
+        Errorf(consumer(), nullptr, {},
+               "Invalid argument for --loop-unroll-heuristic: %s",
+               pass_args.c_str());
+        return false;
+      }
+    }
+    RegisterPass(
+        CreateLoopUnrollHeuristicPass(max_registers, max_instructions));
   } else if (pass_name == "upgrade-memory-model") {
     RegisterPass(CreateUpgradeMemoryModelPass());
   } else if (pass_name == "vector-dce") {
@@ -507,11 +680,17 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag,
       return false;
     }
   } else if (pass_name == "loop-peeling") {
-    RegisterPass(CreateLoopPeelingPass());
+    auto pass = MakeUnique<opt::LoopPeelingPass>(
+        nullptr, impl_->loop_peeling_threshold);
+    impl_->loop_peeling_passes.push_back(pass.get());
+    RegisterPass(PassToken(std::move(pass)));
   } else if (pass_name == "loop-peeling-threshold") {
     int factor = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 0;
     if (factor > 0) {
-      opt::LoopPeelingPass::SetLoopPeelingThreshold(factor);
+      impl_->loop_peeling_threshold = factor;
+      for (opt::LoopPeelingPass* pass : impl_->loop_peeling_passes) {
+        pass->SetLoopPeelingThreshold(factor);
+      }
     } else {
       Error(consumer(), nullptr, {},
             "--loop-peeling-threshold must have a positive integer argument");
@@ -678,6 +857,30 @@ bool Optimizer::Run(const uint32_t* original_binary,
                     const size_t original_binary_size,
                     std::vector<uint32_t>* optimized_binary,
                     const spv_optimizer_options opt_options) const {
+  // Printing the IR before each pass, profiling them or reporting their
+  // decisions requires running them.
+  std::string cache_key;
+  if (impl_->cache != nullptr && impl_->print_all_stream == nullptr &&
+      impl_->profile_stream == nullptr &&
+      impl_->decision_report_stream == nullptr &&
+      std::find(impl_->pipeline.begin(), impl_->pipeline.end(),
+                std::string()) == impl_->pipeline.end()) {
+    cache_key = opt::ComputeOptimizerCacheKey(
+        impl_->CacheDescriptor(opt_options), original_binary,
+        original_binary_size);
+    std::vector<uint32_t> cached_binary;
+    if (impl_->cache->Lookup(cache_key, &cached_binary)) {
+      impl_->ReportCacheLookup(cache_key, true);
+      // Consume the passes just like a real run would.
+      impl_->pass_manager.ClearPasses();
+      impl_->pipeline.clear();
+      impl_->loop_peeling_passes.clear();
+      *optimized_binary = std::move(cached_binary);
+      return true;
+    }
+    impl_->ReportCacheLookup(cache_key, false);
+  }
+
   spvtools::SpirvTools tools(impl_->target_env);
   tools.SetMessageConsumer(impl_->pass_manager.consumer());
   if (opt_options->run_validator_ &&
@@ -697,10 +900,13 @@ bool Optimizer::Run(const uint32_t* original_binary,
   impl_->pass_manager.SetValidatorOptions(&opt_options->val_options_);
   impl_->pass_manager.SetTargetEnv(impl_->target_env);
   auto status = impl_->pass_manager.Run(context.get());
+  // The pass manager has destroyed the passes that ran.
+  impl_->loop_peeling_passes.clear();
 
   if (status == opt::Pass::Status::Failure) {
     return false;
   }
+  impl_->pipeline.clear();
 
 #ifndef NDEBUG
   // We do not keep the result id of DebugScope in struct DebugScope.
@@ -735,24 +941,48 @@ bool Optimizer::Run(const uint32_t* original_binary,
   optimized_binary->clear();
   context->module()->ToBinary(optimized_binary, /* skip_nop = */ true);
 
+  if (!cache_key.empty()) {
+    impl_->cache->Store(cache_key, *optimized_binary);
+  }
+
   return true;
 }
 
 Optimizer& Optimizer::SetPrintAll(std::ostream* out) {
+  impl_->print_all_stream = out;
   impl_->pass_manager.SetPrintAll(out);
   return *this;
 }
 
 Optimizer& Optimizer::SetTimeReport(std::ostream* out) {
+  impl_->time_report_stream = out;
   impl_->pass_manager.SetTimeReport(out);
   return *this;
 }
 
+Optimizer& Optimizer::SetProfileReport(std::ostream* out) {
+  impl_->profile_stream = out;
+  impl_->pass_manager.SetProfileReport(out);
+  return *this;
+}
+
+Optimizer& Optimizer::SetDecisionReport(std::ostream* out) {
+  impl_->decision_report_stream = out;
+  impl_->pass_manager.SetDecisionReport(out);
+  return *this;
+}
+
 Optimizer& Optimizer::SetValidateAfterAll(bool validate) {
+  impl_->validate_after_all = validate;
   impl_->pass_manager.SetValidateAfterAll(validate);
   return *this;
 }
 
+Optimizer& Optimizer::SetCache(OptimizerCache* cache) {
+  impl_->cache = cache;
+  return *this;
+}
+
 Optimizer::PassToken CreateNullPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::NullPass>());
 }
@@ -838,6 +1068,11 @@ Optimizer::PassToken CreateInlineExhaustivePass() {
       MakeUnique<opt::InlineExhaustivePass>());
 }
 
+Optimizer::PassToken CreateInlineCostModelPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InlineCostModelPass>());
+}
+
 Optimizer::PassToken CreateInlineOpaquePass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::InlineOpaquePass>());
@@ -949,6 +1184,12 @@ Optimizer::PassToken CreateLoopInvariantCodeMotionPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::LICMPass>());
 }
 
+Optimizer::PassToken CreateAggressiveLoopInvariantCodeMotionPass(
+    uint32_t max_registers) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::LICMPass>(max_registers));
+}
+
 Optimizer::PassToken CreateLoopPeelingPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::LoopPeelingPass>());
@@ -1008,6 +1249,12 @@ Optimizer::PassToken CreateLoopUnrollPass(bool fully_unroll, int factor) {
       MakeUnique<opt::LoopUnroller>(fully_unroll, factor));
 }
 
+Optimizer::PassToken CreateLoopUnrollHeuristicPass(uint32_t max_registers,
+                                                   uint32_t max_instructions) {
+  return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::LoopUnroller>(
+      opt::LoopUnroller::HeuristicBudget{max_registers, max_instructions}));
+}
+
 Optimizer::PassToken CreateSSARewritePass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::SSARewritePass>());
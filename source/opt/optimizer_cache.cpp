@@ -0,0 +1,231 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/optimizer_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "source/util/make_unique.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// Identifies a file written by DirectoryOptimizerCache.  The second word is
+// the version of the file format.
+constexpr uint32_t kCacheFileMagic = 0x434f5053;  // "SPOC"
+constexpr uint32_t kCacheFileVersion = 1;
+
+// A 128-bit hash built from two independent 64-bit lanes.  It is not
+// cryptographic, but collisions between distinct modules are unlikely enough
+// for a build cache.
+class KeyHasher {
+ public:
+  void AddWord(uint32_t word) {
+    lo_ = (lo_ ^ word) * 0x100000001b3ull;
+    hi_ = RotateLeft(hi_ ^ (word * 0xc2b2ae3d27d4eb4full), 31) *
+          0x9e3779b97f4a7c15ull;
+  }
+
+  void AddString(const std::string& str) {
+    AddWord(static_cast<uint32_t>(str.size()));
+    for (char c : str) {
+      AddWord(static_cast<unsigned char>(c));
+    }
+  }
+
+  std::string HexDigest(uint64_t length) const {
+    static const char kDigits[] = "0123456789abcdef";
+    const uint64_t halves[2] = {Finalize(hi_ ^ length), Finalize(lo_ + length)};
+    std::string result;
+    result.reserve(32);
+    for (uint64_t half : halves) {
+      for (int shift = 60; shift >= 0; shift -= 4) {
+        result.push_back(kDigits[(half >> shift) & 0xf]);
+      }
+    }
+    return result;
+  }
+
+ private:
+  static uint64_t RotateLeft(uint64_t value, int amount) {
+    return (value << amount) | (value >> (64 - amount));
+  }
+
+  // The splitmix64 finalizer.
+  static uint64_t Finalize(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+  }
+
+  uint64_t lo_ = 0xcbf29ce484222325ull;
+  uint64_t hi_ = 0x6a09e667f3bcc908ull;
+};
+
+// Returns a suffix that is very unlikely to be used by any other thread or
+// process writing into the same directory at the same time.
+std::string UniqueSuffix() {
+  static std::atomic<uint64_t> counter{0};
+  uint64_t seed =
+      static_cast<uint64_t>(
+          std::chrono::high_resolution_clock::now().time_since_epoch().count()) ^
+      (counter.fetch_add(1) << 48);
+  try {
+    std::random_device device;
+    seed ^= (static_cast<uint64_t>(device()) << 32) | device();
+  } catch (...) {
+    // Fall back to the clock and counter alone.
+  }
+  return std::to_string(seed);
+}
+
+}  // namespace
+
+std::string ComputeOptimizerCacheKey(const std::string& descriptor,
+                                     const uint32_t* words, size_t num_words) {
+  KeyHasher hasher;
+  hasher.AddString(descriptor);
+  for (size_t i = 0; i < num_words; ++i) {
+    hasher.AddWord(words[i]);
+  }
+  return hasher.HexDigest(num_words);
+}
+
+bool MemoryOptimizerCache::Lookup(const std::string& key,
+                                  std::vector<uint32_t>* binary) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  *binary = it->second->second;
+  return true;
+}
+
+void MemoryOptimizerCache::Store(const std::string& key,
+                                 const std::vector<uint32_t>& binary) {
+  if (max_entries_ == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->second = binary;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+
+  while (entries_.size() >= max_entries_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(key, binary);
+  index_[key] = entries_.begin();
+}
+
+std::string DirectoryOptimizerCache::PathForKey(const std::string& key) const {
+  return directory_ + "/" + key + ".spvcache";
+}
+
+bool DirectoryOptimizerCache::Lookup(const std::string& key,
+                                     std::vector<uint32_t>* binary) {
+  std::ifstream file(PathForKey(key), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  uint32_t header[4];
+  if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+    return false;
+  }
+  if (header[0] != kCacheFileMagic || header[1] != kCacheFileVersion ||
+      header[2] != key.size()) {
+    return false;
+  }
+
+  std::string stored_key(header[2], '\0');
+  if (!file.read(&stored_key[0], stored_key.size()) || stored_key != key) {
+    return false;
+  }
+
+  std::vector<uint32_t> words(header[3]);
+  if (!file.read(reinterpret_cast<char*>(words.data()),
+                 words.size() * sizeof(uint32_t))) {
+    return false;
+  }
+  // Anything past the expected end means the file is not one of ours.
+  if (file.peek() != std::ifstream::traits_type::eof()) {
+    return false;
+  }
+
+  *binary = std::move(words);
+  return true;
+}
+
+void DirectoryOptimizerCache::Store(const std::string& key,
+                                    const std::vector<uint32_t>& binary) {
+  const std::string path = PathForKey(key);
+  const std::string temp_path = path + ".tmp" + UniqueSuffix();
+
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return;
+    }
+    const uint32_t header[4] = {kCacheFileMagic, kCacheFileVersion,
+                                static_cast<uint32_t>(key.size()),
+                                static_cast<uint32_t>(binary.size())};
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(key.data(), key.size());
+    file.write(reinterpret_cast<const char*>(binary.data()),
+               binary.size() * sizeof(uint32_t));
+    if (!file.flush()) {
+      file.close();
+      std::remove(temp_path.c_str());
+      return;
+    }
+  }
+
+  // Renaming is atomic, so readers see either no entry or a complete one.  If
+  // the rename fails because another process already stored this key, its
+  // entry is equivalent to ours.
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+  }
+}
+
+}  // namespace opt
+
+OptimizerCache::~OptimizerCache() = default;
+
+std::unique_ptr<OptimizerCache> CreateMemoryOptimizerCache(size_t max_entries) {
+  return MakeUnique<opt::MemoryOptimizerCache>(max_entries);
+}
+
+std::unique_ptr<OptimizerCache> CreateDirectoryOptimizerCache(
+    const std::string& directory) {
+  return MakeUnique<opt::DirectoryOptimizerCache>(directory);
+}
+
+}  // namespace spvtools
@@ -0,0 +1,86 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_OPTIMIZER_CACHE_H_
+#define SOURCE_OPT_OPTIMIZER_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "spirv-tools/optimizer.hpp"
+
+namespace spvtools {
+namespace opt {
+
+// Returns the cache key for optimizing the |num_words| words at |words| with
+// the configuration described by |descriptor|.  The key is a fixed-length
+// string of lowercase hexadecimal digits, so it can be used as a file name.
+std::string ComputeOptimizerCacheKey(const std::string& descriptor,
+                                     const uint32_t* words, size_t num_words);
+
+// An OptimizerCache that keeps the |max_entries| most recently used results
+// in memory.  It is safe to share between threads.
+class MemoryOptimizerCache : public OptimizerCache {
+ public:
+  explicit MemoryOptimizerCache(size_t max_entries)
+      : max_entries_(max_entries) {}
+
+  bool Lookup(const std::string& key, std::vector<uint32_t>* binary) override;
+  void Store(const std::string& key,
+             const std::vector<uint32_t>& binary) override;
+
+ private:
+  using Entry = std::pair<std::string, std::vector<uint32_t>>;
+
+  const size_t max_entries_;
+
+  std::mutex mutex_;
+  // The cached results, most recently used first.
+  std::list<Entry> entries_;
+  // Maps each key to its entry in |entries_|.
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+// An OptimizerCache that stores each result in its own file in a directory.
+//
+// Files are written to a temporary name and then renamed into place, so
+// concurrent processes sharing the directory never observe a partially
+// written entry.  Each file repeats its key, and entries whose header does
+// not match are treated as misses.
+class DirectoryOptimizerCache : public OptimizerCache {
+ public:
+  explicit DirectoryOptimizerCache(std::string directory)
+      : directory_(std::move(directory)) {}
+
+  bool Lookup(const std::string& key, std::vector<uint32_t>* binary) override;
+  void Store(const std::string& key,
+             const std::vector<uint32_t>& binary) override;
+
+ private:
+  // Returns the path of the file holding the entry for |key|.
+  std::string PathForKey(const std::string& key) const;
+
+  const std::string directory_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_OPTIMIZER_CACHE_H_
@@ -33,12 +33,22 @@ Pass::Status Pass::Run(IRContext* ctx) {
   }
   already_run_ = true;
 
+  // Changes can only be charged to individual functions while the def-use
+  // manager and the instruction to block mapping are valid.
+  const bool tracking_changes = ctx->AreAnalysesValid(
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  const uint64_t tracking_interruptions = ctx->tracking_interruptions();
+
   context_ = ctx;
   Pass::Status status = Process();
   context_ = nullptr;
 
   if (status == Status::SuccessWithChange) {
     ctx->InvalidateAnalysesExceptFor(GetPreservedAnalyses());
+    if (!tracking_changes ||
+        ctx->tracking_interruptions() != tracking_interruptions) {
+      ctx->MarkAllFunctionsModified();
+    }
   }
   if (!(status == Status::Failure || ctx->IsConsistent()))
     assert(false && "An analysis in the context is out of date.");
@@ -17,6 +17,8 @@
 
 #include <algorithm>
 #include <map>
+#include <ostream>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -38,6 +40,8 @@
 namespace spvtools {
 namespace opt {
 
+class FixedPointPassGroup;
+
 // Abstract class of a pass. All passes should implement this abstract class
 // and all analysis and transformation is done via the Process() method.
 class Pass {
@@ -65,6 +69,13 @@ class Pass {
   // "my-pass" (no leading hyphens).
   virtual const char* name() const = 0;
 
+  // Returns the name of this pass followed by the values of the parameters it
+  // was created with, so that differently configured passes get different
+  // keys in the optimizer cache.  Returns an empty string if the result of
+  // the pass cannot be cached, for example because it writes to state outside
+  // of the module.
+  virtual std::string CacheKey() const { return name(); }
+
   // Sets the message consumer to the given |consumer|. |consumer| which will be
   // invoked every time there is a message to be communicated to the outside.
   void SetMessageConsumer(MessageConsumer c) { consumer_ = std::move(c); }
@@ -72,6 +83,14 @@ class Pass {
   // Returns the reference to the message consumer for this pass.
   const MessageConsumer& consumer() const { return consumer_; }
 
+  // Sets the stream to which the pass describes the decisions of its
+  // heuristics, such as the unroll factor chosen for each loop.  If |out| is
+  // null, the decisions are not reported.
+  void SetDecisionReport(std::ostream* out) { decision_report_ = out; }
+
+  // Returns the stream set by SetDecisionReport, or null.
+  std::ostream* decision_report() const { return decision_report_; }
+
   // Returns the def-use manager used for this pass. TODO(dnovillo): This should
   // be handled by the pass manager.
   analysis::DefUseManager* get_def_use_mgr() const {
@@ -113,6 +132,10 @@ class Pass {
     return IRContext::kAnalysisNone;
   }
 
+  // Returns this pass as a group of passes to run to a fixed point, or nullptr
+  // if it is a single pass.
+  virtual FixedPointPassGroup* AsFixedPointPassGroup() { return nullptr; }
+
   // Return type id for |ptrInst|'s pointee
   uint32_t GetPointeeTypeId(const Instruction* ptrInst) const;
 
@@ -153,6 +176,9 @@ class Pass {
  private:
   MessageConsumer consumer_;  // Message consumer.
 
+  // The stream set by SetDecisionReport.
+  std::ostream* decision_report_ = nullptr;
+
   // The context that this pass belongs to.
   IRContext* context_;
 
@@ -15,10 +15,13 @@
 #include "source/opt/pass_manager.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "source/opt/ir_context.h"
+#include "source/opt/pass_profiler.h"
+#include "source/util/make_unique.h"
 #include "source/util/timer.h"
 #include "spirv-tools/libspirv.hpp"
 
@@ -51,13 +54,20 @@ Pass::Status PassManager::Run(IRContext* context) {
     }
   };
 
-  SPIRV_TIMER_DESCRIPTION(time_report_stream_, /* measure_mem_usage = */ true);
-  for (auto& pass : passes_) {
-    print_disassembly("; IR before pass ", pass.get());
+  std::unique_ptr<PassProfiler> profiler;
+  if (profile_stream_) {
+    profiler = MakeUnique<PassProfiler>(context);
+  }
+
+  // Runs |pass| with the instrumentation requested for this pass manager.
+  auto run_pass = [&context, &print_disassembly, &profiler, this](Pass* pass) {
+    print_disassembly("; IR before pass ", pass);
     SPIRV_TIMER_SCOPED(time_report_stream_, (pass ? pass->name() : ""), true);
+    if (profiler) profiler->BeginPass();
+    pass->SetDecisionReport(decision_report_stream_);
     const auto one_status = pass->Run(context);
+    if (profiler) profiler->EndPass(pass->name(), one_status);
     if (one_status == Pass::Status::Failure) return one_status;
-    if (one_status == Pass::Status::SuccessWithChange) status = one_status;
 
     if (validate_after_all_) {
       spvtools::SpirvTools tools(target_env_);
@@ -72,11 +82,33 @@ Pass::Status PassManager::Run(IRContext* context) {
         return Pass::Status::Failure;
       }
     }
+    return one_status;
+  };
+
+  SPIRV_TIMER_DESCRIPTION(time_report_stream_, /* measure_mem_usage = */ true);
+  for (auto& pass : passes_) {
+    Pass::Status one_status;
+    if (FixedPointPassGroup* group = pass->AsFixedPointPassGroup()) {
+      const uint64_t hits_before = context->num_unchanged_function_hits();
+      one_status = group->RunToFixedPoint(run_pass);
+      if (time_report_stream_) {
+        ReportFixedPointGroup(
+            *group, context->num_unchanged_function_hits() - hits_before);
+      }
+    } else {
+      one_status = run_pass(pass.get());
+    }
+    if (one_status == Pass::Status::Failure) {
+      if (profiler) profiler->WriteTrace(profile_stream_);
+      return one_status;
+    }
+    if (one_status == Pass::Status::SuccessWithChange) status = one_status;
 
     // Reset the pass to free any memory used by the pass.
     pass.reset(nullptr);
   }
   print_disassembly("; IR after last pass", nullptr);
+  if (profiler) profiler->WriteTrace(profile_stream_);
 
   // Set the Id bound in the header in case a pass forgot to do so.
   //
@@ -89,5 +121,24 @@ Pass::Status PassManager::Run(IRContext* context) {
   return status;
 }
 
+void PassManager::ReportFixedPointGroup(const FixedPointPassGroup& group,
+                                        uint64_t skipped_functions) {
+  // A hand-unrolled recipe with the same number of rounds runs every pass in
+  // every round.
+  const size_t unrolled_invocations = group.size() * group.num_rounds();
+  *time_report_stream_ << "fixed-point-group: " << group.num_invocations()
+                       << " pass invocations in " << group.num_rounds()
+                       << " rounds ("
+                       << unrolled_invocations - group.num_invocations()
+                       << " fewer than running every pass each round), "
+                       << (group.reached_fixed_point()
+                               ? "reached a fixed point"
+                               : "stopped at the round limit")
+                       << ", " << skipped_functions
+                       << " unchanged function runs skipped, about "
+                       << group.EstimatedSecondsSaved() * 1000.0
+                       << " ms saved\n";
+}
+
 }  // namespace opt
 }  // namespace spvtools
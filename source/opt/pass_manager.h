@@ -15,11 +15,13 @@
 #ifndef SOURCE_OPT_PASS_MANAGER_H_
 #define SOURCE_OPT_PASS_MANAGER_H_
 
+#include <functional>
 #include <memory>
 #include <ostream>
 #include <utility>
 #include <vector>
 
+#include "source/opt/fixed_point_pass_group.h"
 #include "source/opt/log.h"
 #include "source/opt/module.h"
 #include "source/opt/pass.h"
@@ -44,6 +46,8 @@ class PassManager {
       : consumer_(nullptr),
         print_all_stream_(nullptr),
         time_report_stream_(nullptr),
+        profile_stream_(nullptr),
+        decision_report_stream_(nullptr),
         target_env_(SPV_ENV_UNIVERSAL_1_2),
         val_options_(nullptr),
         validate_after_all_(false) {}
@@ -67,6 +71,18 @@ class PassManager {
   // Returns the message consumer.
   inline const MessageConsumer& consumer() const;
 
+  // Removes all passes without running them.
+  void ClearPasses() { passes_.clear(); }
+
+  // Adds a group of passes that is run repeatedly, in order, until a round of
+  // the group makes no change or |max_rounds| rounds have run.  See
+  // FixedPointPassGroup.  Each pass in the group is instrumented like a pass
+  // added with AddPass(), and the time report also gets the number of pass
+  // invocations the group needed.
+  void AddFixedPointGroup(
+      std::vector<std::function<std::unique_ptr<Pass>()>> pass_factories,
+      uint32_t max_rounds);
+
   // Runs all passes on the given |module|. Returns Status::Failure if errors
   // occur when processing using one of the registered passes. All passes
   // registered after the error-reporting pass will be skipped. Returns the
@@ -92,6 +108,22 @@ class PassManager {
     return *this;
   }
 
+  // Sets the option to write a profile of the passes, in the Chrome trace
+  // event format, to |out| at the end of each Run().  See PassProfiler.  No
+  // profile is generated if |out| is null.
+  PassManager& SetProfileReport(std::ostream* out) {
+    profile_stream_ = out;
+    return *this;
+  }
+
+  // Sets the stream to which each pass describes the decisions of its
+  // heuristics.  See Pass::SetDecisionReport.  No report is generated if |out|
+  // is null.
+  PassManager& SetDecisionReport(std::ostream* out) {
+    decision_report_stream_ = out;
+    return *this;
+  }
+
   // Sets the target environment for validation.
   PassManager& SetTargetEnv(spv_target_env env) {
     target_env_ = env;
@@ -111,6 +143,13 @@ class PassManager {
   }
 
  private:
+  // Writes the number of pass invocations and rounds |group| needed to the
+  // time report stream, together with the |skipped_functions| runs over
+  // unchanged functions that its passes skipped and an estimate of the time
+  // saved by not running every pass in every round.
+  void ReportFixedPointGroup(const FixedPointPassGroup& group,
+                             uint64_t skipped_functions);
+
   // Consumer for messages.
   MessageConsumer consumer_;
   // A vector of passes. Order matters.
@@ -121,6 +160,12 @@ class PassManager {
   // The output stream to write the resource utilization of each pass. If this
   // is null, no output is generated.
   std::ostream* time_report_stream_;
+  // The output stream to write the profile of the passes to. If this is null,
+  // no profile is generated.
+  std::ostream* profile_stream_;
+  // The output stream passes describe their decisions to. If this is null, no
+  // report is generated.
+  std::ostream* decision_report_stream_;
   // The target environment.
   spv_target_env target_env_;
   // The validator options (used when validating each pass).
@@ -139,6 +184,14 @@ inline void PassManager::AddPass(Args&&... args) {
   passes_.back()->SetMessageConsumer(consumer_);
 }
 
+inline void PassManager::AddFixedPointGroup(
+    std::vector<std::function<std::unique_ptr<Pass>()>> pass_factories,
+    uint32_t max_rounds) {
+  passes_.emplace_back(
+      new FixedPointPassGroup(std::move(pass_factories), max_rounds));
+  passes_.back()->SetMessageConsumer(consumer_);
+}
+
 inline uint32_t PassManager::NumPasses() const {
   return static_cast<uint32_t>(passes_.size());
 }
@@ -0,0 +1,180 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/pass_profiler.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+int64_t MicrosecondsBetween(std::chrono::steady_clock::time_point start,
+                            std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+      .count();
+}
+
+// Writes |str| to |out| as a JSON string.
+void WriteJsonString(std::ostream* out, const std::string& str) {
+  *out << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      *out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      *out << ' ';
+    } else {
+      *out << c;
+    }
+  }
+  *out << '"';
+}
+
+// Writes the non-zero entries of |counts| as a JSON object keyed by analysis
+// name.
+void WriteAnalysisCounts(
+    std::ostream* out,
+    const std::array<uint32_t, IRContext::kNumAnalyses>& counts) {
+  *out << '{';
+  bool first = true;
+  for (uint32_t i = 0; i < IRContext::kNumAnalyses; ++i) {
+    if (counts[i] == 0) continue;
+    if (!first) *out << ',';
+    first = false;
+    *out << '"' << IRContext::GetAnalysisName(IRContext::Analysis(1 << i))
+         << "\":" << counts[i];
+  }
+  *out << '}';
+}
+
+}  // namespace
+
+PassProfiler::PassProfiler(IRContext* context)
+    : context_(context), creation_time_(std::chrono::steady_clock::now()) {}
+
+void PassProfiler::BeginPass() {
+  instructions_before_ = CountInstructions();
+  builds_before_ = GetBuildCounts();
+  invalidations_before_ = GetInvalidationCounts();
+  all_functions_epoch_before_ = context_->all_functions_modified_epoch();
+  epochs_before_.clear();
+  for (const Function& function : *context_->module()) {
+    epochs_before_[function.result_id()] = function.modification_epoch();
+  }
+
+  // Start the clocks last, so they do not include the work above.
+  cpu_start_ = std::clock();
+  wall_start_ = std::chrono::steady_clock::now();
+}
+
+void PassProfiler::EndPass(const char* name, Pass::Status status) {
+  const auto wall_end = std::chrono::steady_clock::now();
+  const std::clock_t cpu_end = std::clock();
+
+  PassProfile profile;
+  profile.name = name;
+  profile.status = status;
+  profile.start_us = MicrosecondsBetween(creation_time_, wall_start_);
+  profile.wall_us = MicrosecondsBetween(wall_start_, wall_end);
+  profile.cpu_us = static_cast<int64_t>(
+      (cpu_end - cpu_start_) * (1000000.0 / CLOCKS_PER_SEC));
+  profile.instructions_before = instructions_before_;
+  profile.instructions_after = CountInstructions();
+  profile.functions_touched = CountTouchedFunctions();
+
+  const AnalysisCounts builds = GetBuildCounts();
+  const AnalysisCounts invalidations = GetInvalidationCounts();
+  for (uint32_t i = 0; i < IRContext::kNumAnalyses; ++i) {
+    profile.analyses_built[i] = builds[i] - builds_before_[i];
+    profile.analyses_invalidated[i] =
+        invalidations[i] - invalidations_before_[i];
+  }
+  profiles_.push_back(std::move(profile));
+}
+
+void PassProfiler::WriteTrace(std::ostream* out) const {
+  *out << "{\"traceEvents\":[";
+  for (size_t i = 0; i < profiles_.size(); ++i) {
+    const PassProfile& profile = profiles_[i];
+    *out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+    WriteJsonString(out, profile.name);
+    *out << ",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+         << ",\"ts\":" << profile.start_us << ",\"dur\":" << profile.wall_us
+         << ",\"args\":{\"cpu_us\":" << profile.cpu_us << ",\"status\":\""
+         << (profile.status == Pass::Status::Failure
+                 ? "failure"
+                 : profile.status == Pass::Status::SuccessWithChange
+                       ? "changed"
+                       : "unchanged")
+         << "\",\"instructions_before\":" << profile.instructions_before
+         << ",\"instructions_after\":" << profile.instructions_after
+         << ",\"functions_touched\":" << profile.functions_touched
+         << ",\"analyses_built\":";
+    WriteAnalysisCounts(out, profile.analyses_built);
+    *out << ",\"analyses_invalidated\":";
+    WriteAnalysisCounts(out, profile.analyses_invalidated);
+    *out << "}}";
+  }
+  *out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+size_t PassProfiler::CountInstructions() const {
+  size_t count = 0;
+  context_->module()->ForEachInst([&count](const Instruction*) { ++count; });
+  return count;
+}
+
+PassProfiler::AnalysisCounts PassProfiler::GetBuildCounts() const {
+  AnalysisCounts counts;
+  for (uint32_t i = 0; i < IRContext::kNumAnalyses; ++i) {
+    counts[i] = context_->GetAnalysisBuildCount(IRContext::Analysis(1 << i));
+  }
+  return counts;
+}
+
+PassProfiler::AnalysisCounts PassProfiler::GetInvalidationCounts() const {
+  AnalysisCounts counts;
+  for (uint32_t i = 0; i < IRContext::kNumAnalyses; ++i) {
+    counts[i] =
+        context_->GetAnalysisInvalidationCount(IRContext::Analysis(1 << i));
+  }
+  return counts;
+}
+
+uint32_t PassProfiler::CountTouchedFunctions() const {
+  const bool all_touched =
+      context_->all_functions_modified_epoch() != all_functions_epoch_before_;
+  uint32_t count = 0;
+  for (const Function& function : *context_->module()) {
+    if (all_touched) {
+      ++count;
+      continue;
+    }
+    auto before = epochs_before_.find(function.result_id());
+    if (before == epochs_before_.end()) {
+      // A new function.
+      ++count;
+      continue;
+    }
+    const uint64_t epoch = function.modification_epoch();
+    // Stamping an unstamped function that did not change gives it epoch 0.
+    const bool only_stamped =
+        before->second == Function::kUnstampedEpoch && epoch == 0;
+    if (epoch != before->second && !only_stamped) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,107 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_PASS_PROFILER_H_
+#define SOURCE_OPT_PASS_PROFILER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// Records a profile of the passes run on a context, and writes it as a trace
+// in the Chrome trace event format.  The trace is a JSON document that can be
+// loaded in chrome://tracing or Perfetto, or processed by scripts.
+//
+// Each pass is a complete ("X") event whose arguments hold the CPU time, the
+// number of instructions in the module before and after the pass, the number
+// of functions it touched, and how many times each IRContext analysis was
+// built or invalidated while it ran.
+//
+// Unlike the time report, the profile does not depend on SPIRV_TIMER_ENABLED.
+// Counting instructions costs a walk over the module before and after each
+// pass, so profiling should only be enabled when the profile is wanted.
+class PassProfiler {
+ public:
+  explicit PassProfiler(IRContext* context);
+
+  // Starts measuring a pass.
+  void BeginPass();
+
+  // Stops measuring the pass started by the last call to |BeginPass|.  |name|
+  // is the name of the pass, and |status| is what it returned.
+  void EndPass(const char* name, Pass::Status status);
+
+  // Writes the trace for all the passes measured so far to |out|.
+  void WriteTrace(std::ostream* out) const;
+
+ private:
+  using AnalysisCounts = std::array<uint32_t, IRContext::kNumAnalyses>;
+
+  // The measurements for one pass.
+  struct PassProfile {
+    std::string name;
+    Pass::Status status;
+    // Microseconds between the creation of the profiler and the start of the
+    // pass.
+    int64_t start_us;
+    int64_t wall_us;
+    int64_t cpu_us;
+    size_t instructions_before;
+    size_t instructions_after;
+    uint32_t functions_touched;
+    AnalysisCounts analyses_built;
+    AnalysisCounts analyses_invalidated;
+  };
+
+  // Returns the number of instructions in the module.
+  size_t CountInstructions() const;
+
+  // Returns the number of times each analysis has been built or invalidated.
+  AnalysisCounts GetBuildCounts() const;
+  AnalysisCounts GetInvalidationCounts() const;
+
+  // Returns the number of functions whose modification epoch is different
+  // from the one in |epochs_before_|.
+  uint32_t CountTouchedFunctions() const;
+
+  IRContext* context_;
+  const std::chrono::steady_clock::time_point creation_time_;
+
+  // The state of the context when the current pass started.
+  std::chrono::steady_clock::time_point wall_start_;
+  std::clock_t cpu_start_ = 0;
+  size_t instructions_before_ = 0;
+  AnalysisCounts builds_before_{};
+  AnalysisCounts invalidations_before_{};
+  uint64_t all_functions_epoch_before_ = 0;
+  std::unordered_map<uint32_t, uint64_t> epochs_before_;
+
+  std::vector<PassProfile> profiles_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_PASS_PROFILER_H_
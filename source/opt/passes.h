@@ -46,6 +46,7 @@
 #include "source/opt/freeze_spec_constant_value_pass.h"
 #include "source/opt/graphics_robust_access_pass.h"
 #include "source/opt/if_conversion.h"
+#include "source/opt/inline_cost_model_pass.h"
 #include "source/opt/inline_exhaustive_pass.h"
 #include "source/opt/inline_opaque_pass.h"
 #include "source/opt/interface_var_sroa.h"
@@ -14,26 +14,51 @@
 
 #include "source/opt/propagator.h"
 
+#include <algorithm>
+
 namespace spvtools {
 namespace opt {
 
-void SSAPropagator::AddControlEdge(const Edge& edge) {
-  BasicBlock* dest_bb = edge.dest;
+uint8_t SSAPropagator::GetState(const Instruction* inst) const {
+  if (inst->result_id() != 0) {
+    return inst->result_id() < id_state_.size() ? id_state_[inst->result_id()]
+                                                : 0;
+  }
+  auto it = no_result_state_.find(inst);
+  return it != no_result_state_.end() ? it->second : 0;
+}
 
-  // Refuse to add the exit block to the work list.
-  if (dest_bb == ctx_->cfg()->pseudo_exit_block()) {
-    return;
+uint8_t& SSAPropagator::MutableState(const Instruction* inst) {
+  if (inst->result_id() != 0) {
+    if (inst->result_id() >= id_state_.size()) {
+      id_state_.resize(inst->result_id() + 1, 0);
+    }
+    return id_state_[inst->result_id()];
   }
+  return no_result_state_[inst];
+}
 
+uint32_t SSAPropagator::EdgeIndex(uint32_t source, uint32_t dest) const {
+  auto begin = preds_.begin() + pred_offsets_[dest];
+  auto end = preds_.begin() + pred_offsets_[dest + 1];
+  auto it = std::lower_bound(begin, end, source);
+  if (it == end || *it != source) return kNoIndex;
+  return static_cast<uint32_t>(it - preds_.begin());
+}
+
+void SSAPropagator::AddControlEdge(uint32_t source, uint32_t dest) {
   // Try to mark the edge executable.  If it was already in the set of
   // executable edges, do nothing.
-  if (!MarkEdgeExecutable(edge)) {
+  const uint32_t edge = EdgeIndex(source, dest);
+  assert(edge != kNoIndex && "Adding an edge that is not in the CFG.");
+  if (executable_edges_[edge]) {
     return;
   }
+  executable_edges_[edge] = true;
 
   // If the edge had not already been marked executable, add the destination
   // basic block to the work list.
-  blocks_.push(dest_bb);
+  block_queue_.push_back(dest);
 }
 
 void SSAPropagator::AddSSAEdges(Instruction* instr) {
@@ -47,39 +72,44 @@ void SSAPropagator::AddSSAEdges(Instruction* instr) {
         // If the basic block for |use_instr| has not been simulated yet, do
         // nothing.  The instruction |use_instr| will be simulated next time the
         // block is scheduled.
-        if (!BlockHasBeenSimulated(ctx_->get_instr_block(use_instr))) {
+        BasicBlock* use_bb = ctx_->get_instr_block(use_instr);
+        if (use_bb == nullptr || !BlockHasBeenSimulated(use_bb)) {
           return;
         }
 
-        if (ShouldSimulateAgain(use_instr)) {
-          ssa_edge_uses_.push(use_instr);
+        // Queue |use_instr| unless it is already waiting to be simulated.
+        uint8_t& state = MutableState(use_instr);
+        if ((state & (kDoNotSimulate | kQueued)) == 0) {
+          state |= kQueued;
+          ssa_edge_uses_.push_back(use_instr);
         }
       });
 }
 
 bool SSAPropagator::IsPhiArgExecutable(Instruction* phi, uint32_t i) const {
   BasicBlock* phi_bb = ctx_->get_instr_block(phi);
+  const uint32_t dest = BlockIndex(phi_bb->id());
+  const uint32_t source = BlockIndex(phi->GetSingleWordOperand(i + 1));
+  if (dest == kNoIndex || source == kNoIndex) {
+    return false;
+  }
 
-  uint32_t in_label_id = phi->GetSingleWordOperand(i + 1);
-  Instruction* in_label_instr = get_def_use_mgr()->GetDef(in_label_id);
-  BasicBlock* in_bb = ctx_->get_instr_block(in_label_instr);
-
-  return IsEdgeExecutable(Edge(in_bb, phi_bb));
+  const uint32_t edge = EdgeIndex(source, dest);
+  return edge != kNoIndex && executable_edges_[edge];
 }
 
 bool SSAPropagator::SetStatus(Instruction* inst, PropStatus status) {
-  bool has_old_status = false;
-  PropStatus old_status = kVarying;
-  if (HasStatus(inst)) {
-    has_old_status = true;
-    old_status = Status(inst);
-  }
+  uint8_t& state = MutableState(inst);
+  const uint8_t old_bits = state & kStatusMask;
+  const uint8_t new_bits = static_cast<uint8_t>(status + 1);
 
-  assert((!has_old_status || old_status <= status) &&
+  assert((old_bits == 0 || old_bits <= new_bits) &&
          "Invalid lattice transition");
 
-  bool status_changed = !has_old_status || (old_status != status);
-  if (status_changed) statuses_[inst] = status;
+  bool status_changed = old_bits != new_bits;
+  if (status_changed) {
+    state = static_cast<uint8_t>((state & ~kStatusMask) | new_bits);
+  }
 
   return status_changed;
 }
@@ -107,9 +137,10 @@ bool SSAPropagator::Simulate(Instruction* instr) {
     // If |instr| is a block terminator, add all the control edges out of its
     // block.
     if (instr->IsBlockTerminator()) {
-      BasicBlock* block = ctx_->get_instr_block(instr);
-      for (const auto& e : bb_succs_.at(block)) {
-        AddControlEdge(e);
+      const uint32_t block = BlockIndex(ctx_->get_instr_block(instr)->id());
+      for (uint32_t s = succ_offsets_[block]; s < succ_offsets_[block + 1];
+           ++s) {
+        AddControlEdge(block, succs_[s]);
       }
     }
     return false;
@@ -123,7 +154,8 @@ bool SSAPropagator::Simulate(Instruction* instr) {
     // If there are multiple outgoing control flow edges and we know which one
     // will be taken, add the destination block to the CFG work list.
     if (dest_bb) {
-      AddControlEdge(Edge(ctx_->get_instr_block(instr), dest_bb));
+      AddControlEdge(BlockIndex(ctx_->get_instr_block(instr)->id()),
+                     BlockIndex(dest_bb->id()));
     }
     changed = true;
   }
@@ -145,8 +177,7 @@ bool SSAPropagator::Simulate(Instruction* instr) {
              "malformed Phi arguments");
 
       uint32_t arg_id = instr->GetSingleWordOperand(i);
-      Instruction* arg_def_instr = get_def_use_mgr()->GetDef(arg_id);
-      if (!IsPhiArgExecutable(instr, i) || ShouldSimulateAgain(arg_def_instr)) {
+      if (!IsPhiArgExecutable(instr, i) || ShouldSimulateAgain(arg_id)) {
         has_operands_to_simulate = true;
         break;
       }
@@ -157,11 +188,7 @@ bool SSAPropagator::Simulate(Instruction* instr) {
     // also be simulated again.
     has_operands_to_simulate =
         !instr->WhileEachInId([this](const uint32_t* use) {
-          Instruction* def_instr = get_def_use_mgr()->GetDef(*use);
-          if (ShouldSimulateAgain(def_instr)) {
-            return false;
-          }
-          return true;
+          return !ShouldSimulateAgain(*use);
         });
   }
 
@@ -173,10 +200,6 @@ bool SSAPropagator::Simulate(Instruction* instr) {
 }
 
 bool SSAPropagator::Simulate(BasicBlock* block) {
-  if (block == ctx_->cfg()->pseudo_exit_block()) {
-    return false;
-  }
-
   // Always simulate Phi instructions, even if we have simulated this block
   // before. We do this because Phi instructions receive their inputs from
   // incoming edges. When those edges are marked executable, the corresponding
@@ -187,19 +210,20 @@ bool SSAPropagator::Simulate(BasicBlock* block) {
 
   // If this is the first time this block is being simulated, simulate every
   // statement in it.
-  if (!BlockHasBeenSimulated(block)) {
+  const uint32_t index = BlockIndex(block->id());
+  if (!simulated_blocks_[index]) {
     block->ForEachInst([this, &changed](Instruction* instr) {
       if (instr->opcode() != spv::Op::OpPhi) {
         changed |= Simulate(instr);
       }
     });
 
-    MarkBlockSimulated(block);
+    simulated_blocks_[index] = true;
 
     // If this block has exactly one successor, mark the edge to its successor
     // as executable.
-    if (bb_succs_.at(block).size() == 1) {
-      AddControlEdge(bb_succs_.at(block).at(0));
+    if (succ_offsets_[index + 1] - succ_offsets_[index] == 1) {
+      AddControlEdge(index, succs_[succ_offsets_[index]]);
     }
   }
 
@@ -207,32 +231,61 @@ bool SSAPropagator::Simulate(BasicBlock* block) {
 }
 
 void SSAPropagator::Initialize(Function* fn) {
-  // Compute predecessor and successor blocks for every block in |fn|'s CFG.
-  // TODO(dnovillo): Move this to CFG and always build them. Alternately,
-  // move it to IRContext and build CFG preds/succs on-demand.
-  bb_succs_[ctx_->cfg()->pseudo_entry_block()].push_back(
-      Edge(ctx_->cfg()->pseudo_entry_block(), fn->entry().get()));
-
+  // Number the blocks of |fn|.  Only the entries of the previous function are
+  // reset, so running on many functions does not touch the whole table each
+  // time.
+  for (BasicBlock* block : blocks_) block_index_[block->id()] = kNoIndex;
+  blocks_.clear();
+  no_result_state_.clear();
+  if (block_index_.size() < ctx_->module()->IdBound()) {
+    block_index_.resize(ctx_->module()->IdBound(), kNoIndex);
+  }
   for (auto& block : *fn) {
-    const auto& const_block = block;
-    const_block.ForEachSuccessorLabel([this, &block](const uint32_t label_id) {
-      BasicBlock* succ_bb =
-          ctx_->get_instr_block(get_def_use_mgr()->GetDef(label_id));
-      bb_succs_[&block].push_back(Edge(&block, succ_bb));
-      bb_preds_[succ_bb].push_back(Edge(succ_bb, &block));
+    block_index_[block.id()] = static_cast<uint32_t>(blocks_.size());
+    blocks_.push_back(&block);
+  }
+  const uint32_t num_blocks = static_cast<uint32_t>(blocks_.size());
+  simulated_blocks_.assign(num_blocks, false);
+
+  // Compute successor and predecessor blocks for every block in |fn|'s CFG.
+  // Edges to the pseudo exit block are left out, since the exit block is
+  // never simulated.
+  succ_offsets_.assign(1, 0);
+  succs_.clear();
+  std::vector<std::vector<uint32_t>> preds(num_blocks);
+  for (uint32_t b = 0; b < num_blocks; ++b) {
+    const BasicBlock* block = blocks_[b];
+    block->ForEachSuccessorLabel([this, b, &preds](const uint32_t label_id) {
+      const uint32_t succ = BlockIndex(label_id);
+      assert(succ != kNoIndex && "Branch to a block outside the function.");
+      succs_.push_back(succ);
+      preds[succ].push_back(b);
     });
-    if (block.IsReturnOrAbort()) {
-      bb_succs_[&block].push_back(
-          Edge(&block, ctx_->cfg()->pseudo_exit_block()));
-      bb_preds_[ctx_->cfg()->pseudo_exit_block()].push_back(
-          Edge(ctx_->cfg()->pseudo_exit_block(), &block));
-    }
+    succ_offsets_.push_back(static_cast<uint32_t>(succs_.size()));
+  }
+
+  pred_offsets_.assign(1, 0);
+  preds_.clear();
+  for (auto& block_preds : preds) {
+    std::sort(block_preds.begin(), block_preds.end());
+    block_preds.erase(std::unique(block_preds.begin(), block_preds.end()),
+                      block_preds.end());
+    preds_.insert(preds_.end(), block_preds.begin(), block_preds.end());
+    pred_offsets_.push_back(static_cast<uint32_t>(preds_.size()));
   }
+  executable_edges_.assign(preds_.size(), false);
 
-  // Add the edges out of the entry block to seed the propagator.
-  const auto& entry_succs = bb_succs_[ctx_->cfg()->pseudo_entry_block()];
-  for (const auto& e : entry_succs) {
-    AddControlEdge(e);
+  if (id_state_.size() < ctx_->module()->IdBound()) {
+    id_state_.resize(ctx_->module()->IdBound(), 0);
+  }
+
+  // Seed the propagator with the entry block.
+  block_queue_.clear();
+  block_queue_head_ = 0;
+  ssa_edge_uses_.clear();
+  ssa_edge_uses_head_ = 0;
+  if (num_blocks != 0) {
+    block_queue_.push_back(BlockIndex(fn->entry()->id()));
   }
 }
 
@@ -240,22 +293,20 @@ bool SSAPropagator::Run(Function* fn) {
   Initialize(fn);
 
   bool changed = false;
-  while (!blocks_.empty() || !ssa_edge_uses_.empty()) {
+  while (block_queue_head_ < block_queue_.size() ||
+         ssa_edge_uses_head_ < ssa_edge_uses_.size()) {
     // Simulate all blocks first. Simulating blocks will add SSA edges to
     // follow after all the blocks have been simulated.
-    if (!blocks_.empty()) {
-      auto block = blocks_.front();
-      changed |= Simulate(block);
-      blocks_.pop();
+    if (block_queue_head_ < block_queue_.size()) {
+      const uint32_t block = block_queue_[block_queue_head_++];
+      changed |= Simulate(blocks_[block]);
       continue;
     }
 
     // Simulate edges from the SSA queue.
-    if (!ssa_edge_uses_.empty()) {
-      Instruction* instr = ssa_edge_uses_.front();
-      changed |= Simulate(instr);
-      ssa_edge_uses_.pop();
-    }
+    Instruction* instr = ssa_edge_uses_[ssa_edge_uses_head_++];
+    MutableState(instr) &= static_cast<uint8_t>(~kQueued);
+    changed |= Simulate(instr);
   }
 
 #ifndef NDEBUG
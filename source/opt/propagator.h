@@ -15,12 +15,9 @@
 #ifndef SOURCE_OPT_PROPAGATOR_H_
 #define SOURCE_OPT_PROPAGATOR_H_
 
+#include <cstdint>
 #include <functional>
-#include <queue>
-#include <set>
 #include <unordered_map>
-#include <unordered_set>
-#include <utility>
 #include <vector>
 
 #include "source/opt/ir_context.h"
@@ -29,20 +26,6 @@
 namespace spvtools {
 namespace opt {
 
-// Represents a CFG control edge.
-struct Edge {
-  Edge(BasicBlock* b1, BasicBlock* b2) : source(b1), dest(b2) {
-    assert(source && "CFG edges cannot have a null source block.");
-    assert(dest && "CFG edges cannot have a null destination block.");
-  }
-  BasicBlock* source;
-  BasicBlock* dest;
-  bool operator<(const Edge& o) const {
-    return std::make_pair(source->id(), dest->id()) <
-           std::make_pair(o.source->id(), o.dest->id());
-  }
-};
-
 // This class implements a generic value propagation algorithm based on the
 // conditional constant propagation algorithm proposed in
 //
@@ -141,6 +124,12 @@ struct Edge {
 //
 // 4- Simulation terminates when all work queues are drained.
 //
+// The propagator state is kept in flat arrays: per-instruction state is
+// indexed by result ID, per-block state by the position of the block in the
+// function, and the executable flag of each CFG edge is stored next to the
+// sorted list of predecessors of its destination.  An instruction is never
+// queued twice on the SSA edges work list.
+//
 //
 // EXAMPLE: Basic constant store propagator.
 //
@@ -200,12 +189,14 @@ class SSAPropagator {
 
   // Returns true if |inst| has a recorded status. This will be true once |inst|
   // has been simulated once.
-  bool HasStatus(Instruction* inst) const { return statuses_.count(inst); }
+  bool HasStatus(Instruction* inst) const {
+    return (GetState(inst) & kStatusMask) != 0;
+  }
 
   // Returns the current propagation status of |inst|. Assumes
   // |HasStatus(inst)| returns true.
   PropStatus Status(Instruction* inst) const {
-    return statuses_.find(inst)->second;
+    return static_cast<PropStatus>((GetState(inst) & kStatusMask) - 1);
   }
 
   // Records the propagation status |status| for |inst|. Returns true if the
@@ -213,6 +204,21 @@ class SSAPropagator {
   bool SetStatus(Instruction* inst, PropStatus status);
 
  private:
+  // Bits of the per-instruction state.  The low bits hold the propagation
+  // status plus one, so that 0 means no status.
+  static constexpr uint8_t kStatusMask = 0x3;
+  static constexpr uint8_t kDoNotSimulate = 0x4;
+  static constexpr uint8_t kQueued = 0x8;
+
+  // Marks the absence of a block in |block_index_| and of an edge.
+  static constexpr uint32_t kNoIndex = ~0u;
+
+  // Returns the state bits of |inst|.
+  uint8_t GetState(const Instruction* inst) const;
+
+  // Returns a reference to the state bits of |inst|, creating them if needed.
+  uint8_t& MutableState(const Instruction* inst);
+
   // Initialize processing.
   void Initialize(Function* fn);
 
@@ -228,41 +234,45 @@ class SSAPropagator {
 
   // Returns true if |instr| should be simulated again.
   bool ShouldSimulateAgain(Instruction* instr) const {
-    return do_not_simulate_.find(instr) == do_not_simulate_.end();
+    return (GetState(instr) & kDoNotSimulate) == 0;
   }
 
-  // Add |instr| to the set of instructions not to simulate again.
-  void DontSimulateAgain(Instruction* instr) { do_not_simulate_.insert(instr); }
-
-  // Returns true if |block| has been simulated already.
-  bool BlockHasBeenSimulated(BasicBlock* block) const {
-    return simulated_blocks_.find(block) != simulated_blocks_.end();
+  // Returns true if the instruction defining |id| should be simulated again.
+  // This is the case for all ids not defined in the function.
+  bool ShouldSimulateAgain(uint32_t id) const {
+    return id >= id_state_.size() || (id_state_[id] & kDoNotSimulate) == 0;
   }
 
-  // Marks block |block| as simulated.
-  void MarkBlockSimulated(BasicBlock* block) {
-    simulated_blocks_.insert(block);
+  // Add |instr| to the set of instructions not to simulate again.
+  void DontSimulateAgain(Instruction* instr) {
+    MutableState(instr) |= kDoNotSimulate;
   }
 
-  // Marks |edge| as executable.  Returns false if the edge was already marked
-  // as executable.
-  bool MarkEdgeExecutable(const Edge& edge) {
-    return executable_edges_.insert(edge).second;
+  // Returns the position in the function of the block with label |label_id|,
+  // or kNoIndex if there is no such block.
+  uint32_t BlockIndex(uint32_t label_id) const {
+    return label_id < block_index_.size() ? block_index_[label_id] : kNoIndex;
   }
 
-  // Returns true if |edge| has been marked as executable.
-  bool IsEdgeExecutable(const Edge& edge) const {
-    return executable_edges_.find(edge) != executable_edges_.end();
+  // Returns true if |block| has been simulated already.
+  bool BlockHasBeenSimulated(BasicBlock* block) const {
+    const uint32_t index = BlockIndex(block->id());
+    return index != kNoIndex && simulated_blocks_[index];
   }
 
+  // Returns the position of the edge from block |source| to block |dest| in
+  // |preds_|, or kNoIndex if there is no such edge.
+  uint32_t EdgeIndex(uint32_t source, uint32_t dest) const;
+
   // Returns a pointer to the def-use manager for |ctx_|.
   analysis::DefUseManager* get_def_use_mgr() const {
     return ctx_->get_def_use_mgr();
   }
 
-  // If the CFG edge |e| has not been executed, this function adds |e|'s
-  // destination block to the work list.
-  void AddControlEdge(const Edge& e);
+  // If the CFG edge from block |source| to block |dest| has not been
+  // executed, this function marks it executable and adds |dest| to the work
+  // list.
+  void AddControlEdge(uint32_t source, uint32_t dest);
 
   // Adds all the instructions that use the result of |instr| to the SSA edges
   // work list. If |instr| produces no result id, this does nothing.
@@ -277,35 +287,44 @@ class SSAPropagator {
   // track of interesting values by storing them in some user-provided map.
   VisitFunction visit_fn_;
 
-  // SSA def-use edges to traverse. Each entry is a destination statement for an
-  // SSA def-use edge as returned by |def_use_manager_|.
-  std::queue<Instruction*> ssa_edge_uses_;
-
-  // Blocks to simulate.
-  std::queue<BasicBlock*> blocks_;
-
-  // Blocks simulated during propagation.
-  std::unordered_set<BasicBlock*> simulated_blocks_;
-
-  // Set of instructions that should not be simulated again because they have
-  // been found to be in the kVarying state.
-  std::unordered_set<Instruction*> do_not_simulate_;
+  // State bits of every instruction with a result, indexed by result ID.
+  std::vector<uint8_t> id_state_;
 
-  // Map between a basic block and its predecessor edges.
-  // TODO(dnovillo): Move this to CFG and always build them. Alternately,
-  // move it to IRContext and build CFG preds/succs on-demand.
-  std::unordered_map<BasicBlock*, std::vector<Edge>> bb_preds_;
+  // State bits of the instructions without a result.
+  std::unordered_map<const Instruction*, uint8_t> no_result_state_;
 
-  // Map between a basic block and its successor edges.
-  // TODO(dnovillo): Move this to CFG and always build them. Alternately,
-  // move it to IRContext and build CFG preds/succs on-demand.
-  std::unordered_map<BasicBlock*, std::vector<Edge>> bb_succs_;
-
-  // Set of executable CFG edges.
-  std::set<Edge> executable_edges_;
-
-  // Tracks instruction propagation status.
-  std::unordered_map<Instruction*, SSAPropagator::PropStatus> statuses_;
+  // SSA def-use edges to traverse. Each entry is a destination statement for an
+  // SSA def-use edge as returned by |def_use_manager_|.  Entries before
+  // |ssa_edge_uses_head_| have been simulated already.
+  std::vector<Instruction*> ssa_edge_uses_;
+  size_t ssa_edge_uses_head_ = 0;
+
+  // Positions of the blocks to simulate.  Entries before |block_queue_head_|
+  // have been simulated already.
+  std::vector<uint32_t> block_queue_;
+  size_t block_queue_head_ = 0;
+
+  // The blocks of the function being propagated, in function order.
+  std::vector<BasicBlock*> blocks_;
+
+  // Position in |blocks_| of each block, indexed by label ID.
+  std::vector<uint32_t> block_index_;
+
+  // Blocks simulated during propagation, indexed by block position.
+  std::vector<bool> simulated_blocks_;
+
+  // Successors of each block, as block positions in the order the terminator
+  // lists them.  The successors of block B are in
+  // succs_[succ_offsets_[B]..succ_offsets_[B + 1]).
+  std::vector<uint32_t> succ_offsets_;
+  std::vector<uint32_t> succs_;
+
+  // Sorted, distinct predecessors of each block, as block positions, laid out
+  // like |succs_|.  |executable_edges_| tells whether the edge from each
+  // predecessor has been marked executable.
+  std::vector<uint32_t> pred_offsets_;
+  std::vector<uint32_t> preds_;
+  std::vector<bool> executable_edges_;
 };
 
 std::ostream& operator<<(std::ostream& str,
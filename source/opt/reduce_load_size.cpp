@@ -15,6 +15,7 @@
 #include "source/opt/reduce_load_size.h"
 
 #include <set>
+#include <sstream>
 #include <vector>
 
 #include "source/opt/instruction.h"
@@ -30,6 +31,13 @@ constexpr uint32_t kVariableStorageClassInIdx = 0;
 constexpr uint32_t kLoadPointerInIdx = 0;
 }  // namespace
 
+std::string ReduceLoadSize::CacheKey() const {
+  std::ostringstream key;
+  key.precision(17);
+  key << name() << " " << replacement_threshold_;
+  return key.str();
+}
+
 Pass::Status ReduceLoadSize::Process() {
   bool modified = false;
 
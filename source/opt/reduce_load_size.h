@@ -31,6 +31,7 @@ class ReduceLoadSize : public Pass {
       : replacement_threshold_(replacement_threshold) {}
 
   const char* name() const override { return "reduce-load-size"; }
+  std::string CacheKey() const override;
   Status Process() override;
 
   // Return the mask of preserved Analyses.
@@ -333,6 +333,46 @@ void RegisterLiveness::ComputeLoopRegisterPressure(
   }
 }
 
+void RegisterLiveness::SimulateUnroll(
+    const Loop& loop, size_t factor, RegionRegisterLiveness* sim_result) const {
+  ComputeLoopRegisterPressure(loop, sim_result);
+
+  // The values live across the whole loop are the loop live-in values,
+  // except for the header phis which are redefined by each copy.
+  size_t invariant_registers = 0;
+  for (Instruction* insn : sim_result->live_in_) {
+    if (insn->opcode() == spv::Op::OpPhi &&
+        context_->get_instr_block(insn) == loop.GetHeaderBlock()) {
+      continue;
+    }
+    ++invariant_registers;
+  }
+  invariant_registers =
+      std::min(invariant_registers, sim_result->used_registers_);
+  sim_result->used_registers_ =
+      invariant_registers +
+      factor * (sim_result->used_registers_ - invariant_registers);
+
+  // Each copy defines its own version of the values computed in the loop.
+  sim_result->registers_classes_.clear();
+  for (uint32_t bb_id : loop.GetBlocks()) {
+    for (Instruction& insn : *context_->cfg()->block(bb_id)) {
+      if (CreatesRegisterUsage(&insn)) {
+        sim_result->AddRegisterClass(&insn);
+      }
+    }
+  }
+  for (auto& class_count : sim_result->registers_classes_) {
+    class_count.second *= factor;
+  }
+  for (Instruction* insn : sim_result->live_in_) {
+    BasicBlock* bb = context_->get_instr_block(insn);
+    if (bb == nullptr || !loop.IsInsideLoop(bb)) {
+      sim_result->AddRegisterClass(insn);
+    }
+  }
+}
+
 void RegisterLiveness::SimulateFusion(
     const Loop& l1, const Loop& l2, RegionRegisterLiveness* sim_result) const {
   sim_result->Clear();
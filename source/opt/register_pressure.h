@@ -153,6 +153,15 @@ class RegisterLiveness {
       RegionRegisterLiveness* loop1_sim_result,
       RegionRegisterLiveness* loop2_sim_result) const;
 
+  // Estimate the register pressure of |loop| after its body has been
+  // replicated |factor| times. The values that are live-in to |loop|, other
+  // than the header phis, are live in every copy and are counted once. The
+  // values computed in the loop are counted once per copy, as if the copies
+  // were scheduled to overlap, so the result is an upper bound. The result is
+  // stored into |simulation_result|.
+  void SimulateUnroll(const Loop& loop, size_t factor,
+                      RegionRegisterLiveness* simulation_result) const;
+
  private:
   using RegionRegisterLivenessMap =
       std::unordered_map<uint32_t, RegionRegisterLiveness>;
@@ -23,9 +23,35 @@
 #include "source/opcode.h"
 #include "source/opt/decoration_manager.h"
 #include "source/opt/ir_context.h"
+#include "source/util/hash_combine.h"
 
 namespace spvtools {
 namespace opt {
+namespace {
+
+// Returns a hash of the forward pointer |type|.  Forward pointers with the
+// same target pointer type and storage class are equal even if their target
+// ids differ, so unlike Type::HashValue the hash does not use the target id.
+size_t HashForwardPointer(const analysis::ForwardPointer& type) {
+  const analysis::Pointer* target = type.target_pointer();
+  return utils::hash_combine(uint32_t(type.storage_class()),
+                             target ? target->HashValue() : type.target_id());
+}
+
+// Returns a hash of the opcode and in-operands of |inst|.  Decorations that
+// DecorationManager::AreDecorationsTheSame considers the same have the same
+// hash.
+size_t HashDecoration(const Instruction& inst) {
+  size_t hash = utils::hash_combine(0, uint32_t(inst.opcode()));
+  for (uint32_t i = 0; i < inst.NumInOperands(); ++i) {
+    for (uint32_t word : inst.GetInOperand(i).words) {
+      hash = utils::hash_combine(hash, word);
+    }
+  }
+  return hash;
+}
+
+}  // namespace
 
 Pass::Status RemoveDuplicatesPass::Process() {
   bool modified = RemoveDuplicateCapabilities();
@@ -94,8 +120,13 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
 
   analysis::TypeManager type_manager(context()->consumer(), context());
 
-  std::vector<Instruction*> visited_types;
-  std::vector<analysis::ForwardPointer> visited_forward_pointers;
+  // The types kept so far, bucketed by their structural hash.  Equal types
+  // have the same hash, so each type is only compared with the types in its
+  // bucket instead of every type seen so far.  The hash of a recursive type
+  // stops at the first repeated type, and the comparison handles the cycle.
+  std::unordered_map<size_t, std::vector<Instruction*>> visited_types;
+  std::unordered_map<size_t, std::vector<analysis::ForwardPointer>>
+      visited_forward_pointers;
   std::vector<Instruction*> to_delete;
   for (auto* i = &*context()->types_values_begin(); i; i = i->NextNode()) {
     const bool is_i_forward_pointer =
@@ -111,9 +142,9 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
       spv::Id id_to_keep = 0u;
       analysis::Type* i_type = type_manager.GetType(i->result_id());
       assert(i_type);
-      // TODO(dneto0): Use a trie to avoid quadratic behaviour? Extract the
-      // ResultIdTrie from unify_const_pass.cpp for this.
-      for (auto j : visited_types) {
+      std::vector<Instruction*>& candidates =
+          visited_types[i_type->HashValue()];
+      for (auto j : candidates) {
         analysis::Type* j_type = type_manager.GetType(j->result_id());
         assert(j_type);
         if (*i_type == *j_type) {
@@ -124,7 +155,7 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
 
       if (id_to_keep == 0u) {
         // This is a never seen before type, keep it around.
-        visited_types.emplace_back(i);
+        candidates.emplace_back(i);
       } else {
         // The same type has already been seen before, remove this one.
         context()->KillNamesAndDecorates(i->result_id());
@@ -139,16 +170,15 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
       i_type.SetTargetPointer(
           type_manager.GetType(i_type.target_id())->AsPointer());
 
-      // TODO(dneto0): Use a trie to avoid quadratic behaviour? Extract the
-      // ResultIdTrie from unify_const_pass.cpp for this.
+      std::vector<analysis::ForwardPointer>& candidates =
+          visited_forward_pointers[HashForwardPointer(i_type)];
       const bool found_a_match =
-          std::find(std::begin(visited_forward_pointers),
-                    std::end(visited_forward_pointers),
-                    i_type) != std::end(visited_forward_pointers);
+          std::find(std::begin(candidates), std::end(candidates), i_type) !=
+          std::end(candidates);
 
       if (!found_a_match) {
         // This is a never seen before type, keep it around.
-        visited_forward_pointers.emplace_back(i_type);
+        candidates.emplace_back(i_type);
       } else {
         // The same type has already been seen before, remove this one.
         modified = true;
@@ -176,16 +206,18 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
 bool RemoveDuplicatesPass::RemoveDuplicateDecorations() const {
   bool modified = false;
 
-  std::vector<const Instruction*> visited_decorations;
+  // The decorations kept so far, bucketed by a hash of their operands.
+  std::unordered_map<size_t, std::vector<const Instruction*>>
+      visited_decorations;
 
   analysis::DecorationManager decoration_manager(context()->module());
   for (auto* i = &*context()->annotation_begin(); i;) {
     // Is the current decoration equal to one of the decorations we have
     // already visited?
     bool already_visited = false;
-    // TODO(dneto0): Use a trie to avoid quadratic behaviour? Extract the
-    // ResultIdTrie from unify_const_pass.cpp for this.
-    for (const Instruction* j : visited_decorations) {
+    std::vector<const Instruction*>& candidates =
+        visited_decorations[HashDecoration(*i)];
+    for (const Instruction* j : candidates) {
       if (decoration_manager.AreDecorationsTheSame(&*i, j, false)) {
         already_visited = true;
         break;
@@ -194,7 +226,7 @@ bool RemoveDuplicatesPass::RemoveDuplicateDecorations() const {
 
     if (!already_visited) {
       // This is a never seen before decoration, keep it around.
-      visited_decorations.emplace_back(&*i);
+      candidates.emplace_back(&*i);
       i = i->NextNode();
     } else {
       // The same decoration has already been seen before, remove this one.
@@ -45,7 +45,9 @@
 namespace spvtools {
 namespace opt {
 
-uint32_t SENode::NumberOfNodes = 0;
+SENode::SENode(ScalarEvolutionAnalysis* parent_analysis)
+    : parent_analysis_(parent_analysis),
+      unique_id_(parent_analysis->TakeNextNodeId()) {}
 
 ScalarEvolutionAnalysis::ScalarEvolutionAnalysis(IRContext* context)
     : context_(context), pretend_equal_{} {
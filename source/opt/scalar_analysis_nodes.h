@@ -54,8 +54,7 @@ class SENode {
 
   using ChildContainerType = std::vector<SENode*>;
 
-  explicit SENode(ScalarEvolutionAnalysis* parent_analysis)
-      : parent_analysis_(parent_analysis), unique_id_(++NumberOfNodes) {}
+  explicit SENode(ScalarEvolutionAnalysis* parent_analysis);
 
   virtual SENodeType GetType() const = 0;
 
@@ -194,12 +193,8 @@ class SENode {
 
   ScalarEvolutionAnalysis* parent_analysis_;
 
-  // The unique id of this node, assigned on creation by incrementing the static
-  // node count.
+  // The unique id of this node, assigned on creation by |parent_analysis_|.
   uint32_t unique_id_;
-
-  // The number of nodes created.
-  static uint32_t NumberOfNodes;
 };
 // clang-format on
 
@@ -22,6 +22,7 @@
 #include <utility>
 
 #include "source/extensions.h"
+#include "source/opt/ir_builder.h"
 #include "source/opt/reflect.h"
 #include "source/opt/types.h"
 #include "source/util/make_unique.h"
@@ -59,10 +60,7 @@ Pass::Status ScalarReplacementPass::ProcessFunction(Function* function) {
     // of the entry block.
     if (iter->opcode() != spv::Op::OpVariable) break;
 
-    Instruction* varInst = &*iter;
-    if (CanReplaceVariable(varInst)) {
-      worklist.push(varInst);
-    }
+    AddToWorklist(&*iter, &worklist);
   }
 
   Status status = Status::SuccessWithoutChange;
@@ -70,7 +68,9 @@ Pass::Status ScalarReplacementPass::ProcessFunction(Function* function) {
     Instruction* varInst = worklist.front();
     worklist.pop();
 
-    Status var_status = ReplaceVariable(varInst, &worklist);
+    Status var_status = arrays_to_split_.erase(varInst)
+                            ? SplitArrayOfStructs(varInst, &worklist)
+                            : ReplaceVariable(varInst, &worklist);
     if (var_status == Status::Failure)
       return var_status;
     else if (var_status == Status::SuccessWithChange)
@@ -159,8 +159,8 @@ Pass::Status ScalarReplacementPass::ReplaceVariable(
     if (var->opcode() == spv::Op::OpVariable) {
       if (get_def_use_mgr()->NumUsers(var) == 0) {
         context()->KillInst(var);
-      } else if (CanReplaceVariable(var)) {
-        worklist->push(var);
+      } else {
+        AddToWorklist(var, worklist);
       }
     }
   }
@@ -168,6 +168,224 @@ Pass::Status ScalarReplacementPass::ReplaceVariable(
   return Status::SuccessWithChange;
 }
 
+void ScalarReplacementPass::AddToWorklist(Instruction* var_inst,
+                                          std::queue<Instruction*>* worklist) {
+  if (CanReplaceVariable(var_inst)) {
+    worklist->push(var_inst);
+  } else if (CanSplitArrayOfStructs(var_inst)) {
+    arrays_to_split_.insert(var_inst);
+    worklist->push(var_inst);
+  }
+}
+
+Pass::Status ScalarReplacementPass::SplitArrayOfStructs(
+    Instruction* var_inst, std::queue<Instruction*>* worklist) {
+  Instruction* array_type = GetStorageType(var_inst);
+  Instruction* struct_type =
+      get_def_use_mgr()->GetDef(array_type->GetSingleWordInOperand(0u));
+  analysis::TypeManager* type_mgr = context()->get_type_mgr();
+  const analysis::Array* array =
+      type_mgr->GetType(array_type->result_id())->AsArray();
+
+  // Create an array with the same length for each member.
+  std::vector<Instruction*> member_arrays;
+  for (uint32_t m = 0; m < struct_type->NumInOperands(); ++m) {
+    analysis::Array member_array(
+        type_mgr->GetType(struct_type->GetSingleWordInOperand(m)),
+        array->length_info());
+    const uint32_t member_array_type_id =
+        type_mgr->GetTypeInstruction(&member_array);
+    if (member_array_type_id == 0) {
+      return Status::Failure;
+    }
+    CreateVariable(member_array_type_id, var_inst, m, &member_arrays);
+    if (member_arrays.back() == nullptr) {
+      return Status::Failure;
+    }
+  }
+  TransferAnnotations(var_inst, &member_arrays);
+
+  std::vector<Instruction*> users;
+  get_def_use_mgr()->ForEachUser(
+      var_inst, [&users](Instruction* user) { users.push_back(user); });
+
+  std::vector<Instruction*> dead;
+  const uint32_t length = static_cast<uint32_t>(GetArrayLength(array_type));
+  const IRContext::Analysis preserved =
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping;
+  for (Instruction* user : users) {
+    switch (user->opcode()) {
+      case spv::Op::OpAccessChain:
+      case spv::Op::OpInBoundsAccessChain: {
+        const uint32_t element_index_id = user->GetSingleWordInOperand(1u);
+        if (user->NumInOperands() == 2) {
+          std::vector<Instruction*> element_users;
+          get_def_use_mgr()->ForEachUser(
+              user, [&element_users](Instruction* element_user) {
+                element_users.push_back(element_user);
+              });
+          for (Instruction* element_user : element_users) {
+            if (!SplitElementAccess(element_user, element_index_id,
+                                    member_arrays, &dead)) {
+              return Status::Failure;
+            }
+          }
+        } else {
+          const uint32_t member = static_cast<uint32_t>(
+              context()
+                  ->get_constant_mgr()
+                  ->FindDeclaredConstant(user->GetSingleWordInOperand(2u))
+                  ->GetZeroExtendedValue());
+          std::vector<uint32_t> index_ids = {element_index_id};
+          for (uint32_t i = 3; i < user->NumInOperands(); ++i) {
+            index_ids.push_back(user->GetSingleWordInOperand(i));
+          }
+          if (!LowerAccessChain(user, member_arrays[member]->result_id(),
+                                index_ids)) {
+            return Status::Failure;
+          }
+        }
+        dead.push_back(user);
+      } break;
+      case spv::Op::OpLoad: {
+        // Load each member array, and rebuild every element from them.
+        InstructionBuilder builder(context(), user, preserved);
+        std::vector<uint32_t> member_values;
+        for (Instruction* member_array : member_arrays) {
+          member_values.push_back(
+              builder
+                  .AddLoad(GetStorageType(member_array)->result_id(),
+                           member_array->result_id())
+                  ->result_id());
+        }
+        std::vector<uint32_t> elements;
+        for (uint32_t i = 0; i < length; ++i) {
+          std::vector<uint32_t> members;
+          for (uint32_t m = 0; m < member_values.size(); ++m) {
+            members.push_back(
+                builder
+                    .AddCompositeExtract(struct_type->GetSingleWordInOperand(m),
+                                         member_values[m], {i})
+                    ->result_id());
+          }
+          elements.push_back(
+              builder.AddCompositeConstruct(struct_type->result_id(), members)
+                  ->result_id());
+        }
+        Instruction* value =
+            builder.AddCompositeConstruct(array_type->result_id(), elements);
+        context()->ReplaceAllUsesWith(user->result_id(), value->result_id());
+        dead.push_back(user);
+      } break;
+      case spv::Op::OpStore: {
+        // Gather each member of every element into the member arrays.
+        InstructionBuilder builder(context(), user, preserved);
+        const uint32_t value_id = user->GetSingleWordInOperand(1u);
+        for (uint32_t m = 0; m < member_arrays.size(); ++m) {
+          std::vector<uint32_t> elements;
+          for (uint32_t i = 0; i < length; ++i) {
+            elements.push_back(
+                builder
+                    .AddCompositeExtract(struct_type->GetSingleWordInOperand(m),
+                                         value_id, {i, m})
+                    ->result_id());
+          }
+          Instruction* member_value = builder.AddCompositeConstruct(
+              GetStorageType(member_arrays[m])->result_id(), elements);
+          builder.AddStore(member_arrays[m]->result_id(),
+                           member_value->result_id());
+        }
+        dead.push_back(user);
+      } break;
+      default:
+        // Names and decorations are removed with the variable.
+        break;
+    }
+  }
+
+  for (Instruction* inst : dead) {
+    context()->KillInst(inst);
+  }
+  context()->KillInst(var_inst);
+
+  for (Instruction* member_array : member_arrays) {
+    if (get_def_use_mgr()->NumUsers(member_array) == 0) {
+      context()->KillInst(member_array);
+    } else {
+      AddToWorklist(member_array, worklist);
+    }
+  }
+  return Status::SuccessWithChange;
+}
+
+bool ScalarReplacementPass::SplitElementAccess(
+    Instruction* user, uint32_t element_index_id,
+    const std::vector<Instruction*>& member_arrays,
+    std::vector<Instruction*>* dead) {
+  const IRContext::Analysis preserved =
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping;
+  switch (user->opcode()) {
+    case spv::Op::OpAccessChain:
+    case spv::Op::OpInBoundsAccessChain: {
+      const uint32_t member = static_cast<uint32_t>(
+          context()
+              ->get_constant_mgr()
+              ->FindDeclaredConstant(user->GetSingleWordInOperand(1u))
+              ->GetZeroExtendedValue());
+      std::vector<uint32_t> index_ids = {element_index_id};
+      for (uint32_t i = 2; i < user->NumInOperands(); ++i) {
+        index_ids.push_back(user->GetSingleWordInOperand(i));
+      }
+      if (!LowerAccessChain(user, member_arrays[member]->result_id(),
+                            index_ids)) {
+        return false;
+      }
+      dead->push_back(user);
+    } break;
+    case spv::Op::OpLoad: {
+      // Load each member of the element, and rebuild the element.
+      InstructionBuilder builder(context(), user, preserved);
+      std::vector<uint32_t> members;
+      for (Instruction* member_array : member_arrays) {
+        const uint32_t member_type_id =
+            GetStorageType(member_array)->GetSingleWordInOperand(0u);
+        Instruction* member_ptr =
+            builder.AddAccessChain(GetOrCreatePointerType(member_type_id),
+                                   member_array->result_id(),
+                                   {element_index_id});
+        members.push_back(
+            builder.AddLoad(member_type_id, member_ptr->result_id())
+                ->result_id());
+      }
+      Instruction* element =
+          builder.AddCompositeConstruct(user->type_id(), members);
+      context()->ReplaceAllUsesWith(user->result_id(), element->result_id());
+      dead->push_back(user);
+    } break;
+    case spv::Op::OpStore: {
+      // Store each member of the element.
+      InstructionBuilder builder(context(), user, preserved);
+      const uint32_t value_id = user->GetSingleWordInOperand(1u);
+      for (uint32_t m = 0; m < member_arrays.size(); ++m) {
+        const uint32_t member_type_id =
+            GetStorageType(member_arrays[m])->GetSingleWordInOperand(0u);
+        Instruction* member_ptr =
+            builder.AddAccessChain(GetOrCreatePointerType(member_type_id),
+                                   member_arrays[m]->result_id(),
+                                   {element_index_id});
+        Instruction* member_value =
+            builder.AddCompositeExtract(member_type_id, value_id, {m});
+        builder.AddStore(member_ptr->result_id(), member_value->result_id());
+      }
+      dead->push_back(user);
+    } break;
+    default:
+      // Names are removed with the access chain.
+      break;
+  }
+  return true;
+}
+
 bool ScalarReplacementPass::ReplaceWholeDebugDeclare(
     Instruction* dbg_decl, const std::vector<Instruction*>& replacements) {
   // Insert Deref operation to the front of the operation list of |dbg_decl|.
@@ -351,35 +569,44 @@ bool ScalarReplacementPass::ReplaceAccessChain(
     // Out of bounds access, this is illegal IR.  Notice that OpAccessChain
     // indexing is 0-based, so we should also reject index == size-of-array.
     return false;
-  } else {
-    const Instruction* var = replacements[static_cast<size_t>(indexValue)];
-    if (chain->NumInOperands() > 2) {
-      // Replace input access chain with another access chain.
-      BasicBlock::iterator chainIter(chain);
-      uint32_t replacementId = TakeNextId();
-      if (replacementId == 0) {
-        return false;
-      }
-      std::unique_ptr<Instruction> replacementChain(new Instruction(
-          context(), chain->opcode(), chain->type_id(), replacementId,
-          std::initializer_list<Operand>{
-              {SPV_OPERAND_TYPE_ID, {var->result_id()}}}));
-      // Add the remaining indexes.
-      for (uint32_t i = 2; i < chain->NumInOperands(); ++i) {
-        Operand copy(chain->GetInOperand(i));
-        replacementChain->AddOperand(std::move(copy));
-      }
-      replacementChain->UpdateDebugInfoFrom(chain);
-      auto iter = chainIter.InsertBefore(std::move(replacementChain));
-      get_def_use_mgr()->AnalyzeInstDefUse(&*iter);
-      context()->set_instr_block(&*iter, context()->get_instr_block(chain));
-      context()->ReplaceAllUsesWith(chain->result_id(), replacementId);
-    } else {
-      // Replace with a use of the variable.
-      context()->ReplaceAllUsesWith(chain->result_id(), var->result_id());
-    }
   }
 
+  const Instruction* var = replacements[static_cast<size_t>(indexValue)];
+  std::vector<uint32_t> index_ids;
+  for (uint32_t i = 2; i < chain->NumInOperands(); ++i) {
+    index_ids.push_back(chain->GetSingleWordInOperand(i));
+  }
+  return LowerAccessChain(chain, var->result_id(), index_ids);
+}
+
+bool ScalarReplacementPass::LowerAccessChain(
+    Instruction* chain, uint32_t base_id,
+    const std::vector<uint32_t>& index_ids) {
+  if (index_ids.empty()) {
+    // Replace with a use of the base.
+    context()->ReplaceAllUsesWith(chain->result_id(), base_id);
+    return true;
+  }
+
+  // Replace input access chain with another access chain.
+  BasicBlock::iterator chainIter(chain);
+  uint32_t replacementId = TakeNextId();
+  if (replacementId == 0) {
+    return false;
+  }
+  std::unique_ptr<Instruction> replacementChain(
+      new Instruction(context(), chain->opcode(), chain->type_id(),
+                      replacementId,
+                      std::initializer_list<Operand>{
+                          {SPV_OPERAND_TYPE_ID, {base_id}}}));
+  for (uint32_t index_id : index_ids) {
+    replacementChain->AddOperand({SPV_OPERAND_TYPE_ID, {index_id}});
+  }
+  replacementChain->UpdateDebugInfoFrom(chain);
+  auto iter = chainIter.InsertBefore(std::move(replacementChain));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*iter);
+  context()->set_instr_block(&*iter, context()->get_instr_block(chain));
+  context()->ReplaceAllUsesWith(chain->result_id(), replacementId);
   return true;
 }
 
@@ -632,6 +859,115 @@ bool ScalarReplacementPass::CanReplaceVariable(
   return true;
 }
 
+bool ScalarReplacementPass::CanSplitArrayOfStructs(
+    const Instruction* var_inst) const {
+  assert(var_inst->opcode() == spv::Op::OpVariable);
+
+  // Can only split function scope variables, without an initializer other
+  // than null, since the initializer would have to be split too.
+  if (spv::StorageClass(var_inst->GetSingleWordInOperand(0u)) !=
+      spv::StorageClass::Function) {
+    return false;
+  }
+  if (var_inst->NumInOperands() > 1) {
+    const Instruction* init =
+        get_def_use_mgr()->GetDef(var_inst->GetSingleWordInOperand(1u));
+    if (init->opcode() != spv::Op::OpConstantNull) {
+      return false;
+    }
+  }
+
+  if (!CheckTypeAnnotations(get_def_use_mgr()->GetDef(var_inst->type_id())) ||
+      !CheckAnnotations(var_inst)) {
+    return false;
+  }
+
+  const Instruction* array_type = GetStorageType(var_inst);
+  if (array_type->opcode() != spv::Op::OpTypeArray ||
+      IsSpecConstant(array_type->GetSingleWordInOperand(1u)) ||
+      !CheckTypeAnnotations(array_type)) {
+    return false;
+  }
+  const Instruction* struct_type =
+      get_def_use_mgr()->GetDef(array_type->GetSingleWordInOperand(0u));
+  if (struct_type->opcode() != spv::Op::OpTypeStruct ||
+      struct_type->NumInOperands() == 0 ||
+      IsLargerThanSizeLimit(struct_type->NumInOperands()) ||
+      !CheckTypeAnnotations(struct_type)) {
+    return false;
+  }
+
+  const uint64_t num_members = struct_type->NumInOperands();
+  const bool can_split_whole_accesses =
+      GetArrayLength(array_type) * num_members <= kMaxSplitWholeAccessMembers;
+  auto is_member_index = [this, num_members](uint32_t id) {
+    const analysis::Constant* constant =
+        context()->get_constant_mgr()->FindDeclaredConstant(id);
+    return constant != nullptr &&
+           constant->GetZeroExtendedValue() < num_members;
+  };
+
+  // Splitting only pays off if some access selects a single member.
+  bool selects_member = false;
+  auto check_element_use = [this, &is_member_index, &selects_member](
+                               Instruction* user, uint32_t index) {
+    switch (user->opcode()) {
+      case spv::Op::OpAccessChain:
+      case spv::Op::OpInBoundsAccessChain:
+        if (index != 2u || user->NumInOperands() < 2 ||
+            !is_member_index(user->GetSingleWordInOperand(1u))) {
+          return false;
+        }
+        selects_member = true;
+        return CheckUsesRelaxed(user);
+      case spv::Op::OpLoad:
+        return CheckLoad(user, index);
+      case spv::Op::OpStore:
+        return CheckStore(user, index);
+      case spv::Op::OpName:
+        return true;
+      default:
+        return false;
+    }
+  };
+
+  const bool ok = get_def_use_mgr()->WhileEachUse(
+      var_inst, [this, can_split_whole_accesses, &is_member_index,
+                 &selects_member, &check_element_use](Instruction* user,
+                                                      uint32_t index) {
+        // Annotations are checked as a group separately.
+        if (IsAnnotationInst(user->opcode())) {
+          return true;
+        }
+        switch (user->opcode()) {
+          case spv::Op::OpAccessChain:
+          case spv::Op::OpInBoundsAccessChain:
+            if (index != 2u || user->NumInOperands() < 2) {
+              return false;
+            }
+            if (user->NumInOperands() == 2) {
+              // A pointer to an element, which may be dynamically indexed.
+              return get_def_use_mgr()->WhileEachUse(user, check_element_use);
+            }
+            if (!is_member_index(user->GetSingleWordInOperand(2u))) {
+              return false;
+            }
+            selects_member = true;
+            return CheckUsesRelaxed(user);
+          case spv::Op::OpLoad:
+            return can_split_whole_accesses && CheckLoad(user, index);
+          case spv::Op::OpStore:
+            return can_split_whole_accesses && CheckStore(user, index);
+          case spv::Op::OpName:
+          case spv::Op::OpMemberName:
+            return true;
+          default:
+            return false;
+        }
+      });
+  return ok && selects_member;
+}
+
 bool ScalarReplacementPass::CheckType(const Instruction* typeInst) const {
   if (!CheckTypeAnnotations(typeInst)) {
     return false;
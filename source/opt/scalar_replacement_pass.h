@@ -34,6 +34,10 @@ namespace opt {
 class ScalarReplacementPass : public MemPass {
  private:
   static constexpr uint32_t kDefaultLimit = 0;
+  // Loads and stores of a whole array of structs are only split when the
+  // array has at most this many members in total, because they are replaced
+  // with an extract and a construct for each member.
+  static constexpr uint64_t kMaxSplitWholeAccessMembers = 256;
 
  public:
   ScalarReplacementPass(uint32_t limit = kDefaultLimit)
@@ -87,6 +91,37 @@ class ScalarReplacementPass : public MemPass {
   // scalarization.
   bool CanReplaceVariable(const Instruction* varInst) const;
 
+  // Adds |var_inst| to |worklist| if it can be scalarized or split into one
+  // array per struct member.
+  void AddToWorklist(Instruction* var_inst,
+                     std::queue<Instruction*>* worklist);
+
+  // Returns true if |var_inst| is an array of structs that can be split into
+  // one array per member of the struct.
+  //
+  // The elements of the array may be indexed dynamically, but each access
+  // chain must then select a struct member with a constant index, either in
+  // the same access chain or in an access chain based on a pointer to the
+  // element.  Whole elements may be loaded and stored, and so may the whole
+  // array when it is small.
+  bool CanSplitArrayOfStructs(const Instruction* var_inst) const;
+
+  // Replaces |var_inst|, an array of structs, with an array variable for each
+  // member of the struct, and updates its uses.  The new variables that can
+  // be scalarized or split further are added to |worklist|.  Returns
+  //  - Status::SuccessWithChange if the variable was split.
+  //  - Status::Failure if it couldn't create the new variables.
+  Pass::Status SplitArrayOfStructs(Instruction* var_inst,
+                                   std::queue<Instruction*>* worklist);
+
+  // Replaces |user|, a use of a pointer to the element |element_index_id| of
+  // an array of structs that is split into |member_arrays|, with accesses to
+  // the member arrays.  |user| is added to |dead| if it must be removed.
+  // Returns true if successful.
+  bool SplitElementAccess(Instruction* user, uint32_t element_index_id,
+                          const std::vector<Instruction*>& member_arrays,
+                          std::vector<Instruction*>* dead);
+
   // Returns true if |typeInst| is an acceptable type to scalarize.
   //
   // Allows all aggregate types except runtime arrays. Additionally, checks the
@@ -240,6 +275,12 @@ class ScalarReplacementPass : public MemPass {
   bool ReplaceAccessChain(Instruction* chain,
                           const std::vector<Instruction*>& replacements);
 
+  // Replaces |chain| with an access chain of the same type into |base_id|
+  // that uses |index_ids| as indexes, or with |base_id| itself if there are
+  // no indexes.  Returns true if successful.
+  bool LowerAccessChain(Instruction* chain, uint32_t base_id,
+                        const std::vector<uint32_t>& index_ids);
+
   // Returns a set containing the which components of the result of |inst| are
   // potentially used.  If the return value is |nullptr|, then every components
   // is possibly used.
@@ -278,6 +319,10 @@ class ScalarReplacementPass : public MemPass {
                                                 Instruction* to,
                                                 uint32_t member_index);
 
+  // The variables in the worklist that are split into one array per struct
+  // member rather than scalarized.
+  std::unordered_set<const Instruction*> arrays_to_split_;
+
   // Limit on the number of members in an object that will be replaced.
   // 0 means there is no limit.
   uint32_t max_num_elements_;
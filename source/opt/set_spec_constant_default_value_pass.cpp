@@ -17,6 +17,8 @@
 #include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <map>
+#include <sstream>
 #include <tuple>
 #include <vector>
 
@@ -212,6 +214,27 @@ Instruction* GetSpecIdTargetFromDecorationGroup(
 }
 }  // namespace
 
+std::string SetSpecConstantDefaultValuePass::CacheKey() const {
+  // Sorted, so that the key does not depend on the order of the hash maps.
+  std::map<uint32_t, std::string> str_values(spec_id_to_value_str_.begin(),
+                                             spec_id_to_value_str_.end());
+  std::map<uint32_t, std::vector<uint32_t>> bit_patterns(
+      spec_id_to_value_bit_pattern_.begin(),
+      spec_id_to_value_bit_pattern_.end());
+  std::ostringstream key;
+  key << name();
+  for (const auto& value : str_values) {
+    // The length delimits the string, which may contain anything.
+    key << " " << value.first << ":" << value.second.size() << ":"
+        << value.second;
+  }
+  for (const auto& value : bit_patterns) {
+    key << " " << value.first << "=";
+    for (uint32_t word : value.second) key << " " << word;
+  }
+  return key.str();
+}
+
 Pass::Status SetSpecConstantDefaultValuePass::Process() {
   // The operand index of decoration target in an OpDecorate instruction.
   constexpr uint32_t kTargetIdOperandIndex = 0;
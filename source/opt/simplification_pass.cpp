@@ -26,7 +26,16 @@ Pass::Status SimplificationPass::Process() {
   bool modified = false;
 
   for (Function& function : *get_module()) {
-    modified |= SimplifyFunction(&function);
+    // Simplifying a function only depends on the function itself, so there is
+    // nothing to do if it has not changed since this pass last left it as is.
+    if (context()->IsFunctionUnchangedSinceLastRun(name(), function)) {
+      continue;
+    }
+    if (SimplifyFunction(&function)) {
+      modified = true;
+    } else {
+      context()->RecordFunctionUnchangedByRun(name(), &function);
+    }
   }
   return (modified ? Status::SuccessWithChange : Status::SuccessWithoutChange);
 }
@@ -38,9 +38,17 @@
 // minimal number of Phi instructions required to ensure the SSA property, but
 // some Phi instructions may be dead
 // (https://en.wikipedia.org/wiki/Static_single_assignment_form).
+//
+// The memoization tables hold the value of every variable at every block it
+// is queried in, which grows with blocks times variables.  For functions with
+// many blocks, such as those produced by full loop unrolling, the rewriter
+// uses the algorithm of Cytron et al. instead: Phis are placed at the
+// iterated dominance frontiers of the stores, and loads are renamed in a
+// single walk of the dominator tree.
 
 #include "source/opt/ssa_rewrite_pass.h"
 
+#include <limits>
 #include <memory>
 #include <sstream>
 
@@ -65,6 +73,65 @@ namespace opt {
 namespace {
 constexpr uint32_t kStoreValIdInIdx = 1;
 constexpr uint32_t kVariableInitIdInIdx = 1;
+
+// Returns the immediate dominator of every block, given the predecessors of
+// each block.  Blocks are numbered in reverse post-order, so block 0 is the
+// entry block, which is recorded as its own immediate dominator.  This is the
+// iterative algorithm of Cooper, Harvey and Kennedy.
+std::vector<uint32_t> ComputeImmediateDominators(
+    const std::vector<std::vector<uint32_t>>& preds) {
+  constexpr uint32_t kUndefined = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> idom(preds.size(), kUndefined);
+  if (preds.empty()) return idom;
+  idom[0] = 0;
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t b = 1; b < preds.size(); ++b) {
+      uint32_t new_idom = kUndefined;
+      for (uint32_t p : preds[b]) {
+        if (idom[p] == kUndefined) continue;
+        if (new_idom == kUndefined) {
+          new_idom = p;
+          continue;
+        }
+        uint32_t finger1 = p;
+        uint32_t finger2 = new_idom;
+        while (finger1 != finger2) {
+          while (finger1 > finger2) finger1 = idom[finger1];
+          while (finger2 > finger1) finger2 = idom[finger2];
+        }
+        new_idom = finger1;
+      }
+      if (idom[b] != new_idom) {
+        idom[b] = new_idom;
+        changed = true;
+      }
+    }
+  }
+  return idom;
+}
+
+// Returns the dominance frontier of every block, given the predecessors and
+// the immediate dominator of each block.
+std::vector<std::vector<uint32_t>> ComputeDominanceFrontiers(
+    const std::vector<std::vector<uint32_t>>& preds,
+    const std::vector<uint32_t>& idom) {
+  std::vector<std::vector<uint32_t>> frontiers(preds.size());
+  for (uint32_t b = 0; b < preds.size(); ++b) {
+    if (preds[b].size() < 2) continue;
+    for (uint32_t runner : preds[b]) {
+      while (runner != idom[b]) {
+        std::vector<uint32_t>& frontier = frontiers[runner];
+        if (!frontier.empty() && frontier.back() == b) break;
+        frontier.push_back(b);
+        runner = idom[runner];
+      }
+    }
+  }
+  return frontiers;
+}
 }  // namespace
 
 std::string SSARewriter::PhiCandidate::PrettyPrint(const CFG* cfg) const {
@@ -296,20 +363,27 @@ void SSARewriter::SealBlock(BasicBlock* bb) {
          "Tried to seal the same basic block more than once.");
 }
 
-void SSARewriter::ProcessStore(Instruction* inst, BasicBlock* bb) {
+void SSARewriter::GetStoredValue(Instruction* inst, uint32_t* var_id,
+                                 uint32_t* val_id) {
   auto opcode = inst->opcode();
   assert((opcode == spv::Op::OpStore || opcode == spv::Op::OpVariable) &&
          "Expecting a store or a variable definition instruction.");
 
-  uint32_t var_id = 0;
-  uint32_t val_id = 0;
+  *var_id = 0;
+  *val_id = 0;
   if (opcode == spv::Op::OpStore) {
-    (void)pass_->GetPtr(inst, &var_id);
-    val_id = inst->GetSingleWordInOperand(kStoreValIdInIdx);
+    (void)pass_->GetPtr(inst, var_id);
+    *val_id = inst->GetSingleWordInOperand(kStoreValIdInIdx);
   } else if (inst->NumInOperands() >= 2) {
-    var_id = inst->result_id();
-    val_id = inst->GetSingleWordInOperand(kVariableInitIdInIdx);
+    *var_id = inst->result_id();
+    *val_id = inst->GetSingleWordInOperand(kVariableInitIdInIdx);
   }
+}
+
+void SSARewriter::ProcessStore(Instruction* inst, BasicBlock* bb) {
+  uint32_t var_id = 0;
+  uint32_t val_id = 0;
+  GetStoredValue(inst, &var_id, &val_id);
   if (pass_->IsTargetVar(var_id)) {
     WriteVariable(var_id, bb, val_id);
     pass_->context()->get_debug_info_mgr()->AddDebugValueForVariable(
@@ -656,6 +730,12 @@ Pass::Status SSARewriter::RewriteFunctionIntoSSA(Function* fp) {
   // Collect variables that can be converted into SSA IDs.
   pass_->CollectTargetVars(fp);
 
+  uint32_t num_blocks = 0;
+  for (auto bi = fp->begin(); bi != fp->end(); ++bi) ++num_blocks;
+  if (num_blocks >= dominance_frontier_threshold_) {
+    return RewriteWithDominanceFrontiers(fp);
+  }
+
   // Generate all the SSA replacements and Phi candidates. This will
   // generate incomplete and trivial Phis.
   bool succeeded = pass_->cfg()->WhileEachBlockInReversePostOrder(
@@ -685,14 +765,257 @@ Pass::Status SSARewriter::RewriteFunctionIntoSSA(Function* fp) {
                   : Pass::Status::SuccessWithoutChange;
 }
 
+Pass::Status SSARewriter::RewriteWithDominanceFrontiers(Function* fp) {
+  CFG* cfg = pass_->cfg();
+
+  // Number the reachable blocks in reverse post-order.  Unreachable blocks
+  // are left alone, as in the on-the-fly algorithm.
+  std::vector<BasicBlock*> blocks;
+  std::unordered_map<uint32_t, uint32_t> block_index;
+  cfg->ForEachBlockInReversePostOrder(
+      fp->entry().get(), [&blocks, &block_index](BasicBlock* bb) {
+        block_index[bb->id()] = static_cast<uint32_t>(blocks.size());
+        blocks.push_back(bb);
+      });
+  const uint32_t num_blocks = static_cast<uint32_t>(blocks.size());
+
+  std::vector<std::vector<uint32_t>> preds(num_blocks);
+  for (uint32_t b = 0; b < num_blocks; ++b) {
+    for (uint32_t pred_label : cfg->preds(blocks[b]->id())) {
+      auto it = block_index.find(pred_label);
+      if (it != block_index.end()) preds[b].push_back(it->second);
+    }
+  }
+  const std::vector<uint32_t> idom = ComputeImmediateDominators(preds);
+  const std::vector<std::vector<uint32_t>> frontiers =
+      ComputeDominanceFrontiers(preds, idom);
+
+  // Number the target variables, and find the blocks storing each of them and
+  // the variables that are loaded before being stored in some block.  Only
+  // the latter can need a Phi.  A load of a pointer may be a load through a
+  // variable holding a pointer to another target variable, which this scan
+  // does not follow, so every variable is then considered live.
+  std::unordered_map<uint32_t, uint32_t> var_index;
+  std::vector<uint32_t> vars;
+  std::vector<std::vector<uint32_t>> def_blocks;
+  std::vector<uint32_t> last_store_block;
+  std::vector<bool> live_in;
+  bool loads_pointers = false;
+  auto index_of = [&](uint32_t var_id) {
+    auto result =
+        var_index.emplace(var_id, static_cast<uint32_t>(vars.size()));
+    if (result.second) {
+      vars.push_back(var_id);
+      def_blocks.emplace_back();
+      last_store_block.push_back(0);
+      live_in.push_back(false);
+    }
+    return result.first->second;
+  };
+
+  analysis::DefUseManager* def_use_mgr = pass_->context()->get_def_use_mgr();
+  analysis::TypeManager* type_mgr = pass_->context()->get_type_mgr();
+  for (uint32_t b = 0; b < num_blocks; ++b) {
+    for (auto& inst : *blocks[b]) {
+      uint32_t var_id = 0;
+      if (inst.opcode() == spv::Op::OpStore ||
+          inst.opcode() == spv::Op::OpVariable) {
+        uint32_t val_id = 0;
+        GetStoredValue(&inst, &var_id, &val_id);
+        if (!pass_->IsTargetVar(var_id)) continue;
+        const uint32_t k = index_of(var_id);
+        if (def_blocks[k].empty() || def_blocks[k].back() != b) {
+          def_blocks[k].push_back(b);
+        }
+        last_store_block[k] = b + 1;
+      } else if (inst.opcode() == spv::Op::OpLoad) {
+        (void)pass_->GetPtr(&inst, &var_id);
+        if (!pass_->IsTargetVar(var_id)) continue;
+        const uint32_t k = index_of(var_id);
+        if (last_store_block[k] != b + 1) live_in[k] = true;
+        if (type_mgr->GetType(inst.type_id())->AsPointer()) {
+          loads_pointers = true;
+        }
+      }
+    }
+  }
+
+  // Place Phi candidates at the iterated dominance frontier of the blocks
+  // storing each live variable.  The markers hold the index of the last
+  // variable, plus one, that placed a Phi in or queued each block.
+  std::vector<std::vector<std::pair<uint32_t, PhiCandidate*>>> block_phis(
+      num_blocks);
+  std::vector<uint32_t> has_phi(num_blocks, 0);
+  std::vector<uint32_t> queued(num_blocks, 0);
+  std::vector<uint32_t> worklist;
+  for (uint32_t k = 0; k < vars.size(); ++k) {
+    if (!live_in[k] && !loads_pointers) continue;
+    const uint32_t marker = k + 1;
+    worklist = def_blocks[k];
+    for (uint32_t b : worklist) queued[b] = marker;
+    while (!worklist.empty()) {
+      const uint32_t b = worklist.back();
+      worklist.pop_back();
+      for (uint32_t d : frontiers[b]) {
+        if (has_phi[d] == marker) continue;
+        has_phi[d] = marker;
+        PhiCandidate& phi_candidate = CreatePhiCandidate(vars[k], blocks[d]);
+        phi_candidate.phi_args().resize(cfg->preds(blocks[d]->id()).size(),
+                                        0);
+        block_phis[d].push_back({k, &phi_candidate});
+        if (queued[d] != marker) {
+          queued[d] = marker;
+          worklist.push_back(d);
+        }
+      }
+    }
+  }
+
+  // Rename loads and Phi arguments walking the dominator tree.  The current
+  // definition of each variable is the top of its stack, and |pushed| logs
+  // the variables defined in the blocks on the current path so their
+  // definitions can be popped when the walk leaves a block.
+  std::vector<std::vector<uint32_t>> current_defs(vars.size());
+  std::vector<uint32_t> pushed;
+  auto current_def = [&](uint32_t var_id) {
+    auto it = var_index.find(var_id);
+    if (it == var_index.end() || current_defs[it->second].empty()) {
+      return pass_->GetUndefVal(var_id);
+    }
+    return current_defs[it->second].back();
+  };
+  auto define = [&current_defs, &pushed](uint32_t k, uint32_t val_id) {
+    current_defs[k].push_back(val_id);
+    pushed.push_back(k);
+  };
+
+  auto rename_block = [&](uint32_t b) {
+    BasicBlock* bb = blocks[b];
+    for (auto& phi : block_phis[b]) define(phi.first, phi.second->result_id());
+
+    for (auto& inst : *bb) {
+      if (inst.opcode() == spv::Op::OpStore ||
+          inst.opcode() == spv::Op::OpVariable) {
+        uint32_t var_id = 0;
+        uint32_t val_id = 0;
+        GetStoredValue(&inst, &var_id, &val_id);
+        if (!pass_->IsTargetVar(var_id)) continue;
+        define(var_index[var_id], val_id);
+        pass_->context()->get_debug_info_mgr()->AddDebugValueForVariable(
+            &inst, var_id, val_id, &inst);
+      } else if (inst.opcode() == spv::Op::OpLoad) {
+        // Follow variables holding pointers to other target variables, as
+        // ProcessLoad does.
+        uint32_t var_id = 0;
+        (void)pass_->GetPtr(&inst, &var_id);
+        const analysis::Type* load_type = type_mgr->GetType(inst.type_id());
+        uint32_t val_id = 0;
+        while (pass_->IsTargetVar(var_id)) {
+          val_id = current_def(var_id);
+          if (val_id == 0) return false;
+          Instruction* reaching_def_inst = def_use_mgr->GetDef(val_id);
+          if (reaching_def_inst == nullptr ||
+              type_mgr->GetType(reaching_def_inst->type_id())
+                  ->IsSame(load_type)) {
+            break;
+          }
+          var_id = val_id;
+          val_id = 0;
+        }
+        if (val_id != 0) load_replacement_[inst.result_id()] = val_id;
+      }
+    }
+
+    bb->ForEachSuccessorLabel([&](const uint32_t succ_label) {
+      auto it = block_index.find(succ_label);
+      if (it == block_index.end()) return;
+      const auto& succ_preds = cfg->preds(succ_label);
+      for (auto& phi : block_phis[it->second]) {
+        const uint32_t val_id = current_def(phi.second->var_id());
+        for (uint32_t i = 0; i < succ_preds.size(); ++i) {
+          if (succ_preds[i] == bb->id()) phi.second->phi_args()[i] = val_id;
+        }
+      }
+    });
+    return true;
+  };
+
+  std::vector<std::vector<uint32_t>> children(num_blocks);
+  for (uint32_t b = 1; b < num_blocks; ++b) children[idom[b]].push_back(b);
+
+  struct Frame {
+    uint32_t block;
+    uint32_t next_child;
+    size_t num_pushed;
+  };
+  std::vector<Frame> walk;
+  if (num_blocks > 0) {
+    if (!rename_block(0)) return Pass::Status::Failure;
+    walk.push_back({0, 0, 0});
+  }
+  while (!walk.empty()) {
+    Frame& frame = walk.back();
+    if (frame.next_child < children[frame.block].size()) {
+      const uint32_t child = children[frame.block][frame.next_child++];
+      const size_t num_pushed = pushed.size();
+      if (!rename_block(child)) return Pass::Status::Failure;
+      walk.push_back({child, 0, num_pushed});
+      continue;
+    }
+    while (pushed.size() > frame.num_pushed) {
+      current_defs[pushed.back()].pop_back();
+      pushed.pop_back();
+    }
+    walk.pop_back();
+  }
+
+  // Arguments coming from unreachable predecessors are undefined.
+  for (auto& phis : block_phis) {
+    for (auto& phi : phis) {
+      for (uint32_t& arg_id : phi.second->phi_args()) {
+        if (arg_id != 0) continue;
+        arg_id = pass_->GetUndefVal(phi.second->var_id());
+        if (arg_id == 0) return Pass::Status::Failure;
+      }
+    }
+  }
+
+  // Only generate the Phi candidates that some load reaches, directly or
+  // through other Phis.  Marking a candidate complete marks it live.
+  std::vector<PhiCandidate*> live_phis;
+  auto mark_live = [this, &live_phis](uint32_t id) {
+    PhiCandidate* phi_candidate = GetPhiCandidate(id);
+    if (phi_candidate && !phi_candidate->is_complete()) {
+      phi_candidate->MarkComplete();
+      live_phis.push_back(phi_candidate);
+    }
+  };
+  for (const auto& repl : load_replacement_) mark_live(repl.second);
+  while (!live_phis.empty()) {
+    PhiCandidate* phi_candidate = live_phis.back();
+    live_phis.pop_back();
+    for (uint32_t arg_id : phi_candidate->phi_args()) mark_live(arg_id);
+  }
+  for (auto& phis : block_phis) {
+    for (auto& phi : phis) {
+      if (phi.second->is_complete()) phis_to_generate_.push_back(phi.second);
+    }
+  }
+
+  bool modified = ApplyReplacements();
+  return modified ? Pass::Status::SuccessWithChange
+                  : Pass::Status::SuccessWithoutChange;
+}
+
 Pass::Status SSARewritePass::Process() {
   Status status = Status::SuccessWithoutChange;
   for (auto& fn : *get_module()) {
     if (fn.IsDeclaration()) {
       continue;
     }
-    status =
-        CombineStatus(status, SSARewriter(this).RewriteFunctionIntoSSA(&fn));
+    status = CombineStatus(
+        status, SSARewriter(this, dominance_frontier_threshold_)
+                    .RewriteFunctionIntoSSA(&fn));
     // Kill DebugDeclares for target variables.
     for (auto var_id : seen_target_vars_) {
       context()->get_debug_info_mgr()->KillDebugDeclares(var_id);
@@ -37,9 +37,21 @@ namespace opt {
 // operations on SSA IDs.  Phi instructions are added when needed.  See the
 // SSA construction paper for algorithmic details
 // (https://link.springer.com/chapter/10.1007/978-3-642-37051-9_6)
+//
+// Functions with many blocks are instead rewritten with the classic
+// algorithm based on iterated dominance frontiers, which keeps its state in
+// flat per-block arrays and only tracks the current definition of each
+// variable along the dominator tree path being renamed.
 class SSARewriter {
  public:
-  SSARewriter(MemPass* pass) : pass_(pass) {}
+  // Functions with at least this many blocks are rewritten with the
+  // dominance frontier algorithm.
+  static constexpr uint32_t kDefaultDominanceFrontierThreshold = 1000;
+
+  explicit SSARewriter(MemPass* pass, uint32_t dominance_frontier_threshold =
+                                          kDefaultDominanceFrontierThreshold)
+      : pass_(pass),
+        dominance_frontier_threshold_(dominance_frontier_threshold) {}
 
   // Rewrites SSA-target variables in function |fp| into SSA.  This is the
   // entry point for the SSA rewrite algorithm.  SSA-target variables are
@@ -196,6 +208,11 @@ class SSARewriter {
   // Otherwise, returns 0.
   uint32_t GetValueAtBlock(uint32_t var_id, BasicBlock* bb);
 
+  // Returns in |var_id| and |val_id| the variable written by the store or
+  // variable definition |inst| and the value written.  |var_id| is 0 if
+  // |inst| is a variable without initializer.
+  void GetStoredValue(Instruction* inst, uint32_t* var_id, uint32_t* val_id);
+
   // Processes the store operation |inst| in basic block |bb|. This extracts
   // the variable ID being stored into, determines whether the variable is an
   // SSA-target variable, and, if it is, it stores its value in the
@@ -253,6 +270,14 @@ class SSARewriter {
   // candidates.
   void FinalizePhiCandidates();
 
+  // Rewrites the target variables of |fp| into SSA by placing Phi candidates
+  // at the iterated dominance frontiers of the blocks storing them, and then
+  // renaming loads in a walk of the dominator tree.  Phis are only placed for
+  // variables that are live on entry to some block, and Phi candidates that
+  // no load reaches are not generated.  Returns whether the function was
+  // modified or not, and whether or not the rewrite was successful.
+  Pass::Status RewriteWithDominanceFrontiers(Function* fp);
+
   // Prints the table of Phi candidates to std::cerr.
   void PrintPhiCandidates() const;
 
@@ -290,14 +315,24 @@ class SSARewriter {
 
   // Memory pass requesting the SSA rewriter.
   MemPass* pass_;
+
+  // Functions with at least this many blocks are rewritten with
+  // RewriteWithDominanceFrontiers.
+  uint32_t dominance_frontier_threshold_;
 };
 
 class SSARewritePass : public MemPass {
  public:
-  SSARewritePass() = default;
+  explicit SSARewritePass(uint32_t dominance_frontier_threshold =
+                              SSARewriter::kDefaultDominanceFrontierThreshold)
+      : dominance_frontier_threshold_(dominance_frontier_threshold) {}
 
   const char* name() const override { return "ssa-rewrite"; }
   Status Process() override;
+
+ private:
+  // See SSARewriter::kDefaultDominanceFrontierThreshold.
+  uint32_t dominance_frontier_threshold_;
 };
 
 }  // namespace opt
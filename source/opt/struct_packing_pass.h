@@ -43,6 +43,11 @@ class StructPackingPass final : public Pass {
 
   StructPackingPass(const char* structToPack, PackingRules rules);
   const char* name() const override { return "struct-packing"; }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " +
+           std::to_string(static_cast<uint32_t>(packingRules_)) + " " +
+           structToPack_;
+  }
   Status Process() override;
 
   IRContext::Analysis GetPreservedAnalyses() override {
@@ -33,6 +33,10 @@ class SwitchDescriptorSetPass : public Pass {
       : ds_from_(ds_from), ds_to_(ds_to) {}
 
   const char* name() const override { return "switch-descriptorset"; }
+  std::string CacheKey() const override {
+    return std::string(name()) + " " + std::to_string(ds_from_) + " " +
+           std::to_string(ds_to_);
+  }
 
   Status Process() override;
 
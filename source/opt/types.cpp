@@ -65,6 +65,16 @@ bool CompareTwoVectors(const U32VecVec a, const U32VecVec b) {
   return true;
 }
 
+// Combines |hash| with a hash of |decorations| that does not depend on their
+// order, because CompareTwoVectors does not either.
+size_t HashDecorations(size_t hash, const U32VecVec& decorations) {
+  size_t combined = 0;
+  for (const auto& decoration : decorations) {
+    combined += hash_combine(0, decoration);
+  }
+  return hash_combine(hash, combined);
+}
+
 }  // namespace
 
 std::string Type::GetDecorationStr() const {
@@ -206,9 +216,7 @@ size_t Type::ComputeHashValue(size_t hash, SeenTypes* seen) const {
   seen->push_back(this);
 
   hash = hash_combine(hash, uint32_t(kind_));
-  for (const auto& d : decorations_) {
-    hash = hash_combine(hash, d);
-  }
+  hash = HashDecorations(hash, decorations_);
 
   switch (kind_) {
 #define DeclareKindCase(type)                             \
@@ -589,7 +597,7 @@ size_t Struct::ComputeExtraStateHash(size_t hash, SeenTypes* seen) const {
     hash = t->ComputeHashValue(hash, seen);
   }
   for (const auto& pair : element_decorations_) {
-    hash = hash_combine(hash, pair.first, pair.second);
+    hash = HashDecorations(hash_combine(hash, pair.first), pair.second);
   }
   return hash;
 }
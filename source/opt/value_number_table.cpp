@@ -15,47 +15,96 @@
 #include "source/opt/value_number_table.h"
 
 #include <algorithm>
+#include <functional>
+#include <utility>
 
+#include "source/opcode.h"
 #include "source/opt/cfg.h"
 #include "source/opt/ir_context.h"
 
 namespace spvtools {
 namespace opt {
+namespace {
+// The optimistic numbering of a function converges in a number of rounds
+// bounded by the loop nesting depth.  If it has not converged after this many
+// rounds, the function is numbered pessimistically instead.
+constexpr uint32_t kMaxOptimisticRounds = 16;
+}  // namespace
 
 uint32_t ValueNumberTable::GetValueNumber(Instruction* inst) const {
   assert(inst->result_id() != 0 &&
          "inst must have a result id to get a value number.");
+  return GetValueNumber(inst->result_id());
+}
 
-  // Check if this instruction already has a value.
-  auto result_id_to_val = id_to_value_.find(inst->result_id());
-  if (result_id_to_val != id_to_value_.end()) {
-    return result_id_to_val->second;
+void ValueNumberTable::SetValueNumber(uint32_t id, uint32_t value) {
+  if (id >= id_to_value_.size()) {
+    id_to_value_.resize(id + 1, 0);
   }
-  return 0;
+  id_to_value_[id] = value;
 }
 
-uint32_t ValueNumberTable::GetValueNumber(uint32_t id) const {
-  return GetValueNumber(context()->get_def_use_mgr()->GetDef(id));
-}
+ValueNumberTable::Expression ValueNumberTable::MakeExpression(
+    const Instruction& inst, uint32_t block_id) const {
+  Expression expression{inst.opcode(), inst.type_id(), {}, 0};
+  std::vector<uint32_t>& operands = expression.operands;
 
-uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
-  // If it already has a value return that.
-  uint32_t value = GetValueNumber(inst);
-  if (value != 0) {
-    return value;
+  // Replace all of the operands by their value number.  The sign bit will be
+  // set to distinguish between an id and a value number.
+  for (uint32_t o = 0; o < inst.NumInOperands(); ++o) {
+    const Operand& op = inst.GetInOperand(o);
+    operands.push_back(static_cast<uint32_t>(op.words.size()));
+    if (spvIsIdType(op.type)) {
+      uint32_t id_value = op.words[0];
+      const uint32_t value = GetValueNumber(id_value);
+      if (value != 0) {
+        id_value = (1u << 31) | value;
+      }
+      operands.push_back(id_value);
+    } else {
+      operands.insert(operands.end(), op.words.begin(), op.words.end());
+    }
+  }
+
+  // Put the operands of commutative operations in a canonical order, so that
+  // a+b has the same value as b+a.  Both operands are single word ids, so each
+  // takes two entries.
+  if (spvOpcodeIsCommutativeBinaryOperator(inst.opcode()) &&
+      inst.NumInOperands() == 2 && operands.size() == 4 &&
+      operands[1] > operands[3]) {
+    std::swap(operands[1], operands[3]);
+  }
+
+  if (inst.opcode() == spv::Op::OpPhi) {
+    operands.push_back(block_id);
   }
 
-  auto assign_new_number = [this](Instruction* i) {
-    const auto new_value = TakeNextValueNumber();
-    id_to_value_[i->result_id()] = new_value;
-    return new_value;
+  size_t hash = std::hash<uint32_t>()(uint32_t(expression.opcode));
+  auto combine = [&hash](uint32_t word) {
+    hash ^= std::hash<uint32_t>()(word) + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
   };
+  combine(expression.type_id);
+  for (uint32_t word : operands) {
+    combine(word);
+  }
+  expression.hash = hash;
+  return expression;
+}
+
+uint32_t ValueNumberTable::ComputeValueNumber(Instruction* inst,
+                                              uint32_t block_id,
+                                              bool optimistic,
+                                              bool* assumed_congruence,
+                                              ExpressionTable* table) {
+  // A value that is not congruent to any other is numbered by its own id.
+  const uint32_t own_value = inst->result_id();
 
   // If the instruction has other side effects, then it must
   // have its own value number.
   if (!context()->IsCombinatorInstruction(inst) &&
       !inst->IsCommonDebugInstr()) {
-    return assign_new_number(inst);
+    return own_value;
   }
 
   // OpSampledImage and OpImage must remain in the same basic block in which
@@ -64,7 +113,7 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
     case spv::Op::OpSampledImage:
     case spv::Op::OpImage:
     case spv::Op::OpVariable:
-      return assign_new_number(inst);
+      return own_value;
     default:
       break;
   }
@@ -76,7 +125,7 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
       case spv::Op::OpTypeSampledImage:
       case spv::Op::OpTypeImage:
       case spv::Op::OpTypeSampler:
-        return assign_new_number(inst);
+        return own_value;
       default:
         break;
     }
@@ -89,7 +138,7 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
   // read only.  However, if this is ever relaxed because we analyze stores, we
   // will have to add a new case for volatile loads.
   if (inst->IsLoad() && !inst->IsReadOnlyLoad()) {
-    return assign_new_number(inst);
+    return own_value;
   }
 
   analysis::DecorationManager* dec_mgr = context()->get_decoration_mgr();
@@ -98,156 +147,152 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
   if (inst->opcode() == spv::Op::OpCopyObject &&
       dec_mgr->HaveTheSameDecorations(inst->result_id(),
                                       inst->GetSingleWordInOperand(0))) {
-    value = GetValueNumber(inst->GetSingleWordInOperand(0));
+    const uint32_t value = GetValueNumber(inst->GetSingleWordInOperand(0));
     if (value != 0) {
-      id_to_value_[inst->result_id()] = value;
       return value;
     }
   }
 
   // Phi nodes are a type of copy.  If all of the inputs have the same value
   // number, then we can assign the result of the phi the same value number.
-  if (inst->opcode() == spv::Op::OpPhi && inst->NumInOperands() > 0 &&
-      dec_mgr->HaveTheSameDecorations(inst->result_id(),
-                                      inst->GetSingleWordInOperand(0))) {
-    value = GetValueNumber(inst->GetSingleWordInOperand(0));
-    if (value != 0) {
-      for (uint32_t op = 2; op < inst->NumInOperands(); op += 2) {
-        if (value != GetValueNumber(inst->GetSingleWordInOperand(op))) {
-          value = 0;
-          break;
-        }
-      }
-      if (value != 0) {
-        id_to_value_[inst->result_id()] = value;
-        return value;
+  // When numbering optimistically, the inputs without a value number yet come
+  // from back edges, and are assumed to have that value too.
+  if (inst->opcode() == spv::Op::OpPhi && inst->NumInOperands() > 0) {
+    uint32_t value = 0;
+    uint32_t value_id = 0;
+    bool congruent = true;
+    for (uint32_t op = 0; op < inst->NumInOperands(); op += 2) {
+      const uint32_t op_id = inst->GetSingleWordInOperand(op);
+      const uint32_t op_value = GetValueNumber(op_id);
+      if (op_value == 0 && optimistic) {
+        *assumed_congruence = true;
+      } else if (op_value == 0 || (value != 0 && op_value != value)) {
+        congruent = false;
+        break;
+      } else if (value == 0) {
+        value = op_value;
+        value_id = op_id;
       }
     }
+    if (congruent && value != 0 &&
+        dec_mgr->HaveTheSameDecorations(inst->result_id(), value_id)) {
+      return value;
+    }
   }
 
-  // Replace all of the operands by their value number.  The sign bit will be
-  // set to distinguish between an id and a value number.
-  Instruction value_ins(context(), inst->opcode(), inst->type_id(),
-                        inst->result_id(), {});
-  for (uint32_t o = 0; o < inst->NumInOperands(); ++o) {
-    const Operand& op = inst->GetInOperand(o);
-    if (spvIsIdType(op.type)) {
-      uint32_t id_value = op.words[0];
-      auto use_id_to_val = id_to_value_.find(id_value);
-      if (use_id_to_val != id_to_value_.end()) {
-        id_value = (1 << 31) | use_id_to_val->second;
+  // Otherwise, we check if this value has been computed before.
+  Expression expression = MakeExpression(*inst, block_id);
+  for (ExpressionTable* t : {&global_expressions_, table}) {
+    auto entry = t->find(expression);
+    if (entry == t->end()) {
+      continue;
+    }
+    for (uint32_t id : entry->second) {
+      if (dec_mgr->HaveTheSameDecorations(inst->result_id(), id)) {
+        return id;
       }
-      value_ins.AddOperand(Operand(op.type, {id_value}));
-    } else {
-      value_ins.AddOperand(Operand(op.type, op.words));
     }
   }
 
-  // TODO: Implement a normal form for opcodes that commute like integer
-  // addition.  This will let us know that a+b is the same value as b+a.
-
-  // Otherwise, we check if this value has been computed before.
-  auto value_iterator = instruction_to_value_.find(value_ins);
-  if (value_iterator != instruction_to_value_.end()) {
-    value = id_to_value_[value_iterator->first.result_id()];
-    id_to_value_[inst->result_id()] = value;
-    return value;
-  }
-
-  // If not, assign it a new value number.
-  value = TakeNextValueNumber();
-  id_to_value_[inst->result_id()] = value;
-  instruction_to_value_[value_ins] = value;
-  return value;
+  // If not, it is a new value.
+  (*table)[std::move(expression)].push_back(own_value);
+  return own_value;
 }
 
-void ValueNumberTable::BuildDominatorTreeValueNumberTable() {
-  // First value number the headers.
-  for (auto& inst : context()->annotations()) {
-    if (inst.result_id() != 0) {
-      AssignValueNumber(&inst);
+bool ValueNumberTable::NumberFunctionOnce(Function* func, bool optimistic,
+                                          bool* assumed_congruence) {
+  function_expressions_.clear();
+  func->ForEachParam([this](Instruction* param) {
+    SetValueNumber(param->result_id(), param->result_id());
+  });
+
+  bool changed = false;
+  // For best results we want to traverse the code in reverse post order.
+  // This happens naturally because of the forward referencing rules.
+  for (BasicBlock& block : *func) {
+    for (Instruction& inst : block) {
+      if (inst.result_id() == 0) {
+        continue;
+      }
+      const uint32_t value =
+          ComputeValueNumber(&inst, block.id(), optimistic, assumed_congruence,
+                             &function_expressions_);
+      if (value != GetValueNumber(inst.result_id())) {
+        SetValueNumber(inst.result_id(), value);
+        changed = true;
+      }
     }
   }
+  return changed;
+}
 
-  for (auto& inst : context()->capabilities()) {
-    if (inst.result_id() != 0) {
-      AssignValueNumber(&inst);
-    }
+void ValueNumberTable::NumberFunction(Function* func) {
+  bool assumed_congruence = false;
+  NumberFunctionOnce(func, true, &assumed_congruence);
+  if (!assumed_congruence) {
+    // Every operand had a value number when it was used, so there is nothing
+    // to confirm.
+    return;
   }
 
-  for (auto& inst : context()->types_values()) {
-    if (inst.result_id() != 0) {
-      AssignValueNumber(&inst);
+  // Number the function again with the value numbers of the previous round,
+  // until they are stable.
+  for (uint32_t round = 0; round < kMaxOptimisticRounds; ++round) {
+    if (!NumberFunctionOnce(func, true, &assumed_congruence)) {
+      return;
     }
   }
 
-  for (auto& inst : context()->module()->ext_inst_imports()) {
-    if (inst.result_id() != 0) {
-      AssignValueNumber(&inst);
+  // The optimistic assumptions could not be confirmed.  Forget them and
+  // give the phis with operands from back edges their own value number.
+  for (BasicBlock& block : *func) {
+    for (Instruction& inst : block) {
+      if (inst.result_id() != 0) {
+        SetValueNumber(inst.result_id(), 0);
+      }
     }
   }
+  NumberFunctionOnce(func, false, &assumed_congruence);
+}
 
-  for (auto& inst : context()->module()->ext_inst_debuginfo()) {
-    if (inst.result_id() != 0) {
-      AssignValueNumber(&inst);
-    }
-  }
+void ValueNumberTable::BuildDominatorTreeValueNumberTable() {
+  id_to_value_.assign(context()->module()->IdBound(), 0);
 
-  for (Function& func : *context()->module()) {
-    // For best results we want to traverse the code in reverse post order.
-    // This happens naturally because of the forward referencing rules.
-    for (BasicBlock& block : func) {
-      for (Instruction& inst : block) {
-        if (inst.result_id() != 0) {
-          AssignValueNumber(&inst);
-        }
-      }
+  // First value number the headers.
+  auto number_global = [this](Instruction* inst) {
+    if (inst->result_id() != 0 && GetValueNumber(inst->result_id()) == 0) {
+      bool assumed_congruence = false;
+      SetValueNumber(inst->result_id(),
+                     ComputeValueNumber(inst, 0, false, &assumed_congruence,
+                                        &global_expressions_));
     }
-  }
-}
+  };
 
-bool ComputeSameValue::operator()(const Instruction& lhs,
-                                  const Instruction& rhs) const {
-  if (lhs.result_id() == 0 || rhs.result_id() == 0) {
-    return false;
+  for (auto& inst : context()->annotations()) {
+    number_global(&inst);
   }
 
-  if (lhs.opcode() != rhs.opcode()) {
-    return false;
+  for (auto& inst : context()->capabilities()) {
+    number_global(&inst);
   }
 
-  if (lhs.type_id() != rhs.type_id()) {
-    return false;
+  for (auto& inst : context()->types_values()) {
+    number_global(&inst);
   }
 
-  if (lhs.NumInOperands() != rhs.NumInOperands()) {
-    return false;
+  for (auto& inst : context()->module()->ext_inst_imports()) {
+    number_global(&inst);
   }
 
-  for (uint32_t i = 0; i < lhs.NumInOperands(); ++i) {
-    if (lhs.GetInOperand(i) != rhs.GetInOperand(i)) {
-      return false;
-    }
+  for (auto& inst : context()->module()->ext_inst_debuginfo()) {
+    number_global(&inst);
   }
 
-  return lhs.context()->get_decoration_mgr()->HaveTheSameDecorations(
-      lhs.result_id(), rhs.result_id());
-}
-
-std::size_t ValueTableHash::operator()(const Instruction& inst) const {
-  // We hash the opcode and in-operands, not the result, because we want
-  // instructions that are the same except for the result to hash to the
-  // same value.
-  std::u32string h;
-  h.push_back(uint32_t(inst.opcode()));
-  h.push_back(inst.type_id());
-  for (uint32_t i = 0; i < inst.NumInOperands(); ++i) {
-    const auto& opnd = inst.GetInOperand(i);
-    for (uint32_t word : opnd.words) {
-      h.push_back(word);
-    }
+  for (Function& func : *context()->module()) {
+    NumberFunction(&func);
   }
-  return std::hash<std::u32string>()(h);
+  function_expressions_.clear();
 }
+
 }  // namespace opt
 }  // namespace spvtools
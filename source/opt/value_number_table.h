@@ -17,27 +17,16 @@
 
 #include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 #include "source/opt/instruction.h"
 
 namespace spvtools {
 namespace opt {
 
+class Function;
 class IRContext;
 
-// Returns true if the two instructions compute the same value.  Used by the
-// value number table to compare two instructions.
-class ComputeSameValue {
- public:
-  bool operator()(const Instruction& lhs, const Instruction& rhs) const;
-};
-
-// The hash function used in the value number table.
-class ValueTableHash {
- public:
-  std::size_t operator()(const Instruction& inst) const;
-};
-
 // This class implements the value number analysis.  It is using a hash-based
 // approach to value numbering.  It is essentially doing dominator-tree value
 // numbering described in
@@ -49,9 +38,24 @@ class ValueTableHash {
 // The main difference is that because we do not perform redundancy elimination
 // as we build the value number table, we do not have to deal with cleaning up
 // the scope.
+//
+// The functions are numbered with the optimistic RPO algorithm from the same
+// paper: the operands of a phi that come from a back edge are first assumed to
+// be congruent to the other operands, and the function is numbered again until
+// the value numbers no longer change.  This finds loop phis that are congruent,
+// such as two induction variables with the same start and step.
+//
+// Expressions are hash-consed: the key of a value is its opcode, its type and
+// the value numbers of its operands, with the hash computed once.  The
+// operands of commutative operations are put in a canonical order.
+//
+// The value number of a value is the result id of the first instruction found
+// to compute it.  Replacing an instruction by another one with the same value
+// number does not change the value number of its users, so a pass can keep
+// using the table while it eliminates redundancies.
 class ValueNumberTable {
  public:
-  ValueNumberTable(IRContext* ctx) : context_(ctx), next_value_number_(1) {
+  ValueNumberTable(IRContext* ctx) : context_(ctx) {
     BuildDominatorTreeValueNumberTable();
   }
 
@@ -62,27 +66,80 @@ class ValueNumberTable {
 
   // Returns the value number of the value contain in |id|.  Returns 0 if it
   // has not been assigned a value number.
-  uint32_t GetValueNumber(uint32_t id) const;
+  uint32_t GetValueNumber(uint32_t id) const {
+    return id < id_to_value_.size() ? id_to_value_[id] : 0;
+  }
 
   IRContext* context() const { return context_; }
 
  private:
+  // The key of a value: the opcode and type of the instruction computing it,
+  // and its in-operands.  Each operand is encoded as its number of words
+  // followed by its words, where an id with a value number is replaced by the
+  // value number with the sign bit set.
+  struct Expression {
+    spv::Op opcode;
+    uint32_t type_id;
+    std::vector<uint32_t> operands;
+    size_t hash;
+
+    bool operator==(const Expression& other) const {
+      return hash == other.hash && opcode == other.opcode &&
+             type_id == other.type_id && operands == other.operands;
+    }
+  };
+
+  struct ExpressionHash {
+    size_t operator()(const Expression& expression) const {
+      return expression.hash;
+    }
+  };
+
+  // Maps an expression to the result ids of the instructions that computed it
+  // first.  There is one id for each set of decorations.
+  using ExpressionTable =
+      std::unordered_map<Expression, std::vector<uint32_t>, ExpressionHash>;
+
   // Assigns a value number to every result id in the module.
   void BuildDominatorTreeValueNumberTable();
 
-  // Returns the new value number.
-  uint32_t TakeNextValueNumber() { return next_value_number_++; }
-
-  // Assigns a new value number to the result of |inst| if it does not already
-  // have one.  Return the value number for |inst|.  |inst| must have a result
-  // id.
-  uint32_t AssignValueNumber(Instruction* inst);
-
-  std::unordered_map<Instruction, uint32_t, ValueTableHash, ComputeSameValue>
-      instruction_to_value_;
-  std::unordered_map<uint32_t, uint32_t> id_to_value_;
+  // Assigns value numbers to the instructions in |func|, iterating until they
+  // no longer change.
+  void NumberFunction(Function* func);
+
+  // Assigns value numbers to the instructions in |func| once.  When
+  // |optimistic| is true, phi operands that do not have a value number yet
+  // are assumed to be congruent to the other operands.  Otherwise, a phi
+  // with such an operand gets its own value number.  Returns true if any
+  // value number changed.  Sets |assumed_congruence| if a phi operand was
+  // assumed to be congruent.
+  bool NumberFunctionOnce(Function* func, bool optimistic,
+                          bool* assumed_congruence);
+
+  // Returns the value number for the result of |inst|, looking up and
+  // recording its expression in |table|.  |inst| must have a result id.
+  // |block_id| is the label of the block containing |inst|, or 0 if it is not
+  // in a function.  See |NumberFunctionOnce| for |optimistic| and
+  // |assumed_congruence|.
+  uint32_t ComputeValueNumber(Instruction* inst, uint32_t block_id,
+                              bool optimistic, bool* assumed_congruence,
+                              ExpressionTable* table);
+
+  // Returns the expression computed by |inst|, which is in the block with
+  // label |block_id|.  The block is part of the key of a phi, since phis in
+  // different blocks select between different edges.
+  Expression MakeExpression(const Instruction& inst, uint32_t block_id) const;
+
+  // Records |value| as the value number of |id|.
+  void SetValueNumber(uint32_t id, uint32_t value);
+
+  // The expressions of the instructions outside of functions.
+  ExpressionTable global_expressions_;
+  // The expressions of the instructions in the function being numbered.
+  ExpressionTable function_expressions_;
+  // The value number of each id, indexed by id.  0 means no value number.
+  std::vector<uint32_t> id_to_value_;
   IRContext* context_;
-  uint32_t next_value_number_;
 };
 
 }  // namespace opt
@@ -20,6 +20,32 @@
 #include "source/util/hex_float.h"
 
 namespace spvtools {
+namespace {
+
+// Writes |value| in decimal to |out|, preceded by a minus sign if |negative|.
+// This avoids the locale-aware number formatting of the stream, which is
+// much slower and prints the same digits in the classic locale.
+void EmitDecimal(std::ostream* out, uint64_t value, bool negative) {
+  char digits[21];
+  char* const end = digits + sizeof(digits);
+  char* begin = end;
+  do {
+    *--begin = char('0' + value % 10);
+    value /= 10;
+  } while (value);
+  if (negative) *--begin = '-';
+  out->write(begin, end - begin);
+}
+
+// Writes the signed |value| in decimal to |out|.
+void EmitSignedDecimal(std::ostream* out, int64_t value) {
+  // Negate in unsigned arithmetic, which is well defined for the minimum.
+  const uint64_t magnitude =
+      value < 0 ? 0 - static_cast<uint64_t>(value) : uint64_t(value);
+  EmitDecimal(out, magnitude, value < 0);
+}
+
+}  // namespace
 
 void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
                         const spv_parsed_operand_t& operand) {
@@ -37,10 +63,10 @@ void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
   if (operand.num_words == 1) {
     switch (operand.number_kind) {
       case SPV_NUMBER_SIGNED_INT:
-        *out << int32_t(word);
+        EmitSignedDecimal(out, int32_t(word));
         break;
       case SPV_NUMBER_UNSIGNED_INT:
-        *out << word;
+        EmitDecimal(out, word, false);
         break;
       case SPV_NUMBER_FLOATING:
         if (operand.number_bit_width == 16) {
@@ -60,10 +86,10 @@ void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
         uint64_t(word) | (uint64_t(inst.words[operand.offset + 1]) << 32);
     switch (operand.number_kind) {
       case SPV_NUMBER_SIGNED_INT:
-        *out << int64_t(bits);
+        EmitSignedDecimal(out, int64_t(bits));
         break;
       case SPV_NUMBER_UNSIGNED_INT:
-        *out << bits;
+        EmitDecimal(out, bits, false);
         break;
       case SPV_NUMBER_FLOATING:
         // Assume only 64-bit floats.
@@ -200,10 +200,15 @@ bool spvParseTargetEnv(const char* s, spv_target_env* env) {
 
 bool spvReadEnvironmentFromText(const std::vector<char>& text,
                                 spv_target_env* env) {
+  return spvReadEnvironmentFromText(text.data(), text.size(), env);
+}
+
+bool spvReadEnvironmentFromText(const char* text, size_t length,
+                                spv_target_env* env) {
   // Version is expected to match "; Version: 1.X"
   // Version string must occur in header, that is, initial lines of comments
   // Once a non-comment line occurs, the header has ended
-  for (std::size_t i = 0; i < text.size(); ++i) {
+  for (std::size_t i = 0; i < length; ++i) {
     char c = text[i];
 
     if (c == ';') {
@@ -212,7 +217,7 @@ bool spvReadEnvironmentFromText(const std::vector<char>& text,
       constexpr const auto kPrefixLength = 13;
       // 'minor_digit_pos' is the expected position of the version digit.
       const auto minor_digit_pos = i + kPrefixLength;
-      if (minor_digit_pos >= text.size()) return false;
+      if (minor_digit_pos >= length) return false;
 
       // Match the prefix.
       auto j = 1;
@@ -225,7 +230,7 @@ bool spvReadEnvironmentFromText(const std::vector<char>& text,
         static_assert(((spv::Version >> 8) & 0xff) < 10);
         char minor = text[minor_digit_pos];
         char next_char =
-            minor_digit_pos + 1 < text.size() ? text[minor_digit_pos + 1] : 0;
+            minor_digit_pos + 1 < length ? text[minor_digit_pos + 1] : 0;
         if (std::isdigit(minor) && !std::isdigit(next_char)) {
           const auto index = minor - '0';
           assert(index >= 0);
@@ -240,7 +245,7 @@ bool spvReadEnvironmentFromText(const std::vector<char>& text,
       // assumption has failed.)
       // Skip until the next line.
       i += j;
-      for (; i < text.size(); ++i) {
+      for (; i < length; ++i) {
         if (text[i] == '\n') break;
       }
     } else if (!std::isspace(c)) {
@@ -52,5 +52,7 @@ std::string spvTargetEnvList(const int pad, const int wrap);
 // true if valid name found, false otherwise.
 bool spvReadEnvironmentFromText(const std::vector<char>& text,
                                 spv_target_env* env);
+bool spvReadEnvironmentFromText(const char* text, size_t length,
+                                spv_target_env* env);
 
 #endif  // SOURCE_SPIRV_TARGET_ENV_H_
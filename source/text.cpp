@@ -20,10 +20,12 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -223,7 +225,7 @@ spv_result_t spvTextEncodeOperand(const spvtools::AssemblyGrammar& grammar,
       }
       const uint32_t id = context->spvNamedIdAssignOrGet(textValue);
       if (type == SPV_OPERAND_TYPE_TYPE_ID) pInst->resultTypeId = id;
-      spvInstructionAddWord(pInst, id);
+      context->binaryEncodeId(id, pInst);
 
       // Set the extended instruction type.
       // The import set id is the 3rd operand of OpExtInst.
@@ -474,6 +476,20 @@ spv_result_t spvTextEncodeOperand(const spvtools::AssemblyGrammar& grammar,
 
 namespace {
 
+// Buffers reused across the instructions of a module. Words that are passed
+// on to the operand encoders are copied here to be null-terminated, so that
+// encoding an instruction does not allocate once the buffers have grown.
+struct WordBuffers {
+  std::string opcode_name;
+  std::string operand;
+
+  // Copies |word| into the operand buffer and returns it as a C string.
+  const char* Operand(std::string_view word) {
+    operand.assign(word);
+    return operand.c_str();
+  }
+};
+
 /// Encodes an instruction started by !<integer> at the given position in text.
 ///
 /// Puts the encoded words into *pInst.  If successful, moves position past the
@@ -481,13 +497,14 @@ namespace {
 /// leaves position pointing to the error in text.
 spv_result_t encodeInstructionStartingWithImmediate(
     const spvtools::AssemblyGrammar& grammar,
-    spvtools::AssemblyContext* context, spv_instruction_t* pInst) {
-  std::string firstWord;
+    spvtools::AssemblyContext* context, WordBuffers* buffers,
+    spv_instruction_t* pInst) {
+  std::string_view firstWord;
   spv_position_t nextPosition = {};
   auto error = context->getWord(&firstWord, &nextPosition);
   if (error) return context->diagnostic(error) << "Internal Error";
 
-  if ((error = encodeImmediate(context, firstWord.c_str(), pInst))) {
+  if ((error = encodeImmediate(context, buffers->Operand(firstWord), pInst))) {
     return error;
   }
   while (context->advance() != SPV_END_OF_STREAM) {
@@ -496,7 +513,7 @@ spv_result_t encodeInstructionStartingWithImmediate(
 
     // Otherwise, there must be an operand that's either a literal, an ID, or
     // an immediate.
-    std::string operandValue;
+    std::string_view operandValue;
     if ((error = context->getWord(&operandValue, &nextPosition)))
       return context->diagnostic(error) << "Internal Error";
 
@@ -506,9 +523,10 @@ spv_result_t encodeInstructionStartingWithImmediate(
     // Needed to pass to spvTextEncodeOpcode(), but it shouldn't ever be
     // expanded.
     spv_operand_pattern_t dummyExpectedOperands;
-    error = spvTextEncodeOperand(
-        grammar, context, SPV_OPERAND_TYPE_OPTIONAL_CIV, operandValue.c_str(),
-        pInst, &dummyExpectedOperands);
+    error = spvTextEncodeOperand(grammar, context,
+                                 SPV_OPERAND_TYPE_OPTIONAL_CIV,
+                                 buffers->Operand(operandValue), pInst,
+                                 &dummyExpectedOperands);
     if (error) return error;
     context->setPosition(nextPosition);
   }
@@ -520,12 +538,14 @@ spv_result_t encodeInstructionStartingWithImmediate(
 ///
 /// @param[in] grammar the grammar to use for compilation
 /// @param[in, out] context the dynamic compilation info
+/// @param[in, out] buffers the reused word buffers
 /// @param[out] pInst returned binary Opcode
 ///
 /// @return result code
 spv_result_t encodeInstructionStartingWithOpUnknown(
     const spvtools::AssemblyGrammar& grammar,
-    spvtools::AssemblyContext* context, spv_instruction_t* pInst) {
+    spvtools::AssemblyContext* context, WordBuffers* buffers,
+    spv_instruction_t* pInst) {
   spv_position_t nextPosition = {};
 
   uint16_t opcode;
@@ -544,11 +564,12 @@ spv_result_t encodeInstructionStartingWithOpUnknown(
   if (context->advance())
     return context->diagnostic()
            << "Expected opcode enumerant, found end of stream.";
-  std::string opcodeString;
+  std::string_view opcodeString;
   spv_result_t error = context->getWord(&opcodeString, &nextPosition);
   if (error) return context->diagnostic(error) << "Internal Error";
 
-  if (!spvtools::utils::ParseNumber(opcodeString.c_str(), &opcode)) {
+  if (!spvtools::utils::ParseNumber(buffers->Operand(opcodeString),
+                                    &opcode)) {
     return context->diagnostic()
            << "Invalid opcode enumerant: \"" << opcodeString << "\".";
   }
@@ -569,11 +590,12 @@ spv_result_t encodeInstructionStartingWithOpUnknown(
   if (context->advance())
     return context->diagnostic()
            << "Expected number of words, found end of stream.";
-  std::string wordCountString;
+  std::string_view wordCountString;
   error = context->getWord(&wordCountString, &nextPosition);
   if (error) return context->diagnostic(error) << "Internal Error";
 
-  if (!spvtools::utils::ParseNumber(wordCountString.c_str(), &wordCount)) {
+  if (!spvtools::utils::ParseNumber(buffers->Operand(wordCountString),
+                                    &wordCount)) {
     return context->diagnostic()
            << "Invalid number of words: \"" << wordCountString << "\".";
   }
@@ -606,14 +628,14 @@ spv_result_t encodeInstructionStartingWithOpUnknown(
                                    << " more operands, found end of stream.";
     }
     if (context->isStartOfNewInst()) {
-      std::string invalid;
+      std::string_view invalid;
       context->getWord(&invalid, &nextPosition);
       return context->diagnostic()
              << "Unexpected start of new instruction: \"" << invalid
              << "\". Expected " << wordCount + 1 << " more operands";
     }
 
-    std::string operandValue;
+    std::string_view operandValue;
     if ((error = context->getWord(&operandValue, &nextPosition)))
       return context->diagnostic(error) << "Internal Error";
 
@@ -623,9 +645,10 @@ spv_result_t encodeInstructionStartingWithOpUnknown(
     // Needed to pass to spvTextEncodeOpcode(), but it shouldn't ever be
     // expanded.
     spv_operand_pattern_t dummyExpectedOperands;
-    error = spvTextEncodeOperand(
-        grammar, context, SPV_OPERAND_TYPE_OPTIONAL_CIV, operandValue.c_str(),
-        pInst, &dummyExpectedOperands);
+    error = spvTextEncodeOperand(grammar, context,
+                                 SPV_OPERAND_TYPE_OPTIONAL_CIV,
+                                 buffers->Operand(operandValue), pInst,
+                                 &dummyExpectedOperands);
     if (error) return error;
     context->setPosition(nextPosition);
   }
@@ -637,32 +660,33 @@ spv_result_t encodeInstructionStartingWithOpUnknown(
 ///
 /// @param[in] grammar the grammar to use for compilation
 /// @param[in, out] context the dynamic compilation info
-/// @param[in] text stream to translate
+/// @param[in, out] buffers the reused word buffers
 /// @param[out] pInst returned binary Opcode
-/// @param[in,out] pPosition in the text stream
 ///
 /// @return result code
 spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
                                  spvtools::AssemblyContext* context,
+                                 WordBuffers* buffers,
                                  spv_instruction_t* pInst) {
   // Check for !<integer> first.
   if ('!' == context->peek()) {
-    return encodeInstructionStartingWithImmediate(grammar, context, pInst);
+    return encodeInstructionStartingWithImmediate(grammar, context, buffers,
+                                                  pInst);
   }
 
-  std::string firstWord;
+  std::string_view firstWord;
   spv_position_t nextPosition = {};
   spv_result_t error = context->getWord(&firstWord, &nextPosition);
   if (error) return context->diagnostic() << "Internal Error";
 
-  std::string opcodeName;
-  std::string result_id;
+  std::string_view opcodeName;
+  std::string_view result_id;
   spv_position_t result_id_position = {};
   if (context->startsWithOp()) {
     opcodeName = firstWord;
   } else {
     result_id = firstWord;
-    if ('%' != result_id.front()) {
+    if (result_id.empty() || '%' != result_id.front()) {
       return context->diagnostic()
              << "Expected <opcode> or <result-id> at the beginning "
                 "of an instruction, found '"
@@ -674,7 +698,7 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
     context->setPosition(nextPosition);
     if (context->advance())
       return context->diagnostic() << "Expected '=', found end of stream.";
-    std::string equal_sign;
+    std::string_view equal_sign;
     error = context->getWord(&equal_sign, &nextPosition);
     if ("=" != equal_sign)
       return context->diagnostic() << "'=' expected after result id but found '"
@@ -699,11 +723,13 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
                 "id operand instead.";
     }
     context->setPosition(nextPosition);
-    return encodeInstructionStartingWithOpUnknown(grammar, context, pInst);
+    return encodeInstructionStartingWithOpUnknown(grammar, context, buffers,
+                                                  pInst);
   }
 
   // NOTE: The table contains Opcode names without the "Op" prefix.
-  const char* pInstName = opcodeName.data() + 2;
+  buffers->opcode_name.assign(opcodeName.substr(2));
+  const char* pInstName = buffers->opcode_name.c_str();
 
   spv_opcode_desc opcodeEntry;
   error = grammar.lookupOpcode(pInstName, &opcodeEntry);
@@ -752,7 +778,7 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
       // we inject its words into the instruction.
       spv_position_t temp_pos = context->position();
       error = spvTextEncodeOperand(grammar, context, SPV_OPERAND_TYPE_RESULT_ID,
-                                   result_id.c_str(), pInst, nullptr);
+                                   buffers->Operand(result_id), pInst, nullptr);
       result_id_position = context->position();
       // Because we are injecting we have to reset the position afterwards.
       context->setPosition(temp_pos);
@@ -784,12 +810,13 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
         }
       }
 
-      std::string operandValue;
+      std::string_view operandValue;
       error = context->getWord(&operandValue, &nextPosition);
       if (error) return context->diagnostic(error) << "Internal Error";
 
-      error = spvTextEncodeOperand(grammar, context, type, operandValue.c_str(),
-                                   pInst, &expectedOperands);
+      error = spvTextEncodeOperand(grammar, context, type,
+                                   buffers->Operand(operandValue), pInst,
+                                   &expectedOperands);
 
       if (error == SPV_FAILED_MATCH && spvOperandIsOptional(type))
         return SPV_SUCCESS;
@@ -860,8 +887,12 @@ spv_result_t GetNumericIds(const spvtools::AssemblyGrammar& grammar,
   // Skip past whitespace and comments.
   context.advance();
 
+  WordBuffers buffers;
+  spv_instruction_t inst;
   while (context.hasText()) {
-    spv_instruction_t inst;
+    inst.words.clear();
+    inst.extInstType = SPV_EXT_INST_TYPE_NONE;
+    inst.resultTypeId = 0;
 
     // Operand parsing sometimes involves knowing the opcode of the instruction
     // being parsed. A malformed input might feature such an operand *before*
@@ -869,7 +900,7 @@ spv_result_t GetNumericIds(const spvtools::AssemblyGrammar& grammar,
     // the instruction's opcode is initialized to a default value.
     inst.opcode = spv::Op::Max;
 
-    if (spvTextEncodeOpcode(grammar, &context, &inst)) {
+    if (spvTextEncodeOpcode(grammar, &context, &buffers, &inst)) {
       return SPV_ERROR_INVALID_TEXT;
     }
 
@@ -880,6 +911,72 @@ spv_result_t GetNumericIds(const spvtools::AssemblyGrammar& grammar,
   return SPV_SUCCESS;
 }
 
+// The words of a module being assembled. The storage grows geometrically and
+// is handed over to the resulting spv_binary, which frees it with delete[].
+class ModuleWords {
+ public:
+  explicit ModuleWords(size_t capacity)
+      : data_(new uint32_t[capacity]), capacity_(capacity) {}
+
+  size_t size() const { return size_; }
+  uint32_t* data() { return data_.get(); }
+
+  // Appends the |count| words at |words|.
+  void Append(const uint32_t* words, size_t count) {
+    if (size_ + count > capacity_) {
+      size_t capacity = std::max(capacity_ * 2, size_ + count);
+      std::unique_ptr<uint32_t[]> data(new uint32_t[capacity]);
+      memcpy(data.get(), data_.get(), sizeof(uint32_t) * size_);
+      data_ = std::move(data);
+      capacity_ = capacity;
+    }
+    memcpy(data_.get() + size_, words, sizeof(uint32_t) * count);
+    size_ += count;
+  }
+
+  // Removes all the words, keeping the storage.
+  void Clear() { size_ = 0; }
+
+  // Releases the storage to the caller.
+  uint32_t* Release() { return data_.release(); }
+
+ private:
+  std::unique_ptr<uint32_t[]> data_;
+  size_t size_ = 0;
+  size_t capacity_;
+};
+
+// Encodes the instructions of the module in |text| into |words|, after the
+// header words, in a single pass over the text.  Only the instructions which
+// start before the text index |end| are encoded.
+spv_result_t EncodeModule(
+    const spvtools::AssemblyGrammar& grammar,
+    spvtools::AssemblyContext* context, ModuleWords* words,
+    size_t end = std::numeric_limits<size_t>::max()) {
+  // Skip past whitespace and comments.
+  context->advance();
+
+  // The instruction is encoded into |inst| and then appended to the module.
+  // Reusing it keeps the capacity of its word vector.
+  WordBuffers buffers;
+  spv_instruction_t inst;
+  while (context->hasText() && context->position().index < end) {
+    inst.opcode = spv::Op::OpNop;
+    inst.extInstType = SPV_EXT_INST_TYPE_NONE;
+    inst.resultTypeId = 0;
+    inst.words.clear();
+    context->setInstructionOffset(words->size());
+
+    if (auto error = spvTextEncodeOpcode(grammar, context, &buffers, &inst)) {
+      return error;
+    }
+    words->Append(inst.words.data(), inst.words.size());
+
+    if (context->advance()) break;
+  }
+  return SPV_SUCCESS;
+}
+
 // Translates a given assembly language module into binary form.
 // If a diagnostic is generated, it is not yet marked as being
 // for a text-based input.
@@ -888,69 +985,304 @@ spv_result_t spvTextToBinaryInternal(const spvtools::AssemblyGrammar& grammar,
                                      const spv_text text,
                                      const uint32_t options,
                                      spv_binary* pBinary) {
-  // The ids in this set will have the same values both in source and binary.
-  // All other ids will be generated by filling in the gaps.
-  std::set<uint32_t> ids_to_preserve;
+  const bool preserve_numeric_ids =
+      options & SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS;
 
-  if (options & SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS) {
-    // Collect all numeric ids from the source into ids_to_preserve.
-    const spv_result_t result =
-        GetNumericIds(grammar, consumer, text, &ids_to_preserve);
-    if (result != SPV_SUCCESS) return result;
-  }
+  auto context = std::make_unique<spvtools::AssemblyContext>(text, consumer);
 
-  spvtools::AssemblyContext context(text, consumer, std::move(ids_to_preserve));
-
-  if (!text->str) return context.diagnostic() << "Missing assembly text.";
+  if (!text->str) return context->diagnostic() << "Missing assembly text.";
 
   if (!grammar.isValid()) {
     return SPV_ERROR_INVALID_TABLE;
   }
   if (!pBinary) return SPV_ERROR_INVALID_POINTER;
 
-  std::vector<spv_instruction_t> instructions;
-
-  // Skip past whitespace and comments.
-  context.advance();
-
-  while (context.hasText()) {
-    instructions.push_back({});
-    spv_instruction_t& inst = instructions.back();
+  // Assembly takes a handful of characters per word. The buffer grows if
+  // the estimate falls short.
+  const size_t estimated_words = SPV_INDEX_INSTRUCTION + text->length / 8;
+  auto words = std::make_unique<ModuleWords>(estimated_words);
+  const uint32_t header[SPV_INDEX_INSTRUCTION] = {};
+  words->Append(header, SPV_INDEX_INSTRUCTION);
+
+  // Numeric ids keep their value, and named ids fill the gaps between them
+  // once the whole module has been seen.
+  if (preserve_numeric_ids) context->deferNamedIds();
+
+  const spv_result_t result =
+      EncodeModule(grammar, context.get(), words.get());
+
+  if (context->hasDeferredIdCollision()) {
+    // A numeric id may have taken the value of a provisional one. Collect
+    // the numeric ids with a dry run and assemble the module again.
+    std::set<uint32_t> ids_to_preserve;
+    const spv_result_t dry_run_result =
+        GetNumericIds(grammar, consumer, text, &ids_to_preserve);
+    if (dry_run_result != SPV_SUCCESS) return dry_run_result;
 
-    if (auto error = spvTextEncodeOpcode(grammar, &context, &inst)) {
+    context = std::make_unique<spvtools::AssemblyContext>(
+        text, consumer, std::move(ids_to_preserve));
+    words = std::make_unique<ModuleWords>(estimated_words);
+    words->Append(header, SPV_INDEX_INSTRUCTION);
+    if (auto error = EncodeModule(grammar, context.get(), words.get())) {
       return error;
     }
+  } else if (result != SPV_SUCCESS) {
+    return result;
+  } else if (preserve_numeric_ids) {
+    context->resolveDeferredIds(words->data());
+  }
 
-    if (context.advance()) break;
+  if (auto error =
+          SetHeader(grammar.target_env(), context->getBound(), words->data()))
+    return error;
+
+  spv_binary binary = new spv_binary_t();
+  if (!binary) return SPV_ERROR_OUT_OF_MEMORY;
+  binary->wordCount = words->size();
+  binary->code = words->Release();
+
+  *pBinary = binary;
+
+  return SPV_SUCCESS;
+}
+
+// The assembly text read from a spv_text_reader_fn, a window at a time.
+//
+// The assembler keeps views into the text while it encodes an instruction, so
+// the window is only cut at the start of an instruction.  To find those
+// without parsing, the window is cut at lines which can only start an
+// instruction: outside of strings and comments, and beginning with an opcode
+// or with a result id assignment.  The window extends to the end of such a
+// line, so that the assembler can see that an instruction starts there.
+class TextStream {
+ public:
+  TextStream(spv_text_reader_fn reader, void* user_data)
+      : reader_(reader), user_data_(user_data) {}
+
+  // Returns the text of the window.
+  spv_text text() { return &text_; }
+
+  // Returns true once the window holds the rest of the input.
+  bool complete() const { return end_of_input_; }
+
+  // Reads text until the window has an instruction start after the index
+  // |index|, or holds the rest of the input.  Returns the index of the last
+  // instruction start in the window, or the length of the window if it is
+  // complete.
+  size_t ReadPast(size_t index);
+
+  // Removes the first |count| characters from the window.
+  void Drop(size_t count);
+
+ private:
+  static constexpr size_t kReadSize = 64 * 1024;
+  static constexpr size_t kNoStart = std::numeric_limits<size_t>::max();
+
+  // Looks for instruction starts in the complete lines read since the last
+  // call.
+  void Scan();
+
+  // Returns the index at which an instruction starts on the line beginning at
+  // |index|, or kNoStart.  The line ends before |end| or at |end|.
+  size_t FindInstructionStart(size_t index, size_t end) const;
+
+  const spv_text_reader_fn reader_;
+  void* const user_data_;
+  std::vector<char> buffer_;
+  bool end_of_input_ = false;
+  spv_text_t text_ = {nullptr, 0};
+
+  // The characters of |buffer_| already scanned, always whole lines unless
+  // the input ended.
+  size_t scanned_ = 0;
+  // The lexical state at the end of the scanned characters.
+  bool at_line_start_ = true;
+  bool quoting_ = false;
+  bool escaping_ = false;
+  bool comment_ = false;
+  // The last instruction start found, or kNoStart.
+  size_t instruction_start_ = kNoStart;
+};
+
+size_t TextStream::ReadPast(size_t index) {
+  while (!end_of_input_ &&
+         (instruction_start_ == kNoStart || instruction_start_ <= index)) {
+    const size_t size = buffer_.size();
+    buffer_.resize(size + kReadSize);
+    const size_t read =
+        std::min(reader_(user_data_, buffer_.data() + size, kReadSize),
+                 kReadSize);
+    buffer_.resize(size + read);
+    if (read == 0) end_of_input_ = true;
+    Scan();
+  }
+
+  text_.str = buffer_.data();
+  text_.length = end_of_input_ ? buffer_.size() : scanned_;
+  return end_of_input_ ? buffer_.size() : instruction_start_;
+}
+
+void TextStream::Drop(size_t count) {
+  buffer_.erase(buffer_.begin(), buffer_.begin() + count);
+  scanned_ -= count;
+  if (instruction_start_ != kNoStart && instruction_start_ > count) {
+    instruction_start_ -= count;
+  } else {
+    instruction_start_ = kNoStart;
   }
+  text_.str = buffer_.data();
+  text_.length -= count;
+}
 
-  size_t totalSize = SPV_INDEX_INSTRUCTION;
-  for (auto& inst : instructions) {
-    totalSize += inst.words.size();
+void TextStream::Scan() {
+  size_t end = buffer_.size();
+  if (!end_of_input_) {
+    while (end > scanned_ && buffer_[end - 1] != '\n') --end;
   }
 
-  uint32_t* data = new uint32_t[totalSize];
-  if (!data) return SPV_ERROR_OUT_OF_MEMORY;
-  uint64_t currentIndex = SPV_INDEX_INSTRUCTION;
-  for (auto& inst : instructions) {
-    memcpy(data + currentIndex, inst.words.data(),
-           sizeof(uint32_t) * inst.words.size());
-    currentIndex += inst.words.size();
+  // Follows the rules of advance() and getWord() in text_handler.cpp.
+  for (size_t i = scanned_; i < end; ++i) {
+    if (at_line_start_) {
+      at_line_start_ = false;
+      if (!quoting_ && !escaping_ && !comment_) {
+        const size_t start = FindInstructionStart(i, end);
+        if (start != kNoStart) instruction_start_ = start;
+      }
+    }
+
+    const char ch = buffer_[i];
+    if (ch == '\0') {
+      // The text ends at a null character.
+      buffer_.resize(i);
+      end_of_input_ = true;
+      end = i;
+      break;
+    }
+    if (comment_) {
+      if (ch == '\n') {
+        comment_ = false;
+        at_line_start_ = true;
+      }
+      continue;
+    }
+    if (ch == '\\') {
+      escaping_ = !escaping_;
+      continue;
+    }
+    if (!escaping_) {
+      if (ch == '"') {
+        quoting_ = !quoting_;
+      } else if (!quoting_) {
+        if (ch == ';') comment_ = true;
+        if (ch == '\n') at_line_start_ = true;
+      }
+    }
+    escaping_ = false;
   }
+  scanned_ = end;
+}
 
-  if (auto error = SetHeader(grammar.target_env(), context.getBound(), data))
-    return error;
+size_t TextStream::FindInstructionStart(size_t index, size_t end) const {
+  const char* text = buffer_.data();
+  auto skip_blanks = [text, end](size_t i) {
+    while (i < end && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r'))
+      ++i;
+    return i;
+  };
+  auto starts_with_op = [text, end](size_t i) {
+    return i + 3 <= end && text[i] == 'O' && text[i + 1] == 'p' &&
+           'A' <= text[i + 2] && text[i + 2] <= 'Z';
+  };
+
+  const size_t start = skip_blanks(index);
+  if (starts_with_op(start)) return start;
+  if (start >= end || text[start] != '%') return kNoStart;
+
+  // A result id, which must not contain characters changing the lexical
+  // state, followed by an assignment.
+  size_t i = start + 1;
+  for (; i < end; ++i) {
+    const char ch = text[i];
+    if (ch == ' ' || ch == '\t') break;
+    if (strchr(";,()\r\n\"\\", ch) || ch == '\0') return kNoStart;
+  }
+  const size_t equals = skip_blanks(i);
+  if (equals == i || equals >= end || text[equals] != '=') return kNoStart;
+  const size_t opcode = skip_blanks(equals + 1);
+  if (opcode == equals + 1 || !starts_with_op(opcode)) return kNoStart;
+  return start;
+}
 
-  spv_binary binary = new spv_binary_t();
-  if (!binary) {
-    delete[] data;
-    return SPV_ERROR_OUT_OF_MEMORY;
+// Translates the assembly text read from |reader| into binary form, and
+// passes the words to |sink| as they are produced.  If a diagnostic is
+// generated, it is not yet marked as being for a text-based input.
+spv_result_t spvTextStreamToBinaryInternal(
+    const spvtools::AssemblyGrammar& grammar,
+    const spvtools::MessageConsumer& consumer, spv_text_reader_fn reader,
+    void* reader_data, const uint32_t options, spv_binary_sink_fn sink,
+    void* sink_data) {
+  if (!grammar.isValid()) {
+    return SPV_ERROR_INVALID_TABLE;
+  }
+  if (!reader || !sink) return SPV_ERROR_INVALID_POINTER;
+
+  const bool preserve_numeric_ids =
+      options & SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS;
+
+  TextStream stream(reader, reader_data);
+  spvtools::AssemblyContext context(stream.text(), consumer);
+  if (preserve_numeric_ids) context.deferNamedIds();
+
+  ModuleWords words(SPV_INDEX_INSTRUCTION + 1024);
+  const uint32_t placeholder[SPV_INDEX_INSTRUCTION] = {};
+  words.Append(placeholder, SPV_INDEX_INSTRUCTION);
+
+  // Passes the instruction words held in |words| to the sink.  The header is
+  // only known at the end.
+  size_t words_offset = 0;
+  auto flush = [&words, &words_offset, sink, sink_data]() {
+    const size_t first = words_offset == 0 ? SPV_INDEX_INSTRUCTION : 0;
+    if (words.size() > first) {
+      sink(sink_data, words_offset + first, words.data() + first,
+           words.size() - first);
+    }
+    words_offset += words.size();
+    words.Clear();
+  };
+
+  size_t end = stream.ReadPast(0);
+  for (;;) {
+    if (auto error = EncodeModule(grammar, &context, &words, end)) {
+      if (context.hasDeferredIdCollision()) break;
+      return error;
+    }
+    if (stream.complete()) break;
+
+    const size_t consumed = context.position().index;
+    stream.Drop(consumed);
+    context.dropText(consumed);
+    // Named ids take their final value when first seen, unless numeric ids
+    // are preserved.
+    if (!preserve_numeric_ids) flush();
+    end = stream.ReadPast(0);
   }
-  binary->code = data;
-  binary->wordCount = totalSize;
 
-  *pBinary = binary;
+  if (context.hasDeferredIdCollision()) {
+    // The text cannot be read again to assemble it with the numeric ids known
+    // up front, as spvTextToBinary does.
+    return spvtools::DiagnosticStream({}, consumer, "", SPV_ERROR_INVALID_TEXT)
+           << "Numeric ids of 2^31 or more cannot be preserved when the "
+              "assembly text is streamed.";
+  }
+  if (preserve_numeric_ids) context.resolveDeferredIds(words.data());
+  flush();
 
+  uint32_t header[SPV_INDEX_INSTRUCTION];
+  if (auto error =
+          SetHeader(grammar.target_env(), context.getBound(), header)) {
+    return error;
+  }
+  sink(sink_data, 0, header, SPV_INDEX_INSTRUCTION);
   return SPV_SUCCESS;
 }
 
@@ -987,6 +1319,27 @@ spv_result_t spvTextToBinaryWithOptions(const spv_const_context context,
   return result;
 }
 
+spv_result_t spvTextToBinaryStream(const spv_const_context context,
+                                   spv_text_reader_fn reader,
+                                   void* reader_data, const uint32_t options,
+                                   spv_binary_sink_fn sink, void* sink_data,
+                                   spv_diagnostic* pDiagnostic) {
+  spv_context_t hijack_context = *context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    spvtools::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+
+  spvtools::AssemblyGrammar grammar(&hijack_context);
+
+  spv_result_t result =
+      spvTextStreamToBinaryInternal(grammar, hijack_context.consumer, reader,
+                                    reader_data, options, sink, sink_data);
+  if (pDiagnostic && *pDiagnostic) (*pDiagnostic)->isTextSource = true;
+
+  return result;
+}
+
 void spvTextDestroy(spv_text text) {
   if (text) {
     if (text->str) delete[] text->str;
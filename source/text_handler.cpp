@@ -88,16 +88,21 @@ spv_result_t advance(spv_text text, spv_position position) {
 }
 
 // Fetches the next word from the given text stream starting from the given
-// *position. On success, writes the decoded word into *word and updates
+// *position. On success, points *word at the word in the text and updates
 // *position to the location past the returned word.
 //
 // A word ends at the next comment or whitespace.  However, double-quoted
 // strings remain intact, and a backslash always escapes the next character.
-spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
+spv_result_t getWord(spv_text text, spv_position position,
+                     std::string_view* word) {
   if (!text->str || !text->length) return SPV_ERROR_INVALID_TEXT;
   if (!position) return SPV_ERROR_INVALID_POINTER;
 
   const size_t start_index = position->index;
+  auto set_word = [text, start_index, position, word]() {
+    *word = std::string_view(text->str + start_index,
+                             position->index - start_index);
+  };
 
   bool quoting = false;
   bool escaping = false;
@@ -105,7 +110,7 @@ spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
   // NOTE: Assumes first character is not white space!
   while (true) {
     if (position->index >= text->length) {
-      word->assign(text->str + start_index, text->str + position->index);
+      set_word();
       return SPV_SUCCESS;
     }
     const char ch = text->str[position->index];
@@ -125,10 +130,10 @@ spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
         case '\n':
         case '\r':
           if (escaping || quoting) break;
-          word->assign(text->str + start_index, text->str + position->index);
+          set_word();
           return SPV_SUCCESS;
         case '\0': {  // NOTE: End of word found!
-          word->assign(text->str + start_index, text->str + position->index);
+          set_word();
           return SPV_SUCCESS;
         }
         default:
@@ -161,7 +166,15 @@ const IdType kUnknownType = {0, false, IdTypeClass::kBottom};
 // This represents all of the data that is only valid for the duration of
 // a single compilation.
 uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
-  if (!ids_to_preserve_.empty()) {
+  if (defer_named_ids_) {
+    uint32_t id = 0;
+    if (spvtools::utils::ParseNumber(textValue, &id)) {
+      if (id >= kFirstDeferredId) deferred_id_collision_ = true;
+      numeric_ids_.insert(id);
+      bound_ = std::max(bound_, id + 1);
+      return id;
+    }
+  } else if (!ids_to_preserve_.empty()) {
     uint32_t id = 0;
     if (spvtools::utils::ParseNumber(textValue, &id)) {
       if (ids_to_preserve_.find(id) != ids_to_preserve_.end()) {
@@ -171,8 +184,14 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
     }
   }
 
-  const auto it = named_ids_.find(textValue);
+  id_name_.assign(textValue);
+  const auto it = named_ids_.find(id_name_);
   if (it == named_ids_.end()) {
+    if (defer_named_ids_) {
+      const uint32_t id = kFirstDeferredId + num_deferred_ids_++;
+      named_ids_.emplace(id_name_, id);
+      return id;
+    }
     uint32_t id = next_id_++;
     if (!ids_to_preserve_.empty()) {
       while (ids_to_preserve_.find(id) != ids_to_preserve_.end()) {
@@ -180,7 +199,7 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
       }
     }
 
-    named_ids_.emplace(textValue, id);
+    named_ids_.emplace(id_name_, id);
     bound_ = std::max(bound_, id + 1);
     return id;
   }
@@ -188,6 +207,32 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
   return it->second;
 }
 
+void AssemblyContext::resolveDeferredIds(uint32_t* words) {
+  assert(!deferred_id_collision_);
+  if (num_deferred_ids_ == 0) return;
+
+  std::vector<uint32_t> numeric_ids(numeric_ids_.begin(), numeric_ids_.end());
+  std::sort(numeric_ids.begin(), numeric_ids.end());
+
+  // Fill the gaps between the numeric IDs, as spvNamedIdAssignOrGet does
+  // when the numeric IDs are known up front.
+  std::vector<uint32_t> final_ids(num_deferred_ids_);
+  auto next_numeric = numeric_ids.begin();
+  uint32_t next_id = 1;
+  for (uint32_t& final_id : final_ids) {
+    while (next_numeric != numeric_ids.end() && *next_numeric <= next_id) {
+      if (*next_numeric == next_id) ++next_id;
+      ++next_numeric;
+    }
+    final_id = next_id++;
+  }
+  bound_ = std::max(bound_, next_id);
+
+  for (size_t word : deferred_id_words_) {
+    words[word] = final_ids[words[word] - kFirstDeferredId];
+  }
+}
+
 uint32_t AssemblyContext::getBound() const { return bound_; }
 
 spv_result_t AssemblyContext::advance() {
@@ -196,6 +241,15 @@ spv_result_t AssemblyContext::advance() {
 
 spv_result_t AssemblyContext::getWord(std::string* word,
                                       spv_position next_position) {
+  std::string_view view;
+  *next_position = current_position_;
+  spv_result_t result = spvtools::getWord(text_, next_position, &view);
+  if (result == SPV_SUCCESS) word->assign(view);
+  return result;
+}
+
+spv_result_t AssemblyContext::getWord(std::string_view* word,
+                                      spv_position next_position) {
   *next_position = current_position_;
   return spvtools::getWord(text_, next_position, word);
 }
@@ -209,10 +263,10 @@ bool AssemblyContext::isStartOfNewInst() {
   if (spvtools::advance(text_, &pos)) return false;
   if (spvtools::startsWithOp(text_, &pos)) return true;
 
-  std::string word;
+  std::string_view word;
   pos = current_position_;
   if (spvtools::getWord(text_, &pos, &word)) return false;
-  if ('%' != word.front()) return false;
+  if (word.empty() || '%' != word.front()) return false;
 
   if (spvtools::advance(text_, &pos)) return false;
   if (spvtools::getWord(text_, &pos, &word)) return false;
@@ -242,6 +296,16 @@ spv_result_t AssemblyContext::binaryEncodeU32(const uint32_t value,
   return SPV_SUCCESS;
 }
 
+spv_result_t AssemblyContext::binaryEncodeId(const uint32_t id,
+                                             spv_instruction_t* pInst) {
+  if (defer_named_ids_ && id >= kFirstDeferredId &&
+      id - kFirstDeferredId < num_deferred_ids_) {
+    deferred_id_words_.push_back(instruction_offset_ + pInst->words.size());
+  }
+  pInst->words.push_back(id);
+  return SPV_SUCCESS;
+}
+
 spv_result_t AssemblyContext::binaryEncodeNumericLiteral(
     const char* val, spv_result_t error_code, const IdType& type,
     spv_instruction_t* pInst) {
@@ -19,9 +19,12 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "source/diagnostic.h"
 #include "source/instruction.h"
@@ -133,6 +136,25 @@ class AssemblyContext {
   // assigned integer value if the ID has been seen before.
   uint32_t spvNamedIdAssignOrGet(const char* textValue);
 
+  // Makes IDs written as numbers keep their value without a separate pass
+  // to collect them. Named IDs get provisional values until
+  // resolveDeferredIds assigns them the gaps between the numeric IDs.
+  void deferNamedIds() { defer_named_ids_ = true; }
+
+  // Sets the offset in the module of the instruction being encoded, so the
+  // words holding deferred IDs can be patched once they are resolved.
+  void setInstructionOffset(size_t offset) { instruction_offset_ = offset; }
+
+  // Returns true if a numeric ID fell in the range of the provisional IDs.
+  // Encoding may then have mixed the two up, so the module must be assembled
+  // again with the numeric IDs collected up front. Diagnostics are dropped
+  // from that point on, since they may be caused by the collision.
+  bool hasDeferredIdCollision() const { return deferred_id_collision_; }
+
+  // Replaces the provisional IDs in the module |words| by their final values,
+  // in order of first appearance, and updates the bound.
+  void resolveDeferredIds(uint32_t* words);
+
   // Returns the largest largest numeric ID that has been assigned.
   uint32_t getBound() const;
 
@@ -144,6 +166,9 @@ class AssemblyContext {
   // the next location past the end of the word.
   spv_result_t getWord(std::string* word, spv_position next_position);
 
+  // As above, but |word| views the input text instead of copying it.
+  spv_result_t getWord(std::string_view* word, spv_position next_position);
+
   // Returns true if the next word in the input is the start of a new Opcode.
   bool startsWithOp();
 
@@ -155,7 +180,11 @@ class AssemblyContext {
   // stream, and for the given error code. Any data written to this object will
   // show up in pDiagnsotic on destruction.
   DiagnosticStream diagnostic(spv_result_t error) {
-    return DiagnosticStream(current_position_, consumer_, "", error);
+    spv_position_t position = current_position_;
+    position.index += dropped_text_;
+    return DiagnosticStream(position,
+                            deferred_id_collision_ ? nullptr : consumer_, "",
+                            error);
   }
 
   // Returns a diagnostic object with the default assembly error code.
@@ -181,11 +210,24 @@ class AssemblyContext {
   // Returns the current position in the input stream.
   const spv_position_t& position() const { return current_position_; }
 
+  // Accounts for the first |count| characters of the input text being
+  // discarded, when the text is streamed.  Positions become relative to the
+  // remaining text, while diagnostics still report the index in the whole
+  // input.
+  void dropText(size_t count) {
+    current_position_.index -= count;
+    dropped_text_ += count;
+  }
+
   // Appends the given 32-bit value to the given instruction.
   // Returns SPV_SUCCESS if the value could be correctly inserted in the
   // instruction.
   spv_result_t binaryEncodeU32(const uint32_t value, spv_instruction_t* pInst);
 
+  // Appends the given ID, as returned by spvNamedIdAssignOrGet, to the given
+  // instruction. Records where it goes if its final value is not known yet.
+  spv_result_t binaryEncodeId(const uint32_t id, spv_instruction_t* pInst);
+
   // Appends the given string to the given instruction.
   // Returns SPV_SUCCESS if the value could be correctly inserted in the
   // instruction.
@@ -257,6 +299,26 @@ class AssemblyContext {
   uint32_t bound_;
   uint32_t next_id_;
   std::set<uint32_t> ids_to_preserve_;
+
+  // Provisional values of deferred named IDs start here, well above the IDs
+  // found in practice.
+  static constexpr uint32_t kFirstDeferredId = 0x80000000u;
+  // See deferNamedIds.
+  bool defer_named_ids_ = false;
+  // The numeric IDs seen so far when named IDs are deferred.
+  std::unordered_set<uint32_t> numeric_ids_;
+  // Number of provisional IDs handed out.
+  uint32_t num_deferred_ids_ = 0;
+  // See hasDeferredIdCollision.
+  bool deferred_id_collision_ = false;
+  // Offsets in the module of the words holding provisional IDs.
+  std::vector<size_t> deferred_id_words_;
+  // See setInstructionOffset.
+  size_t instruction_offset_ = 0;
+  // Reused to look up named IDs without allocating.
+  std::string id_name_;
+  // See dropText.
+  size_t dropped_text_ = 0;
 };
 
 }  // namespace spvtools
@@ -36,7 +36,7 @@
 namespace {
 // TODO(issue 1950): The validator only returns a single message anyway, so no
 // point in generating more than 1 warning.
-static uint32_t kDefaultMaxNumOfWarnings = 1;
+static const uint32_t kDefaultMaxNumOfWarnings = 1;
 }  // namespace
 
 namespace spvtools {
@@ -167,6 +167,49 @@ TEST_F(BinaryToText, InvalidMagicNumber) {
   spvDiagnosticDestroy(diagnostic);
 }
 
+void AppendText(void* user_data, const char* text, size_t length) {
+  auto* chunks = static_cast<std::vector<std::string>*>(user_data);
+  chunks->emplace_back(text, length);
+}
+
+TEST_F(BinaryToText, SinkReceivesSameTextInChunks) {
+  std::string input =
+      "%int = OpTypeInt 32 0\n"
+      "%sint = OpTypeInt 32 1\n"
+      "%slong = OpTypeInt 64 1\n"
+      "%min = OpConstant %sint -2147483648\n"
+      "%lmin = OpConstant %slong -9223372036854775808\n";
+  for (int i = 0; i < 10000; ++i) {
+    input += "%c" + std::to_string(i) + " = OpConstant %int " +
+             std::to_string(i * 7919u) + "\n";
+  }
+  CompileSuccessfully(input);
+
+  spv_text text = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context, binary->code, binary->wordCount,
+                            SPV_BINARY_TO_TEXT_OPTION_NONE, &text, nullptr));
+  const std::string expected(text->str, text->length);
+  spvTextDestroy(text);
+  EXPECT_THAT(expected, HasSubstr("OpConstant %2 -2147483648"));
+  EXPECT_THAT(expected, HasSubstr("OpConstant %3 -9223372036854775808"));
+
+  std::vector<std::string> chunks;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToTextWithSink(context, binary->code, binary->wordCount,
+                                    SPV_BINARY_TO_TEXT_OPTION_NONE,
+                                    AppendText, &chunks, nullptr));
+  EXPECT_GT(chunks.size(), 1u);
+  std::string actual;
+  for (const auto& chunk : chunks) actual += chunk;
+  EXPECT_EQ(expected, actual);
+
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            spvBinaryToTextWithSink(context, binary->code, binary->wordCount,
+                                    SPV_BINARY_TO_TEXT_OPTION_NONE, nullptr,
+                                    nullptr, nullptr));
+}
+
 struct FailedDecodeCase {
   std::string source_text;
   std::vector<uint32_t> appended_instruction;
@@ -2687,6 +2730,130 @@ INSTANTIATE_TEST_SUITE_P(GeneratorStrings, GeneratorStringTest,
                              {65535, 32767, "Unknown(65535); 32767"},
                          }));
 
+// Returns a module with several functions.  With |debug_info|, the module
+// has names and decorations at module scope, and otherwise the only debug
+// instructions are inside the functions.
+std::string MakeModuleWithFunctions(bool debug_info) {
+  std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+)";
+  if (debug_info) {
+    text += R"(OpName %main "main"
+OpName %helper0 "a_helper_function_with_a_rather_long_name"
+OpDecorate %sum0 RelaxedPrecision
+OpDecorate %cond1 RelaxedPrecision
+OpDecorate %r2 RelaxedPrecision
+)";
+  }
+  text += R"(%void = OpTypeVoid
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%fn = OpTypeFunction %void
+%fn_int = OpTypeFunction %int %int
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_10 = OpConstant %int 10
+)";
+  // Each helper function has its number in place of '@' in its ids.
+  const std::string helper = R"(%helper@ = OpFunction %int None %fn_int
+%x@ = OpFunctionParameter %int
+%entry@ = OpLabel
+OpNoLine
+%cond@ = OpSLessThan %bool %x@ %int_10
+OpSelectionMerge %merge@ None
+OpBranchConditional %cond@ %then@ %merge@
+%merge@ = OpLabel
+%r@ = OpPhi %int %x@ %entry@ %sum@ %then@
+OpReturnValue %r@
+%then@ = OpLabel
+%sum@ = OpIAdd %int %x@ %int_1
+OpBranch %merge@
+OpFunctionEnd
+)";
+  for (int i = 0; i < 12; ++i) {
+    for (char c : helper) {
+      if (c == '@') {
+        text += std::to_string(i);
+      } else {
+        text += c;
+      }
+    }
+  }
+  text += R"(%main = OpFunction %void None %fn
+%m_entry = OpLabel
+OpBranch %loop
+%loop = OpLabel
+%i = OpPhi %int %int_0 %m_entry %next %continue
+OpLoopMerge %exit %continue None
+OpBranch %body
+%body = OpLabel
+%call = OpFunctionCall %int %helper0 %i
+OpBranch %continue
+%continue = OpLabel
+%next = OpIAdd %int %i %int_1
+%done = OpSGreaterThan %bool %next %int_10
+OpBranchConditional %done %exit %loop
+%exit = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  return text;
+}
+
+using ParallelDisassemblyTest =
+    ::testing::TestWithParam<std::tuple<bool, uint32_t>>;
+
+TEST_P(ParallelDisassemblyTest, SameTextAsSerial) {
+  ScopedContext context;
+  const std::string input = MakeModuleWithFunctions(std::get<0>(GetParam()));
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context.context, input.c_str(),
+                                         input.size(), &binary, nullptr));
+
+  const uint32_t options = std::get<1>(GetParam());
+  spv_text serial = nullptr;
+  spv_text parallel = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context.context, binary->code, binary->wordCount,
+                            options, &serial, nullptr));
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context.context, binary->code, binary->wordCount,
+                            options | SPV_BINARY_TO_TEXT_OPTION_PARALLEL,
+                            &parallel, nullptr));
+  EXPECT_EQ(std::string(serial->str, serial->length),
+            std::string(parallel->str, parallel->length));
+
+  spvTextDestroy(serial);
+  spvTextDestroy(parallel);
+  spvBinaryDestroy(binary);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Options, ParallelDisassemblyTest,
+    Combine(::testing::Bool(),
+            ::testing::ValuesIn(std::vector<uint32_t>{
+                SPV_BINARY_TO_TEXT_OPTION_NONE,
+                SPV_BINARY_TO_TEXT_OPTION_INDENT |
+                    SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES,
+                SPV_BINARY_TO_TEXT_OPTION_INDENT |
+                    SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES |
+                    SPV_BINARY_TO_TEXT_OPTION_COMMENT,
+                SPV_BINARY_TO_TEXT_OPTION_INDENT |
+                    SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET |
+                    SPV_BINARY_TO_TEXT_OPTION_COMMENT,
+                SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES |
+                    SPV_BINARY_TO_TEXT_OPTION_NESTED_INDENT |
+                    SPV_BINARY_TO_TEXT_OPTION_REORDER_BLOCKS |
+                    SPV_BINARY_TO_TEXT_OPTION_COMMENT,
+                SPV_BINARY_TO_TEXT_OPTION_INDENT |
+                    SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET |
+                    SPV_BINARY_TO_TEXT_OPTION_NESTED_INDENT |
+                    SPV_BINARY_TO_TEXT_OPTION_REORDER_BLOCKS |
+                    SPV_BINARY_TO_TEXT_OPTION_COMMENT,
+            })));
+
 // TODO(dneto): Test new instructions and enums in SPIR-V 1.3
 
 }  // namespace
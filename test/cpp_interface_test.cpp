@@ -143,6 +143,32 @@ TEST(CppInterface, DisassembleOverloads) {
   }
 }
 
+TEST(CppInterface, DisassembleToSink) {
+  // Make the text long enough to be passed to the sink in several pieces.
+  std::string input_text;
+  for (uint32_t i = 4; i < 10000; ++i) {
+    input_text += "%" + std::to_string(i) + " = OpSizeOf %1 %3\n";
+  }
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(t.Assemble(input_text, &binary));
+
+  std::string expected_text;
+  EXPECT_TRUE(t.Disassemble(binary, &expected_text));
+
+  std::string output_text;
+  int invocation_count = 0;
+  EXPECT_TRUE(t.DisassembleToSink(
+      binary.data(), binary.size(),
+      [&output_text, &invocation_count](const char* text, size_t length) {
+        output_text.append(text, length);
+        ++invocation_count;
+      }));
+  EXPECT_EQ(expected_text, output_text);
+  EXPECT_GT(invocation_count, 1);
+}
+
 TEST(CppInterface, SuccessfulValidation) {
   SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
   int invocation_count = 0;
@@ -0,0 +1,252 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/latest_version_spirv_header.h"
+#include "source/spirv_constant.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using Section = ModuleIndex::Section;
+
+const char kModule[] = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpEntryPoint GLCompute %other "other"
+               OpExecutionMode %main OriginUpperLeft
+               OpName %main "main"
+               OpDecorate %struct Block
+               OpMemberDecorate %struct 0 Offset 0
+      %group = OpDecorationGroup
+               OpGroupDecorate %group %var %struct
+       %void = OpTypeVoid
+         %fn = OpTypeFunction %void
+       %bool = OpTypeBool
+       %true = OpConstantTrue %bool
+     %struct = OpTypeStruct %bool
+        %ptr = OpTypePointer Private %struct
+        %var = OpVariable %ptr Private
+       %main = OpFunction %void None %fn
+      %entry = OpLabel
+               OpBranchConditional %true %then %exit
+       %then = OpLabel
+               OpBranch %exit
+       %exit = OpLabel
+               OpReturn
+               OpFunctionEnd
+      %other = OpFunction %void None %fn
+      %start = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+class ModuleIndexTest : public ::testing::Test {
+ protected:
+  // Assembles |text| into |binary_| and builds |index_| from it.
+  void Build(const std::string& text,
+             uint32_t options = SPV_TEXT_TO_BINARY_OPTION_NONE) {
+    SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+    ASSERT_TRUE(tools.Assemble(text, &binary_, options));
+    ASSERT_TRUE(index_.Build(binary_.data(), binary_.size()));
+  }
+
+  // Returns the opcode of the instruction at |offset|.
+  spv::Op OpcodeAt(size_t offset) const {
+    return static_cast<spv::Op>(binary_[offset] & 0xffff);
+  }
+
+  std::vector<uint32_t> binary_;
+  ModuleIndex index_;
+};
+
+TEST_F(ModuleIndexTest, Sections) {
+  Build(kModule);
+  EXPECT_EQ(5u, index_.GetSection(Section::kCapability).begin);
+  EXPECT_TRUE(index_.GetSection(Section::kExtension).empty());
+  EXPECT_EQ(spv::Op::OpEntryPoint,
+            OpcodeAt(index_.GetSection(Section::kEntryPoint).begin));
+  EXPECT_EQ(index_.GetSection(Section::kEntryPoint).end,
+            index_.GetSection(Section::kExecutionMode).begin);
+  EXPECT_EQ(spv::Op::OpDecorate,
+            OpcodeAt(index_.GetSection(Section::kAnnotation).begin));
+  EXPECT_EQ(spv::Op::OpTypeVoid,
+            OpcodeAt(index_.GetSection(Section::kGlobal).begin));
+  EXPECT_EQ(index_.GetSection(Section::kGlobal).end,
+            index_.GetSection(Section::kFunction).begin);
+  EXPECT_EQ(binary_.size(), index_.GetSection(Section::kFunction).end);
+}
+
+TEST_F(ModuleIndexTest, Definitions) {
+  Build(kModule);
+  EXPECT_EQ(binary_[SPV_INDEX_BOUND], index_.id_bound());
+  for (uint32_t id = 1; id < index_.id_bound(); ++id) {
+    const size_t offset = index_.GetDefinition(id);
+    ASSERT_NE(ModuleIndex::kNotFound, offset) << id;
+    // The result id is the second operand of instructions with a type.
+    EXPECT_TRUE(binary_[offset + 1] == id || binary_[offset + 2] == id) << id;
+  }
+  EXPECT_EQ(ModuleIndex::kNotFound, index_.GetDefinition(0));
+  EXPECT_EQ(ModuleIndex::kNotFound, index_.GetDefinition(index_.id_bound()));
+}
+
+TEST_F(ModuleIndexTest, SparseIds) {
+  Build(R"(%1 = OpTypeVoid
+           %100000 = OpTypeBool
+           %7 = OpTypeInt 32 0)",
+        SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  EXPECT_EQ(spv::Op::OpTypeBool, OpcodeAt(index_.GetDefinition(100000)));
+  EXPECT_EQ(spv::Op::OpTypeInt, OpcodeAt(index_.GetDefinition(7)));
+  EXPECT_EQ(ModuleIndex::kNotFound, index_.GetDefinition(99999));
+}
+
+TEST_F(ModuleIndexTest, EntryPointsAndDecorations) {
+  Build(kModule);
+  const std::vector<size_t> entry_points = index_.GetEntryPoints();
+  ASSERT_EQ(2u, entry_points.size());
+  EXPECT_EQ(spv::Op::OpEntryPoint, OpcodeAt(entry_points[1]));
+
+  // %struct is the target of OpDecorate, OpMemberDecorate and
+  // OpGroupDecorate, in that order. %var only of the latter.
+  const uint32_t struct_id =
+      binary_[index_.GetSection(Section::kAnnotation).begin + 1];
+  std::vector<spv::Op> opcodes;
+  for (size_t offset : index_.GetDecorations(struct_id)) {
+    opcodes.push_back(OpcodeAt(offset));
+  }
+  EXPECT_THAT(opcodes,
+              ElementsAre(spv::Op::OpDecorate, spv::Op::OpMemberDecorate,
+                          spv::Op::OpGroupDecorate));
+  const uint32_t var_id =
+      binary_[index_.GetDecorations(struct_id).back() + 2];
+  EXPECT_EQ(1u, index_.GetDecorations(var_id).size());
+}
+
+TEST_F(ModuleIndexTest, FunctionsAndBlocks) {
+  Build(kModule);
+  ASSERT_EQ(2u, index_.function_count());
+  for (size_t i = 0; i < index_.function_count(); ++i) {
+    const ModuleIndex::Range function = index_.GetFunction(i);
+    EXPECT_EQ(spv::Op::OpFunction, OpcodeAt(function.begin));
+    EXPECT_EQ(spv::Op::OpFunctionEnd, OpcodeAt(function.end - 1));
+    const uint32_t id = binary_[function.begin + 2];
+    EXPECT_EQ(function.begin, index_.GetFunctionById(id).begin);
+  }
+  EXPECT_TRUE(index_.GetFunction(2).empty());
+
+  const std::vector<size_t> blocks = index_.GetBlocks(0);
+  ASSERT_EQ(3u, blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const ModuleIndex::Range block =
+        index_.GetBlockById(binary_[blocks[i] + 1]);
+    EXPECT_EQ(blocks[i], block.begin);
+    // The blocks follow each other, up to the OpFunctionEnd.
+    EXPECT_EQ(i + 1 < blocks.size() ? blocks[i + 1]
+                                    : index_.GetFunction(0).end - 1,
+              block.end);
+  }
+  EXPECT_EQ(1u, index_.GetBlocks(1).size());
+  // Ids which are not labels have no block.
+  EXPECT_TRUE(index_.GetBlockById(binary_[blocks[0] - 3]).empty());
+}
+
+TEST_F(ModuleIndexTest, SaveAndLoad) {
+  Build(kModule);
+  std::vector<uint32_t> data;
+  index_.Save(&data);
+
+  ModuleIndex loaded;
+  ASSERT_TRUE(loaded.Load(data.data(), data.size()));
+  EXPECT_TRUE(loaded.Matches(binary_.data(), binary_.size()));
+  EXPECT_EQ(index_.id_bound(), loaded.id_bound());
+  for (uint32_t id = 0; id <= index_.id_bound(); ++id) {
+    EXPECT_EQ(index_.GetDefinition(id), loaded.GetDefinition(id));
+    EXPECT_EQ(index_.GetDecorations(id), loaded.GetDecorations(id));
+    EXPECT_EQ(index_.GetBlockById(id).end, loaded.GetBlockById(id).end);
+  }
+  EXPECT_EQ(index_.GetEntryPoints(), loaded.GetEntryPoints());
+  EXPECT_EQ(index_.GetBlocks(0), loaded.GetBlocks(0));
+  EXPECT_EQ(index_.GetFunction(1).begin, loaded.GetFunction(1).begin);
+  EXPECT_EQ(index_.GetSection(Section::kGlobal).end,
+            loaded.GetSection(Section::kGlobal).end);
+
+  std::vector<uint32_t> saved_again;
+  loaded.Save(&saved_again);
+  EXPECT_THAT(saved_again, Eq(data));
+
+  std::vector<uint32_t> changed = binary_;
+  changed.back() ^= 1;
+  EXPECT_FALSE(loaded.Matches(changed.data(), changed.size()));
+}
+
+TEST_F(ModuleIndexTest, LoadRejectsBadData) {
+  Build(kModule);
+  std::vector<uint32_t> data;
+  index_.Save(&data);
+
+  ModuleIndex loaded;
+  EXPECT_FALSE(loaded.Load(data.data(), data.size() - 1));
+  EXPECT_EQ(0u, loaded.id_bound());
+  std::vector<uint32_t> bad_magic = data;
+  bad_magic[0] ^= 1;
+  EXPECT_FALSE(loaded.Load(bad_magic.data(), bad_magic.size()));
+  data.push_back(0);
+  EXPECT_FALSE(loaded.Load(data.data(), data.size()));
+}
+
+TEST_F(ModuleIndexTest, BuildRejectsBadBinaries) {
+  Build(kModule);
+  ModuleIndex index;
+  EXPECT_FALSE(index.Build(binary_.data(), binary_.size() - 1));
+  EXPECT_EQ(0u, index.function_count());
+  EXPECT_FALSE(index.Build(binary_.data(), 3));
+  std::vector<uint32_t> bad_magic = binary_;
+  bad_magic[0] = 0;
+  EXPECT_FALSE(index.Build(bad_magic.data(), bad_magic.size()));
+}
+
+TEST_F(ModuleIndexTest, OtherEndianness) {
+  Build(kModule);
+  std::vector<uint32_t> swapped = binary_;
+  for (uint32_t& word : swapped) {
+    word = (word >> 24) | ((word >> 8) & 0xff00) | ((word << 8) & 0xff0000) |
+           (word << 24);
+  }
+  ModuleIndex index;
+  ASSERT_TRUE(index.Build(swapped.data(), swapped.size()));
+  EXPECT_EQ(index_.id_bound(), index.id_bound());
+  for (uint32_t id = 0; id < index_.id_bound(); ++id) {
+    EXPECT_EQ(index_.GetDefinition(id), index.GetDefinition(id));
+  }
+  EXPECT_EQ(index_.GetBlocks(0), index.GetBlocks(0));
+}
+
+TEST_F(ModuleIndexTest, MoveLeavesEmptyIndex) {
+  Build(kModule);
+  ModuleIndex moved(std::move(index_));
+  EXPECT_EQ(2u, moved.function_count());
+  EXPECT_EQ(0u, index_.function_count());
+  EXPECT_EQ(ModuleIndex::kNotFound, index_.GetDefinition(1));
+}
+
+}  // namespace
+}  // namespace spvtools
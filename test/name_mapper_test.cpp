@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -156,6 +157,58 @@ INSTANTIATE_TEST_SUITE_P(
         {"%1 = OpTypeVoid %2 = OpTypeVoid %3 = OpTypeVoid", 3, "void_1"},
     }));
 
+// Ids without a friendlier name are named by their number, which a debug name
+// made of digits can take first.
+INSTANTIATE_TEST_SUITE_P(
+    NumberNames, FriendlyNameTest,
+    ::testing::ValuesIn(std::vector<NameIdCase>{
+        {"%1 = OpTypeVoid %2 = OpTypeFunction %1", 2, "2"},
+        {"OpName %1 \"2\" %1 = OpTypeVoid %2 = OpTypeFunction %1", 1, "2"},
+        {"OpName %1 \"2\" %1 = OpTypeVoid %2 = OpTypeFunction %1", 2, "2_0"},
+        {"OpName %1 \"2_0\" OpName %3 \"2\" %1 = OpTypeVoid "
+         "%2 = OpTypeFunction %1 %3 = OpTypeBool",
+         2, "2_1"},
+        // The first name recorded for an Id wins, even out of order.
+        {"%1 = OpTypeVoid %2 = OpTypeFunction %1 OpName %2 \"foo\"", 2, "2"},
+        {"%1 = OpTypeVoid %2 = OpTypeFunction %1 OpName %3 \"2\"", 3, "2_0"},
+        {"%1 = OpTypeVoid %2 = OpTypeFunction %1 OpName %3 \"2\"", 2, "2"},
+    }));
+
+using FriendlyNameMapperTest = spvtest::TextToBinaryTest;
+
+TEST_F(FriendlyNameMapperTest, ConcurrentFirstCalls) {
+  const std::string assembly = R"(
+    OpName %3 "x"
+    %1 = OpTypeFloat 32
+    %2 = OpTypeVector %1 4
+    %3 = OpTypePointer Private %2
+    %4 = OpTypeVoid
+    %5 = OpTypeFunction %4
+  )";
+  ScopedContext context(SPV_ENV_UNIVERSAL_1_1);
+  const auto words = CompileSuccessfully(assembly, SPV_ENV_UNIVERSAL_1_1);
+  FriendlyNameMapper friendly_mapper(context.context, words.data(),
+                                     words.size());
+
+  // Every thread may be the one to parse the module.
+  std::vector<std::vector<std::string>> names(4);
+  std::vector<std::thread> threads;
+  for (auto& thread_names : names) {
+    threads.emplace_back([&friendly_mapper, &thread_names] {
+      for (uint32_t id = 1; id <= 6; ++id) {
+        thread_names.push_back(friendly_mapper.NameForId(id));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  const std::vector<std::string> expected = {"float", "v4float", "x",
+                                             "void",  "5",       "6"};
+  for (const auto& thread_names : names) {
+    EXPECT_THAT(thread_names, Eq(expected));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(Arrays, FriendlyNameTest,
                          ::testing::ValuesIn(std::vector<NameIdCase>{
                              {"OpName %2 \"FortyTwo\" %1 = OpTypeFloat 32 "
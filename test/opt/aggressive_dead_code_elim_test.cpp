@@ -28,6 +28,7 @@ namespace {
 using AggressiveDCETest = PassTest<::testing::Test>;
 
 using ::testing::HasSubstr;
+using ::testing::Not;
 
 TEST_F(AggressiveDCETest, EliminateExtendedInst) {
   //  #version 140
@@ -8478,6 +8479,103 @@ TEST_F(AggressiveDCETest, KeepCopyLogical) {
   SinglePassRunAndMatch<AggressiveDCEPass>(before, true);
 }
 
+TEST_F(AggressiveDCETest, UnchangedFunctionIsNotProcessedAgain) {
+  // The first run removes %dead from %main and leaves %f unchanged.  The
+  // second run skips %f, but must still keep what %f uses.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %v "v"
+OpName %out "out"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%uint = OpTypeInt 32 0
+%uint_fn = OpTypeFunction %uint
+%uint_1 = OpConstant %uint 1
+%uint_2 = OpConstant %uint 2
+%_ptr_Function_uint = OpTypePointer Function %uint
+%_ptr_Output_uint = OpTypePointer Output %uint
+%out = OpVariable %_ptr_Output_uint Output
+%main = OpFunction %void None %void_fn
+%main_entry = OpLabel
+%dead = OpIAdd %uint %uint_1 %uint_1
+%call = OpFunctionCall %uint %f
+OpStore %out %call
+OpReturn
+OpFunctionEnd
+%f = OpFunction %uint None %uint_fn
+%f_entry = OpLabel
+%v = OpVariable %_ptr_Function_uint Function
+OpStore %v %uint_2
+%load = OpLoad %uint %v
+OpReturnValue %load
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  ASSERT_NE(context, nullptr);
+  // Changes can only be charged to a function while these are valid.
+  context->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                                IRContext::kAnalysisInstrToBlockMapping);
+  auto func = context->module()->begin();
+  Function* main = &*func;
+  Function* f = &*++func;
+  const std::string pass_name = AggressiveDCEPass().CacheKey();
+
+  EXPECT_EQ(AggressiveDCEPass().Run(context.get()),
+            Pass::Status::SuccessWithChange);
+  EXPECT_FALSE(context->IsFunctionUnchangedSinceLastRun(pass_name, *main));
+  EXPECT_TRUE(context->IsFunctionUnchangedSinceLastRun(pass_name, *f));
+
+  std::vector<uint32_t> first_binary;
+  context->module()->ToBinary(&first_binary, false);
+
+  EXPECT_EQ(AggressiveDCEPass().Run(context.get()),
+            Pass::Status::SuccessWithoutChange);
+  EXPECT_TRUE(context->IsFunctionUnchangedSinceLastRun(pass_name, *main));
+  EXPECT_TRUE(context->IsFunctionUnchangedSinceLastRun(pass_name, *f));
+
+  std::vector<uint32_t> second_binary;
+  context->module()->ToBinary(&second_binary, false);
+  EXPECT_EQ(first_binary, second_binary);
+
+  std::string disassembly;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_1);
+  ASSERT_TRUE(tools.Disassemble(second_binary, &disassembly,
+                                SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES));
+  EXPECT_THAT(disassembly, HasSubstr("OpName %v \"v\""));
+  EXPECT_THAT(disassembly, HasSubstr("OpStore %v %uint_2"));
+  EXPECT_THAT(disassembly, Not(HasSubstr("OpIAdd")));
+
+  // Other instances of the pass keep their own record.
+  EXPECT_FALSE(context->IsFunctionUnchangedSinceLastRun(
+      AggressiveDCEPass(true, true).CacheKey(), *f));
+
+  // Returning the constant directly, as passes do by updating the def-use
+  // manager themselves, makes the variable of %f dead.
+  Instruction* ret = &*f->begin()->tail();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+  const uint32_t uint_2 = context->get_constant_mgr()->GetUIntConstId(2);
+  def_use_mgr->EraseUseRecordsOfOperandIds(ret);
+  ret->SetInOperand(0, {uint_2});
+  def_use_mgr->AnalyzeInstUse(ret);
+  EXPECT_FALSE(context->IsFunctionUnchangedSinceLastRun(pass_name, *f));
+
+  EXPECT_EQ(AggressiveDCEPass().Run(context.get()),
+            Pass::Status::SuccessWithChange);
+  std::vector<uint32_t> third_binary;
+  context->module()->ToBinary(&third_binary, false);
+  ASSERT_TRUE(tools.Disassemble(third_binary, &disassembly,
+                                SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES));
+  EXPECT_THAT(disassembly, HasSubstr("OpReturnValue %uint_2"));
+  EXPECT_THAT(disassembly, Not(HasSubstr("OpLoad")));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
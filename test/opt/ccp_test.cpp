@@ -1342,6 +1342,67 @@ TEST_F(CCPTest, LateralLatticeTransition) {
   EXPECT_EQ(std::get<1>(result), Pass::Status::SuccessWithChange);
 }
 
+// Builds a function |name| that switches on the constant %int_<selector>
+// over |num_cases| targets, each feeding its own case number to a Phi.
+std::string SwitchFunction(const std::string& name, uint32_t num_cases,
+                           uint32_t selector) {
+  std::string text = "%" + name + R"( = OpFunction %void None %void_fn
+%)" + name + "_entry = OpLabel\nOpSelectionMerge %" + name + "_merge None\n" +
+                     "OpSwitch %int_" + std::to_string(selector) + " %" +
+                     name + "_merge";
+  for (uint32_t i = 0; i < num_cases; ++i) {
+    text += " " + std::to_string(i) + " %" + name + "_case" +
+            std::to_string(i);
+  }
+  text += "\n";
+  for (uint32_t i = 0; i < num_cases; ++i) {
+    text += "%" + name + "_case" + std::to_string(i) +
+            " = OpLabel\nOpBranch %" + name + "_merge\n";
+  }
+  text += "%" + name + "_merge = OpLabel\n%" + name + "_phi = OpPhi %int" +
+          " %int_0 %" + name + "_entry";
+  for (uint32_t i = 0; i < num_cases; ++i) {
+    text += " %int_" + std::to_string(i) + " %" + name + "_case" +
+            std::to_string(i);
+  }
+  text += "\nOpStore %out %" + name + "_phi\nOpReturn\nOpFunctionEnd\n";
+  return text;
+}
+
+TEST_F(CCPTest, SwitchWithManyTargetsAndPhiWithManyPredecessors) {
+  // Only the case selected by the constant is executable, so each Phi only
+  // sees one constant.  The two functions share the propagator's tables.
+  const uint32_t kNumCases = 64;
+  std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK: OpStore %out %int_5
+; CHECK: %other = OpFunction
+; CHECK: OpStore %out %int_40
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpEntryPoint Fragment %other "other" %out
+OpExecutionMode %main OriginUpperLeft
+OpExecutionMode %other OriginUpperLeft
+OpName %main "main"
+OpName %other "other"
+OpName %out "out"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%_ptr_Output_int = OpTypePointer Output %int
+%out = OpVariable %_ptr_Output_int Output
+)";
+  for (uint32_t i = 0; i < kNumCases; ++i) {
+    text += "%int_" + std::to_string(i) + " = OpConstant %int " +
+            std::to_string(i) + "\n";
+  }
+  text += SwitchFunction("main", kNumCases, 5) +
+          SwitchFunction("other", kNumCases, 40);
+
+  SinglePassRunAndMatch<CCPPass>(text, true);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
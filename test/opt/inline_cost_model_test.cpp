@@ -0,0 +1,201 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InlineCostModelTest = PassTest<::testing::Test>;
+
+const std::string kPrelude = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %big "big"
+OpName %small "small"
+OpName %v "v"
+OpName %acc "acc"
+OpDecorate %in Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_fn = OpTypeFunction %float %float
+%int = OpTypeInt 32 1
+%bool = OpTypeBool
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%small = OpFunction %float None %float_fn
+%y = OpFunctionParameter %float
+%small_entry = OpLabel
+%s = OpFAdd %float %y %y
+OpReturnValue %s
+OpFunctionEnd
+)";
+
+// Returns a function %big with |size| instructions in its body.
+std::string BigFunction(uint32_t size) {
+  std::string text = R"(%big = OpFunction %float None %float_fn
+%x = OpFunctionParameter %float
+%big_entry = OpLabel
+%b0 = OpFMul %float %x %x
+)";
+  for (uint32_t i = 1; i + 1 < size; ++i) {
+    text += "%b" + std::to_string(i) + " = OpFAdd %float %b" +
+            std::to_string(i - 1) + " %x\n";
+  }
+  text += "OpReturnValue %b" + std::to_string(size - 2) + "\nOpFunctionEnd\n";
+  return text;
+}
+
+// A main function that calls |callee| once before a loop and once in it.
+std::string MainWithLoop(const std::string& callee) {
+  return R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%v = OpLoad %float %in
+%c0 = OpFunctionCall %float )" +
+         callee + R"( %v
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %i_next %continue
+%acc = OpPhi %float %c0 %entry %c1 %continue
+%cond = OpSLessThan %bool %i %int_4
+OpLoopMerge %merge %continue None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%c1 = OpFunctionCall %float )" +
+         callee + R"( %acc
+OpBranch %continue
+%continue = OpLabel
+%i_next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpStore %out %acc
+OpReturn
+OpFunctionEnd
+)";
+}
+
+TEST_F(InlineCostModelTest, SmallCalleeIsAlwaysInlined) {
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+)" + kPrelude + BigFunction(20) +
+                           MainWithLoop("%small");
+
+  SinglePassRunAndMatch<InlineCostModelPass>(text, true, 0u, 0u);
+}
+
+TEST_F(InlineCostModelTest, CallInLoopIsMoreProfitable) {
+  // The callee is too big to inline at the call before the loop, but the
+  // loop depth brings the cost of the call in the loop under the threshold.
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK: OpFunctionCall %float %big %v
+; CHECK: OpLoopMerge
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+)" + kPrelude + BigFunction(20) +
+                           MainWithLoop("%big");
+
+  SinglePassRunAndMatch<InlineCostModelPass>(text, true, 4u, 100u);
+}
+
+TEST_F(InlineCostModelTest, GrowthBudgetLimitsInlining) {
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK: OpFunctionCall %float %big %v
+; CHECK: OpLoopMerge
+; CHECK: OpFunctionCall %float %big %acc
+)" + kPrelude + BigFunction(20) +
+                           MainWithLoop("%big");
+
+  SinglePassRunAndMatch<InlineCostModelPass>(text, true, 4u, 0u);
+}
+
+TEST_F(InlineCostModelTest, LastCallIsInlined) {
+  // The callee is too big for the threshold and the budget, but inlining
+  // its only call lets it be removed.
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+)" + kPrelude + BigFunction(20) + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%v = OpLoad %float %in
+%acc = OpFunctionCall %float %big %v
+OpStore %out %acc
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InlineCostModelPass>(text, true, 0u, 0u);
+}
+
+TEST_F(InlineCostModelTest, UntypedPointerArgumentIsMoreProfitable) {
+  // The callee is too big for the threshold, but passing it a pointer brings
+  // the cost under it, even when the pointer is untyped.
+  std::string prelude = kPrelude;
+  prelude.insert(prelude.find("%small = OpFunction"),
+                 "%uptr = OpTypeUntypedPointerKHR Function\n"
+                 "%uptr_fn = OpTypeFunction %float %uptr\n");
+  std::string callee = R"(%big = OpFunction %float None %uptr_fn
+%p = OpFunctionParameter %uptr
+%big_entry = OpLabel
+%b0 = OpLoad %float %p
+)";
+  for (uint32_t i = 1; i < 39; ++i) {
+    callee += "%b" + std::to_string(i) + " = OpFAdd %float %b" +
+              std::to_string(i - 1) + " %b0\n";
+  }
+  callee += "OpReturnValue %b38\nOpFunctionEnd\n";
+
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+OpCapability UntypedPointersKHR
+OpExtension "SPV_KHR_untyped_pointers"
+)" + prelude + callee + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%var = OpUntypedVariableKHR %uptr Function %float
+%v = OpLoad %float %in
+OpStore %var %v
+%c0 = OpFunctionCall %float %big %var
+%c1 = OpFunctionCall %float %big %var
+%sum = OpFAdd %float %c0 %c1
+OpStore %out %sum
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InlineCostModelPass>(text, true, 10u, 100u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
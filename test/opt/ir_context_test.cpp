@@ -22,6 +22,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "source/opt/pass.h"
+#include "source/opt/simplification_pass.h"
 #include "test/opt/pass_fixture.h"
 #include "test/opt/pass_utils.h"
 
@@ -1419,6 +1420,178 @@ TEST_F(IRContextTest, RemovesMultipleCapabilities) {
             1);
 }
 
+const std::string kTwoFunctionsText = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %1 "main"
+       %void = OpTypeVoid
+       %uint = OpTypeInt 32 0
+     %uint_1 = OpConstant %uint 1
+     %uint_2 = OpConstant %uint 2
+          %6 = OpTypeFunction %void
+          %1 = OpFunction %void None %6
+         %10 = OpLabel
+         %11 = OpIAdd %uint %uint_1 %uint_1
+         %12 = OpFunctionCall %void %2
+               OpReturn
+               OpFunctionEnd
+          %2 = OpFunction %void None %6
+         %20 = OpLabel
+         %21 = OpIAdd %uint %uint_2 %uint_2
+               OpReturn
+               OpFunctionEnd)";
+
+TEST_F(IRContextTest, ChangingAnInstructionOnlyModifiesItsFunction) {
+  std::unique_ptr<IRContext> ctx =
+      BuildModule(SPV_ENV_UNIVERSAL_1_6, nullptr, kTwoFunctionsText,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ctx->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                            IRContext::kAnalysisInstrToBlockMapping);
+  Function* main = ctx->GetFunction(1);
+  Function* callee = ctx->GetFunction(2);
+
+  // Functions are never unchanged before a pass recorded them.
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+  ctx->RecordFunctionUnchangedByRun("test", main);
+  ctx->RecordFunctionUnchangedByRun("test", callee);
+  EXPECT_TRUE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+  EXPECT_TRUE(ctx->IsFunctionUnchangedSinceLastRun("test", *callee));
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("other", *callee));
+
+  const uint32_t uint_1 =
+      ctx->get_def_use_mgr()->GetDef(11)->GetSingleWordInOperand(0);
+  Instruction* add = ctx->get_def_use_mgr()->GetDef(21);
+  ctx->ForgetUses(add);
+  add->SetInOperand(1, {uint_1});
+  ctx->AnalyzeUses(add);
+
+  EXPECT_TRUE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("test", *callee));
+}
+
+TEST_F(IRContextTest, AddingAConstantDoesNotModifyFunctions) {
+  std::unique_ptr<IRContext> ctx =
+      BuildModule(SPV_ENV_UNIVERSAL_1_6, nullptr, kTwoFunctionsText,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ctx->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                            IRContext::kAnalysisInstrToBlockMapping);
+  Function* main = ctx->GetFunction(1);
+  ctx->RecordFunctionUnchangedByRun("test", main);
+
+  EXPECT_NE(ctx->get_constant_mgr()->GetUIntConstId(42), 0u);
+  EXPECT_TRUE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+
+  // Adding a block is not seen by the def-use manager, but is still a change.
+  std::unique_ptr<Instruction> label(
+      new Instruction(ctx.get(), spv::Op::OpLabel, 0, ctx->TakeNextId(), {}));
+  main->AddBasicBlock(MakeUnique<BasicBlock>(std::move(label)));
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+}
+
+TEST_F(IRContextTest, UntrackedChangesModifyAllFunctions) {
+  std::unique_ptr<IRContext> ctx =
+      BuildModule(SPV_ENV_UNIVERSAL_1_6, nullptr, kTwoFunctionsText,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ctx->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                            IRContext::kAnalysisInstrToBlockMapping);
+  Function* main = ctx->GetFunction(1);
+  Function* callee = ctx->GetFunction(2);
+  ctx->RecordFunctionUnchangedByRun("test", main);
+  ctx->RecordFunctionUnchangedByRun("test", callee);
+
+  // A pass that changes the module without preserving the def-use manager
+  // may have made changes that were not reported to the context.
+  NoopPassPreservesNothing pass(Pass::Status::SuccessWithChange);
+  pass.Run(ctx.get());
+
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("test", *callee));
+}
+
+TEST_F(IRContextTest, ChangesMadeDirectlyInTheDefUseManagerAreTracked) {
+  std::unique_ptr<IRContext> ctx =
+      BuildModule(SPV_ENV_UNIVERSAL_1_6, nullptr, kTwoFunctionsText,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ctx->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                            IRContext::kAnalysisInstrToBlockMapping);
+  Function* main = ctx->GetFunction(1);
+  Function* callee = ctx->GetFunction(2);
+  ctx->RecordFunctionUnchangedByRun("test", main);
+  ctx->RecordFunctionUnchangedByRun("test", callee);
+
+  // Passes often rewrite operands and tell the def-use manager themselves.
+  analysis::DefUseManager* def_use_mgr = ctx->get_def_use_mgr();
+  const uint32_t uint_1 = def_use_mgr->GetDef(11)->GetSingleWordInOperand(0);
+  Instruction* add = def_use_mgr->GetDef(21);
+  def_use_mgr->EraseUseRecordsOfOperandIds(add);
+  add->SetInOperand(1, {uint_1});
+  def_use_mgr->AnalyzeInstUse(add);
+
+  EXPECT_TRUE(ctx->IsFunctionUnchangedSinceLastRun("test", *main));
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("test", *callee));
+}
+
+// Replaces the first operand of the OpIAdd in the entry point with the
+// constant 1, updating the def-use manager directly.
+class ReplaceAddOperandPass : public Pass {
+ public:
+  const char* name() const override { return "replace-add-operand"; }
+  Status Process() override {
+    Function* func = context()->GetFunction(1);
+    for (Instruction& inst : *func->begin()) {
+      if (inst.opcode() != spv::Op::OpIAdd) continue;
+      const uint32_t one = inst.GetSingleWordInOperand(1);
+      get_def_use_mgr()->EraseUseRecordsOfOperandIds(&inst);
+      inst.SetInOperand(0, {one});
+      get_def_use_mgr()->AnalyzeInstUse(&inst);
+      return Status::SuccessWithChange;
+    }
+    return Status::SuccessWithoutChange;
+  }
+  Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping;
+  }
+};
+
+TEST_F(IRContextTest, SkippingPassRunsAgainAfterDirectDefUseChange) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %1 "main"
+       %void = OpTypeVoid
+       %uint = OpTypeInt 32 0
+     %uint_1 = OpConstant %uint 1
+        %ptr = OpTypePointer Function %uint
+          %6 = OpTypeFunction %void
+          %1 = OpFunction %void None %6
+         %10 = OpLabel
+        %var = OpVariable %ptr Function
+         %11 = OpLoad %uint %var
+         %12 = OpIAdd %uint %11 %uint_1
+               OpStore %var %12
+               OpReturn
+               OpFunctionEnd)";
+  std::unique_ptr<IRContext> ctx =
+      BuildModule(SPV_ENV_UNIVERSAL_1_6, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ctx->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                            IRContext::kAnalysisInstrToBlockMapping);
+
+  // There is nothing to simplify, so the function is recorded as unchanged.
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange,
+            SimplificationPass().Run(ctx.get()));
+  EXPECT_TRUE(ctx->IsFunctionUnchangedSinceLastRun("simplify-instructions",
+                                                   *ctx->GetFunction(1)));
+
+  // The add of two constants can now be folded.
+  EXPECT_EQ(Pass::Status::SuccessWithChange,
+            ReplaceAddOperandPass().Run(ctx.get()));
+  EXPECT_FALSE(ctx->IsFunctionUnchangedSinceLastRun("simplify-instructions",
+                                                    *ctx->GetFunction(1)));
+  EXPECT_EQ(Pass::Status::SuccessWithChange,
+            SimplificationPass().Run(ctx.get()));
+}
+
 // If new environments are added, then we must update the list of tests.
 static_assert(SPV_ENV_VULKAN_1_4 + 1 == SPV_ENV_MAX);
 INSTANTIATE_TEST_SUITE_P(
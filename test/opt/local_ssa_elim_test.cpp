@@ -13,6 +13,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -5456,6 +5457,168 @@ float4 main([[vk::location(0)]] float2 inUV : TEXCOORD0) : SV_TARGET
   SinglePassRunAndMatch<SSARewritePass>(text, true);
 }
 
+TEST_F(LocalSSAElimTest, ForLoopWithDominanceFrontiers) {
+  // Same as ForLoop, rewritten with the dominance frontier algorithm.
+  const std::string text = R"(
+; CHECK: [[entry:%\w+]] = OpLabel
+; CHECK: [[header:%\w+]] = OpLabel
+; CHECK-DAG: [[f:%\w+]] = OpPhi %float %float_0 [[entry]] [[add:%\w+]] [[cont:%\w+]]
+; CHECK-DAG: [[i:%\w+]] = OpPhi %int %int_0 [[entry]] [[inc:%\w+]] [[cont]]
+; CHECK: OpLoopMerge
+; CHECK: OpSLessThan %bool [[i]] %int_4
+; CHECK: OpAccessChain %_ptr_Input_float %BC [[i]]
+; CHECK: [[add]] = OpFAdd %float [[f]]
+; CHECK: [[cont]] = OpLabel
+; CHECK: [[inc]] = OpIAdd %int [[i]] %int_1
+; CHECK: OpStore %fo [[f]]
+OpCapability Shader
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %BC %fo
+OpExecutionMode %main OriginUpperLeft
+OpSource GLSL 140
+OpName %main "main"
+OpName %f "f"
+OpName %i "i"
+OpName %BC "BC"
+OpName %fo "fo"
+%void = OpTypeVoid
+%8 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%_ptr_Function_float = OpTypePointer Function %float
+%float_0 = OpConstant %float 0
+%int = OpTypeInt 32 1
+%_ptr_Function_int = OpTypePointer Function %int
+%int_0 = OpConstant %int 0
+%int_4 = OpConstant %int 4
+%bool = OpTypeBool
+%v4float = OpTypeVector %float 4
+%_ptr_Input_v4float = OpTypePointer Input %v4float
+%BC = OpVariable %_ptr_Input_v4float Input
+%_ptr_Input_float = OpTypePointer Input %float
+%int_1 = OpConstant %int 1
+%_ptr_Output_float = OpTypePointer Output %float
+%fo = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %8
+%22 = OpLabel
+%f = OpVariable %_ptr_Function_float Function
+%i = OpVariable %_ptr_Function_int Function
+OpStore %f %float_0
+OpStore %i %int_0
+OpBranch %23
+%23 = OpLabel
+OpLoopMerge %24 %25 None
+OpBranch %26
+%26 = OpLabel
+%27 = OpLoad %int %i
+%28 = OpSLessThan %bool %27 %int_4
+OpBranchConditional %28 %29 %24
+%29 = OpLabel
+%30 = OpLoad %float %f
+%31 = OpLoad %int %i
+%32 = OpAccessChain %_ptr_Input_float %BC %31
+%33 = OpLoad %float %32
+%34 = OpFAdd %float %30 %33
+OpStore %f %34
+OpBranch %25
+%25 = OpLabel
+%35 = OpLoad %int %i
+%36 = OpIAdd %int %35 %int_1
+OpStore %i %36
+OpBranch %23
+%24 = OpLabel
+%37 = OpLoad %float %f
+OpStore %fo %37
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<SSARewritePass>(text, true, 0u);
+}
+
+// Returns a function with |num_diamonds| if-then-else constructs in
+// sequence.  Each one loads %x, stores to %x in one branch and to %y in the
+// other, so every merge block needs a Phi for each variable.
+std::string ChainOfDiamonds(uint32_t num_diamonds) {
+  std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%bool = OpTypeBool
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_10 = OpConstant %int 10
+%_ptr_Function_int = OpTypePointer Function %int
+%_ptr_Output_int = OpTypePointer Output %int
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpVariable %_ptr_Function_int Function
+%y = OpVariable %_ptr_Function_int Function
+OpStore %x %int_0
+OpStore %y %int_0
+)";
+  for (uint32_t d = 0; d < num_diamonds; ++d) {
+    const std::string n = std::to_string(d);
+    text += "%l" + n + " = OpLoad %int %x\n";
+    text += "%c" + n + " = OpSLessThan %bool %l" + n + " %int_10\n";
+    text += "OpSelectionMerge %m" + n + " None\n";
+    text += "OpBranchConditional %c" + n + " %t" + n + " %e" + n + "\n";
+    text += "%t" + n + " = OpLabel\n";
+    text += "%a" + n + " = OpIAdd %int %l" + n + " %int_1\n";
+    text += "OpStore %x %a" + n + "\n";
+    text += "OpBranch %m" + n + "\n";
+    text += "%e" + n + " = OpLabel\n";
+    text += "OpStore %y %l" + n + "\n";
+    text += "OpBranch %m" + n + "\n";
+    text += "%m" + n + " = OpLabel\n";
+  }
+  text += R"(%rx = OpLoad %int %x
+%ry = OpLoad %int %y
+%sum = OpIAdd %int %rx %ry
+OpStore %out %sum
+OpReturn
+OpFunctionEnd
+)";
+  return text;
+}
+
+size_t CountOccurrences(const std::string& text, const std::string& what) {
+  size_t count = 0;
+  for (size_t pos = text.find(what); pos != std::string::npos;
+       pos = text.find(what, pos + what.size())) {
+    ++count;
+  }
+  return count;
+}
+
+TEST_F(LocalSSAElimTest, LargeFunctionUsesDominanceFrontiers) {
+  // The function is over the default threshold, so the default pass uses
+  // the dominance frontier algorithm.  Both algorithms must place the same
+  // Phis.
+  const uint32_t kNumDiamonds = 300;
+  const std::string text = ChainOfDiamonds(kNumDiamonds);
+
+  auto frontiers = SinglePassRunAndDisassemble<SSARewritePass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true);
+  auto on_the_fly = SinglePassRunAndDisassemble<SSARewritePass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true,
+      std::numeric_limits<uint32_t>::max());
+  EXPECT_EQ(std::get<1>(frontiers), Pass::Status::SuccessWithChange);
+  EXPECT_EQ(std::get<1>(on_the_fly), Pass::Status::SuccessWithChange);
+
+  const std::string& frontiers_text = std::get<0>(frontiers);
+  const std::string& on_the_fly_text = std::get<0>(on_the_fly);
+  EXPECT_EQ(CountOccurrences(frontiers_text, "OpPhi"), 2 * kNumDiamonds);
+  EXPECT_EQ(CountOccurrences(on_the_fly_text, "OpPhi"), 2 * kNumDiamonds);
+  EXPECT_EQ(CountOccurrences(frontiers_text, "OpLoad"), 0u);
+  EXPECT_EQ(CountOccurrences(on_the_fly_text, "OpLoad"), 0u);
+}
+
 // TODO(greg-lunarg): Add tests to verify handling of these cases:
 //
 //    No optimization in the presence of
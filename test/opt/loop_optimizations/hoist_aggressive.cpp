@@ -0,0 +1,366 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/licm_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using AggressiveLICMTest = PassTest<::testing::Test>;
+
+/*
+  Tests for the aggressive mode of the LICM pass.  The loops read and write
+  storage buffers, whose loads the default mode does not hoist.
+*/
+
+// Returns the declarations of the module, with |in_annotations| and
+// |in_types| declaring the %in variable.
+std::string Prelude(const std::string& in_annotations,
+                    const std::string& in_types) {
+  return R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpMemberDecorate %buffer 0 Offset 0
+OpDecorate %buffer BufferBlock
+OpDecorate %in DescriptorSet 0
+OpDecorate %in Binding 0
+)" + in_annotations +
+         R"(OpDecorate %out DescriptorSet 0
+OpDecorate %out Binding 1
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%uint = OpTypeInt 32 0
+%bool = OpTypeBool
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%uint_10 = OpConstant %uint 10
+%buffer = OpTypeStruct %uint
+%_ptr_Uniform_buffer = OpTypePointer Uniform %buffer
+%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+)" + in_types +
+         R"(%out = OpVariable %_ptr_Uniform_buffer Uniform
+)";
+}
+
+const std::string kPrelude =
+    Prelude("", "%in = OpVariable %_ptr_Uniform_buffer Uniform\n");
+
+// Returns a function that sums the value in %in over 10 iterations, with
+// |body_end| at the end of the loop body.  The value is at the indices
+// |in_indices| of %in, and is loaded with the memory operands |load_operands|.
+// The loop only exits after its body, so the body runs at least once.
+std::string SumLoop(const std::string& body_end,
+                    const std::string& load_operands = "",
+                    const std::string& in_indices = "%uint_0") {
+  return R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %i_next %continue
+%acc = OpPhi %uint %uint_0 %entry %acc_next %continue
+OpLoopMerge %merge %continue None
+OpBranch %body
+%body = OpLabel
+%in_ptr = OpAccessChain %_ptr_Uniform_uint %in )" +
+         in_indices + R"(
+%x = OpLoad %uint %in_ptr )" + load_operands + R"(
+%acc_next = OpIAdd %uint %acc %x
+)" + body_end +
+         R"(OpBranch %continue
+%continue = OpLabel
+%i_next = OpIAdd %uint %i %uint_1
+%cond = OpULessThan %bool %i_next %uint_10
+OpBranchConditional %cond %header %merge
+%merge = OpLabel
+%out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+OpStore %out_ptr %acc_next
+OpReturn
+OpFunctionEnd
+)";
+}
+
+TEST_F(AggressiveLICMTest, HoistLoadFromUnwrittenBuffer) {
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NEXT: %in_ptr = OpAccessChain %_ptr_Uniform_uint %in %uint_0
+; CHECK-NEXT: %x = OpLoad %uint %in_ptr
+; CHECK-NEXT: OpBranch %header
+; CHECK: %body = OpLabel
+; CHECK-NEXT: %acc_next = OpIAdd %uint %acc %x
+)" + kPrelude + SumLoop("");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistLoadFromLoopThatMayNotRun) {
+  // The header tests the condition before the body, so the loop may exit
+  // without running the load.
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NOT: OpLoad
+; CHECK: OpBranch %header
+; CHECK: %body = OpLabel
+; CHECK: %x = OpLoad %uint %in_ptr
+)" + kPrelude + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %i_next %continue
+%acc = OpPhi %uint %uint_0 %entry %acc_next %continue
+%cond = OpULessThan %bool %i %uint_10
+OpLoopMerge %merge %continue None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%in_ptr = OpAccessChain %_ptr_Uniform_uint %in %uint_0
+%x = OpLoad %uint %in_ptr
+%acc_next = OpIAdd %uint %acc %x
+OpBranch %continue
+%continue = OpLabel
+%i_next = OpIAdd %uint %i %uint_1
+OpBranch %header
+%merge = OpLabel
+%out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+OpStore %out_ptr %acc
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistLoadAfterEarlyExit) {
+  // The body can break out of the loop before it reaches the load.
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NOT: OpLoad
+; CHECK: OpBranch %header
+; CHECK: %load = OpLabel
+; CHECK: %x = OpLoad %uint %in_ptr
+)" + kPrelude + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %i_next %continue
+%acc = OpPhi %uint %uint_0 %entry %acc_next %continue
+OpLoopMerge %merge %continue None
+OpBranch %body
+%body = OpLabel
+%in_ptr = OpAccessChain %_ptr_Uniform_uint %in %uint_0
+%stop = OpUGreaterThan %bool %acc %uint_10
+OpBranchConditional %stop %merge %load
+%load = OpLabel
+%x = OpLoad %uint %in_ptr
+%acc_next = OpIAdd %uint %acc %x
+OpBranch %continue
+%continue = OpLabel
+%i_next = OpIAdd %uint %i %uint_1
+%cond = OpULessThan %bool %i_next %uint_10
+OpBranchConditional %cond %header %merge
+%merge = OpLabel
+%result = OpPhi %uint %acc %body %acc_next %continue
+%out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+OpStore %out_ptr %result
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistLoadFromWrittenBuffer) {
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NEXT: %in_ptr = OpAccessChain %_ptr_Uniform_uint %in %uint_0
+; CHECK-NEXT: OpBranch %header
+; CHECK: %body = OpLabel
+; CHECK-NEXT: %x = OpLoad %uint %in_ptr
+)" + kPrelude + SumLoop("OpStore %in_ptr %acc_next\n");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+// The CHECKs of a load that stays in the body of SumLoop.
+const std::string kLoadNotHoisted = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NOT: OpLoad
+; CHECK: OpBranch %header
+; CHECK: %body = OpLabel
+; CHECK: %x = OpLoad %uint %in_ptr
+)";
+
+TEST_F(AggressiveLICMTest, DoNotHoistNonPrivateLoad) {
+  // Under the Vulkan memory model, other invocations may write the memory of
+  // a non-private access while the loop runs, as in a spin-wait.
+  const std::string text =
+      kLoadNotHoisted + kPrelude + SumLoop("", "NonPrivatePointer");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistLoadMadeVisible) {
+  const std::string text =
+      kLoadNotHoisted + kPrelude +
+      SumLoop("", "MakePointerVisible|NonPrivatePointer %uint_1");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistLoadFromArrayOfCoherentBlocks) {
+  // The Coherent member is in a block inside an array of descriptors.
+  const std::string text =
+      kLoadNotHoisted +
+      Prelude("OpMemberDecorate %coherent_buffer 0 Offset 0\n"
+              "OpMemberDecorate %coherent_buffer 0 Coherent\n"
+              "OpDecorate %coherent_buffer BufferBlock\n",
+              "%uint_2 = OpConstant %uint 2\n"
+              "%coherent_buffer = OpTypeStruct %uint\n"
+              "%buffers = OpTypeArray %coherent_buffer %uint_2\n"
+              "%_ptr_Uniform_buffers = OpTypePointer Uniform %buffers\n"
+              "%in = OpVariable %_ptr_Uniform_buffers Uniform\n") +
+      SumLoop("", "", "%uint_1 %uint_0");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistLoadFromNestedCoherentStruct) {
+  // The Coherent member is in a struct nested in the block.
+  const std::string text =
+      kLoadNotHoisted +
+      Prelude("OpMemberDecorate %inner 0 Offset 0\n"
+              "OpMemberDecorate %inner 0 Coherent\n"
+              "OpMemberDecorate %outer 0 Offset 0\n"
+              "OpDecorate %outer BufferBlock\n",
+              "%inner = OpTypeStruct %uint\n"
+              "%outer = OpTypeStruct %inner\n"
+              "%_ptr_Uniform_outer = OpTypePointer Uniform %outer\n"
+              "%in = OpVariable %_ptr_Uniform_outer Uniform\n") +
+      SumLoop("", "", "%uint_0 %uint_0");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotHoistGuardedLoadFromLoopWithoutExit) {
+  // The loop never exits, so no block leaving it constrains where the load
+  // is, but the load only runs when its guard holds.
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NOT: OpLoad
+; CHECK: OpBranch %header
+; CHECK: %load = OpLabel
+; CHECK: %x = OpLoad %uint %in_ptr
+)" + kPrelude + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %i_next %continue
+%guard = OpULessThan %bool %i %uint_10
+OpLoopMerge %merge %continue None
+OpBranchConditional %guard %load %continue
+%load = OpLabel
+%in_ptr = OpAccessChain %_ptr_Uniform_uint %in %uint_0
+%x = OpLoad %uint %in_ptr
+%out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+OpStore %out_ptr %x
+OpBranch %continue
+%continue = OpLabel
+%i_next = OpIAdd %uint %i %uint_1
+OpBranch %header
+%merge = OpLabel
+OpUnreachable
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, RegisterBudgetLimitsHoisting) {
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NEXT: OpBranch %header
+; CHECK: %body = OpLabel
+; CHECK-NEXT: %in_ptr = OpAccessChain %_ptr_Uniform_uint %in %uint_0
+; CHECK-NEXT: %x = OpLoad %uint %in_ptr
+)" + kPrelude + SumLoop("");
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 0u);
+}
+
+TEST_F(AggressiveLICMTest, SinkInvariantStore) {
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NEXT: %out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+; CHECK-NEXT: OpBranch %header
+; CHECK: %header = OpLabel
+; CHECK-NOT: OpStore
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: OpStore %out_ptr %uint_1
+; CHECK-NEXT: OpReturn
+)" + kPrelude + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %i_next %header
+%out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+OpStore %out_ptr %uint_1
+%i_next = OpIAdd %uint %i %uint_1
+%cond = OpULessThan %bool %i_next %uint_10
+OpLoopMerge %merge %header None
+OpBranchConditional %cond %header %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+TEST_F(AggressiveLICMTest, DoNotSinkStoreThatIsLoadedInTheLoop) {
+  const std::string text = R"(
+; CHECK: %header = OpLabel
+; CHECK: OpStore %out_ptr %uint_1
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: OpReturn
+)" + kPrelude + R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %uint %uint_0 %entry %i_next %header
+%out_ptr = OpAccessChain %_ptr_Uniform_uint %out %uint_0
+OpStore %out_ptr %uint_1
+%y = OpLoad %uint %out_ptr
+%i_next = OpIAdd %uint %i %y
+%cond = OpULessThan %bool %i_next %uint_10
+OpLoopMerge %merge %header None
+OpBranchConditional %cond %header %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<LICMPass>(text, true, 64u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -31,7 +31,9 @@ class PeelingPassTest : public PassTest<::testing::Test> {
   LoopPeelingPass::LoopPeelingStats AssembleAndRunPeelingTest(
       const std::string& text_head, const std::string& text_tail,
       spv::Op opcode, const std::string& res_id, const std::string& op1,
-      const std::string& op2) {
+      const std::string& op2,
+      size_t code_grow_threshold =
+          LoopPeelingPass::kDefaultCodeGrowThreshold) {
     std::string opcode_str;
     switch (opcode) {
       case spv::Op::OpSLessThan:
@@ -61,7 +63,8 @@ class PeelingPassTest : public PassTest<::testing::Test> {
 
     LoopPeelingPass::LoopPeelingStats stats;
     SinglePassRunAndDisassemble<LoopPeelingPass>(
-        text_head + test_cond + text_tail, true, true, &stats);
+        text_head + test_cond + text_tail, true, true, &stats,
+        code_grow_threshold);
 
     return stats;
   }
@@ -70,9 +73,11 @@ class PeelingPassTest : public PassTest<::testing::Test> {
   LoopPeelingPass::LoopPeelingStats RunPeelingTest(
       const std::string& text_head, const std::string& text_tail,
       spv::Op opcode, const std::string& res_id, const std::string& op1,
-      const std::string& op2, size_t nb_of_loops) {
+      const std::string& op2, size_t nb_of_loops,
+      size_t code_grow_threshold =
+          LoopPeelingPass::kDefaultCodeGrowThreshold) {
     LoopPeelingPass::LoopPeelingStats stats = AssembleAndRunPeelingTest(
-        text_head, text_tail, opcode, res_id, op1, op2);
+        text_head, text_tail, opcode, res_id, op1, op2, code_grow_threshold);
 
     Function& f = *context()->module()->begin();
     LoopDescriptor& ld = *context()->GetLoopDescriptor(&f);
@@ -89,9 +94,11 @@ class PeelingPassTest : public PassTest<::testing::Test> {
                           const std::string& res_id, const std::string& op1,
                           const std::string& op2,
                           const PeelTraceType& expected_peel_trace,
-                          size_t expected_nb_of_loops) {
+                          size_t expected_nb_of_loops,
+                          size_t code_grow_threshold =
+                              LoopPeelingPass::kDefaultCodeGrowThreshold) {
     auto stats = RunPeelingTest(text_head, text_tail, opcode, res_id, op1, op2,
-                                expected_nb_of_loops);
+                                expected_nb_of_loops, code_grow_threshold);
 
     EXPECT_EQ(stats.peeled_loops_.size(), expected_peel_trace.size());
     if (stats.peeled_loops_.size() != expected_peel_trace.size()) {
@@ -1003,11 +1010,9 @@ TEST_F(PeelingPassTest, PeelingNestedPass) {
   {
     SCOPED_TRACE("Over threshold");
 
-    size_t current_threshold = LoopPeelingPass::GetLoopPeelingThreshold();
-    LoopPeelingPass::SetLoopPeelingThreshold(1u);
     // Expect no peeling and 2 loops at the end.
-    run_test(spv::Op::OpSLessThan, "%46", "%int_7", {}, 2);
-    LoopPeelingPass::SetLoopPeelingThreshold(current_threshold);
+    BuildAndCheckTrace(text_head, text_tail, spv::Op::OpSLessThan, "%30",
+                       "%46", "%int_7", {}, 2, 1u);
   }
 }
 /*
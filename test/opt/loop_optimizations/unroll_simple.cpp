@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -28,6 +29,7 @@ namespace spvtools {
 namespace opt {
 namespace {
 
+using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAre;
 using PassClassTest = PassTest<::testing::Test>;
 
@@ -3864,6 +3866,117 @@ OpFunctionEnd
   SinglePassRunAndCheck<LoopUnroller>(text, text, false);
 }
 
+// A loop running 8 times that is not marked for unrolling.  Its blocks have
+// 14 instructions.
+std::string HeuristicLoop(const std::string& loop_control) {
+  return R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %x "x"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_8 = OpConstant %int 8
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%uint = OpTypeInt 32 0
+%uint_8 = OpConstant %uint 8
+%array = OpTypeArray %float %uint_8
+%_ptr_Function_array = OpTypePointer Function %array
+%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%x = OpVariable %_ptr_Function_array Function
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %i_next %continue
+OpLoopMerge %merge %continue )" +
+         loop_control + R"(
+OpBranch %cond_block
+%cond_block = OpLabel
+%cond = OpSLessThan %bool %i %int_8
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%ptr = OpAccessChain %_ptr_Function_float %x %i
+OpStore %ptr %float_1
+OpBranch %continue
+%continue = OpLabel
+%i_next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+}
+
+// Returns the number of times |pattern| occurs in |text|.
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST_F(PassClassTest, HeuristicUnrollFullyUnrollsWithinBudget) {
+  const std::string text = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpLoopMerge
+; CHECK: OpReturn
+)" + HeuristicLoop("None");
+
+  SinglePassRunAndMatch<LoopUnroller>(text, true,
+                                      LoopUnroller::HeuristicBudget{64, 1024});
+}
+
+TEST_F(PassClassTest, HeuristicUnrollPicksFactorUnderSizeBudget) {
+  // A full unroll is 112 instructions, an unroll by 4 is 56.
+  std::vector<std::string> messages;
+  SetMessageConsumer([&messages](spv_message_level_t level, const char*,
+                                 const spv_position_t&, const char* message) {
+    if (level == SPV_MSG_DEBUG) messages.push_back(message);
+  });
+
+  auto result = SinglePassRunAndDisassemble<LoopUnroller>(
+      HeuristicLoop("None"), true, true,
+      LoopUnroller::HeuristicBudget{64, 60});
+  EXPECT_EQ(std::get<1>(result), Pass::Status::SuccessWithChange);
+  EXPECT_EQ(CountOccurrences(std::get<0>(result), "OpLoopMerge"), 1u);
+  EXPECT_EQ(CountOccurrences(std::get<0>(result), "OpStore"), 4u);
+
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_THAT(messages[0], HasSubstr("unrolled by 4"));
+}
+
+TEST_F(PassClassTest, HeuristicUnrollReportsLoopOverBudget) {
+  std::vector<std::string> messages;
+  SetMessageConsumer([&messages](spv_message_level_t level, const char*,
+                                 const spv_position_t&, const char* message) {
+    if (level == SPV_MSG_DEBUG) messages.push_back(message);
+  });
+
+  auto result = SinglePassRunAndDisassemble<LoopUnroller>(
+      HeuristicLoop("None"), true, true,
+      LoopUnroller::HeuristicBudget{1, 1024});
+  EXPECT_EQ(std::get<1>(result), Pass::Status::SuccessWithoutChange);
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_THAT(messages[0], HasSubstr("not unrolled"));
+}
+
+TEST_F(PassClassTest, HeuristicUnrollSkipsDontUnrollLoops) {
+  auto result = SinglePassRunAndDisassemble<LoopUnroller>(
+      HeuristicLoop("DontUnroll"), true, true,
+      LoopUnroller::HeuristicBudget{64, 1024});
+  EXPECT_EQ(std::get<1>(result), Pass::Status::SuccessWithoutChange);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
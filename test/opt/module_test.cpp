@@ -334,6 +334,72 @@ OpFunctionEnd
   EXPECT_EQ(1, non_semantic_ids.count(11));
   EXPECT_EQ(1, non_semantic_ids.count(12));
 }
+
+// A module with several functions, each with line and scope instructions
+// which depend on the instructions before them.
+const char kDebugInfoModule[] = R"(
+OpCapability Shader
+OpCapability Linkage
+%1 = OpExtInstImport "OpenCL.DebugInfo.100"
+OpMemoryModel Logical GLSL450
+%file = OpString "file.hlsl"
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%src = OpExtInst %void %1 DebugSource %file
+%cu = OpExtInst %void %1 DebugCompilationUnit 1 4 %src HLSL
+%f1 = OpFunction %void None %fn
+%b1 = OpLabel
+%s1 = OpExtInst %void %1 DebugScope %cu
+OpLine %file 1 0
+OpSelectionMerge %m1 None
+OpLine %file 1 0
+OpBranchConditional %true %m1 %m1
+%m1 = OpLabel
+OpReturn
+OpFunctionEnd
+%f2 = OpFunction %void None %fn
+%b2 = OpLabel
+OpReturn
+OpFunctionEnd
+%f3 = OpFunction %void None %fn
+%b3 = OpLabel
+%s3 = OpExtInst %void %1 DebugScope %cu
+OpLine %file 3 0
+OpReturn
+OpFunctionEnd
+OpLine %file 4 0
+)";
+
+TEST(ModuleTest, ParallelToBinaryMatchesSerial) {
+  std::vector<uint32_t> serial;
+  BuildModule(kDebugInfoModule)->module()->ToBinary(&serial, false);
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_1);
+  std::string text;
+  ASSERT_TRUE(tools.Disassemble(serial, &text));
+  EXPECT_NE(std::string::npos, text.find("DebugScope"));
+
+  for (size_t num_threads : {2, 3, 8}) {
+    std::vector<uint32_t> parallel;
+    BuildModule(kDebugInfoModule)
+        ->module()
+        ->ToBinary(&parallel, false, num_threads);
+    EXPECT_THAT(parallel, Eq(serial)) << num_threads;
+  }
+}
+
+TEST(ModuleTest, ToBinaryAppends) {
+  std::vector<uint32_t> expected;
+  BuildModule(kDebugInfoModule)->module()->ToBinary(&expected, true);
+
+  std::vector<uint32_t> binary = {1, 2, 3};
+  BuildModule(kDebugInfoModule)->module()->ToBinary(&binary, true, 2);
+  ASSERT_EQ(expected.size() + 3, binary.size());
+  EXPECT_EQ(std::vector<uint32_t>({1, 2, 3}),
+            std::vector<uint32_t>(binary.begin(), binary.begin() + 3));
+  EXPECT_EQ(expected, std::vector<uint32_t>(binary.begin() + 3, binary.end()));
+}
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
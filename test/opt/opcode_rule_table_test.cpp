@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/opcode_rule_table.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using RuleTable = OpcodeRuleTable<std::vector<int>>;
+
+TEST(OpcodeRuleTableTest, EmptyTableHasNoRules) {
+  RuleTable table;
+  EXPECT_EQ(table.Find(spv::Op::OpIAdd), nullptr);
+  EXPECT_FALSE(table.HasRules(spv::Op::OpIAdd));
+}
+
+TEST(OpcodeRuleTableTest, RulesAreKeptInInsertionOrder) {
+  RuleTable table;
+  table[spv::Op::OpIAdd].push_back(1);
+  table[spv::Op::OpIAdd].push_back(2);
+  table[spv::Op::OpFAdd].push_back(3);
+
+  ASSERT_NE(table.Find(spv::Op::OpIAdd), nullptr);
+  EXPECT_THAT(*table.Find(spv::Op::OpIAdd), ::testing::ElementsAre(1, 2));
+  ASSERT_NE(table.Find(spv::Op::OpFAdd), nullptr);
+  EXPECT_THAT(*table.Find(spv::Op::OpFAdd), ::testing::ElementsAre(3));
+  EXPECT_FALSE(table.HasRules(spv::Op::OpISub));
+}
+
+TEST(OpcodeRuleTableTest, EmptyRuleSetIsNotARule) {
+  RuleTable table;
+  table[spv::Op::OpIMul];
+  EXPECT_NE(table.Find(spv::Op::OpIMul), nullptr);
+  EXPECT_FALSE(table.HasRules(spv::Op::OpIMul));
+}
+
+TEST(OpcodeRuleTableTest, OpcodesPastTheLargestRuleAreEmpty) {
+  RuleTable table;
+  table[spv::Op::OpNop].push_back(1);
+  EXPECT_TRUE(table.HasRules(spv::Op::OpNop));
+  EXPECT_FALSE(table.HasRules(spv::Op::OpGroupIAddNonUniformAMD));
+
+  table[spv::Op::OpGroupIAddNonUniformAMD].push_back(2);
+  EXPECT_TRUE(table.HasRules(spv::Op::OpGroupIAddNonUniformAMD));
+  EXPECT_THAT(*table.Find(spv::Op::OpNop), ::testing::ElementsAre(1));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -12,11 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "spirv-tools/libspirv.hpp"
+#include "source/opt/optimizer_cache.h"
 #include "spirv-tools/optimizer.hpp"
 #include "test/opt/pass_fixture.h"
 
@@ -177,6 +184,7 @@ TEST(Optimizer, CanRegisterPassesFromFlags) {
       "--cfg-cleanup",
       "--local-redundancy-elimination",
       "--loop-invariant-code-motion",
+      "--loop-invariant-code-motion-aggressive",
       "--reduce-load-size",
       "--redundancy-elimination",
       "--private-to-local",
@@ -189,6 +197,7 @@ TEST(Optimizer, CanRegisterPassesFromFlags) {
       "--loop-fission=20",
       "--loop-fusion=2",
       "--loop-unroll",
+      "--loop-unroll-heuristic=32:512",
       "--vector-dce",
       "--loop-unroll-partial=3",
       "--loop-peeling",
@@ -219,6 +228,16 @@ TEST(Optimizer, CanRegisterPassesFromFlags) {
 
   EXPECT_FALSE(opt.RegisterPassFromFlag("--loop-unroll-partial"));
   EXPECT_EQ(msg_level, SPV_MSG_ERROR);
+
+  EXPECT_FALSE(opt.RegisterPassFromFlag("--loop-unroll-heuristic=4294967296"));
+  EXPECT_EQ(msg_level, SPV_MSG_ERROR);
+
+  EXPECT_FALSE(opt.RegisterPassFromFlag("--loop-unroll-heuristic=8:"));
+  EXPECT_EQ(msg_level, SPV_MSG_ERROR);
+
+  EXPECT_FALSE(
+      opt.RegisterPassFromFlag("--loop-invariant-code-motion-aggressive=-1"));
+  EXPECT_EQ(msg_level, SPV_MSG_ERROR);
 }
 
 
@@ -506,6 +525,319 @@ OpFunctionEnd)";
   EXPECT_EQ(test_disassembly, default_disassembly);
 }
 
+// A cache that records how it is used.
+class RecordingCache : public OptimizerCache {
+ public:
+  bool Lookup(const std::string& key, std::vector<uint32_t>* binary) override {
+    looked_up.push_back(key);
+    return cache_.Lookup(key, binary);
+  }
+  void Store(const std::string& key,
+             const std::vector<uint32_t>& binary) override {
+    stored.push_back(key);
+    cache_.Store(key, binary);
+  }
+
+  std::vector<std::string> looked_up;
+  std::vector<std::string> stored;
+
+ private:
+  MemoryOptimizerCache cache_{16};
+};
+
+TEST(Optimizer, CacheHitReturnsStoredBinary) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid",
+                 &binary_in);
+  RecordingCache cache;
+
+  std::vector<uint32_t> first_out;
+  {
+    Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+    opt.SetCache(&cache);
+    ASSERT_TRUE(opt.RegisterPassFromFlag("--strip-debug"));
+    ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &first_out));
+  }
+  ASSERT_EQ(cache.looked_up.size(), 1u);
+  ASSERT_EQ(cache.stored.size(), 1u);
+  EXPECT_EQ(cache.looked_up[0], cache.stored[0]);
+
+  std::vector<uint32_t> second_out;
+  std::vector<std::string> messages;
+  {
+    Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+    opt.SetMessageConsumer([&messages](spv_message_level_t level, const char*,
+                                       const spv_position_t&,
+                                       const char* message) {
+      if (level == SPV_MSG_DEBUG) messages.push_back(message);
+    });
+    opt.SetCache(&cache);
+    ASSERT_TRUE(opt.RegisterPassFromFlag("--strip-debug"));
+    ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &second_out));
+  }
+  EXPECT_EQ(cache.looked_up.size(), 2u);
+  EXPECT_EQ(cache.stored.size(), 1u);
+  EXPECT_EQ(first_out, second_out);
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_THAT(messages[0], ::testing::HasSubstr("Optimizer cache hit"));
+}
+
+TEST(Optimizer, CacheKeyDependsOnPassesAndOptions) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid",
+                 &binary_in);
+  RecordingCache cache;
+
+  auto run = [&cache, &binary_in](const std::vector<std::string>& flags,
+                                  bool preserve_bindings) {
+    Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+    opt.SetCache(&cache);
+    EXPECT_TRUE(opt.RegisterPassesFromFlags(flags));
+    OptimizerOptions options;
+    options.set_preserve_bindings(preserve_bindings);
+    std::vector<uint32_t> binary_out;
+    EXPECT_TRUE(
+        opt.Run(binary_in.data(), binary_in.size(), &binary_out, options));
+  };
+
+  run({"--strip-debug"}, false);
+  run({"--strip-debug", "--eliminate-dead-const"}, false);
+  run({"--eliminate-dead-const", "--strip-debug"}, false);
+  run({"--strip-debug"}, true);
+  run({"-O"}, false);
+  run({"-Os"}, false);
+
+  ASSERT_EQ(cache.stored.size(), 6u);
+  std::set<std::string> keys(cache.stored.begin(), cache.stored.end());
+  EXPECT_EQ(keys.size(), 6u);
+}
+
+TEST(Optimizer, CacheKeyDependsOnPassParameters) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "%void = OpTypeVoid", &binary_in);
+  RecordingCache cache;
+
+  auto run = [&cache, &binary_in](Optimizer::PassToken&& pass) {
+    Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+    opt.SetCache(&cache);
+    opt.RegisterPass(std::move(pass));
+    std::vector<uint32_t> binary_out;
+    EXPECT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+  };
+
+  run(CreateLoopUnrollPass(false, 2));
+  run(CreateLoopUnrollPass(false, 8));
+  run(CreateLoopUnrollPass(false, 8));
+  run(CreateScalarReplacementPass(10));
+  run(CreateScalarReplacementPass(20));
+  run(CreateReduceLoadSizePass(0.5));
+  run(CreateReduceLoadSizePass(0.75));
+  run(CreateSwitchDescriptorSetPass(0, 1));
+  run(CreateSwitchDescriptorSetPass(0, 2));
+
+  EXPECT_EQ(cache.looked_up.size(), 9u);
+  ASSERT_EQ(cache.stored.size(), 8u);
+  std::set<std::string> keys(cache.stored.begin(), cache.stored.end());
+  EXPECT_EQ(keys.size(), 8u);
+}
+
+TEST(Optimizer, CacheIsBypassedForPassesWithOutsideResults) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "%void = OpTypeVoid", &binary_in);
+  RecordingCache cache;
+
+  std::unordered_set<uint32_t> live_locs;
+  std::unordered_set<uint32_t> live_builtins;
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.SetCache(&cache);
+  opt.RegisterPass(CreateAnalyzeLiveInputPass(&live_locs, &live_builtins));
+  std::vector<uint32_t> binary_out;
+  ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+  EXPECT_TRUE(cache.looked_up.empty());
+  EXPECT_TRUE(cache.stored.empty());
+}
+
+TEST(Optimizer, CacheIsBypassedWhenPrintingAll) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "%void = OpTypeVoid", &binary_in);
+  RecordingCache cache;
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  std::ostringstream print_all;
+  opt.SetCache(&cache).SetPrintAll(&print_all);
+  opt.RegisterPass(CreateNullPass());
+  std::vector<uint32_t> binary_out;
+  ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+  EXPECT_TRUE(cache.looked_up.empty());
+  EXPECT_TRUE(cache.stored.empty());
+}
+
+// A fragment shader with a small counted loop, so the loop passes in the
+// performance recipe have something to work on.
+std::string LoopShader() {
+  return R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%bool = OpTypeBool
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_3 = OpConstant %int 3
+%int_10 = OpConstant %int 10
+%_ptr_Output_int = OpTypePointer Output %int
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %next %continue
+%sum = OpPhi %int %int_0 %entry %sum_next %continue
+%cond = OpSLessThan %bool %i %int_10
+OpLoopMerge %merge %continue None
+OpBranchConditional %cond %body %merge
+%body = OpLabel
+%small = OpSLessThan %bool %i %int_3
+%add = OpSelect %int %small %int_1 %i
+%sum_next = OpIAdd %int %sum %add
+OpBranch %continue
+%continue = OpLabel
+%next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpStore %out %sum
+OpReturn
+OpFunctionEnd
+)";
+}
+
+// Runs the performance recipe, optionally preceded by loop peeling with the
+// given threshold, on |binary|.
+std::vector<uint32_t> RunPerformanceRecipe(const std::vector<uint32_t>& binary,
+                                           uint32_t peeling_threshold) {
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_3);
+  if (peeling_threshold) {
+    EXPECT_TRUE(opt.RegisterPassFromFlag("--loop-peeling"));
+    EXPECT_TRUE(opt.RegisterPassFromFlag("--loop-peeling-threshold=" +
+                                         std::to_string(peeling_threshold)));
+  }
+  opt.RegisterPerformancePasses();
+  std::vector<uint32_t> optimized;
+  EXPECT_TRUE(opt.Run(binary.data(), binary.size(), &optimized));
+  return optimized;
+}
+
+TEST(Optimizer, ConcurrentOptimizersDoNotShareState) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools.Assemble(LoopShader(), &binary));
+
+  // Each thread uses a different peeling threshold, so any setting that
+  // leaks between optimizers shows up as a mismatch against the result of
+  // running the same configuration alone.
+  const uint32_t kNumThreads = 8;
+  const uint32_t kRunsPerThread = 4;
+  std::vector<std::vector<uint32_t>> expected(kNumThreads);
+  for (uint32_t t = 0; t < kNumThreads; ++t) {
+    expected[t] = RunPerformanceRecipe(binary, t % 2 ? 1 : 0);
+  }
+
+  std::vector<std::vector<std::vector<uint32_t>>> results(
+      kNumThreads, std::vector<std::vector<uint32_t>>(kRunsPerThread));
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&binary, &results, t]() {
+      for (uint32_t run = 0; run < kRunsPerThread; ++run) {
+        results[t][run] = RunPerformanceRecipe(binary, t % 2 ? 1 : 0);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (uint32_t t = 0; t < kNumThreads; ++t) {
+    for (uint32_t run = 0; run < kRunsPerThread; ++run) {
+      EXPECT_THAT(results[t][run], Eq(expected[t]));
+    }
+  }
+}
+
+TEST(Optimizer, DecisionReportListsUnrollDecisions) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools.Assemble(LoopShader(), &binary));
+  RecordingCache cache;
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_3);
+  std::ostringstream report;
+  opt.SetCache(&cache).SetDecisionReport(&report);
+  ASSERT_TRUE(opt.RegisterPassFromFlag("--loop-unroll-heuristic"));
+  std::vector<uint32_t> optimized;
+  ASSERT_TRUE(opt.Run(binary.data(), binary.size(), &optimized));
+
+  // One line for the only loop.  The report needs the pass to run, so the
+  // cache is bypassed.
+  const std::string text = report.str();
+  EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 1);
+  EXPECT_THAT(text, testing::StartsWith("loop-unroll-heuristic: Loop %"));
+  EXPECT_THAT(text, testing::HasSubstr("(10 iterations, "));
+  EXPECT_THAT(text, testing::HasSubstr("): fully unrolled, estimated "));
+  EXPECT_TRUE(cache.looked_up.empty());
+}
+
+TEST(OptimizerCache, MemoryCacheEvictsLeastRecentlyUsed) {
+  MemoryOptimizerCache cache(2);
+  std::vector<uint32_t> value;
+  cache.Store("a", {1});
+  cache.Store("b", {2});
+  // Touch "a" so that "b" is the least recently used entry.
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  cache.Store("c", {3});
+
+  EXPECT_FALSE(cache.Lookup("b", &value));
+  EXPECT_TRUE(cache.Lookup("a", &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{1}));
+  EXPECT_TRUE(cache.Lookup("c", &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{3}));
+}
+
+TEST(OptimizerCache, DirectoryCacheRoundTrips) {
+  std::unique_ptr<OptimizerCache> cache =
+      CreateDirectoryOptimizerCache(::testing::TempDir());
+  const std::string key = ComputeOptimizerCacheKey(
+      ::testing::UnitTest::GetInstance()->current_test_info()->name(), nullptr,
+      0);
+  const std::vector<uint32_t> binary = {0x07230203, 1, 2, 3};
+
+  cache->Store(key, binary);
+  std::vector<uint32_t> value;
+  ASSERT_TRUE(cache->Lookup(key, &value));
+  EXPECT_THAT(value, Eq(binary));
+
+  const std::string other_key = ComputeOptimizerCacheKey("other", nullptr, 0);
+  EXPECT_FALSE(cache->Lookup(other_key, &value));
+}
+
+TEST(OptimizerCache, KeyDependsOnBinaryAndDescriptor) {
+  const std::vector<uint32_t> a = {1, 2, 3};
+  const std::vector<uint32_t> b = {1, 2, 4};
+  const std::string key = ComputeOptimizerCacheKey("x", a.data(), a.size());
+  EXPECT_EQ(key.size(), 32u);
+  EXPECT_EQ(key, ComputeOptimizerCacheKey("x", a.data(), a.size()));
+  EXPECT_NE(key, ComputeOptimizerCacheKey("x", b.data(), b.size()));
+  EXPECT_NE(key, ComputeOptimizerCacheKey("y", a.data(), a.size()));
+  EXPECT_NE(key, ComputeOptimizerCacheKey("x", a.data(), a.size() - 1));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
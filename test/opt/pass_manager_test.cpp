@@ -14,6 +14,7 @@
 
 #include <initializer_list>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,6 +30,7 @@ namespace {
 
 using spvtest::GetIdBound;
 using ::testing::Eq;
+using ::testing::HasSubstr;
 
 // A null pass whose constructors accept arguments
 class NullPassWithArgs : public NullPass {
@@ -186,6 +188,166 @@ TEST(PassManager, RecomputeIdBoundAutomatically) {
   EXPECT_THAT(GetIdBound(*context.module()), Eq(201u));
 }
 
+// A pass that reports a change as long as |*remaining| is not zero, and
+// decrements it every time it does.
+class CountdownPass : public Pass {
+ public:
+  explicit CountdownPass(uint32_t* remaining) : remaining_(remaining) {}
+
+  const char* name() const override { return "countdown"; }
+  Status Process() override {
+    if (*remaining_ == 0) return Status::SuccessWithoutChange;
+    --*remaining_;
+    return Status::SuccessWithChange;
+  }
+
+ private:
+  uint32_t* remaining_;
+};
+
+TEST(PassManager, FixedPointGroupStopsWhenNoPassChanges) {
+  PassManager manager;
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, MakeUnique<Module>(),
+                    manager.consumer());
+  std::ostringstream report;
+  manager.SetTimeReport(&report);
+
+  uint32_t remaining = 2;
+  manager.AddFixedPointGroup(
+      {[&remaining]() { return MakeUnique<CountdownPass>(&remaining); },
+       []() { return MakeUnique<NullPass>(); }},
+      10);
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(&context));
+  EXPECT_EQ(0u, remaining);
+
+  // Two rounds change the module.  The third round stops once the countdown
+  // pass has confirmed the null pass result.
+  EXPECT_THAT(report.str(),
+              HasSubstr("fixed-point-group: 5 pass invocations in 3 rounds "
+                        "(1 fewer than running every pass each round), "
+                        "reached a fixed point"));
+}
+
+TEST(PassManager, FixedPointGroupStopsAtRoundLimit) {
+  PassManager manager;
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, MakeUnique<Module>(),
+                    manager.consumer());
+  std::ostringstream report;
+  manager.SetTimeReport(&report);
+
+  uint32_t remaining = 10;
+  manager.AddFixedPointGroup(
+      {[&remaining]() { return MakeUnique<CountdownPass>(&remaining); }}, 3);
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(&context));
+  EXPECT_EQ(7u, remaining);
+  EXPECT_THAT(report.str(), HasSubstr("stopped at the round limit"));
+}
+
+// A pass that skips every function it has already seen unchanged.
+class SkipUnchangedPass : public Pass {
+ public:
+  const char* name() const override { return "skip-unchanged"; }
+  Status Process() override {
+    for (Function& func : *get_module()) {
+      if (context()->IsFunctionUnchangedSinceLastRun(name(), func)) continue;
+      context()->RecordFunctionUnchangedByRun(name(), &func);
+    }
+    return Status::SuccessWithoutChange;
+  }
+};
+
+TEST(PassManager, FixedPointGroupReportsSkippedFunctionsAndTimeSaved) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %1 "main"
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+          %1 = OpFunction %void None %3
+          %4 = OpLabel
+               OpReturn
+               OpFunctionEnd
+          %5 = OpFunction %void None %3
+          %6 = OpLabel
+               OpReturn
+               OpFunctionEnd)";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_6, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  context->BuildInvalidAnalyses(IRContext::kAnalysisDefUse |
+                                IRContext::kAnalysisInstrToBlockMapping);
+  context->RecordFunctionUnchangedByRun("skip-unchanged",
+                                        context->GetFunction(1));
+  context->RecordFunctionUnchangedByRun("skip-unchanged",
+                                        context->GetFunction(5));
+
+  PassManager manager;
+  std::ostringstream report;
+  manager.SetTimeReport(&report);
+  manager.AddFixedPointGroup({[]() { return MakeUnique<SkipUnchangedPass>(); },
+                              []() { return MakeUnique<NullPass>(); }},
+                             4);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, manager.Run(context.get()));
+  EXPECT_THAT(report.str(),
+              HasSubstr("fixed-point-group: 2 pass invocations in 1 rounds "
+                        "(0 fewer than running every pass each round), "
+                        "reached a fixed point, "
+                        "2 unchanged function runs skipped, about "));
+  EXPECT_THAT(report.str(), HasSubstr(" ms saved\n"));
+}
+
+// A pass that builds the def-use manager without changing the module.
+class BuildDefUsePass : public Pass {
+ public:
+  const char* name() const override { return "build-def-use"; }
+  Status Process() override {
+    context()->get_def_use_mgr();
+    return Status::SuccessWithoutChange;
+  }
+};
+
+TEST(PassManager, ProfileReport) {
+  PassManager manager;
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, MakeUnique<Module>(),
+                    manager.consumer());
+  std::ostringstream profile;
+  manager.SetProfileReport(&profile);
+
+  manager.AddPass<BuildDefUsePass>();
+  manager.AddPass<AppendOpNopPass>();
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(&context));
+
+  const std::string trace = profile.str();
+  EXPECT_THAT(trace, HasSubstr("{\"traceEvents\":["));
+  EXPECT_THAT(trace,
+              HasSubstr("\"name\":\"build-def-use\",\"cat\":\"pass\""));
+  EXPECT_THAT(trace, HasSubstr("\"status\":\"unchanged\","
+                               "\"instructions_before\":0,"
+                               "\"instructions_after\":0,"
+                               "\"functions_touched\":0,"
+                               "\"analyses_built\":{\"def-use\":1},"
+                               "\"analyses_invalidated\":{}"));
+  EXPECT_THAT(trace,
+              HasSubstr("\"name\":\"AppendOpNop\",\"cat\":\"pass\""));
+  EXPECT_THAT(trace, HasSubstr("\"status\":\"changed\","
+                               "\"instructions_before\":0,"
+                               "\"instructions_after\":1,"
+                               "\"functions_touched\":0,"
+                               "\"analyses_built\":{},"
+                               "\"analyses_invalidated\":{\"def-use\":1}"));
+}
+
+TEST(PassManager, FixedPointGroupWithoutChanges) {
+  PassManager manager;
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, MakeUnique<Module>(),
+                    manager.consumer());
+  manager.AddFixedPointGroup({[]() { return MakeUnique<NullPass>(); },
+                              []() { return MakeUnique<NullPass>(); }},
+                             4);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, manager.Run(&context));
+}
+
 }  // anonymous namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -639,6 +639,72 @@ OpFunctionEnd
   EXPECT_EQ(GetErrorMessage(), "");
 }
 
+// Types whose decorations only differ in order are the same type.
+TEST_F(RemoveDuplicatesTest, DecorationOrderDoesNotMatter) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %1 Block
+OpDecorate %1 Restrict
+OpDecorate %2 Restrict
+OpDecorate %2 Block
+%3 = OpTypeFloat 32
+%1 = OpTypeStruct %3
+%2 = OpTypeStruct %3
+)";
+
+  const std::string after = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %1 Block
+OpDecorate %1 Restrict
+%3 = OpTypeFloat 32
+%1 = OpTypeStruct %3
+)";
+
+  EXPECT_EQ(RunPass(spirv), after);
+  EXPECT_EQ(GetErrorMessage(), "");
+}
+
+// Comparing every type or decoration with all the previous ones would take
+// far too long on this module.
+TEST_F(RemoveDuplicatesTest, ManyTypesAndDecorations) {
+  const uint32_t kNumArrays = 20000;
+  std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+)";
+  for (uint32_t i = 0; i < kNumArrays; ++i) {
+    const std::string n = std::to_string(i);
+    spirv += "OpDecorate %a" + n + " ArrayStride 4\n";
+    spirv += "OpDecorate %a" + n + " ArrayStride 4\n";
+    spirv += "OpDecorate %b" + n + " ArrayStride 4\n";
+  }
+  spirv += "%uint = OpTypeInt 32 0\n";
+  for (uint32_t i = 0; i < kNumArrays; ++i) {
+    const std::string n = std::to_string(i);
+    spirv += "%c" + n + " = OpConstant %uint " + std::to_string(i + 1) + "\n";
+    spirv += "%a" + n + " = OpTypeArray %uint %c" + n + "\n";
+    spirv += "%b" + n + " = OpTypeArray %uint %c" + n + "\n";
+  }
+
+  const std::string result = RunPass(spirv);
+  EXPECT_EQ(GetErrorMessage(), "");
+
+  auto count = [&result](const std::string& str) {
+    uint32_t n = 0;
+    for (size_t pos = result.find(str); pos != std::string::npos;
+         pos = result.find(str, pos + 1)) {
+      ++n;
+    }
+    return n;
+  };
+  EXPECT_EQ(count("OpTypeArray"), kNumArrays);
+  EXPECT_EQ(count("ArrayStride"), kNumArrays);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -2356,6 +2356,175 @@ TEST_F(ScalarReplacementTest, RestrictPointer) {
   SinglePassRunAndMatch<ScalarReplacementPass>(text, true);
 }
 
+const std::string kArrayOfStructsPrelude = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %func "func"
+OpName %i "i"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%int = OpTypeInt 32 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_1 = OpConstant %uint 1
+%uint_2 = OpConstant %uint 2
+%uint_4 = OpConstant %uint 4
+%float_1 = OpConstant %float 1
+%int_1 = OpConstant %int 1
+%S = OpTypeStruct %float %int
+%_arr_S_uint_4 = OpTypeArray %S %uint_4
+%_ptr_Function__arr_S_uint_4 = OpTypePointer Function %_arr_S_uint_4
+%_ptr_Function_S = OpTypePointer Function %S
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Function_int = OpTypePointer Function %int
+%func_type = OpTypeFunction %void %uint
+%func = OpFunction %void None %func_type
+%i = OpFunctionParameter %uint
+%entry = OpLabel
+%var = OpVariable %_ptr_Function__arr_S_uint_4 Function
+)";
+
+TEST_F(ScalarReplacementTest, SplitArrayOfStructsWithDynamicIndex) {
+  // The float member is indexed dynamically, so it stays an array.  The int
+  // member is only accessed with constant indexes, so it is scalarized.
+  const std::string text = R"(
+; CHECK: [[float_arr:%\w+]] = OpTypeArray %float %uint_4
+; CHECK: [[float_arr_ptr:%\w+]] = OpTypePointer Function [[float_arr]]
+; CHECK: %entry = OpLabel
+; CHECK-DAG: [[int_var:%\w+]] = OpVariable %_ptr_Function_int Function
+; CHECK-DAG: [[float_var:%\w+]] = OpVariable [[float_arr_ptr]] Function
+; CHECK-NOT: OpVariable
+; CHECK: [[ac:%\w+]] = OpAccessChain %_ptr_Function_float [[float_var]] %i
+; CHECK-NEXT: OpStore [[ac]] %float_1
+; CHECK-NEXT: OpStore [[int_var]] %int_1
+; CHECK-NEXT: OpLoad %int [[int_var]]
+)" + kArrayOfStructsPrelude + R"(
+%p0 = OpAccessChain %_ptr_Function_float %var %i %uint_0
+OpStore %p0 %float_1
+%p1 = OpAccessChain %_ptr_Function_int %var %uint_2 %uint_1
+OpStore %p1 %int_1
+%l1 = OpLoad %int %p1
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<ScalarReplacementPass>(text, true);
+}
+
+TEST_F(ScalarReplacementTest, SplitArrayOfStructsElementAccesses) {
+  // Loads and stores of a dynamically indexed element access each member
+  // array.
+  const std::string text = R"(
+; CHECK: %entry = OpLabel
+; CHECK-NOT: OpAccessChain %_ptr_Function_S
+; CHECK: [[f:%\w+]] = OpAccessChain %_ptr_Function_float [[float_var:%\w+]] %i
+; CHECK-NEXT: [[fv:%\w+]] = OpLoad %float [[f]]
+; CHECK-NEXT: [[n:%\w+]] = OpAccessChain %_ptr_Function_int [[int_var:%\w+]] %i
+; CHECK-NEXT: [[nv:%\w+]] = OpLoad %int [[n]]
+; CHECK-NEXT: [[s:%\w+]] = OpCompositeConstruct %S [[fv]] [[nv]]
+; CHECK-NEXT: [[f2:%\w+]] = OpAccessChain %_ptr_Function_float [[float_var]] %i
+; CHECK-NEXT: [[fx:%\w+]] = OpCompositeExtract %float [[s]] 0
+; CHECK-NEXT: OpStore [[f2]] [[fx]]
+; CHECK-NEXT: [[n2:%\w+]] = OpAccessChain %_ptr_Function_int [[int_var]] %i
+; CHECK-NEXT: [[nx:%\w+]] = OpCompositeExtract %int [[s]] 1
+; CHECK-NEXT: OpStore [[n2]] [[nx]]
+; CHECK-NEXT: [[m:%\w+]] = OpAccessChain %_ptr_Function_float [[float_var]] %i
+; CHECK-NEXT: OpStore [[m]] %float_1
+)" + kArrayOfStructsPrelude + R"(
+%e = OpAccessChain %_ptr_Function_S %var %i
+%v = OpLoad %S %e
+OpStore %e %v
+%m = OpAccessChain %_ptr_Function_float %e %uint_0
+OpStore %m %float_1
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<ScalarReplacementPass>(text, true);
+}
+
+TEST_F(ScalarReplacementTest, SplitArrayOfStructsWholeAccesses) {
+  // A load of the whole array is rebuilt from the member arrays, and a store
+  // of the whole array is split into stores of the member arrays.
+  const std::string text = R"(
+; CHECK: [[float_arr:%\w+]] = OpTypeArray %float %uint_4
+; CHECK: %entry = OpLabel
+; CHECK-NOT: OpVariable %_ptr_Function__arr_S_uint_4
+; CHECK: [[fl:%\w+]] = OpLoad [[float_arr]] [[float_var:%\w+]]
+; CHECK: OpCompositeExtract %float [[fl]] 0
+; CHECK: OpCompositeConstruct %S
+; CHECK: [[whole:%\w+]] = OpCompositeConstruct %_arr_S_uint_4
+; CHECK-NEXT: OpCompositeExtract %float [[whole]] 0 0
+; CHECK: [[fs:%\w+]] = OpCompositeConstruct [[float_arr]]
+; CHECK-NEXT: OpStore [[float_var]] [[fs]]
+; CHECK: OpAccessChain %_ptr_Function_float [[float_var]] %i
+; CHECK-NOT: OpLoad %_arr_S_uint_4
+)" + kArrayOfStructsPrelude + R"(
+%whole = OpLoad %_arr_S_uint_4 %var
+OpStore %var %whole
+%p0 = OpAccessChain %_ptr_Function_float %var %i %uint_0
+OpStore %p0 %float_1
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<ScalarReplacementPass>(text, true);
+}
+
+TEST_F(ScalarReplacementTest, DontSplitLargeArrayOfStructsWithWholeAccess) {
+  // 129 elements of 2 members exceed the limit of 256 members for rebuilding
+  // whole loads and stores.
+  const std::string text = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %func "func"
+OpName %i "i"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%int = OpTypeInt 32 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_129 = OpConstant %uint 129
+%float_1 = OpConstant %float 1
+%S = OpTypeStruct %float %int
+%_arr_S_uint_129 = OpTypeArray %S %uint_129
+%_ptr_Function__arr_S_uint_129 = OpTypePointer Function %_arr_S_uint_129
+%_ptr_Function_float = OpTypePointer Function %float
+%func_type = OpTypeFunction %void %uint
+%func = OpFunction %void None %func_type
+%i = OpFunctionParameter %uint
+%entry = OpLabel
+%var = OpVariable %_ptr_Function__arr_S_uint_129 Function
+%whole = OpLoad %_arr_S_uint_129 %var
+OpStore %var %whole
+%p0 = OpAccessChain %_ptr_Function_float %var %i %uint_0
+OpStore %p0 %float_1
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result =
+      SinglePassRunAndDisassemble<ScalarReplacementPass>(text, true, true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(ScalarReplacementTest, DontSplitArrayOfStructsWithoutMemberAccess) {
+  // Splitting does not help when every access is to a whole element.
+  const std::string text = kArrayOfStructsPrelude + R"(
+%e = OpAccessChain %_ptr_Function_S %var %i
+%v = OpLoad %S %e
+OpStore %e %v
+OpReturn
+OpFunctionEnd
+)";
+
+  auto result =
+      SinglePassRunAndDisassemble<ScalarReplacementPass>(text, true, true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -148,6 +148,41 @@ TEST_F(ValueTableTest, DifferentValue) {
   EXPECT_NE(vtable.GetValueNumber(inst1), vtable.GetValueNumber(inst2));
 }
 
+TEST_F(ValueTableTest, CommutativeOperandsSameValue) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeFloat 32
+          %6 = OpTypePointer Function %5
+          %2 = OpFunction %3 None %4
+          %7 = OpLabel
+          %8 = OpVariable %6 Function
+          %9 = OpLoad %5 %8
+         %10 = OpLoad %5 %8
+         %11 = OpFAdd %5 %9 %10
+         %12 = OpFAdd %5 %10 %9
+         %13 = OpFSub %5 %9 %10
+         %14 = OpFSub %5 %10 %9
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable vtable(context.get());
+  Instruction* add1 = context->get_def_use_mgr()->GetDef(11);
+  Instruction* add2 = context->get_def_use_mgr()->GetDef(12);
+  EXPECT_EQ(vtable.GetValueNumber(add1), vtable.GetValueNumber(add2));
+
+  Instruction* sub1 = context->get_def_use_mgr()->GetDef(13);
+  Instruction* sub2 = context->get_def_use_mgr()->GetDef(14);
+  EXPECT_NE(vtable.GetValueNumber(sub1), vtable.GetValueNumber(sub2));
+}
+
 TEST_F(ValueTableTest, DifferentValueDifferentBlock) {
   const std::string text = R"(
                OpCapability Shader
@@ -612,8 +647,8 @@ TEST_F(ValueTableTest, PhiTest2) {
   EXPECT_NE(vtable.GetValueNumber(inst2), vtable.GetValueNumber(phi));
 }
 
-// Test that a phi node in a loop header gets a new value because one of its
-// inputs comes from later in the loop.
+// Test that a phi node in a loop header gets the value of its inputs even
+// though one of them comes from later in the loop.
 TEST_F(ValueTableTest, PhiLoopTest) {
   const std::string text = R"(
                OpCapability Shader
@@ -654,11 +689,96 @@ TEST_F(ValueTableTest, PhiLoopTest) {
   EXPECT_EQ(vtable.GetValueNumber(inst1), vtable.GetValueNumber(inst2));
 
   Instruction* phi1 = context->get_def_use_mgr()->GetDef(15);
-  EXPECT_NE(vtable.GetValueNumber(inst1), vtable.GetValueNumber(phi1));
+  EXPECT_EQ(vtable.GetValueNumber(inst1), vtable.GetValueNumber(phi1));
 
   Instruction* phi2 = context->get_def_use_mgr()->GetDef(18);
   EXPECT_EQ(vtable.GetValueNumber(inst1), vtable.GetValueNumber(phi2));
+}
+
+// Test that two induction variables with the same initial value and step get
+// the same value, and that so do the values computed from them.
+TEST_F(ValueTableTest, CongruentInductionVariables) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeInt 32 1
+          %6 = OpTypeBool
+          %7 = OpConstant %5 0
+          %8 = OpConstant %5 1
+          %9 = OpConstant %5 10
+          %2 = OpFunction %3 None %4
+         %10 = OpLabel
+               OpBranch %11
+         %11 = OpLabel
+         %12 = OpPhi %5 %7 %10 %14 %11
+         %13 = OpPhi %5 %7 %10 %15 %11
+         %14 = OpIAdd %5 %12 %8
+         %15 = OpIAdd %5 %8 %13
+         %16 = OpSLessThan %6 %14 %9
+               OpLoopMerge %17 %11 None
+               OpBranchConditional %16 %11 %17
+         %17 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable vtable(context.get());
+  Instruction* phi1 = context->get_def_use_mgr()->GetDef(12);
+  Instruction* phi2 = context->get_def_use_mgr()->GetDef(13);
+  EXPECT_EQ(vtable.GetValueNumber(phi1), vtable.GetValueNumber(phi2));
+
+  Instruction* add1 = context->get_def_use_mgr()->GetDef(14);
+  Instruction* add2 = context->get_def_use_mgr()->GetDef(15);
+  EXPECT_EQ(vtable.GetValueNumber(add1), vtable.GetValueNumber(add2));
+
+  Instruction* init = context->get_def_use_mgr()->GetDef(7);
+  EXPECT_NE(vtable.GetValueNumber(init), vtable.GetValueNumber(phi1));
+}
+
+// Test that induction variables with different steps keep different values.
+TEST_F(ValueTableTest, DifferentInductionVariables) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeInt 32 1
+          %6 = OpTypeBool
+          %7 = OpConstant %5 0
+          %8 = OpConstant %5 1
+          %9 = OpConstant %5 2
+          %2 = OpFunction %3 None %4
+         %10 = OpLabel
+               OpBranch %11
+         %11 = OpLabel
+         %12 = OpPhi %5 %7 %10 %14 %11
+         %13 = OpPhi %5 %7 %10 %15 %11
+         %14 = OpIAdd %5 %12 %8
+         %15 = OpIAdd %5 %13 %9
+         %16 = OpSLessThan %6 %14 %9
+               OpLoopMerge %17 %11 None
+               OpBranchConditional %16 %11 %17
+         %17 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable vtable(context.get());
+  Instruction* phi1 = context->get_def_use_mgr()->GetDef(12);
+  Instruction* phi2 = context->get_def_use_mgr()->GetDef(13);
   EXPECT_NE(vtable.GetValueNumber(phi1), vtable.GetValueNumber(phi2));
+
+  Instruction* add1 = context->get_def_use_mgr()->GetDef(14);
+  Instruction* add2 = context->get_def_use_mgr()->GetDef(15);
+  EXPECT_NE(vtable.GetValueNumber(add1), vtable.GetValueNumber(add2));
 }
 
 // Test to make sure that OpPhi instructions with no in operands are handled
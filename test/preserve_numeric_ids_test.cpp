@@ -155,5 +155,77 @@ OpFunctionEnd
   EXPECT_EQ(expected, after);
 }
 
+TEST(TextHandler, PreserveNumericIdsDefinedAfterNamedIds) {
+  // The named ids are seen before the numeric ids whose values they must
+  // avoid.
+  const std::string before =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%1 = OpTypeInt 32 0
+%3 = OpTypeInt 32 1
+%4 = OpTypeVector %float 4
+)";
+
+  const std::string expected =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+%2 = OpTypeVoid
+%5 = OpTypeFunction %2
+%6 = OpTypeFloat 32
+%1 = OpTypeInt 32 0
+%3 = OpTypeInt 32 1
+%4 = OpTypeVector %6 4
+)";
+
+  std::string after;
+  EXPECT_EQ(SPV_SUCCESS,
+            ToBinaryAndBack(before, &after,
+                            SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS,
+                            SPV_BINARY_TO_TEXT_OPTION_NO_HEADER));
+
+  EXPECT_EQ(expected, after);
+}
+
+TEST(TextHandler, PreserveLargeNumericIds) {
+  // The numeric id is in the range the assembler uses for named ids until
+  // it has seen the whole module.
+  const std::string before =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%2147483648 = OpTypeFunction %void
+)";
+
+  const std::string expected =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+%1 = OpTypeVoid
+%2147483648 = OpTypeFunction %1
+)";
+
+  ScopedContext ctx;
+  spv_binary binary = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvTextToBinaryWithOptions(
+                ctx.context, before.c_str(), before.size(),
+                SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS, &binary,
+                &diagnostic));
+  EXPECT_EQ(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+  spvBinaryDestroy(binary);
+
+  std::string after;
+  EXPECT_EQ(SPV_SUCCESS,
+            ToBinaryAndBack(before, &after,
+                            SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS,
+                            SPV_BINARY_TO_TEXT_OPTION_NO_HEADER));
+
+  EXPECT_EQ(expected, after);
+}
+
 }  // namespace
 }  // namespace spvtools
@@ -0,0 +1,110 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "tools/io.h"
+
+namespace spvtools {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+class ReadFileTest : public ::testing::Test {
+ public:
+  ReadFileTest()
+      : filename_(::testing::TempDir() + "read_file_test_" +
+                  ::testing::UnitTest::GetInstance()
+                      ->current_test_info()
+                      ->name()) {}
+  ~ReadFileTest() override { std::remove(filename_.c_str()); }
+
+  // Writes |size| bytes at |data| to the file.
+  void WriteBytes(const void* data, size_t size) {
+    FILE* file = fopen(filename_.c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    EXPECT_EQ(size, fwrite(data, 1, size, file));
+    fclose(file);
+  }
+
+  const char* filename() const { return filename_.c_str(); }
+
+ private:
+  std::string filename_;
+};
+
+TEST_F(ReadFileTest, BinaryFile) {
+  std::vector<uint32_t> words(100000);
+  for (size_t i = 0; i < words.size(); ++i) words[i] = uint32_t(i * 31);
+  WriteBytes(words.data(), words.size() * sizeof(uint32_t));
+
+  FileContents<uint32_t> contents;
+  ASSERT_TRUE(ReadBinaryFile(filename(), &contents));
+  EXPECT_THAT(std::vector<uint32_t>(contents.begin(), contents.end()),
+              ElementsAreArray(words));
+
+  std::vector<uint32_t> data;
+  ASSERT_TRUE(ReadBinaryFile(filename(), &data));
+  EXPECT_THAT(data, ElementsAreArray(words));
+}
+
+TEST_F(ReadFileTest, HexFile) {
+  const std::string hex = "0x07230203 0x00010000 0x00000000";
+  WriteBytes(hex.data(), hex.size());
+
+  FileContents<uint32_t> contents;
+  ASSERT_TRUE(ReadBinaryFile(filename(), &contents));
+  EXPECT_THAT(std::vector<uint32_t>(contents.begin(), contents.end()),
+              ElementsAre(0x07230203u, 0x00010000u, 0u));
+}
+
+TEST_F(ReadFileTest, UnalignedBinaryFile) {
+  const char bytes[] = {0x03, 0x02, 0x23, 0x07, 0x00, 0x01};
+  WriteBytes(bytes, sizeof(bytes));
+
+  FileContents<uint32_t> contents;
+  EXPECT_FALSE(ReadBinaryFile(filename(), &contents));
+}
+
+TEST_F(ReadFileTest, TextFile) {
+  const std::string text =
+      "OpCapability Shader\nOpMemoryModel Logical GLSL450\n";
+  WriteBytes(text.data(), text.size());
+
+  FileContents<char> contents;
+  ASSERT_TRUE(ReadTextFile(filename(), &contents));
+  EXPECT_EQ(text, std::string(contents.begin(), contents.end()));
+}
+
+TEST_F(ReadFileTest, EmptyTextFile) {
+  WriteBytes("", 0);
+
+  FileContents<char> contents;
+  ASSERT_TRUE(ReadTextFile(filename(), &contents));
+  EXPECT_TRUE(contents.empty());
+}
+
+TEST_F(ReadFileTest, MissingFile) {
+  FileContents<uint32_t> binary;
+  EXPECT_FALSE(ReadBinaryFile(filename(), &binary));
+  FileContents<char> text;
+  EXPECT_FALSE(ReadTextFile(filename(), &text));
+}
+
+}  // namespace
+}  // namespace spvtools
@@ -248,6 +248,187 @@ INSTANTIATE_TEST_SUITE_P(
         {"0x1.804p4", 0x00004e01},
     }));
 
+// Assembles |text| with spvTextToBinaryStream, reading at most |chunk_size|
+// characters at a time, and collects the binary into |binary|.
+spv_result_t AssembleStream(const std::string& text, size_t chunk_size,
+                            uint32_t options, std::vector<uint32_t>* binary,
+                            spv_diagnostic* diagnostic) {
+  struct Reader {
+    const std::string& text;
+    size_t chunk_size;
+    size_t index = 0;
+  } reader{text, chunk_size};
+  auto read = [](void* user_data, char* buffer, size_t size) {
+    auto* r = static_cast<Reader*>(user_data);
+    const size_t count =
+        std::min({size, r->chunk_size, r->text.size() - r->index});
+    memcpy(buffer, r->text.data() + r->index, count);
+    r->index += count;
+    return count;
+  };
+  // The instruction words must come in order, and the header last.
+  auto sink = [](void* user_data, size_t offset, const uint32_t* words,
+                 size_t count) {
+    auto* b = static_cast<std::vector<uint32_t>*>(user_data);
+    if (offset == 0) {
+      EXPECT_EQ(SPV_INDEX_INSTRUCTION, count);
+      std::copy(words, words + count, b->begin());
+      b->push_back(0);  // Marks that the header was passed.
+      return;
+    }
+    EXPECT_EQ(b->size(), offset);
+    b->insert(b->end(), words, words + count);
+  };
+
+  binary->assign(SPV_INDEX_INSTRUCTION, 0);
+  const spv_result_t result =
+      spvTextToBinaryStream(ScopedContext().context, read, &reader, options,
+                            sink, binary, diagnostic);
+  if (result == SPV_SUCCESS) {
+    EXPECT_EQ(0u, binary->back()) << "The header was not passed";
+    binary->pop_back();
+  }
+  return result;
+}
+
+// Returns a module of several thousand lines, with strings and comments which
+// contain text looking like instructions, and forward references.
+std::string LargeModule() {
+  std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "OpEntryPoint GLCompute %main \"main\"\n"
+      "OpSourceExtension \"a;b\n"
+      "OpName %main \\\"x\\\"\n"
+      "%x = OpTypeInt 32 0\"\n"
+      "OpSourceExtension \"\\\\\" ; OpName %main \"y\"\n"
+      "; %y = OpTypeInt 32 0\n"
+      "OpName %later \"later\"\n"
+      "%void = OpTypeVoid\n"
+      "%fn = OpTypeFunction %void\n"
+      "\t%uint = OpTypeInt 32 0\n"
+      "%7 = OpTypeFloat 32\n";
+  for (int i = 0; i < 2000; ++i) {
+    const std::string n = std::to_string(i);
+    text += "  %c" + n + " = OpConstant %uint " + n + "\n";
+    text += "OpName %c" + n + " \"c" + n + "\\\nOpNop\"  ; comment\n";
+  }
+  text +=
+      "%later = OpConstant %uint 7\n"
+      "%main = OpFunction %void None %fn\n"
+      "%entry = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd";
+  return text;
+}
+
+TEST(TextToBinaryStream, SameAsWholeText) {
+  const std::string text = LargeModule();
+  for (uint32_t options :
+       {uint32_t(SPV_TEXT_TO_BINARY_OPTION_NONE),
+        uint32_t(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS)}) {
+    spv_binary expected = nullptr;
+    ASSERT_EQ(SPV_SUCCESS,
+              spvTextToBinaryWithOptions(ScopedContext().context, text.data(),
+                                         text.size(), options, &expected,
+                                         nullptr));
+    for (size_t chunk_size : {1, 7, 64, 1 << 20}) {
+      std::vector<uint32_t> binary;
+      ASSERT_EQ(SPV_SUCCESS,
+                AssembleStream(text, chunk_size, options, &binary, nullptr));
+      EXPECT_THAT(binary, Eq(std::vector<uint32_t>(
+                              expected->code,
+                              expected->code + expected->wordCount)))
+          << "options " << options << ", chunks of " << chunk_size;
+    }
+    spvBinaryDestroy(expected);
+  }
+}
+
+TEST(TextToBinaryStream, EndsAtNullCharacter) {
+  const char kText[] = "OpCapability Shader\nOpNop\0OpNop\n";
+  const std::string text(kText, sizeof(kText) - 1);
+  spv_binary expected = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvTextToBinary(ScopedContext().context, text.data(), text.size(),
+                            &expected, nullptr));
+  std::vector<uint32_t> binary;
+  ASSERT_EQ(SPV_SUCCESS, AssembleStream(text, 3, SPV_TEXT_TO_BINARY_OPTION_NONE,
+                                        &binary, nullptr));
+  EXPECT_THAT(binary, Eq(std::vector<uint32_t>(
+                          expected->code,
+                          expected->code + expected->wordCount)));
+  spvBinaryDestroy(expected);
+}
+
+TEST(TextToBinaryStream, ErrorReportsPositionInWholeText) {
+  const std::string text = LargeModule() + "\n%bad = OpTypeInt 32 what\n";
+  spv_diagnostic expected = nullptr;
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_ERROR_INVALID_TEXT,
+            spvTextToBinary(ScopedContext().context, text.data(), text.size(),
+                            &binary, &expected));
+  ASSERT_THAT(expected, NotNull());
+
+  spv_diagnostic diagnostic = nullptr;
+  std::vector<uint32_t> words;
+  ASSERT_EQ(SPV_ERROR_INVALID_TEXT,
+            AssembleStream(text, 7, SPV_TEXT_TO_BINARY_OPTION_NONE, &words,
+                           &diagnostic));
+  ASSERT_THAT(diagnostic, NotNull());
+  EXPECT_THAT(diagnostic->error, Eq(std::string(expected->error)));
+  EXPECT_EQ(expected->position.line, diagnostic->position.line);
+  EXPECT_EQ(expected->position.column, diagnostic->position.column);
+  EXPECT_EQ(expected->position.index, diagnostic->position.index);
+  EXPECT_TRUE(diagnostic->isTextSource);
+  spvDiagnosticDestroy(diagnostic);
+  spvDiagnosticDestroy(expected);
+}
+
+TEST(TextToBinaryStream, HugeNumericIdsAreNotPreserved) {
+  const std::string text = "%a = OpTypeVoid\n%2147483648 = OpTypeBool\n";
+  spv_diagnostic diagnostic = nullptr;
+  std::vector<uint32_t> binary;
+  EXPECT_EQ(SPV_ERROR_INVALID_TEXT,
+            AssembleStream(text, 64,
+                           SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS,
+                           &binary, &diagnostic));
+  ASSERT_THAT(diagnostic, NotNull());
+  EXPECT_THAT(diagnostic->error,
+              Eq(std::string("Numeric ids of 2^31 or more cannot be preserved "
+                             "when the assembly text is streamed.")));
+  spvDiagnosticDestroy(diagnostic);
+}
+
+TEST(TextToBinaryStream, NullCallbacks) {
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            spvTextToBinaryStream(ScopedContext().context, nullptr, nullptr,
+                                  SPV_TEXT_TO_BINARY_OPTION_NONE, nullptr,
+                                  nullptr, nullptr));
+}
+
+TEST(TextToBinaryStream, CppInterface) {
+  const std::string text = LargeModule();
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> expected;
+  ASSERT_TRUE(tools.Assemble(text, &expected));
+
+  size_t index = 0;
+  std::vector<uint32_t> binary(SPV_INDEX_INSTRUCTION);
+  ASSERT_TRUE(tools.AssembleStream(
+      [&text, &index](char* buffer, size_t size) {
+        const size_t count = std::min<size_t>({size, 100, text.size() - index});
+        memcpy(buffer, text.data() + index, count);
+        index += count;
+        return count;
+      },
+      [&binary](size_t offset, const uint32_t* words, size_t count) {
+        if (offset + count > binary.size()) binary.resize(offset + count);
+        std::copy(words, words + count, binary.begin() + offset);
+      }));
+  EXPECT_THAT(binary, Eq(expected));
+}
+
 TEST(CreateContext, UniversalEnvironment) {
   auto c = spvContextCreate(SPV_ENV_UNIVERSAL_1_0);
   EXPECT_THAT(c, NotNull());
@@ -0,0 +1,136 @@
+# Copyright (c) 2026 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+
+import placeholder
+import expect
+
+from spirv_test_framework import inside_spirv_testsuite, SpirvTest
+
+
+def empty_main_assembly():
+  return """
+         OpCapability Shader
+         OpMemoryModel Logical GLSL450
+         OpEntryPoint Vertex %4 "main"
+         OpName %4 "main"
+    %2 = OpTypeVoid
+    %3 = OpTypeFunction %2
+    %4 = OpFunction %2 None %3
+    %5 = OpLabel
+         OpReturn
+         OpFunctionEnd"""
+
+
+def invalid_opcode_assembly():
+  # A module that fails to disassemble after its header.
+  return """
+         OpCapability Shader
+         !0x0001ffff"""
+
+
+class DisassembledFiles(SpirvTest):
+  """Mixin class for checking that each of expected_disassembly_filenames
+  holds a disassembled module."""
+
+  def check_disassembled_files(self, status):
+    for filename in self.expected_disassembly_filenames:
+      if not os.path.isfile(filename):
+        return False, 'Expected output file: ' + filename
+      with open(filename) as disassembly:
+        if 'OpFunctionEnd' not in disassembly.read():
+          return False, 'Expected a disassembled module in ' + filename
+    return True, ''
+
+
+@inside_spirv_testsuite('SpirvDisBatch')
+class TestBatchDisassemblesEachPair(expect.ReturnCodeIsZero,
+                                    expect.BatchSummary, DisassembledFiles):
+  """Tests that --batch disassembles each input into its output."""
+
+  shader1 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  shader2 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output1 = placeholder.TempFileName('output1.spvasm')
+  output2 = placeholder.TempFileName('output2.spvasm')
+  spirv_args = ['--batch', '-j', '2', shader1, output1, shader2, output2]
+  expected_batch_inputs = [shader1, shader2]
+  expected_failed_inputs = []
+  expected_disassembly_filenames = [output1, output2]
+
+
+@inside_spirv_testsuite('SpirvDisBatch')
+class TestBatchReportsFailuresInOrder(expect.ReturnCodeIsNonZero,
+                                      expect.BatchSummary,
+                                      expect.NoNamedOutputFiles,
+                                      DisassembledFiles):
+  """Tests that the summary lists the files in order, and that a file that
+  fails makes spirv-dis fail without leaving its output behind."""
+
+  shader1 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  invalid = placeholder.FileSPIRVShader(invalid_opcode_assembly(), '.spvasm')
+  shader2 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output1 = placeholder.TempFileName('output1.spvasm')
+  invalid_output = placeholder.TempFileName('invalid_output.spvasm')
+  output2 = placeholder.TempFileName('output2.spvasm')
+  batch_file = placeholder.FileShader(
+      '# A file that does not exist.\n'
+      'missing.spv missing_output.spvasm\n', '.txt')
+  spirv_args = [
+      '-j', '3', shader1, output1, invalid, invalid_output, shader2, output2,
+      '--batch-file', batch_file
+  ]
+  expected_batch_inputs = [shader1, invalid, shader2, 'missing.spv']
+  expected_failed_inputs = [invalid, 'missing.spv']
+  expected_output_filenames = [invalid_output]
+  expected_disassembly_filenames = [output1, output2]
+
+
+@inside_spirv_testsuite('SpirvDisBatch')
+class TestBatchKeepsExistingOutputOfFailedFile(expect.ReturnCodeIsNonZero,
+                                               expect.BatchSummary):
+  """Tests that an output file which existed before the run is not removed
+  when its input fails to disassemble."""
+
+  invalid = placeholder.FileSPIRVShader(invalid_opcode_assembly(), '.spvasm')
+  existing_output = placeholder.FileShader('existing', '.spvasm')
+  spirv_args = ['--batch', invalid, existing_output]
+  expected_batch_inputs = [invalid]
+  expected_failed_inputs = [invalid]
+  expected_kept_filenames = [existing_output]
+
+  def check_existing_output_kept(self, status):
+    for filename in self.expected_kept_filenames:
+      if not os.path.isfile(filename):
+        return False, 'The existing output file was removed: ' + filename
+    return True, ''
+
+
+@inside_spirv_testsuite('SpirvDisBatch')
+class TestBatchRejectsOutputFlag(expect.ErrorMessageSubstr):
+  """Tests that -o cannot be used with --batch."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spvasm')
+  spirv_args = ['--batch', shader, output, '-o', output]
+  expected_error_substr = '-o cannot be used in batch mode'
+
+
+@inside_spirv_testsuite('SpirvDisBatch')
+class TestBatchRejectsStandardOutput(expect.ErrorMessageSubstr):
+  """Tests that no job of a batch can write to standard output."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  spirv_args = ['--batch', shader, '-']
+  expected_error_substr = 'cannot be standard output'
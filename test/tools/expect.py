@@ -721,3 +721,37 @@ class ExecutedListOfPasses(SpirvTest):
             'Expected pass "%s" but found pass "%s"\n' % (expected, actual))
 
     return True, ''
+
+
+class BatchSummary(SpirvTest):
+  """Mixin class for checking the summary printed in batch mode.
+
+  To mix in this class, subclasses need to provide expected_batch_inputs as
+  the input files in the order of the jobs, and expected_failed_inputs as the
+  ones among them that fail.
+  """
+
+  def check_batch_summary(self, status):
+    lines = convert_to_unix_line_endings(status.stderr).splitlines()
+    failed = [
+        line[len('FAILED: '):] for line in lines if line.startswith('FAILED: ')
+    ]
+    if failed != list(self.expected_failed_inputs):
+      return False, ('Expected failed files {ex}, but found {ac}'.format(
+          ex=self.expected_failed_inputs, ac=failed))
+
+    # The messages of each file start with its name, in the order of the jobs.
+    order = [
+        self.expected_batch_inputs.index(line[:-1])
+        for line in lines
+        if line.endswith(':') and line[:-1] in self.expected_batch_inputs
+    ]
+    if order != sorted(order):
+      return False, 'The messages of the files are not in the order of the jobs'
+
+    summary = '{ok} of {total} files succeeded'.format(
+        ok=len(self.expected_batch_inputs) - len(self.expected_failed_inputs),
+        total=len(self.expected_batch_inputs))
+    if not lines or lines[-1] != summary:
+      return False, 'Expected the summary line: ' + summary
+    return True, ''
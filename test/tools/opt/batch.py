@@ -0,0 +1,110 @@
+# Copyright (c) 2026 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import placeholder
+import expect
+
+from spirv_test_framework import inside_spirv_testsuite
+
+
+def empty_main_assembly():
+  return """
+         OpCapability Shader
+         OpMemoryModel Logical GLSL450
+         OpEntryPoint Vertex %4 "main"
+         OpName %4 "main"
+    %2 = OpTypeVoid
+    %3 = OpTypeFunction %2
+    %4 = OpFunction %2 None %3
+    %5 = OpLabel
+         OpReturn
+         OpFunctionEnd"""
+
+
+@inside_spirv_testsuite('SpirvOptBatch')
+class TestBatchOptimizesEachPair(expect.ValidObjectFile1_6,
+                                 expect.BatchSummary):
+  """Tests that --batch optimizes each input into its output."""
+
+  shader1 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  shader2 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output1 = placeholder.TempFileName('output1.spv')
+  output2 = placeholder.TempFileName('output2.spv')
+  spirv_args = [
+      '--batch', '-O', '-j', '2', shader1, output1, shader2, output2
+  ]
+  expected_batch_inputs = [shader1, shader2]
+  expected_failed_inputs = []
+
+
+@inside_spirv_testsuite('SpirvOptBatch')
+class TestBatchReportsFailuresInOrder(expect.ReturnCodeIsNonZero,
+                                      expect.BatchSummary,
+                                      expect.NoNamedOutputFiles):
+  """Tests that the summary lists the files in order, and that a file that
+  fails makes spirv-opt fail without writing its output."""
+
+  shader1 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  invalid = placeholder.FileShader('not a SPIR-V binary', '.spv')
+  shader2 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output1 = placeholder.TempFileName('output1.spv')
+  invalid_output = placeholder.TempFileName('invalid_output.spv')
+  output2 = placeholder.TempFileName('output2.spv')
+  batch_file = placeholder.FileFlag(
+      '--batch-file=', '# A file that does not exist.\n'
+      'missing.spv missing_output.spv\n', '.txt')
+  spirv_args = [
+      '-j', '3', shader1, output1, invalid, invalid_output, shader2, output2,
+      batch_file
+  ]
+  expected_batch_inputs = [shader1, invalid, shader2, 'missing.spv']
+  expected_failed_inputs = [invalid, 'missing.spv']
+  expected_output_filenames = [invalid_output]
+
+
+@inside_spirv_testsuite('SpirvOptBatch')
+class TestBatchRejectsOutputFlag(expect.ErrorMessageSubstr):
+  """Tests that -o cannot be used with --batch."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spv')
+  spirv_args = ['--batch', shader, output, '-o', output]
+  expected_error_substr = '-o cannot be used in batch mode'
+
+
+@inside_spirv_testsuite('SpirvOptBatch')
+class TestBatchRejectsStandardOutput(expect.ErrorMessageSubstr):
+  """Tests that no job of a batch can write to standard output."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  spirv_args = ['--batch', shader, '-']
+  expected_error_substr = 'cannot be standard output'
+
+
+@inside_spirv_testsuite('SpirvOptBatch')
+class TestBatchRejectsProfileReport(expect.ErrorMessageSubstr,
+                                    expect.NoNamedOutputFiles):
+  """Tests that --profile-report, which writes one trace per run, cannot be
+  used with --batch, and that neither the profile nor the outputs are
+  written."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spv')
+  profile = placeholder.TempFileName('profile.json')
+  spirv_args = [
+      '--batch', '-j', '1', '--profile-report=profile.json', shader, output
+  ]
+  expected_error_substr = (
+      '--profile-report cannot be used in batch or server mode')
+  expected_output_filenames = [output, profile]
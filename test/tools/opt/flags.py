@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import json
 import placeholder
 import expect
 import re
@@ -141,7 +142,7 @@ class TestPerformanceOptimizationPasses(expect.ValidObjectFile1_6,
       'wrap-opkill',
       'eliminate-dead-branches',
       'merge-return',
-      'inline-entry-points-exhaustive',
+      'inline-cost-model',
       'eliminate-dead-functions',
       'eliminate-dead-code-aggressive',
       'private-to-local',
@@ -159,6 +160,7 @@ class TestPerformanceOptimizationPasses(expect.ValidObjectFile1_6,
       'eliminate-dead-code-aggressive',
       'loop-unroll',
       'eliminate-dead-branches',
+      'loop-invariant-code-motion-aggressive',
       'redundancy-elimination',
       'combine-access-chains',
       'simplify-instructions',
@@ -355,3 +357,94 @@ class TestLoopPeelingThresholdArgsInvalidNumber(expect.ErrorMessageSubstr):
 
   spirv_args = ['--loop-peeling-threshold=a10f']
   expected_error_substr = 'must have a positive integer argument'
+
+
+def counted_loop_assembly():
+  return """
+         OpCapability Shader
+         OpMemoryModel Logical GLSL450
+         OpEntryPoint Fragment %main "main" %out
+         OpExecutionMode %main OriginUpperLeft
+         OpDecorate %out Location 0
+ %void = OpTypeVoid
+   %fn = OpTypeFunction %void
+  %int = OpTypeInt 32 1
+ %bool = OpTypeBool
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_10 = OpConstant %int 10
+%_ptr_Output_int = OpTypePointer Output %int
+  %out = OpVariable %_ptr_Output_int Output
+ %main = OpFunction %void None %fn
+%entry = OpLabel
+         OpBranch %header
+%header = OpLabel
+    %i = OpPhi %int %int_0 %entry %next %continue
+  %sum = OpPhi %int %int_0 %entry %sum_next %continue
+ %cond = OpSLessThan %bool %i %int_10
+         OpLoopMerge %merge %continue None
+         OpBranchConditional %cond %body %merge
+ %body = OpLabel
+%sum_next = OpIAdd %int %sum %i
+         OpBranch %continue
+%continue = OpLabel
+ %next = OpIAdd %int %i %int_1
+         OpBranch %header
+%merge = OpLabel
+         OpStore %out %sum
+         OpReturn
+         OpFunctionEnd"""
+
+
+@inside_spirv_testsuite('SpirvOptFlags')
+class TestDecisionReportListsUnrollDecisions(expect.ValidObjectFile1_6,
+                                             expect.StderrMatch):
+  """Tests that --decision-report prints the unroll factor chosen for each
+  loop to stderr."""
+
+  shader = placeholder.FileSPIRVShader(counted_loop_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spv')
+  spirv_args = [
+      shader, '-o', output, '--loop-unroll-heuristic', '--decision-report'
+  ]
+  expected_object_filenames = (output)
+  expected_stderr = re.compile(
+      r'^loop-unroll-heuristic: Loop %\d+ \(10 iterations, \d+ instructions\):'
+      r' fully unrolled, estimated \d+ registers and \d+ instructions$',
+      re.MULTILINE)
+
+
+@inside_spirv_testsuite('SpirvOptFlags')
+class TestNoDecisionReportByDefault(expect.ValidObjectFile1_6,
+                                    expect.NoOutputOnStderr):
+  """Tests that the unroll decisions are not printed without
+  --decision-report."""
+
+  shader = placeholder.FileSPIRVShader(counted_loop_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spv')
+  spirv_args = [shader, '-o', output, '--loop-unroll-heuristic']
+  expected_object_filenames = (output)
+
+
+@inside_spirv_testsuite('SpirvOptFlags')
+class TestProfileReportIsValidJson(expect.ValidObjectFile1_6):
+  """Tests that --profile-report writes a single trace in the Chrome trace
+  event format."""
+
+  shader = placeholder.FileSPIRVShader(counted_loop_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spv')
+  profile = placeholder.TempFileName('profile.json')
+  spirv_args = [shader, '-o', output, '-O', '--profile-report=profile.json']
+  expected_object_filenames = (output)
+  expected_profile_filenames = [profile]
+
+  def check_profile_is_json(self, status):
+    for filename in self.expected_profile_filenames:
+      try:
+        with open(filename) as profile_file:
+          profile = json.load(profile_file)
+      except (OSError, ValueError) as error:
+        return False, 'Invalid profile {f}: {e}'.format(f=filename, e=error)
+      if not profile.get('traceEvents'):
+        return False, 'Expected trace events in ' + filename
+    return True, ''
@@ -116,6 +116,36 @@ class ConfigFlagsFile(PlaceHolder):
     return self.filename
 
 
+class FileFlag(PlaceHolder):
+  """Stands for a flag whose value is a file generated out of a string."""
+
+  def __init__(self, flag, content, suffix):
+    assert isinstance(flag, str)
+    assert isinstance(content, str)
+    assert isinstance(suffix, str)
+    self.flag = flag
+    self.content = content
+    self.suffix = suffix
+    self.filename = None
+
+  def instantiate_for_spirv_args(self, testcase):
+    """Creates a temporary file and writes content into it.
+
+        Returns:
+            The flag followed by the name of the temporary file.
+    """
+    temp_fd, self.filename = tempfile.mkstemp(
+        dir=testcase.directory, suffix=self.suffix)
+    fd = os.fdopen(temp_fd, 'w')
+    fd.write(self.content)
+    fd.close()
+    return self.flag + self.filename
+
+  def instantiate_for_expectation(self, testcase):
+    assert self.filename is not None
+    return self.filename
+
+
 class FileSPIRVShader(PlaceHolder):
   """Stands for a source shader file which must be converted to SPIR-V."""
 
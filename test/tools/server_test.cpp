@@ -0,0 +1,377 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/util/server.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::MatchesRegex;
+
+// Appends the request numbered |id| to |stream|, framed as the server reads
+// it.
+void AppendRequest(uint32_t id, const std::string& flags,
+                   const std::vector<uint32_t>& binary, std::string* stream) {
+  const uint32_t header[3] = {id, static_cast<uint32_t>(flags.size()),
+                              static_cast<uint32_t>(binary.size())};
+  stream->append(reinterpret_cast<const char*>(header), sizeof(header));
+  stream->append(flags);
+  stream->append(reinterpret_cast<const char*>(binary.data()),
+                 binary.size() * sizeof(uint32_t));
+}
+
+// Parses the responses in |stream|, and appends their ids to |ids| in the
+// order they were written.  Fails the test if |stream| is malformed.
+std::map<uint32_t, ServerResponse> ParseResponses(const std::string& stream,
+                                                  std::vector<uint32_t>* ids) {
+  std::map<uint32_t, ServerResponse> responses;
+  size_t offset = 0;
+  while (offset < stream.size()) {
+    uint32_t header[4];
+    if (stream.size() - offset < sizeof(header)) {
+      ADD_FAILURE() << "Truncated response header";
+      break;
+    }
+    memcpy(header, stream.data() + offset, sizeof(header));
+    offset += sizeof(header);
+    const size_t binary_bytes = header[3] * sizeof(uint32_t);
+    if (stream.size() - offset < header[2] + binary_bytes) {
+      ADD_FAILURE() << "Truncated response " << header[0];
+      break;
+    }
+
+    ServerResponse& response = responses[header[0]];
+    ids->push_back(header[0]);
+    response.succeeded = header[1] == 0;
+    response.messages = stream.substr(offset, header[2]);
+    offset += header[2];
+    response.binary.resize(header[3]);
+    memcpy(response.binary.data(), stream.data() + offset, binary_bytes);
+    offset += binary_bytes;
+  }
+  return responses;
+}
+
+// Answers each request with its own binary and a message listing its flags.
+// The flag "--fail" makes the request fail.  A request with the flag "--wait"
+// blocks until a request without it is handled, so a server that does not
+// handle requests concurrently hangs.
+class EchoHandler {
+ public:
+  void operator()(size_t, const ServerRequest& request,
+                  ServerResponse* response) {
+    bool wait = false;
+    response->succeeded = true;
+    for (const std::string& flag : request.flags) {
+      response->messages += flag + "\n";
+      if (flag == "--wait") wait = true;
+      if (flag == "--fail") response->succeeded = false;
+    }
+    response->binary = request.binary;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wait) {
+      released_.wait(lock, [this] { return released_once_; });
+    } else {
+      released_once_ = true;
+      released_.notify_all();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable released_;
+  bool released_once_ = false;
+};
+
+// Runs the server on standard input and output, with |input| as the input.
+// Returns what the server wrote, and sets |status| to its exit code.
+std::string RunStdioServer(const std::string& input, size_t num_workers,
+                           const ServerHandler& handler, int* status) {
+  FILE* in = tmpfile();
+  FILE* out = tmpfile();
+  EXPECT_NE(in, nullptr);
+  EXPECT_NE(out, nullptr);
+  if (!in || !out) return "";
+  fwrite(input.data(), 1, input.size(), in);
+  fflush(in);
+  rewind(in);
+
+  fflush(stdout);
+  const int saved_stdin = dup(fileno(stdin));
+  const int saved_stdout = dup(fileno(stdout));
+  dup2(fileno(in), fileno(stdin));
+  dup2(fileno(out), fileno(stdout));
+  clearerr(stdin);
+
+  *status = RunServer("", num_workers, handler);
+
+  // Drops the requests the server did not read, so that they are not left in
+  // the buffer of stdin for the next test.
+  while (fgetc(stdin) != EOF) {
+  }
+  fflush(stdout);
+  dup2(saved_stdin, fileno(stdin));
+  dup2(saved_stdout, fileno(stdout));
+  close(saved_stdin);
+  close(saved_stdout);
+  clearerr(stdin);
+
+  std::string output;
+  rewind(out);
+  char buffer[4096];
+  for (size_t len; (len = fread(buffer, 1, sizeof(buffer), out)) > 0;) {
+    output.append(buffer, len);
+  }
+  fclose(in);
+  fclose(out);
+  return output;
+}
+
+TEST(ServerTest, StdioAnswersEveryRequestAndReportsLatency) {
+  std::string input;
+  // The ids are chosen by the client, and need not be in order.
+  AppendRequest(9, "--wait", {1, 2, 3}, &input);
+  AppendRequest(2, "-O --fail", {4}, &input);
+  AppendRequest(5, "--shutdown", {}, &input);
+  // Requests after the shutdown are not read.
+  AppendRequest(4, "-O", {5}, &input);
+
+  EchoHandler handler;
+  int status = -1;
+  testing::internal::CaptureStderr();
+  const std::string output = RunStdioServer(
+      input, 2,
+      [&handler](size_t worker, const ServerRequest& request,
+                 ServerResponse* response) {
+        handler(worker, request, response);
+      },
+      &status);
+  const std::string errors = testing::internal::GetCapturedStderr();
+  EXPECT_EQ(status, 0);
+
+  std::vector<uint32_t> ids;
+  const auto responses = ParseResponses(output, &ids);
+  // Each request is answered once, in whatever order the workers finish.
+  EXPECT_THAT(ids, testing::UnorderedElementsAre(9, 2, 5));
+  ASSERT_EQ(responses.size(), 3u);
+  EXPECT_TRUE(responses.at(9).succeeded);
+  EXPECT_EQ(responses.at(9).messages, "--wait\n");
+  EXPECT_THAT(responses.at(9).binary, testing::ElementsAre(1, 2, 3));
+  EXPECT_FALSE(responses.at(2).succeeded);
+  EXPECT_EQ(responses.at(2).messages, "-O\n--fail\n");
+  EXPECT_THAT(responses.at(2).binary, testing::ElementsAre(4));
+  EXPECT_TRUE(responses.at(5).succeeded);
+  EXPECT_EQ(responses.at(5).messages, "");
+  EXPECT_EQ(responses.count(4), 0u);
+
+  EXPECT_THAT(errors, MatchesRegex("2 requests served, latency in ms: "
+                                   "p50 [0-9.]+, p90 [0-9.]+, p99 [0-9.]+, "
+                                   "max [0-9.]+\n"));
+}
+
+TEST(ServerTest, StdioStopsAtTheEndOfTheInput) {
+  int status = -1;
+  testing::internal::CaptureStderr();
+  const std::string output = RunStdioServer(
+      "", 1, [](size_t, const ServerRequest&, ServerResponse*) {}, &status);
+  EXPECT_EQ(testing::internal::GetCapturedStderr(), "0 requests served\n");
+  EXPECT_EQ(status, 0);
+  EXPECT_EQ(output, "");
+}
+
+// Returns a socket address for |path|.
+sockaddr_un SocketAddress(const std::string& path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  EXPECT_LT(path.size(), sizeof(address.sun_path));
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  return address;
+}
+
+// Connects to the server on |path|, retrying while it starts.  Returns the
+// socket, or -1.
+int Connect(const std::string& path) {
+  const sockaddr_un address = SocketAddress(path);
+  for (int attempt = 0; attempt < 500; ++attempt) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) == 0) {
+      return fd;
+    }
+    close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return -1;
+}
+
+// Sends the request numbered |id| on |fd| and returns the response.
+ServerResponse Call(int fd, uint32_t id, const std::string& flags,
+                    const std::vector<uint32_t>& binary) {
+  std::string request;
+  AppendRequest(id, flags, binary, &request);
+  EXPECT_EQ(write(fd, request.data(), request.size()),
+            static_cast<ssize_t>(request.size()));
+
+  // Reads until the response is complete.
+  std::string stream;
+  char buffer[4096];
+  for (;;) {
+    if (stream.size() >= 4 * sizeof(uint32_t)) {
+      uint32_t header[4];
+      memcpy(header, stream.data(), sizeof(header));
+      if (stream.size() >=
+          sizeof(header) + header[2] + header[3] * sizeof(uint32_t)) {
+        break;
+      }
+    }
+    const ssize_t len = read(fd, buffer, sizeof(buffer));
+    if (len <= 0) {
+      ADD_FAILURE() << "The server closed the connection";
+      return ServerResponse();
+    }
+    stream.append(buffer, static_cast<size_t>(len));
+  }
+
+  std::vector<uint32_t> ids;
+  auto responses = ParseResponses(stream, &ids);
+  EXPECT_THAT(ids, testing::ElementsAre(id));
+  return responses[id];
+}
+
+TEST(ServerTest, SocketReplacesStaleSocketFile) {
+  const std::string path = testing::TempDir() + "spirv_server_test_stale";
+  unlink(path.c_str());
+
+  // Leaves a socket file behind with nobody listening on it, like a server
+  // that was killed.
+  const sockaddr_un address = SocketAddress(path);
+  const int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(stale, 0);
+  ASSERT_EQ(bind(stale, reinterpret_cast<const sockaddr*>(&address),
+                 sizeof(address)),
+            0);
+  close(stale);
+  ASSERT_EQ(access(path.c_str(), F_OK), 0);
+
+  EchoHandler handler;
+  int status = -1;
+  testing::internal::CaptureStderr();
+  std::thread server([&] {
+    status = RunServer(path, 2,
+                       [&handler](size_t worker, const ServerRequest& request,
+                                  ServerResponse* response) {
+                         handler(worker, request, response);
+                       });
+  });
+
+  const int client = Connect(path);
+  if (client >= 0) {
+    const ServerResponse response = Call(client, 7, "-O", {8, 9});
+    EXPECT_TRUE(response.succeeded);
+    EXPECT_EQ(response.messages, "-O\n");
+    EXPECT_THAT(response.binary, testing::ElementsAre(8, 9));
+    EXPECT_TRUE(Call(client, 8, "--shutdown", {}).succeeded);
+    close(client);
+  } else {
+    ADD_FAILURE() << "Could not connect to the server";
+    // Stops the server from a second client if it runs after all.
+    const int fd = Connect(path);
+    if (fd >= 0) {
+      Call(fd, 0, "--shutdown", {});
+      close(fd);
+    }
+  }
+  server.join();
+  const std::string errors = testing::internal::GetCapturedStderr();
+
+  EXPECT_EQ(status, 0);
+  EXPECT_THAT(errors, HasSubstr("1 requests served"));
+  EXPECT_NE(access(path.c_str(), F_OK), 0);
+}
+
+TEST(ServerTest, SocketInUseIsReported) {
+  const std::string path = testing::TempDir() + "spirv_server_test_in_use";
+  unlink(path.c_str());
+
+  const sockaddr_un address = SocketAddress(path);
+  const int other = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(other, 0);
+  ASSERT_EQ(bind(other, reinterpret_cast<const sockaddr*>(&address),
+                 sizeof(address)),
+            0);
+  ASSERT_EQ(listen(other, 1), 0);
+
+  testing::internal::CaptureStderr();
+  const int status = RunServer(
+      path, 1, [](size_t, const ServerRequest&, ServerResponse*) {});
+  EXPECT_THAT(testing::internal::GetCapturedStderr(),
+              HasSubstr("another server is listening on '" + path + "'"));
+  EXPECT_EQ(status, 1);
+  // The socket of the other server is left alone.
+  EXPECT_EQ(access(path.c_str(), F_OK), 0);
+
+  close(other);
+  unlink(path.c_str());
+}
+
+TEST(ServerTest, SocketPathOfRegularFileIsKept) {
+  const std::string path = testing::TempDir() + "spirv_server_test_file";
+  FILE* file = fopen(path.c_str(), "w");
+  ASSERT_NE(file, nullptr);
+  fputs("not a socket", file);
+  fclose(file);
+
+  testing::internal::CaptureStderr();
+  const int status = RunServer(
+      path, 1, [](size_t, const ServerRequest&, ServerResponse*) {});
+  EXPECT_THAT(testing::internal::GetCapturedStderr(),
+              HasSubstr("'" + path + "' exists and is not a socket"));
+  EXPECT_EQ(status, 1);
+
+  // The file is neither removed nor changed.
+  file = fopen(path.c_str(), "r");
+  ASSERT_NE(file, nullptr);
+  char contents[32] = {};
+  fread(contents, 1, sizeof(contents) - 1, file);
+  fclose(file);
+  EXPECT_STREQ(contents, "not a socket");
+  unlink(path.c_str());
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
+
+#endif
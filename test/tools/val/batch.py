@@ -0,0 +1,68 @@
+# Copyright (c) 2026 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import placeholder
+import expect
+
+from spirv_test_framework import inside_spirv_testsuite
+
+
+def empty_main_assembly():
+  return """
+         OpCapability Shader
+         OpMemoryModel Logical GLSL450
+         OpEntryPoint Vertex %4 "main"
+         OpName %4 "main"
+    %2 = OpTypeVoid
+    %3 = OpTypeFunction %2
+    %4 = OpFunction %2 None %3
+    %5 = OpLabel
+         OpReturn
+         OpFunctionEnd"""
+
+
+def missing_memory_model_assembly():
+  return """
+         OpCapability Shader"""
+
+
+@inside_spirv_testsuite('SpirvValBatch')
+class TestBatchValidatesEachFile(expect.ReturnCodeIsZero, expect.BatchSummary):
+  """Tests that --batch validates each input."""
+
+  shader1 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  shader2 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  spirv_args = ['--batch', '-j', '2', shader1, shader2]
+  expected_batch_inputs = [shader1, shader2]
+  expected_failed_inputs = []
+
+
+@inside_spirv_testsuite('SpirvValBatch')
+class TestBatchReportsFailuresInOrder(expect.ReturnCodeIsNonZero,
+                                      expect.BatchSummary):
+  """Tests that the summary lists the files in order, and that a file that
+  fails makes spirv-val fail."""
+
+  shader1 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  invalid = placeholder.FileSPIRVShader(missing_memory_model_assembly(),
+                                        '.spvasm')
+  shader2 = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  batch_file = placeholder.FileShader(
+      '# A file that does not exist.\n'
+      'missing.spv\n', '.txt')
+  spirv_args = [
+      '-j', '3', shader1, invalid, shader2, '--batch-file', batch_file
+  ]
+  expected_batch_inputs = [shader1, invalid, shader2, 'missing.spv']
+  expected_failed_inputs = [invalid, 'missing.spv']
@@ -184,6 +184,16 @@ TEST_F(ValidationStateTest, CheckEntryPoints) {
             vstate_->FindDef(vstate_->entry_points()[0])->opcode());
 }
 
+TEST_F(ValidationStateTest, KeptStateNamesIdsAfterTheContextIsGone) {
+  // The context used for validation is destroyed before the friendly names
+  // are first asked for.
+  std::string spirv =
+      std::string(kHeader) + " OpName %func \"main\"" + std::string(kVoidFVoid);
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+  EXPECT_EQ("'1[%main]'", vstate_->getIdName(1));
+}
+
 TEST_F(ValidationStateTest, CheckStructMemberLimitOption) {
   spvValidatorOptionsSetUniversalLimit(
       options_, spv_validator_limit_max_struct_members, 32000u);
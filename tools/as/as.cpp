@@ -90,13 +90,14 @@ int main(int, const char** argv) {
   }
   std::string inFile = flags::positional_arguments[0];
 
-  std::vector<char> contents;
+  FileContents<char> contents;
   if (!ReadTextFile(inFile.c_str(), &contents)) return 1;
 
   // Can only deduce target after the file has been read
   spv_target_env target_env;
   if (flags::target_env.value().empty()) {
-    if (!spvReadEnvironmentFromText(contents, &target_env)) {
+    if (!spvReadEnvironmentFromText(contents.data(), contents.size(),
+                                    &target_env)) {
       // Revert to default version since deduction failed
       target_env = kDefaultTarget;
     }
@@ -19,19 +19,25 @@
 
 #include <cstdio>
 #include <cstring>
+#include <filesystem>
 #include <string>
+#include <system_error>
 #include <vector>
 
 #include "spirv-tools/libspirv.h"
 #include "tools/io.h"
+#include "tools/util/batch.h"
 #include "tools/util/flags.h"
 
 static const std::string kHelpText = R"(%s - Disassemble a SPIR-V binary module
 
 Usage: %s [options] [<filename>]
+       %s [options] --batch [<filename> <output>]...
 
 The SPIR-V binary is read from <filename>. If no file is specified,
 or if the filename is "-", then the binary is read from standard input.
+With --batch, each <filename> is disassembled into the <output> that
+follows it.
 
 A text-based hex stream is also accepted as binary input, which should either
 consist of 32-bit words or 8-bit bytes.  The 0x or x prefix is optional, but
@@ -68,6 +74,21 @@ Options:
   --offsets         Show byte offsets for each instruction.
 
   --comment         Add comments to make reading easier
+
+  --parallel        Disassemble function bodies on multiple threads.  The
+                    output is the same as without this option.
+
+  --batch           Disassemble several files on worker threads, and print a
+                    summary of the messages and status of each file at the
+                    end.  Output is never colored in batch mode.
+
+  --batch-file <filename>
+                    Implies --batch, and reads additional pairs of input and
+                    output files from <filename>, one pair per line.  Empty
+                    lines and lines starting with '#' are ignored.
+
+  -j <n>            Use <n> worker threads in batch mode.  Defaults to the
+                    number of hardware threads.
 )";
 
 // clang-format off
@@ -84,17 +105,135 @@ FLAG_LONG_bool   (nested_indent,  /* default_value= */ false, /* required= */ fa
 FLAG_LONG_bool   (reorder_blocks, /* default_value= */ false, /* required= */ false);
 FLAG_LONG_bool   (offsets,        /* default_value= */ false, /* required= */ false);
 FLAG_LONG_bool   (comment,        /* default_value= */ false, /* required= */ false);
+FLAG_LONG_bool   (parallel,       /* default_value= */ false, /* required= */ false);
+FLAG_LONG_bool   (batch,          /* default_value= */ false, /* required= */ false);
+FLAG_LONG_string (batch_file,     /* default_value= */ "",    /* required= */ false);
+FLAG_SHORT_uint  (j,              /* default_value= */ 0,     /* required= */ false);
 // clang-format on
 
 static const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_5;
 
+namespace {
+
+// Writes the disassembly to a file as it is produced. The file is created
+// with the first piece of text, so that a binary failing to disassemble
+// early leaves no output behind.
+class OutputSink {
+ public:
+  explicit OutputSink(const char* filename) : filename_(filename) {}
+  ~OutputSink() {
+    if (file_) fclose(file_);
+  }
+
+  // Appends |length| characters of |text| to the file. Matches
+  // spv_text_sink_fn, with the sink as |user_data|.
+  static void Write(void* user_data, const char* text, size_t length) {
+    auto* sink = static_cast<OutputSink*>(user_data);
+    if (sink->failed_ || !sink->Open()) return;
+    if (fwrite(text, 1, length, sink->file_) != length) {
+      fprintf(stderr, "error: could not write to file '%s'\n",
+              sink->filename_);
+      sink->failed_ = true;
+    }
+  }
+
+  // Closes the file, creating it if no text was written. Returns false if
+  // writing failed.
+  bool Close() {
+    if (failed_ || !Open()) return false;
+    const bool closed = fclose(file_) == 0;
+    file_ = nullptr;
+    if (!closed) {
+      fprintf(stderr, "error: could not write to file '%s'\n", filename_);
+    }
+    return closed;
+  }
+
+  // Removes the partially written file, if this sink created it.  A file
+  // that existed before is left truncated rather than removed.
+  void Discard() {
+    if (!file_) return;
+    fclose(file_);
+    file_ = nullptr;
+    if (created_) remove(filename_);
+  }
+
+ private:
+  // Opens the file if it is not open yet. Returns false on failure.
+  bool Open() {
+    if (file_) return true;
+    std::error_code error;
+    created_ = !std::filesystem::exists(filename_, error);
+    file_ = fopen(filename_, "w");
+    if (!file_) {
+      fprintf(stderr, "error: could not open file '%s'\n", filename_);
+      failed_ = true;
+    }
+    return file_ != nullptr;
+  }
+
+  const char* filename_;
+  FILE* file_ = nullptr;
+  bool failed_ = false;
+  // Whether the file did not exist before the sink opened it.
+  bool created_ = false;
+};
+
+// Disassembles each pair of input and output files given on the command line
+// with |options|.  Returns the exit code.
+int DisassembleBatch(uint32_t options) {
+  std::vector<spvtools::utils::BatchJob> jobs;
+  if (!spvtools::utils::AddBatchJobs(flags::positional_arguments, true,
+                                     &jobs)) {
+    return 1;
+  }
+  const std::string& batch_file = flags::batch_file.value();
+  if (!batch_file.empty() &&
+      !spvtools::utils::ReadBatchFile(batch_file.c_str(), true, &jobs)) {
+    return 1;
+  }
+  const size_t num_workers = flags::j.value()
+                                 ? flags::j.value()
+                                 : spvtools::utils::DefaultBatchWorkers();
+
+  // A context only holds immutable grammar tables, so the workers share it.
+  spv_context context = spvContextCreate(kDefaultEnvironment);
+  const bool succeeded = spvtools::utils::RunBatch(
+      jobs, num_workers,
+      [context, options](size_t, const spvtools::utils::BatchJob& job,
+                         std::string* log) {
+        FileContents<uint32_t> contents;
+        if (!ReadBinaryFile(job.input.c_str(), &contents)) return false;
+
+        OutputSink sink(job.output.c_str());
+        spv_diagnostic diagnostic = nullptr;
+        spv_result_t error = spvBinaryToTextWithSink(
+            context, contents.data(), contents.size(), options,
+            OutputSink::Write, &sink, &diagnostic);
+        if (error) {
+          sink.Discard();
+          if (diagnostic) {
+            *log += "error: " + std::to_string(diagnostic->position.index) +
+                    ": " + diagnostic->error + "\n";
+          }
+          spvDiagnosticDestroy(diagnostic);
+          return false;
+        }
+        return sink.Close();
+      });
+  spvContextDestroy(context);
+  return succeeded ? 0 : 1;
+}
+
+}  // namespace
+
 int main(int, const char** argv) {
   if (!flags::Parse(argv)) {
     return 1;
   }
 
   if (flags::h.value() || flags::help.value()) {
-    printf(kHelpText.c_str(), argv[0], argv[0]);
+    printf(kHelpText.c_str(), argv[0], argv[0], argv[0]);
     return 0;
   }
 
@@ -104,7 +243,13 @@ int main(int, const char** argv) {
     return 0;
   }
 
-  if (flags::positional_arguments.size() > 1) {
+  const bool batch = flags::batch.value() || !flags::batch_file.value().empty();
+  if (batch && flags::o.value() != "-") {
+    fprintf(stderr, "error: -o cannot be used in batch mode.\n");
+    return 1;
+  }
+
+  if (!batch && flags::positional_arguments.size() > 1) {
     fprintf(stderr, "error: more than one input file specified.\n");
     return 1;
   }
@@ -141,6 +286,10 @@ int main(int, const char** argv) {
 
   if (flags::comment.value()) options |= SPV_BINARY_TO_TEXT_OPTION_COMMENT;
 
+  if (flags::parallel.value()) options |= SPV_BINARY_TO_TEXT_OPTION_PARALLEL;
+
+  if (batch) return DisassembleBatch(options);
+
   if (flags::o.value() == "-") {
     // Print to standard output.
     options |= SPV_BINARY_TO_TEXT_OPTION_PRINT;
@@ -156,7 +305,7 @@ int main(int, const char** argv) {
   }
 
   // Read the input binary.
-  std::vector<uint32_t> contents;
+  FileContents<uint32_t> contents;
   if (!ReadBinaryFile(inFile.c_str(), &contents)) return 1;
 
   // If printing to standard output, then spvBinaryToText should
@@ -164,30 +313,28 @@ int main(int, const char** argv) {
   // controlled by modifying console objects synchronously while
   // outputting to the stream rather than by injecting escape codes
   // into the output stream.
-  // If the printing option is off, then save the text in memory, so
-  // it can be emitted later in this function.
+  // Otherwise, the text is written to the output file as it is produced,
+  // so large modules are never held in memory as text.
   const bool print_to_stdout = SPV_BINARY_TO_TEXT_OPTION_PRINT & options;
-  spv_text text = nullptr;
-  spv_text* textOrNull = print_to_stdout ? nullptr : &text;
+  OutputSink sink(outFile.c_str());
   spv_diagnostic diagnostic = nullptr;
   spv_context context = spvContextCreate(kDefaultEnvironment);
   spv_result_t error =
-      spvBinaryToText(context, contents.data(), contents.size(), options,
-                      textOrNull, &diagnostic);
+      print_to_stdout
+          ? spvBinaryToText(context, contents.data(), contents.size(), options,
+                            nullptr, &diagnostic)
+          : spvBinaryToTextWithSink(context, contents.data(), contents.size(),
+                                    options, OutputSink::Write, &sink,
+                                    &diagnostic);
   spvContextDestroy(context);
   if (error) {
+    sink.Discard();
     spvDiagnosticPrint(diagnostic);
     spvDiagnosticDestroy(diagnostic);
     return error;
   }
 
-  if (!print_to_stdout) {
-    if (!WriteFile<char>(outFile.c_str(), "w", text->str, text->length)) {
-      spvTextDestroy(text);
-      return 1;
-    }
-  }
-  spvTextDestroy(text);
+  if (!print_to_stdout && !sink.Close()) return 1;
 
   return 0;
 }
@@ -18,6 +18,16 @@
 #include <ctype.h>
 #include <stdlib.h>
 
+#include <algorithm>
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SPIRV_TOOLS_MAP_FILES
+#endif
+
 #if defined(SPIRV_WINDOWS)
 #include <fcntl.h>
 #include <io.h>
@@ -42,13 +52,46 @@ template <typename T>
 void ReadFile(FILE* file, std::vector<T>* data) {
   if (file == nullptr) return;
 
-  const int buf_size = 4096 / sizeof(T);
-  T buf[buf_size];
-  while (size_t len = fread(buf, sizeof(T), buf_size, file)) {
-    data->insert(data->end(), buf, buf + len);
+  // Read straight into |data|, growing it geometrically.
+  size_t size = data->size();
+  data->resize(std::max(2 * size, 4096 / sizeof(T)));
+  while (size_t len =
+             fread(data->data() + size, sizeof(T), data->size() - size, file)) {
+    size += len;
+    if (size == data->size()) data->resize(2 * size);
   }
+  data->resize(size);
 }
 
+#if defined(SPIRV_TOOLS_MAP_FILES)
+// Maps the file named |filename| into memory and sets |size| to its size in
+// bytes.  Returns null if that is not possible, for example because the file
+// is not a regular file or is empty, in which case it has to be read.
+std::shared_ptr<const char> MapFile(const char* filename, size_t* size) {
+  if (!filename || !strcmp("-", filename)) return nullptr;
+
+  const int fd = open(filename, O_RDONLY);
+  if (fd == -1) return nullptr;
+  struct stat info;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    *size = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  if (mapping == MAP_FAILED) return nullptr;
+
+  const size_t mapped_size = *size;
+  return std::shared_ptr<const char>(
+      static_cast<const char*>(mapping), [mapped_size](const char* address) {
+        munmap(const_cast<char*>(address), mapped_size);
+      });
+}
+#else
+std::shared_ptr<const char> MapFile(const char*, size_t*) { return nullptr; }
+#endif
+
 // Returns true if |file| has encountered an error opening the file or reading
 // from it. If there was an error, writes an error message to standard error.
 bool WasFileCorrectlyRead(FILE* file, const char* filename) {
@@ -98,8 +141,9 @@ enum class HexMode {
 // end-of-file.
 bool IsSpace(char c) { return isspace(c) || c == ',' || c == '\0'; }
 
-bool IsHexStream(const std::vector<char>& stream) {
-  for (char c : stream) {
+bool IsHexStream(const char* stream, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    const char c = stream[i];
     if (IsSpace(c)) {
       continue;
     }
@@ -126,14 +170,14 @@ bool MatchIgnoreCase(const char* token, const char* expect, size_t len) {
 // Helper class to tokenize a hex stream
 class HexTokenizer {
  public:
-  HexTokenizer(const char* filename, const std::vector<char>& stream,
+  HexTokenizer(const char* filename, const char* stream, size_t size,
                std::vector<uint32_t>* data)
-      : filename_(filename), stream_(stream), data_(data) {
+      : filename_(filename), stream_(stream), size_(size), data_(data) {
     DetermineMode();
   }
 
   bool Parse() {
-    while (current_ < stream_.size() && !encountered_error_) {
+    while (current_ < size_ && !encountered_error_) {
       data_->push_back(GetNextWord());
 
       // Make sure trailing space does not lead to parse error by skipping it
@@ -156,7 +200,7 @@ class HexTokenizer {
 
   // Skip whitespace until the next non-whitespace non-comma character.
   void SkipSpace() {
-    while (current_ < stream_.size()) {
+    while (current_ < size_) {
       char c = stream_[current_];
       if (!IsSpace(c)) {
         return;
@@ -181,7 +225,7 @@ class HexTokenizer {
   }
 
   // Consume the next character.
-  char Next() { return current_ < stream_.size() ? stream_[current_++] : '\0'; }
+  char Next() { return current_ < size_ ? stream_[current_++] : '\0'; }
 
   // Determine how to read the hex stream based on the first token.
   void DetermineMode() {
@@ -340,13 +384,31 @@ class HexTokenizer {
   }
 
   const char* filename_;
-  const std::vector<char>& stream_;
+  const char* stream_;
+  const size_t size_;
   std::vector<uint32_t>* data_;
 
   HexMode mode_ = HexMode::Words;
   size_t current_ = 0;
   bool encountered_error_ = false;
 };
+
+// Sets |data| to the binary in the |size| bytes at |bytes|, which are either
+// a hex stream or the words of the binary.  Returns false in case of errors.
+bool ConvertToBinary(const char* filename, const char* bytes, size_t size,
+                     std::vector<uint32_t>* data) {
+  if (IsHexStream(bytes, size)) {
+    // If a hex stream, parse it and fill |data|.
+    HexTokenizer tokenizer(filename, bytes, size, data);
+    return tokenizer.Parse();
+  }
+
+  // If not a hex stream, convert it to uint32_t via memcpy.
+  if (!WasFileSizeAligned(filename, size, sizeof(uint32_t))) return false;
+  data->resize(size / sizeof(uint32_t), 0);
+  memcpy(data->data(), bytes, size);
+  return true;
+}
 }  // namespace
 
 bool ReadBinaryFile(const char* filename, std::vector<uint32_t>* data) {
@@ -372,25 +434,32 @@ bool ReadBinaryFile(const char* filename, std::vector<uint32_t>* data) {
     return false;
   }
 
-  if (IsHexStream(data_raw)) {
-    // If a hex stream, parse it and fill |data|.
-    HexTokenizer tokenizer(filename, data_raw, data);
-    succeeded = tokenizer.Parse();
-  } else {
-    // If not a hex stream, convert it to uint32_t via memcpy.
-    succeeded = WasFileSizeAligned(filename, data_raw.size(), sizeof(uint32_t));
-    if (succeeded) {
-      data->resize(data_raw.size() / sizeof(uint32_t), 0);
-      memcpy(data->data(), data_raw.data(), data_raw.size());
-    }
+  return ConvertToBinary(filename, data_raw.data(), data_raw.size(), data);
+}
+
+bool ReadBinaryFile(const char* filename, FileContents<uint32_t>* contents) {
+  size_t size = 0;
+  std::shared_ptr<const char> mapping = MapFile(filename, &size);
+  if (mapping && !IsHexStream(mapping.get(), size)) {
+    if (!WasFileSizeAligned(filename, size, sizeof(uint32_t))) return false;
+    // The mapping is page-aligned, so the words can be used in place.
+    *contents = FileContents<uint32_t>(
+        mapping, reinterpret_cast<const uint32_t*>(mapping.get()),
+        size / sizeof(uint32_t));
+    return true;
   }
 
+  std::vector<uint32_t> data;
+  const bool succeeded =
+      mapping ? ConvertToBinary(filename, mapping.get(), size, &data)
+              : ReadBinaryFile(filename, &data);
+  if (succeeded) *contents = FileContents<uint32_t>(std::move(data));
   return succeeded;
 }
 
 bool ConvertHexToBinary(const std::vector<char>& stream,
                         std::vector<uint32_t>* data) {
-  HexTokenizer tokenizer("<input string>", stream, data);
+  HexTokenizer tokenizer("<input string>", stream.data(), stream.size(), data);
   return tokenizer.Parse();
 }
 
@@ -412,6 +481,20 @@ bool ReadTextFile(const char* filename, std::vector<char>* data) {
   return succeeded;
 }
 
+bool ReadTextFile(const char* filename, FileContents<char>* contents) {
+  size_t size = 0;
+  if (std::shared_ptr<const char> mapping = MapFile(filename, &size)) {
+    const char* text = mapping.get();
+    *contents = FileContents<char>(std::move(mapping), text, size);
+    return true;
+  }
+
+  std::vector<char> data;
+  if (!ReadTextFile(filename, &data)) return false;
+  *contents = FileContents<char>(std::move(data));
+  return true;
+}
+
 namespace {
 // A class to create and manage a file for outputting data.
 class OutputFile {
@@ -430,6 +513,8 @@ class OutputFile {
       fp_ = stdout;
     } else {
       fp_ = fopen(filename, mode);
+      // The data is written at once, so buffering would only copy it.
+      if (fp_) setvbuf(fp_, nullptr, _IONBF, 0);
     }
   }
 
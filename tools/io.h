@@ -18,8 +18,40 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include <utility>
 #include <vector>
 
+// The contents of an input file, as an array of elements of type |T|.  The
+// contents either refer to a memory-mapped file or own a buffer the file was
+// read into.  Copies share the same memory.
+template <typename T>
+class FileContents {
+ public:
+  FileContents() = default;
+  // Takes ownership of |buffer|.
+  explicit FileContents(std::vector<T>&& buffer) {
+    auto owned = std::make_shared<std::vector<T>>(std::move(buffer));
+    data_ = owned->data();
+    size_ = owned->size();
+    storage_ = std::move(owned);
+  }
+  // Refers to the |size| elements at |data|, which |storage| keeps alive.
+  FileContents(std::shared_ptr<const void> storage, const T* data, size_t size)
+      : storage_(std::move(storage)), data_(data), size_(size) {}
+
+  const T* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+ private:
+  std::shared_ptr<const void> storage_;
+  const T* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 // Sets the contents of the file named |filename| in |data|, assuming each
 // element in the file is of type |uint32_t|. The file is opened as a binary
 // file. If |filename| is nullptr or "-", reads from the standard input, but
@@ -41,6 +73,11 @@
 //    little-endian order
 bool ReadBinaryFile(const char* filename, std::vector<uint32_t>* data);
 
+// Same as above, but maps a regular file into memory instead of copying it
+// where possible.  Other inputs, such as pipes and the standard input, and
+// hex streams are read into memory.
+bool ReadBinaryFile(const char* filename, FileContents<uint32_t>* contents);
+
 // The hex->binary logic of |ReadBinaryFile| applied to a pre-loaded stream of
 // bytes.  Used by tests to avoid having to call |ReadBinaryFile| with temp
 // files.  Returns false in case of parse errors.
@@ -54,10 +91,16 @@ bool ConvertHexToBinary(const std::vector<char>& stream,
 // returns false.
 bool ReadTextFile(const char* filename, std::vector<char>* data);
 
+// Same as above, but maps a regular file into memory instead of copying it
+// where possible.  Other inputs, such as pipes and the standard input, are
+// read into memory.
+bool ReadTextFile(const char* filename, FileContents<char>* contents);
+
 // Writes the given |data| into the file named as |filename| using the given
 // |mode|, assuming |data| is an array of |count| elements of type |T|. If
-// |filename| is nullptr or "-", writes to standard output. If any error occurs,
-// returns false and outputs error message to standard error.
+// |filename| is nullptr or "-", writes to standard output. A file is written
+// without buffering, with a single write where the system allows it. If any
+// error occurs, returns false and outputs error message to standard error.
 template <typename T>
 bool WriteFile(const char* filename, const char* mode, const T* data,
                size_t count);
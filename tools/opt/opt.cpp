@@ -17,6 +17,7 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -28,7 +29,9 @@
 #include "spirv-tools/libspirv.hpp"
 #include "spirv-tools/optimizer.hpp"
 #include "tools/io.h"
+#include "tools/util/batch.h"
 #include "tools/util/cli_consumer.h"
+#include "tools/util/server.h"
 
 namespace {
 
@@ -51,6 +54,44 @@ void opt_diagnostic(spv_message_level_t level, const char* /*source*/,
   fprintf(stderr, "%s\n", message);
 }
 
+// The cache selected with --cache-dir, if any.  It must outlive every call to
+// Optimizer::Run.
+std::unique_ptr<spvtools::OptimizerCache> opt_cache;
+
+// The file selected with --profile-report, if any.  It must outlive every call
+// to Optimizer::Run.  It is only opened for a single input file.
+std::ofstream profile_file;
+
+const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_6;
+
+// The optimizer configuration given on the command line.  It is applied to
+// each Optimizer, so that batch mode can set up one per worker.
+struct OptimizerSettings {
+  spv_target_env target_env = kDefaultEnvironment;
+  bool print_all = false;
+  bool time_report = false;
+  bool decision_report = false;
+  // The file given to --profile-report, or empty.
+  std::string profile_report;
+  bool validate_after_all = false;
+  std::vector<std::string> pass_flags;
+  bool preserve_interface = true;
+};
+
+// The files given on the command line and how to process them.
+struct FileSettings {
+  // The positional arguments: the input file, or with --batch the pairs of
+  // input and output files.
+  std::vector<std::string> files;
+  const char* out_file = nullptr;
+  bool batch = false;
+  std::string batch_file;
+  // With --server, the socket to listen on, or empty for standard input.
+  bool server = false;
+  std::string server_socket;
+  size_t num_workers = 0;
+};
+
 std::string GetListOfPassesAsString(const spvtools::Optimizer& optimizer) {
   std::stringstream ss;
   for (const auto& name : optimizer.GetPassNames()) {
@@ -59,8 +100,6 @@ std::string GetListOfPassesAsString(const spvtools::Optimizer& optimizer) {
   return ss.str();
 }
 
-const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_6;
-
 std::string GetLegalizationPasses() {
   spvtools::Optimizer optimizer(kDefaultEnvironment);
   optimizer.RegisterLegalizationPasses();
@@ -86,26 +125,50 @@ void PrintUsage(const char* program) {
       R"(%s - Optimize a SPIR-V binary file.
 
 USAGE: %s [options] [<input>] -o <output>
+       %s [options] --batch [<input> <output>]...
+       %s [options] --server[=<socket>]
 
 The SPIR-V binary is read from <input>. If no file is specified,
 or if <input> is "-", then the binary is read from standard input.
 if <output> is "-", then the optimized output is written to
 standard output.
 
+With --batch, each <input> is optimized into the <output> that
+follows it.  With --server, binaries are optimized on request.
+
 NOTE: The optimizer is a work in progress.
 
 Options (in lexicographical order):)",
-      program, program);
+      program, program, program, program);
   printf(R"(
   --amd-ext-to-khr
                Replaces the extensions VK_AMD_shader_ballot, VK_AMD_gcn_shader,
                and VK_AMD_shader_trinary_minmax with equivalent code using core
                instructions and capabilities.)");
   printf(R"(
+  --batch
+               Optimizes several files with the same passes.  The positional
+               arguments are pairs of input and output files.  The files are
+               spread over worker threads, see -j, each of which sets up its
+               optimizer once and reuses it.  A summary of the messages and
+               status of each file is printed at the end.)");
+  printf(R"(
+  --batch-file=<file>
+               Implies --batch, and reads additional pairs of input and output
+               files from <file>, one pair per line.  Empty lines and lines
+               starting with '#' are ignored.)");
+  printf(R"(
   --before-hlsl-legalization
                Forwards this option to the validator.  See the validator help
                for details.)");
   printf(R"(
+  --cache-dir=<dir>
+               Reuse optimized modules stored in the existing directory <dir>,
+               and store the result there when it is not found.  The entry is
+               keyed by the input module, the passes and options given on the
+               command line, and the version of this tool.  The directory can
+               be shared by concurrent invocations.)");
+  printf(R"(
   --ccp
                Apply the conditional constant propagation transform.  This will
                propagate constant values throughout the program, and simplify
@@ -172,6 +235,12 @@ Options (in lexicographical order):)",
                semantics to a variable with HelperInvocation BuiltIn decoration
                in the fragement shader.)");
   printf(R"(
+  --decision-report
+               Print the decisions of the passes that choose how to transform
+               the module, one line each, to standard error output.  For
+               example, --loop-unroll-heuristic reports the unroll factor it
+               chooses for each loop and why.)");
+  printf(R"(
   --descriptor-scalar-replacement
                Replaces every array variable |desc| that has a DescriptorSet
                and Binding decorations with a new variable for each element of
@@ -264,11 +333,21 @@ Options (in lexicographical order):)",
   --if-conversion
                Convert if-then-else like assignments into OpSelect.)");
   printf(R"(
+  --inline-cost-model
+               Inline the function calls in entry point call tree functions
+               that a size and benefit cost model considers profitable,
+               within a bound on the growth of the module.)");
+  printf(R"(
   --inline-entry-points-exhaustive
                Exhaustively inline all function calls in entry point call tree
                functions. Currently does not inline calls to functions with
                early return in a loop.)");
   printf(R"(
+  -j <n>
+               Uses <n> worker threads in batch or server mode.  Defaults to
+               the number of hardware threads.  --print-all, --time-report
+               and --decision-report require -j 1.)");
+  printf(R"(
   --legalize-hlsl
                Runs a series of optimizations that attempts to take SPIR-V
                generated by an HLSL front-end and generates legal Vulkan SPIR-V.
@@ -300,9 +379,24 @@ Options (in lexicographical order):)",
                Identifies code in loops that has the same value for every
                iteration of the loop, and move it to the loop pre-header.)");
   printf(R"(
+  --loop-invariant-code-motion-aggressive[=<max registers>]
+               Does what --loop-invariant-code-motion does, and also hoists
+               loads from variables the loop does not write and sinks
+               invariant stores to the loop merge block. Stops hoisting in a
+               loop when its estimated register pressure would exceed the
+               limit, which defaults to 64.)");
+  printf(R"(
   --loop-unroll
                Fully unrolls loops marked with the Unroll flag)");
   printf(R"(
+  --loop-unroll-heuristic[=<max registers>[:<max instructions>]]
+               Unrolls loops not marked with the DontUnroll flag, fully if
+               the estimated register pressure and size of the unrolled loop
+               fit the limits, or partially by the largest power of two
+               factor that fits them. The limits default to 64 registers and
+               1024 instructions. See --decision-report to print the choice
+               made for each loop.)");
+  printf(R"(
   --loop-unroll-partial
                Partially unrolls loops marked with the Unroll flag. Takes an
                additional non-0 integer argument to set the unroll factor, or
@@ -419,6 +513,16 @@ Options (in lexicographical order):)",
                Print SPIR-V assembly to standard error output before each pass
                and after the last pass.)");
   printf(R"(
+  --profile-report=<file>
+               Write a profile of the passes to <file> as JSON in the Chrome
+               trace event format, which can be loaded in chrome://tracing or
+               Perfetto.  For each pass it records the wall and CPU time, the
+               number of instructions before and after the pass, the number of
+               functions it changed, and how many times each analysis was
+               built or invalidated.  Unlike --time-report, it is available
+               on every platform.  It cannot be used in batch or server
+               mode.)");
+  printf(R"(
   --private-to-local
                Change the scope of private variables that are used in a single
                function to that function.)");
@@ -486,6 +590,19 @@ Options (in lexicographical order):)",
                be replaced.  0 means there is no limit.  The default value is
                100.)");
   printf(R"(
+  --server[=<socket>]
+               Keeps running, and optimizes the binaries sent in requests on
+               standard input, or by clients of the Unix domain socket
+               <socket>.  The results are sent back on standard output or the
+               socket.  A request holds an id, the flags listing its passes
+               in the --pass=arg form, and the binary.  Without flags, the
+               passes on the command line are used.  The other options on the
+               command line apply to every request.  The passes of each
+               request are set up once per worker thread, see -j, and reused.
+               The request "--shutdown" stops the server, which then prints
+               the latency percentiles of the requests.  The framing of
+               requests and responses is described in tools/util/server.h.)");
+  printf(R"(
   --set-spec-const-default-value "<spec id>:<default value> ..."
                Set the default values of the specialization constants with
                <spec id>:<default value> pairs specified in a double-quoted
@@ -638,22 +755,21 @@ bool ReadFlagsFromFile(const char* oconfig_flag,
   return true;
 }
 
-OptStatus ParseFlags(int argc, const char** argv,
-                     spvtools::Optimizer* optimizer, const char** in_file,
-                     const char** out_file,
+OptStatus ParseFlags(int argc, const char** argv, OptimizerSettings* settings,
+                     FileSettings* file_settings,
                      spvtools::ValidatorOptions* validator_options,
                      spvtools::OptimizerOptions* optimizer_options);
 
 // Parses and handles the -Oconfig flag. |prog_name| contains the name of
 // the spirv-opt binary (used to build a new argv vector for the recursive
 // invocation to ParseFlags). |opt_flag| contains the -Oconfig=FILENAME flag.
-// |optimizer|, |in_file|, |out_file|, |validator_options|, and
-// |optimizer_options| are as in ParseFlags.
+// |settings|, |file_settings|, |validator_options|, and |optimizer_options|
+// are as in ParseFlags.
 //
 // This returns the same OptStatus instance returned by ParseFlags.
 OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
-                           spvtools::Optimizer* optimizer, const char** in_file,
-                           const char** out_file,
+                           OptimizerSettings* settings,
+                           FileSettings* file_settings,
                            spvtools::ValidatorOptions* validator_options,
                            spvtools::OptimizerOptions* optimizer_options) {
   std::vector<std::string> flags;
@@ -679,8 +795,8 @@ OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
   }
 
   auto ret_val =
-      ParseFlags(static_cast<int>(flags.size()), new_argv, optimizer, in_file,
-                 out_file, validator_options, optimizer_options);
+      ParseFlags(static_cast<int>(flags.size()), new_argv, settings,
+                 file_settings, validator_options, optimizer_options);
   delete[] new_argv;
   return ret_val;
 }
@@ -726,20 +842,17 @@ std::string CanonicalizeFlag(const char** argv, int argc, int* argi) {
 }
 
 // Parses command-line flags. |argc| contains the number of command-line flags.
-// |argv| points to an array of strings holding the flags. |optimizer| is the
-// Optimizer instance used to optimize the program.
+// |argv| points to an array of strings holding the flags. The configuration of
+// the Optimizer instances used to optimize the program is stored in
+// |settings|.
 //
-// On return, this function stores the name of the input program in |in_file|.
-// The name of the output file in |out_file|. The return value indicates whether
-// optimization should continue and a status code indicating an error or
-// success.
-OptStatus ParseFlags(int argc, const char** argv,
-                     spvtools::Optimizer* optimizer, const char** in_file,
-                     const char** out_file,
+// On return, this function stores the names of the input and output files in
+// |file_settings|. The return value indicates whether optimization should
+// continue and a status code indicating an error or success.
+OptStatus ParseFlags(int argc, const char** argv, OptimizerSettings* settings,
+                     FileSettings* file_settings,
                      spvtools::ValidatorOptions* validator_options,
                      spvtools::OptimizerOptions* optimizer_options) {
-  std::vector<std::string> pass_flags;
-  bool preserve_interface = true;
   for (int argi = 1; argi < argc; ++argi) {
     const char* cur_arg = argv[argi];
     if ('-' == cur_arg[0]) {
@@ -751,24 +864,37 @@ OptStatus ParseFlags(int argc, const char** argv,
         PrintUsage(argv[0]);
         return {OPT_STOP, 0};
       } else if (0 == strcmp(cur_arg, "-o")) {
-        if (!*out_file && argi + 1 < argc) {
-          *out_file = argv[++argi];
+        if (!file_settings->out_file && argi + 1 < argc) {
+          file_settings->out_file = argv[++argi];
         } else {
           PrintUsage(argv[0]);
           return {OPT_STOP, 1};
         }
       } else if ('\0' == cur_arg[1]) {
         // Setting a filename of "-" to indicate stdin.
-        if (!*in_file) {
-          *in_file = cur_arg;
-        } else {
-          spvtools::Error(opt_diagnostic, nullptr, {},
-                          "More than one input file specified");
+        file_settings->files.push_back(cur_arg);
+      } else if (0 == strcmp(cur_arg, "--batch")) {
+        file_settings->batch = true;
+      } else if (0 == strncmp(cur_arg, "--batch-file=",
+                              sizeof("--batch-file=") - 1)) {
+        file_settings->batch = true;
+        file_settings->batch_file =
+            spvtools::utils::SplitFlagArgs(cur_arg).second;
+      } else if (0 == strcmp(cur_arg, "--server")) {
+        file_settings->server = true;
+      } else if (0 == strncmp(cur_arg, "--server=", sizeof("--server=") - 1)) {
+        file_settings->server = true;
+        file_settings->server_socket =
+            spvtools::utils::SplitFlagArgs(cur_arg).second;
+      } else if (0 == strcmp(cur_arg, "-j")) {
+        if (!spvtools::utils::ParseBatchWorkers(
+                argi + 1 < argc ? argv[++argi] : nullptr,
+                &file_settings->num_workers)) {
           return {OPT_STOP, 1};
         }
       } else if (0 == strncmp(cur_arg, "-Oconfig=", sizeof("-Oconfig=") - 1)) {
         OptStatus status =
-            ParseOconfigFlag(argv[0], cur_arg, optimizer, in_file, out_file,
+            ParseOconfigFlag(argv[0], cur_arg, settings, file_settings,
                              validator_options, optimizer_options);
         if (status.action != OPT_CONTINUE) {
           return status;
@@ -776,13 +902,33 @@ OptStatus ParseFlags(int argc, const char** argv,
       } else if (0 == strcmp(cur_arg, "--skip-validation")) {
         optimizer_options->set_run_validator(false);
       } else if (0 == strcmp(cur_arg, "--print-all")) {
-        optimizer->SetPrintAll(&std::cerr);
+        settings->print_all = true;
       } else if (0 == strcmp(cur_arg, "--preserve-bindings")) {
         optimizer_options->set_preserve_bindings(true);
       } else if (0 == strcmp(cur_arg, "--preserve-spec-constants")) {
         optimizer_options->set_preserve_spec_constants(true);
       } else if (0 == strcmp(cur_arg, "--time-report")) {
-        optimizer->SetTimeReport(&std::cerr);
+        settings->time_report = true;
+      } else if (0 == strcmp(cur_arg, "--decision-report")) {
+        settings->decision_report = true;
+      } else if (0 == strncmp(cur_arg, "--profile-report=",
+                              sizeof("--profile-report=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        if (split_flag.second.empty()) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "Invalid value passed to --profile-report");
+          return {OPT_STOP, 1};
+        }
+        settings->profile_report = split_flag.second;
+      } else if (0 == strncmp(cur_arg, "--cache-dir=",
+                              sizeof("--cache-dir=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        if (split_flag.second.empty()) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "Invalid value passed to --cache-dir");
+          return {OPT_STOP, 1};
+        }
+        opt_cache = spvtools::CreateDirectoryOptimizerCache(split_flag.second);
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         validator_options->SetRelaxStructStore(true);
       } else if (0 == strncmp(cur_arg, "--max-id-bound=",
@@ -812,9 +958,9 @@ OptStatus ParseFlags(int argc, const char** argv,
                           "Invalid value passed to --target-env");
           return {OPT_STOP, 1};
         }
-        optimizer->SetTargetEnv(target_env);
+        settings->target_env = target_env;
       } else if (0 == strcmp(cur_arg, "--validate-after-all")) {
-        optimizer->SetValidateAfterAll(true);
+        settings->validate_after_all = true;
       } else if (0 == strcmp(cur_arg, "--before-hlsl-legalization")) {
         validator_options->SetBeforeHlslLegalization(true);
       } else if (0 == strcmp(cur_arg, "--relax-logical-pointer")) {
@@ -830,11 +976,11 @@ OptStatus ParseFlags(int argc, const char** argv,
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         validator_options->SetRelaxStructStore(true);
       } else if (0 == strcmp(cur_arg, "--preserve-interface")) {
-        preserve_interface = true;
+        settings->preserve_interface = true;
       } else {
         // Some passes used to accept the form '--pass arg', canonicalize them
         // to '--pass=arg'.
-        pass_flags.push_back(CanonicalizeFlag(argv, argc, &argi));
+        settings->pass_flags.push_back(CanonicalizeFlag(argv, argc, &argi));
 
         // If we were requested to legalize SPIR-V generated from the HLSL
         // front-end, skip validation.
@@ -843,37 +989,167 @@ OptStatus ParseFlags(int argc, const char** argv,
         }
       }
     } else {
-      if (!*in_file) {
-        *in_file = cur_arg;
-      } else {
-        spvtools::Error(opt_diagnostic, nullptr, {},
-                        "More than one input file specified");
-        return {OPT_STOP, 1};
-      }
+      file_settings->files.push_back(cur_arg);
     }
   }
 
-  if (!optimizer->RegisterPassesFromFlags(pass_flags, preserve_interface)) {
-    return {OPT_STOP, 1};
+  return {OPT_CONTINUE, 0};
+}
+
+// Configures |optimizer| with |settings|.  Returns false if the passes could
+// not be registered.
+bool ConfigureOptimizer(const OptimizerSettings& settings,
+                        spvtools::Optimizer* optimizer) {
+  optimizer->SetTargetEnv(settings.target_env);
+  if (settings.print_all) optimizer->SetPrintAll(&std::cerr);
+  if (settings.time_report) optimizer->SetTimeReport(&std::cerr);
+  if (settings.decision_report) optimizer->SetDecisionReport(&std::cerr);
+  if (profile_file.is_open()) optimizer->SetProfileReport(&profile_file);
+  if (opt_cache) optimizer->SetCache(opt_cache.get());
+  optimizer->SetValidateAfterAll(settings.validate_after_all);
+  return optimizer->RegisterPassesFromFlags(settings.pass_flags,
+                                            settings.preserve_interface);
+}
+
+// Returns true if the reports requested in |settings| can be written with
+// |num_workers| workers.  Otherwise, prints an error and returns false.
+bool CheckReportsForWorkers(const OptimizerSettings& settings,
+                            size_t num_workers) {
+  // Each run writes a complete trace, and several of them in one file are not
+  // a valid trace.
+  if (!settings.profile_report.empty()) {
+    spvtools::Error(opt_diagnostic, nullptr, {},
+                    "--profile-report cannot be used in batch or server mode");
+    return false;
+  }
+  if (num_workers > 1 &&
+      (settings.print_all || settings.time_report ||
+       settings.decision_report)) {
+    spvtools::Error(opt_diagnostic, nullptr, {},
+                    "--print-all, --time-report and --decision-report need "
+                    "-j 1 in batch and server mode");
+    return false;
   }
+  return true;
+}
 
-  return {OPT_CONTINUE, 0};
+// Optimizes each pair of input and output files in |file_settings| with its
+// own Optimizer for each worker.  Returns the exit code.
+int OptimizeBatch(const OptimizerSettings& settings,
+                  const FileSettings& file_settings,
+                  const spvtools::OptimizerOptions& optimizer_options) {
+  std::vector<spvtools::utils::BatchJob> jobs;
+  if (!spvtools::utils::AddBatchJobs(file_settings.files, true, &jobs)) {
+    return 1;
+  }
+  if (!file_settings.batch_file.empty() &&
+      !spvtools::utils::ReadBatchFile(file_settings.batch_file.c_str(), true,
+                                      &jobs)) {
+    return 1;
+  }
+
+  size_t num_workers = file_settings.num_workers
+                           ? file_settings.num_workers
+                           : spvtools::utils::DefaultBatchWorkers();
+  num_workers = std::max<size_t>(1, std::min(num_workers, jobs.size()));
+  if (!CheckReportsForWorkers(settings, num_workers)) return 1;
+
+  // The recipe is set up once per worker and reused for all its files.
+  std::vector<std::string> logs(num_workers);
+  std::vector<std::unique_ptr<spvtools::Optimizer>> optimizers;
+  for (size_t worker = 0; worker < num_workers; ++worker) {
+    optimizers.push_back(
+        std::make_unique<spvtools::Optimizer>(settings.target_env));
+    optimizers.back()->SetMessageConsumer(
+        spvtools::utils::BatchMessageConsumer(&logs[worker]));
+    if (!ConfigureOptimizer(settings, optimizers.back().get())) {
+      // The same errors would be reported by every worker.
+      fprintf(stderr, "%s", logs[worker].c_str());
+      return 1;
+    }
+  }
+
+  const bool ok = spvtools::utils::RunBatch(
+      jobs, num_workers,
+      [&](size_t worker, const spvtools::utils::BatchJob& job,
+          std::string* log) {
+        FileContents<uint32_t> input;
+        bool succeeded = ReadBinaryFile(job.input.c_str(), &input);
+        std::vector<uint32_t> binary;
+        succeeded = succeeded &&
+                    optimizers[worker]->Run(input.data(), input.size(),
+                                            &binary, optimizer_options) &&
+                    WriteFile<uint32_t>(job.output.c_str(), "wb",
+                                        binary.data(), binary.size());
+        log->swap(logs[worker]);
+        logs[worker].clear();
+        return succeeded;
+      });
+  return ok ? 0 : 1;
 }
 
 }  // namespace
 
-int main(int argc, const char** argv) {
-  const char* in_file = nullptr;
-  const char* out_file = nullptr;
+// Serves optimization requests until shut down.  The passes of a request are
+// given by its flags, or by |settings| if it has none.  Returns the exit code.
+int Serve(const OptimizerSettings& settings, const FileSettings& file_settings,
+          const spvtools::OptimizerOptions& optimizer_options) {
+  const size_t num_workers = file_settings.num_workers
+                                 ? file_settings.num_workers
+                                 : spvtools::utils::DefaultBatchWorkers();
+  if (!CheckReportsForWorkers(settings, num_workers)) return 1;
 
-  spv_target_env target_env = kDefaultEnvironment;
+  // Each worker keeps an Optimizer for each list of passes it was asked for,
+  // so the passes are only set up once.  Clients usually stick to a few
+  // lists, but the number kept is bounded all the same.
+  const size_t kMaxOptimizersPerWorker = 16;
+  struct Worker {
+    std::string messages;
+    std::map<std::vector<std::string>, std::unique_ptr<spvtools::Optimizer>>
+        optimizers;
+  };
+  std::vector<Worker> workers(num_workers);
 
-  spvtools::Optimizer optimizer(target_env);
-  optimizer.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
+  return spvtools::utils::RunServer(
+      file_settings.server_socket, num_workers,
+      [&](size_t index, const spvtools::utils::ServerRequest& request,
+          spvtools::utils::ServerResponse* response) {
+        Worker& worker = workers[index];
+        const std::vector<std::string>& pass_flags =
+            request.flags.empty() ? settings.pass_flags : request.flags;
+        auto it = worker.optimizers.find(pass_flags);
+        if (it == worker.optimizers.end()) {
+          if (worker.optimizers.size() == kMaxOptimizersPerWorker) {
+            worker.optimizers.clear();
+          }
+          OptimizerSettings request_settings = settings;
+          request_settings.pass_flags = pass_flags;
+          auto optimizer =
+              std::make_unique<spvtools::Optimizer>(settings.target_env);
+          optimizer->SetMessageConsumer(
+              spvtools::utils::BatchMessageConsumer(&worker.messages));
+          if (!ConfigureOptimizer(request_settings, optimizer.get())) {
+            response->messages.swap(worker.messages);
+            worker.messages.clear();
+            return;
+          }
+          it = worker.optimizers.emplace(pass_flags, std::move(optimizer))
+                   .first;
+        }
+        response->succeeded =
+            it->second->Run(request.binary.data(), request.binary.size(),
+                            &response->binary, optimizer_options);
+        response->messages.swap(worker.messages);
+        worker.messages.clear();
+      });
+}
 
+int main(int argc, const char** argv) {
+  OptimizerSettings settings;
+  FileSettings file_settings;
   spvtools::ValidatorOptions validator_options;
   spvtools::OptimizerOptions optimizer_options;
-  OptStatus status = ParseFlags(argc, argv, &optimizer, &in_file, &out_file,
+  OptStatus status = ParseFlags(argc, argv, &settings, &file_settings,
                                 &validator_options, &optimizer_options);
   optimizer_options.set_validator_options(validator_options);
 
@@ -881,20 +1157,64 @@ int main(int argc, const char** argv) {
     return status.code;
   }
 
+  if (file_settings.server) {
+    if (file_settings.batch || file_settings.out_file ||
+        !file_settings.files.empty()) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      "--server takes no files, -o or --batch");
+      return 1;
+    }
+    return Serve(settings, file_settings, optimizer_options);
+  }
+
+  if (file_settings.batch) {
+    if (file_settings.out_file) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      "-o cannot be used in batch mode");
+      return 1;
+    }
+    return OptimizeBatch(settings, file_settings, optimizer_options);
+  }
+
+  if (file_settings.files.size() > 1) {
+    spvtools::Error(opt_diagnostic, nullptr, {},
+                    "More than one input file specified");
+    return 1;
+  }
+  const char* in_file =
+      file_settings.files.empty() ? nullptr : file_settings.files[0].c_str();
+  const char* out_file = file_settings.out_file;
+
+  if (!settings.profile_report.empty()) {
+    profile_file.open(settings.profile_report);
+    if (!profile_file) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      ("Could not open " + settings.profile_report).c_str());
+      return 1;
+    }
+  }
+
+  spvtools::Optimizer optimizer(settings.target_env);
+  optimizer.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
+  if (!ConfigureOptimizer(settings, &optimizer)) {
+    return 1;
+  }
+
   if (out_file == nullptr) {
     spvtools::Error(opt_diagnostic, nullptr, {}, "-o required");
     return 1;
   }
 
-  std::vector<uint32_t> binary;
-  if (!ReadBinaryFile(in_file, &binary)) {
+  // A regular input file is mapped into memory, and the optimizer reads it
+  // from there.
+  FileContents<uint32_t> input;
+  if (!ReadBinaryFile(in_file, &input)) {
     return 1;
   }
 
-  // By using the same vector as input and output, we save time in the case
-  // that there was no change.
+  std::vector<uint32_t> binary;
   bool ok =
-      optimizer.Run(binary.data(), binary.size(), &binary, optimizer_options);
+      optimizer.Run(input.data(), input.size(), &binary, optimizer_options);
 
   if (!WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())) {
     return 1;
@@ -0,0 +1,168 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/util/batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+// Returns false and prints an error if |job| writes to standard output, which
+// the jobs of a batch cannot share.
+bool CheckBatchOutput(const BatchJob& job) {
+  if (job.output == "-") {
+    fprintf(stderr, "error: the output for '%s' cannot be standard output\n",
+            job.input.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool AddBatchJobs(const std::vector<std::string>& args, bool with_outputs,
+                  std::vector<BatchJob>* jobs) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    BatchJob job;
+    job.input = args[i];
+    if (with_outputs) {
+      if (++i == args.size()) {
+        fprintf(stderr, "error: no output file for '%s'\n", job.input.c_str());
+        return false;
+      }
+      job.output = args[i];
+      if (!CheckBatchOutput(job)) return false;
+    }
+    jobs->push_back(std::move(job));
+  }
+  return true;
+}
+
+bool ReadBatchFile(const char* filename, bool with_outputs,
+                   std::vector<BatchJob>* jobs) {
+  std::ifstream file(filename);
+  if (!file) {
+    fprintf(stderr, "error: could not open batch file '%s'\n", filename);
+    return false;
+  }
+
+  std::string line;
+  for (size_t line_number = 1; std::getline(file, line); ++line_number) {
+    // Ignore empty lines and lines starting with the comment marker '#'.
+    if (line.empty() || line[0] == '#') continue;
+
+    // Like -Oconfig files, this does not support quoting.
+    std::istringstream tokens(line);
+    std::vector<std::string> fields;
+    for (std::string field; tokens >> field;) fields.push_back(field);
+    if (fields.empty()) continue;
+    if (fields.size() != (with_outputs ? 2u : 1u)) {
+      fprintf(stderr, "error: %s:%zu: expected %s\n", filename, line_number,
+              with_outputs ? "an input and an output file" : "an input file");
+      return false;
+    }
+    BatchJob job;
+    job.input = fields[0];
+    if (with_outputs) {
+      job.output = fields[1];
+      if (!CheckBatchOutput(job)) return false;
+    }
+    jobs->push_back(std::move(job));
+  }
+  return true;
+}
+
+bool ParseBatchWorkers(const char* arg, size_t* num_workers) {
+  char* end = nullptr;
+  const unsigned long value = arg ? strtoul(arg, &end, 10) : 0;
+  if (!arg || *end != '\0' || value == 0) {
+    fprintf(stderr, "error: -j expects a positive number of workers\n");
+    return false;
+  }
+  *num_workers = static_cast<size_t>(value);
+  return true;
+}
+
+size_t DefaultBatchWorkers() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+MessageConsumer BatchMessageConsumer(std::string* log) {
+  return [log](spv_message_level_t level, const char*,
+               const spv_position_t& position, const char* message) {
+    const char* prefix = nullptr;
+    switch (level) {
+      case SPV_MSG_FATAL:
+      case SPV_MSG_INTERNAL_ERROR:
+      case SPV_MSG_ERROR:
+        prefix = "error";
+        break;
+      case SPV_MSG_WARNING:
+        prefix = "warning";
+        break;
+      case SPV_MSG_INFO:
+        prefix = "info";
+        break;
+      default:
+        return;
+    }
+    *log += prefix;
+    *log += ": line " + std::to_string(position.index) + ": " + message + "\n";
+  };
+}
+
+bool RunBatch(const std::vector<BatchJob>& jobs, size_t num_workers,
+              const BatchJobFunction& process) {
+  std::vector<std::string> logs(jobs.size());
+  std::vector<char> succeeded(jobs.size(), false);
+
+  std::atomic<size_t> next(0);
+  auto work = [&](size_t worker) {
+    for (size_t i = next++; i < jobs.size(); i = next++) {
+      succeeded[i] = process(worker, jobs[i], &logs[i]);
+    }
+  };
+  num_workers = std::max<size_t>(1, std::min(num_workers, jobs.size()));
+  std::vector<std::thread> threads;
+  for (size_t worker = 1; worker < num_workers; ++worker) {
+    threads.emplace_back(work, worker);
+  }
+  work(0);
+  for (std::thread& thread : threads) thread.join();
+
+  size_t num_failed = 0;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    if (!logs[i].empty()) {
+      fprintf(stderr, "%s:\n%s", jobs[i].input.c_str(), logs[i].c_str());
+    }
+    if (!succeeded[i]) {
+      fprintf(stderr, "FAILED: %s\n", jobs[i].input.c_str());
+      ++num_failed;
+    }
+  }
+  fprintf(stderr, "%zu of %zu files succeeded\n", jobs.size() - num_failed,
+          jobs.size());
+  return num_failed == 0;
+}
+
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLS_UTIL_BATCH_H_
+#define TOOLS_UTIL_BATCH_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace utils {
+
+// One input file to process in batch mode, and the file to write the result
+// to, if the tool writes one.
+struct BatchJob {
+  std::string input;
+  std::string output;
+};
+
+// Appends a job for each input file in |args|.  If |with_outputs|, |args|
+// alternates between input and output files.  Returns false and prints an
+// error if an input file has no output file, or if an output file is "-".
+bool AddBatchJobs(const std::vector<std::string>& args, bool with_outputs,
+                  std::vector<BatchJob>* jobs);
+
+// Appends the jobs listed in the response file |filename| to |jobs|.  Each
+// line holds an input file and, if |with_outputs|, an output file, separated
+// by whitespace.  Empty lines and lines starting with '#' are ignored.  Returns
+// false and prints an error if the file cannot be read, a line is malformed,
+// or an output file is "-".
+bool ReadBatchFile(const char* filename, bool with_outputs,
+                   std::vector<BatchJob>* jobs);
+
+// Parses the worker count given to -j.  Returns false and prints an error if
+// |arg| is not a positive number.
+bool ParseBatchWorkers(const char* arg, size_t* num_workers);
+
+// Returns the number of workers to use when no count is given.
+size_t DefaultBatchWorkers();
+
+// Returns a message consumer which appends messages to |log| in the format
+// of CLIMessageConsumer.
+MessageConsumer BatchMessageConsumer(std::string* log);
+
+// Processes |job| on the worker numbered |worker|, appending its messages to
+// |log|.  Returns true on success.
+using BatchJobFunction =
+    std::function<bool(size_t worker, const BatchJob& job, std::string* log)>;
+
+// Runs |process| for each job on |num_workers| threads.  Each worker handles
+// one job at a time, so state indexed by the worker number, such as an
+// Optimizer, is reused across jobs without locking.  Once all jobs are done,
+// prints a summary to standard error with the messages and status of each
+// job in order.  Returns true if every job succeeded.
+bool RunBatch(const std::vector<BatchJob>& jobs, size_t num_workers,
+              const BatchJobFunction& process);
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // TOOLS_UTIL_BATCH_H_
@@ -0,0 +1,465 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/util/server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SPIRV_TOOLS_UNIX_SOCKETS
+#endif
+
+#if defined(SPIRV_WINDOWS)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+// Limits on the size of a request, so that a corrupt header does not make the
+// server allocate unbounded memory.
+constexpr uint32_t kMaxFlagsBytes = 1 << 16;
+constexpr uint32_t kMaxBinaryWords = 1 << 28;
+
+// The flag of a request which shuts the server down.
+const char kShutdownFlag[] = "--shutdown";
+
+// A stream of requests from one client, and of responses back to it.
+class Connection {
+ public:
+  virtual ~Connection() = default;
+
+  // Reads the next request into |request|.  Returns false at the end of the
+  // stream, or if the request is malformed.
+  bool ReadRequest(ServerRequest* request);
+
+  // Writes |response| to the request numbered |id|.  Can be called from
+  // several threads at once.  Returns false on error.
+  bool WriteResponse(uint32_t id, const ServerResponse& response);
+
+  // Makes pending and future reads fail, so that the reader stops.  Responses
+  // can still be written.
+  virtual void StopReading() {}
+
+ protected:
+  // Reads exactly |size| bytes into |data|.  Returns false at the end of the
+  // stream or on error.
+  virtual bool Read(void* data, size_t size) = 0;
+
+  // Writes |size| bytes of |data|.  Returns false on error.
+  virtual bool Write(const void* data, size_t size) = 0;
+
+  // Sends out what was written.  Returns false on error.
+  virtual bool Flush() { return true; }
+
+ private:
+  std::mutex write_mutex_;
+};
+
+bool Connection::ReadRequest(ServerRequest* request) {
+  uint32_t header[3];
+  if (!Read(header, sizeof(header))) return false;
+  request->id = header[0];
+  if (header[1] > kMaxFlagsBytes || header[2] > kMaxBinaryWords) {
+    fprintf(stderr, "error: request %u is too large\n", request->id);
+    return false;
+  }
+
+  std::string flags(header[1], '\0');
+  request->binary.resize(header[2]);
+  if (!Read(&flags[0], flags.size()) ||
+      !Read(request->binary.data(),
+            request->binary.size() * sizeof(uint32_t))) {
+    fprintf(stderr, "error: request %u is truncated\n", request->id);
+    return false;
+  }
+
+  // Like -Oconfig files, this does not support quoting.
+  std::istringstream tokens(flags);
+  request->flags.clear();
+  for (std::string flag; tokens >> flag;) request->flags.push_back(flag);
+  return true;
+}
+
+bool Connection::WriteResponse(uint32_t id, const ServerResponse& response) {
+  const uint32_t header[4] = {
+      id, response.succeeded ? 0u : 1u,
+      static_cast<uint32_t>(response.messages.size()),
+      static_cast<uint32_t>(response.binary.size())};
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  return Write(header, sizeof(header)) &&
+         Write(response.messages.data(), response.messages.size()) &&
+         Write(response.binary.data(),
+               response.binary.size() * sizeof(uint32_t)) &&
+         Flush();
+}
+
+// The connection over standard input and output.
+class StdioConnection final : public Connection {
+ public:
+  StdioConnection() {
+#if defined(SPIRV_WINDOWS)
+    _setmode(_fileno(stdin), O_BINARY);
+    _setmode(_fileno(stdout), O_BINARY);
+#endif
+  }
+
+ protected:
+  bool Read(void* data, size_t size) override {
+    return fread(data, 1, size, stdin) == size;
+  }
+  bool Write(const void* data, size_t size) override {
+    return fwrite(data, 1, size, stdout) == size;
+  }
+  bool Flush() override { return fflush(stdout) == 0; }
+};
+
+#if defined(SPIRV_TOOLS_UNIX_SOCKETS)
+// A connection to a client of the Unix domain socket.
+class SocketConnection final : public Connection {
+ public:
+  explicit SocketConnection(int fd) : fd_(fd) {
+#if defined(SO_NOSIGPIPE)
+    // A client going away must not kill the server.
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+  }
+  ~SocketConnection() override { close(fd_); }
+
+  void StopReading() override { shutdown(fd_, SHUT_RD); }
+
+ protected:
+  bool Read(void* data, size_t size) override {
+    auto* bytes = static_cast<char*>(data);
+    while (size > 0) {
+      const ssize_t len = read(fd_, bytes, size);
+      if (len < 0 && errno == EINTR) continue;
+      if (len <= 0) return false;
+      bytes += len;
+      size -= static_cast<size_t>(len);
+    }
+    return true;
+  }
+
+  bool Write(const void* data, size_t size) override {
+#if defined(MSG_NOSIGNAL)
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+      const ssize_t len = send(fd_, bytes, size, flags);
+      if (len < 0 && errno == EINTR) continue;
+      if (len <= 0) return false;
+      bytes += len;
+      size -= static_cast<size_t>(len);
+    }
+    return true;
+  }
+
+ private:
+  const int fd_;
+};
+#endif
+
+// Queues the requests read from the connections, and answers them on a pool
+// of worker threads.
+class Server {
+ public:
+  Server(size_t num_workers, const ServerHandler& handler) : handler_(handler) {
+    for (size_t worker = 0; worker < num_workers; ++worker) {
+      workers_.emplace_back([this, worker] { Work(worker); });
+    }
+  }
+
+  // Reads requests from |connection| until it ends or the server stops.
+  void Serve(const std::shared_ptr<Connection>& connection);
+
+  // Calls Serve on a thread of its own, which Finish waits for.
+  void ServeInBackground(std::shared_ptr<Connection> connection);
+
+  // Stops reading requests.
+  void Stop();
+
+  // Returns true once the server stopped reading requests.
+  bool stopping() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stopping_;
+  }
+
+  // Stops the server, waits for the readers to stop and for the workers to
+  // answer the requests already read, and prints the latency summary.
+  void Finish();
+
+ private:
+  // A request waiting for a worker.
+  struct Job {
+    std::shared_ptr<Connection> connection;
+    ServerRequest request;
+    std::chrono::steady_clock::time_point received;
+  };
+
+  // Answers the queued requests on the worker numbered |worker|.
+  void Work(size_t worker);
+
+  const ServerHandler& handler_;
+  std::vector<std::thread> workers_;
+
+  // Guards the members below.
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  bool stopping_ = false;
+  std::deque<Job> jobs_;
+  std::vector<std::weak_ptr<Connection>> connections_;
+  // The number of threads started by ServeInBackground that did not return.
+  size_t num_readers_ = 0;
+  std::condition_variable readers_done_;
+  // The time from reading each request to writing its response, in
+  // milliseconds.
+  std::vector<double> latencies_;
+};
+
+void Server::Serve(const std::shared_ptr<Connection>& connection) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) return;
+    // Forgets the clients that went away, so that a long-running server does
+    // not keep one entry per client it ever had.
+    connections_.erase(
+        std::remove_if(connections_.begin(), connections_.end(),
+                       [](const std::weak_ptr<Connection>& weak_connection) {
+                         return weak_connection.expired();
+                       }),
+        connections_.end());
+    connections_.push_back(connection);
+  }
+
+  for (;;) {
+    Job job;
+    if (!connection->ReadRequest(&job.request)) break;
+    job.received = std::chrono::steady_clock::now();
+    if (job.request.flags.size() == 1 &&
+        job.request.flags[0] == kShutdownFlag) {
+      ServerResponse response;
+      response.succeeded = true;
+      connection->WriteResponse(job.request.id, response);
+      Stop();
+      break;
+    }
+
+    job.connection = connection;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) break;
+    jobs_.push_back(std::move(job));
+    ready_.notify_one();
+  }
+}
+
+void Server::ServeInBackground(std::shared_ptr<Connection> connection) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++num_readers_;
+  }
+  // The thread is detached so that it goes away with its client; Finish
+  // waits for the count of running readers to drop to zero instead.
+  std::thread([this, connection]() mutable {
+    Serve(connection);
+    connection.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_readers_ == 0) readers_done_.notify_all();
+  }).detach();
+}
+
+void Server::Stop() {
+  std::vector<std::shared_ptr<Connection>> connections;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) return;
+    stopping_ = true;
+    for (const auto& weak_connection : connections_) {
+      if (auto connection = weak_connection.lock()) {
+        connections.push_back(std::move(connection));
+      }
+    }
+  }
+  ready_.notify_all();
+  for (const auto& connection : connections) connection->StopReading();
+}
+
+void Server::Work(size_t worker) {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (jobs_.empty()) return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    ServerResponse response;
+    handler_(worker, job.request, &response);
+    job.connection->WriteResponse(job.request.id, response);
+
+    const std::chrono::duration<double, std::milli> latency =
+        std::chrono::steady_clock::now() - job.received;
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_.push_back(latency.count());
+  }
+}
+
+void Server::Finish() {
+  Stop();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    readers_done_.wait(lock, [this] { return num_readers_ == 0; });
+  }
+  for (std::thread& worker : workers_) worker.join();
+
+  if (latencies_.empty()) {
+    fprintf(stderr, "0 requests served\n");
+    return;
+  }
+  std::sort(latencies_.begin(), latencies_.end());
+  // Uses the nearest-rank method.
+  const auto percentile = [this](size_t percent) {
+    const size_t rank = (percent * latencies_.size() + 99) / 100;
+    return latencies_[std::max<size_t>(rank, 1) - 1];
+  };
+  fprintf(stderr,
+          "%zu requests served, latency in ms: p50 %.3f, p90 %.3f, "
+          "p99 %.3f, max %.3f\n",
+          latencies_.size(), percentile(50), percentile(90), percentile(99),
+          latencies_.back());
+}
+
+#if defined(SPIRV_TOOLS_UNIX_SOCKETS)
+// Removes the socket at |address| if it was left behind by a server that did
+// not exit cleanly.  Returns false, after reporting the error, if the path
+// cannot be used: it is some other kind of file, or another server is
+// listening on it.
+bool RemoveStaleSocket(const sockaddr_un& address) {
+  struct stat status;
+  if (lstat(address.sun_path, &status) != 0) {
+    // A missing path is what bind expects; other errors are left for it to
+    // report.
+    return true;
+  }
+  // connect fails with ECONNREFUSED on a regular file too, so only a socket
+  // may be removed.
+  if (!S_ISSOCK(status.st_mode)) {
+    fprintf(stderr, "error: '%s' exists and is not a socket\n",
+            address.sun_path);
+    return false;
+  }
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return true;
+  const bool in_use = connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                              sizeof(address)) == 0;
+  const bool stale = !in_use && errno == ECONNREFUSED;
+  close(fd);
+  if (in_use) {
+    fprintf(stderr, "error: another server is listening on '%s'\n",
+            address.sun_path);
+    return false;
+  }
+  if (stale) unlink(address.sun_path);
+  return true;
+}
+
+// Accepts clients on the Unix domain socket |path| until |server| stops.
+// Returns the exit code of the tool.
+int ServeSocket(const std::string& path, Server* server) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    fprintf(stderr, "error: socket path '%s' is too long\n", path.c_str());
+    return 1;
+  }
+  memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  if (!RemoveStaleSocket(address)) return 1;
+
+  const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 ||
+      bind(listener, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listener, SOMAXCONN) != 0) {
+    fprintf(stderr, "error: could not listen on '%s': %s\n", path.c_str(),
+            strerror(errno));
+    if (listener >= 0) close(listener);
+    return 1;
+  }
+
+  while (!server->stopping()) {
+    // Wakes up regularly to notice a shutdown requested by a client.
+    pollfd poll_fd = {listener, POLLIN, 0};
+    if (poll(&poll_fd, 1, 100) <= 0) continue;
+    const int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) continue;
+    server->ServeInBackground(std::make_shared<SocketConnection>(fd));
+  }
+  close(listener);
+  unlink(path.c_str());
+  return 0;
+}
+#endif
+
+}  // namespace
+
+int RunServer(const std::string& socket_path, size_t num_workers,
+              const ServerHandler& handler) {
+#if !defined(SPIRV_TOOLS_UNIX_SOCKETS)
+  if (!socket_path.empty()) {
+    fprintf(stderr,
+            "error: Unix domain sockets are not supported on this platform\n");
+    return 1;
+  }
+#endif
+
+  Server server(std::max<size_t>(num_workers, 1), handler);
+  int status = 0;
+  if (socket_path.empty()) {
+    server.Serve(std::make_shared<StdioConnection>());
+  } else {
+#if defined(SPIRV_TOOLS_UNIX_SOCKETS)
+    status = ServeSocket(socket_path, &server);
+#endif
+  }
+  server.Finish();
+  return status;
+}
+
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLS_UTIL_SERVER_H_
+#define TOOLS_UTIL_SERVER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Support for the --server mode of the command-line tools, which keeps a
+// process and its worker state alive across many requests.
+//
+// Requests and responses are framed as 32-bit words in host byte order, since
+// only local clients are served.  A request is:
+//
+//   word 0: an id chosen by the client, echoed in the response
+//   word 1: the number of bytes of flags
+//   word 2: the number of words of the SPIR-V binary
+//   then the flags, separated by whitespace, followed by the binary.
+//
+// A response is:
+//
+//   word 0: the id of the request
+//   word 1: 0 on success, 1 on failure
+//   word 2: the number of bytes of messages
+//   word 3: the number of words of the resulting binary
+//   then the messages, followed by the binary.
+//
+// Requests are processed concurrently, so responses may come back in a
+// different order than the requests were sent.  A request whose only flag is
+// "--shutdown" stops the server once the requests already received have been
+// answered.  In standard input mode, the end of the input does the same.
+
+namespace spvtools {
+namespace utils {
+
+// A request received by the server.
+struct ServerRequest {
+  uint32_t id = 0;
+  std::vector<std::string> flags;
+  std::vector<uint32_t> binary;
+};
+
+// The answer to a request.
+struct ServerResponse {
+  bool succeeded = false;
+  std::string messages;
+  std::vector<uint32_t> binary;
+};
+
+// Processes |request| on the worker numbered |worker|.  A worker handles one
+// request at a time, so state indexed by the worker number, such as an
+// Optimizer, is reused across requests without locking.
+using ServerHandler = std::function<void(
+    size_t worker, const ServerRequest& request, ServerResponse* response)>;
+
+// Serves requests on |num_workers| threads until shut down, then prints the
+// number of requests and their latency percentiles to standard error.  If
+// |socket_path| is empty, requests are read from standard input and responses
+// are written to standard output.  Otherwise, the server listens for any
+// number of clients on the Unix domain socket |socket_path|, replacing a
+// socket left behind by a server that did not exit cleanly.  It fails if the
+// path is another kind of file, or if another server listens on it.  Returns
+// the exit code of the tool.
+int RunServer(const std::string& socket_path, size_t num_workers,
+              const ServerHandler& handler);
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // TOOLS_UTIL_SERVER_H_
@@ -12,17 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "source/spirv_target_env.h"
 #include "source/spirv_validator_options.h"
 #include "spirv-tools/libspirv.hpp"
 #include "tools/io.h"
+#include "tools/util/batch.h"
 #include "tools/util/cli_consumer.h"
+#include "tools/util/server.h"
 
 void print_usage(char* argv0) {
   std::string target_env_list = spvTargetEnvList(36, 105);
@@ -30,14 +36,32 @@ void print_usage(char* argv0) {
       R"(%s - Validate a SPIR-V binary file.
 
 USAGE: %s [options] [<filename>]
+       %s [options] --batch [<filename>]...
+       %s [options] --server[=<socket>]
 
 The SPIR-V binary is read from <filename>. If no file is specified,
 or if the filename is "-", then the binary is read from standard input.
+With --batch, each <filename> is validated.  With --server, binaries
+are validated on request.
 
 NOTE: The validator is a work in progress.
 
 Options:
   -h, --help                       Print this help.
+  --batch                          Validate several files on worker threads and print a summary of
+                                   the messages and status of each file at the end.
+  --batch-file <file>              Implies --batch, and reads additional files to validate from
+                                   <file>, one per line.  Lines starting with '#' are ignored.
+  -j <n>                           Use <n> worker threads in batch or server mode.  Defaults to the
+                                   number of hardware threads.
+  --server[=<socket>]              Keep running, and validate the binaries sent in requests on standard
+                                   input, or by clients of the Unix domain socket <socket>.  The
+                                   results are sent back on standard output or the socket.  A request
+                                   holds an id, optional flags "--target-env <env>" overriding the
+                                   target environment, and the binary.  The other options on the
+                                   command line apply to every request.  The request "--shutdown"
+                                   stops the server, which then prints the latency percentiles of
+                                   the requests.  The framing is described in tools/util/server.h.
   --max-struct-members             <maximum number of structure members allowed>
   --max-struct-depth               <maximum allowed nesting depth of structures>
   --max-local-variables            <maximum number of local variables allowed>
@@ -76,11 +100,68 @@ Options:
   --target-env                     {%s}
                                    Use validation rules from the specified environment.
 )",
-      argv0, argv0, target_env_list.c_str());
+      argv0, argv0, argv0, argv0, target_env_list.c_str());
+}
+
+// Serves validation requests on |socket_path| until shut down.  A request can
+// override |target_env|, and is validated with |options|.  Returns the exit
+// code.
+int Serve(const std::string& socket_path, size_t num_workers,
+          spv_target_env target_env, const spvtools::ValidatorOptions& options) {
+  if (!num_workers) num_workers = spvtools::utils::DefaultBatchWorkers();
+
+  // Each worker keeps a SpirvTools for each target environment it was asked
+  // for, so that its grammar tables are only set up once.
+  struct Worker {
+    std::string messages;
+    std::map<spv_target_env, std::unique_ptr<spvtools::SpirvTools>> tools;
+  };
+  std::vector<Worker> workers(num_workers);
+
+  return spvtools::utils::RunServer(
+      socket_path, num_workers,
+      [&](size_t index, const spvtools::utils::ServerRequest& request,
+          spvtools::utils::ServerResponse* response) {
+        spv_target_env request_env = target_env;
+        const std::vector<std::string>& flags = request.flags;
+        for (size_t i = 0; i < flags.size(); ++i) {
+          if (flags[i] != "--target-env") {
+            response->messages = "error: unsupported flag " + flags[i] + "\n";
+            return;
+          }
+          if (i + 1 == flags.size()) {
+            response->messages = "error: Missing argument to --target-env\n";
+            return;
+          }
+          if (!spvParseTargetEnv(flags[++i].c_str(), &request_env)) {
+            response->messages =
+                "error: Unrecognized target env: " + flags[i] + "\n";
+            return;
+          }
+        }
+
+        Worker& worker = workers[index];
+        std::unique_ptr<spvtools::SpirvTools>& tools =
+            worker.tools[request_env];
+        if (!tools) {
+          tools = std::make_unique<spvtools::SpirvTools>(request_env);
+          tools->SetMessageConsumer(
+              spvtools::utils::BatchMessageConsumer(&worker.messages));
+        }
+        response->succeeded = tools->Validate(
+            request.binary.data(), request.binary.size(), options);
+        response->messages.swap(worker.messages);
+        worker.messages.clear();
+      });
 }
 
 int main(int argc, char** argv) {
-  const char* inFile = nullptr;
+  std::vector<std::string> files;
+  bool batch = false;
+  const char* batch_file = nullptr;
+  bool server = false;
+  std::string server_socket;
+  size_t num_workers = 0;
   spv_target_env target_env = SPV_ENV_UNIVERSAL_1_6;
   spvtools::ValidatorOptions options;
   bool continue_processing = true;
@@ -171,28 +252,38 @@ int main(int argc, char** argv) {
         options.SetAllowVulkan32BitBitwise(true);
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         options.SetRelaxStructStore(true);
-      } else if (0 == cur_arg[1]) {
-        // Setting a filename of "-" to indicate stdin.
-        if (!inFile) {
-          inFile = cur_arg;
+      } else if (0 == strcmp(cur_arg, "--batch")) {
+        batch = true;
+      } else if (0 == strcmp(cur_arg, "--batch-file")) {
+        if (argi + 1 < argc) {
+          batch = true;
+          batch_file = argv[++argi];
         } else {
-          fprintf(stderr, "error: More than one input file specified\n");
+          fprintf(stderr, "error: Missing argument to --batch-file\n");
+          continue_processing = false;
+          return_code = 1;
+        }
+      } else if (0 == strcmp(cur_arg, "--server")) {
+        server = true;
+      } else if (0 == strncmp(cur_arg, "--server=", sizeof("--server=") - 1)) {
+        server = true;
+        server_socket = cur_arg + sizeof("--server=") - 1;
+      } else if (0 == strcmp(cur_arg, "-j")) {
+        if (!spvtools::utils::ParseBatchWorkers(
+                argi + 1 < argc ? argv[++argi] : nullptr, &num_workers)) {
           continue_processing = false;
           return_code = 1;
         }
+      } else if (0 == cur_arg[1]) {
+        // Setting a filename of "-" to indicate stdin.
+        files.push_back(cur_arg);
       } else {
         print_usage(argv[0]);
         continue_processing = false;
         return_code = 1;
       }
     } else {
-      if (!inFile) {
-        inFile = cur_arg;
-      } else {
-        fprintf(stderr, "error: More than one input file specified\n");
-        continue_processing = false;
-        return_code = 1;
-      }
+      files.push_back(cur_arg);
     }
   }
 
@@ -201,7 +292,54 @@ int main(int argc, char** argv) {
     return return_code;
   }
 
-  std::vector<uint32_t> contents;
+  if (server) {
+    if (batch || !files.empty()) {
+      fprintf(stderr, "error: --server takes no files or --batch\n");
+      return 1;
+    }
+    return Serve(server_socket, num_workers, target_env, options);
+  }
+
+  if (batch) {
+    std::vector<spvtools::utils::BatchJob> jobs;
+    if (!spvtools::utils::AddBatchJobs(files, false, &jobs) ||
+        (batch_file &&
+         !spvtools::utils::ReadBatchFile(batch_file, false, &jobs))) {
+      return 1;
+    }
+    if (!num_workers) num_workers = spvtools::utils::DefaultBatchWorkers();
+    num_workers = std::max<size_t>(1, std::min(num_workers, jobs.size()));
+
+    std::vector<std::string> logs(num_workers);
+    std::vector<std::unique_ptr<spvtools::SpirvTools>> workers;
+    for (size_t worker = 0; worker < num_workers; ++worker) {
+      workers.push_back(std::make_unique<spvtools::SpirvTools>(target_env));
+      workers.back()->SetMessageConsumer(
+          spvtools::utils::BatchMessageConsumer(&logs[worker]));
+    }
+    const bool succeed = spvtools::utils::RunBatch(
+        jobs, num_workers,
+        [&](size_t worker, const spvtools::utils::BatchJob& job,
+            std::string* log) {
+          FileContents<uint32_t> contents;
+          const bool valid =
+              ReadBinaryFile(job.input.c_str(), &contents) &&
+              workers[worker]->Validate(contents.data(), contents.size(),
+                                        options);
+          log->swap(logs[worker]);
+          logs[worker].clear();
+          return valid;
+        });
+    return !succeed;
+  }
+
+  if (files.size() > 1) {
+    fprintf(stderr, "error: More than one input file specified\n");
+    return 1;
+  }
+  const char* inFile = files.empty() ? nullptr : files[0].c_str();
+
+  FileContents<uint32_t> contents;
   if (!ReadBinaryFile(inFile, &contents)) return 1;
 
   spvtools::SpirvTools tools(target_env);